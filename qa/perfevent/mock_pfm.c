@@ -3,6 +3,7 @@
 #include "mock_pfm.h"
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
 #include <errno.h>
 
@@ -17,6 +18,7 @@ int wrap_ioctl_retval = 0;
 int wrap_malloc_fail = 0;
 int wrap_sysconf_override = 0;
 int wrap_sysconf_retcode = -1;
+int n_read_calls = 0;
 
 void init_mock()
 {
@@ -29,6 +31,7 @@ void init_mock()
     wrap_malloc_fail = 0;
     wrap_sysconf_override = 0;
     wrap_sysconf_retcode = -1;
+    n_read_calls = 0;
 }
 
 /* Mock implementations of pfm library functions to allow unit testing */
@@ -111,6 +114,10 @@ ssize_t __wrap_read(int fd, void *buf, size_t count)
     if(fd >= BASE_FAKE_FD)
     {
         memset(buf, 0, count);
+        /* group leader read: nr, time_enabled, time_running, value[nr] */
+        if(count > 3 * sizeof(uint64_t))
+            ((uint64_t *)buf)[0] = count / sizeof(uint64_t) - 3;
+        ++n_read_calls;
         return count;
     }
 
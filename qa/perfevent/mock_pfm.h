@@ -12,5 +12,6 @@ extern int wrap_ioctl_retval;
 extern int wrap_malloc_fail;
 extern int wrap_sysconf_override;
 extern int wrap_sysconf_retcode;
+extern int n_read_calls;
 
 #endif /* MOCK_PFM_H_ */
@@ -1221,6 +1221,83 @@ void test_parse_hv_gpci_events(void)
     assert(ev_count == (8 + 9));
 }
 
+/* Fetch twice, returning the number of read() calls made by the second */
+static int grouped_reads(perfhandle_t *h, int *counters)
+{
+    perf_counter *data = NULL;
+    int nevents = 0;
+    perf_derived_counter *pdata = NULL;
+    int nderivedevents = 0;
+    int reads;
+
+    perf_get(h, &data, &nevents, &pdata, &nderivedevents);
+    reads = n_read_calls;
+    *counters = perf_get(h, &data, &nevents, &pdata, &nderivedevents);
+    reads = n_read_calls - reads;
+
+    assert(nevents == 3);
+    assert(data[0].ninstances == 6);
+
+    perf_counter_destroy(data, nevents, pdata, nderivedevents);
+    return reads;
+}
+
+void test_grouped_counters(void)
+{
+    perfhandle_t *h;
+    int counters, reads;
+
+    printf( " ===== %s ==== \n", __FUNCTION__) ;
+    // Simulate 6 CPU system, 3 events on each CPU
+    setenv("SYSFS_MOUNT_POINT", "./fakefs/sys2", 1);
+    wrap_sysconf_override = 1;
+    wrap_sysconf_retcode = 6;
+
+    const char *eventlist = "config/test_grouped_counters.txt";
+
+    /* hardware events are read individually by default */
+    h = perf_event_create(eventlist);
+    assert( h != NULL );
+    reads = grouped_reads(h, &counters);
+    printf("default: %d counters, %d reads\n", counters, reads);
+    assert(counters == 18 && reads == 18);
+    perf_event_destroy(h);
+
+    /* one group per cpu */
+    perf_event_groupsize(4);
+    h = perf_event_create(eventlist);
+    assert( h != NULL );
+    reads = grouped_reads(h, &counters);
+    printf("groupsize 4: %d counters, %d reads\n", counters, reads);
+    assert(counters == 18 && reads == 6);
+    perf_event_destroy(h);
+
+    /* two groups per cpu */
+    perf_event_groupsize(2);
+    h = perf_event_create(eventlist);
+    assert( h != NULL );
+    reads = grouped_reads(h, &counters);
+    printf("groupsize 2: %d counters, %d reads\n", counters, reads);
+    assert(counters == 18 && reads == 12);
+    perf_event_destroy(h);
+
+    /* counter2 on cpu0 cannot join the group, so is read on its own */
+    init_mock();
+    wrap_sysconf_override = 1;
+    wrap_sysconf_retcode = 6;
+    perf_event_groupsize(4);
+    perf_event_open_retvals[6] = -1;
+    h = perf_event_create(eventlist);
+    assert( h != NULL );
+    reads = grouped_reads(h, &counters);
+    printf("group fallback: %d counters, %d reads\n", counters, reads);
+    assert(counters == 18 && reads == 7);
+    perf_event_destroy(h);
+
+    perf_event_groupsize(0);
+    wrap_sysconf_override = 0;
+}
+
 int runtest(int n)
 {
     init_mock();
@@ -1339,6 +1416,9 @@ int runtest(int n)
 	case 36:
 	    test_parse_hv_gpci_events();
 	    break;
+	case 37:
+	    test_grouped_counters();
+	    break;
         default:
             ret = -1;
     }
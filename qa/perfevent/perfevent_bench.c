@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * Benchmark perf_get() for a range of event and CPU counts, reading the
+ * counters individually and then in per-CPU groups.  Only the kernel
+ * software events (cpu-clock, task-clock) are used, so no PMU hardware
+ * is needed - just permission to open system-wide perf events.
+ *
+ * For each combination the read(2) calls and elapsed time per fetch are
+ * reported.
+ */
+#include "perfinterface.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+static const char *swevents[] = { "cpu-clock", "task-clock" };
+#define NSWEVENTS (sizeof(swevents) / sizeof(swevents[0]))
+
+static int nreads;
+
+ssize_t __real_read(int fd, void *buf, size_t count);
+
+ssize_t __wrap_read(int fd, void *buf, size_t count)
+{
+    ++nreads;
+    return __real_read(fd, buf, count);
+}
+
+/* perfevent configuration for nevents software events on each of ncpus */
+static int write_config(const char *path, int nevents, int ncpus)
+{
+    FILE *fp;
+    int cpu, i;
+
+    if ((fp = fopen(path, "w")) == NULL)
+        return -1;
+    fprintf(fp, "[perf]\n");
+    for (cpu = 0; cpu < ncpus; cpu++)
+        for (i = 0; i < nevents; i++)
+            fprintf(fp, "%s %d\n", swevents[i % NSWEVENTS], cpu);
+    fclose(fp);
+    return 0;
+}
+
+/* Returns the counters read per fetch, or -1 if no events could be opened */
+static int bench(const char *config, int groupsize, int iterations,
+                 int *reads, double *usec)
+{
+    perfhandle_t *h;
+    perf_counter *data = NULL;
+    perf_derived_counter *pdata = NULL;
+    int size = 0, derivedsize = 0;
+    int i, counters;
+    struct timespec start, end;
+
+    perf_event_groupsize(groupsize);
+    if ((h = perf_event_create(config)) == NULL)
+        return -1;
+    perf_counter_enable(h, PERF_COUNTER_ENABLE);
+
+    /* prime the counters and previous values */
+    perf_get(h, &data, &size, &pdata, &derivedsize);
+
+    nreads = 0;
+    counters = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+        counters = perf_get(h, &data, &size, &pdata, &derivedsize);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *reads = nreads / iterations;
+    *usec = ((end.tv_sec - start.tv_sec) * 1e6 +
+             (end.tv_nsec - start.tv_nsec) / 1e3) / iterations;
+
+    perf_event_destroy(h);
+    perf_counter_destroy(data, size, pdata, derivedsize);
+    return counters;
+}
+
+/* Next count in the sweep 1, 2, 4, ... max, or 0 when done */
+static int next_count(int n, int max)
+{
+    if (n >= max)
+        return 0;
+    return (n * 2 > max) ? max : n * 2;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-c maxcpus] [-e maxevents] [-i iterations]\n", name);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    char config[] = "/tmp/perfevent_bench.XXXXXX";
+    int maxcpus = 0, maxevents = 8, iterations = 100;
+    int nevents, ncpus, counters, reads, fd, c;
+    int sts = 0;
+    double usec;
+
+    while ((c = getopt(argc, argv, "c:e:i:")) != -1) {
+        switch (c) {
+            case 'c':
+                maxcpus = atoi(optarg);
+                break;
+            case 'e':
+                maxevents = atoi(optarg);
+                break;
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc || maxevents < 1 || iterations < 1)
+        usage(argv[0]);
+
+    if ((c = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+        c = 1;
+    if (maxcpus < 1 || maxcpus > c)
+        maxcpus = c;
+
+    if ((fd = mkstemp(config)) < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    printf("%6s %5s %-10s %8s %6s %10s\n",
+           "events", "cpus", "mode", "counters", "reads", "usec/fetch");
+
+    for (nevents = 1; nevents && sts == 0; nevents = next_count(nevents, maxevents)) {
+        for (ncpus = 1; ncpus && sts == 0; ncpus = next_count(ncpus, maxcpus)) {
+            if (write_config(config, nevents, ncpus) < 0) {
+                perror(config);
+                sts = 1;
+                continue;
+            }
+
+            counters = bench(config, 1, iterations, &reads, &usec);
+            if (counters < 0) {
+                fprintf(stderr, "%s: cannot open software perf events\n", argv[0]);
+                sts = 2;
+                continue;
+            }
+            printf("%6d %5d %-10s %8d %6d %10.1f\n",
+                   nevents, ncpus, "individual", counters, reads, usec);
+
+            counters = bench(config, 0, iterations, &reads, &usec);
+            printf("%6d %5d %-10s %8d %6d %10.1f\n",
+                   nevents, ncpus, "grouped", counters, reads, usec);
+        }
+    }
+
+    unlink(config);
+    return sts;
+}
@@ -0,0 +1,117 @@
+//
+// Test QmcGroup::fetchAsync with a local context (which must be fetched
+// in the calling thread, else PM_ERR_THREAD from the DSO PMDAs), and
+// optionally a host context alongside it.  The values from each
+// asynchronous fetch are reported, then those of a synchronous fetch.
+//
+
+#include <QCoreApplication>
+#include <QTextStream>
+#include <qmc_group.h>
+#include <qmc_metric.h>
+
+QTextStream cerr(stderr);
+QTextStream cout(stdout);
+
+static const char *localMetrics[] = {
+    "@:sampledso.long.hundred", "@:sampledso.bin",
+};
+static const char *hostMetrics[] = {
+    "sample.long.hundred", "sample.bin",
+};
+
+static void
+report(const char *kind, int count, QList<QmcMetric *> const &metrics)
+{
+    for (int i = 0; i < metrics.size(); i++) {
+	QmcMetric *metric = metrics[i];
+
+	cout << kind << ' ' << count << ": " << metric->name() << ':';
+	for (int j = 0; j < metric->numValues(); j++) {
+	    if (metric->error(j) < 0)
+		cout << ' ' << pmErrStr(metric->error(j));
+	    else
+		cout << ' ' << metric->value(j);
+	}
+	cout << Qt::endl;
+    }
+}
+
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Receiver(QmcGroup *group, QList<QmcMetric *> const &metrics, int fetches)
+	: my_group(group), my_metrics(metrics), my_fetches(fetches),
+	  my_count(0) {}
+
+public slots:
+    void fetched(int generation)
+    {
+	if (my_group->fetchComplete(generation) == false) {
+	    cout << "fetch " << generation << " superseded" << Qt::endl;
+	    return;
+	}
+	report("async", ++my_count, my_metrics);
+	if (my_count < my_fetches)
+	    my_group->fetchAsync(this, "fetched");
+	else
+	    QCoreApplication::quit();
+    }
+
+private:
+    QmcGroup *my_group;
+    QList<QmcMetric *> my_metrics;
+    int my_fetches;
+    int my_count;
+};
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QList<QmcMetric *> metrics;
+    QmcGroup group;
+    QString spec;
+    unsigned int i;
+    int fetches = 3;
+
+    pmSetProgname(argv[0]);
+    if (argc > 2) {
+	cerr << "Usage: " << pmGetProgname() << " [host]" << Qt::endl;
+	exit(1);
+	/*NOTREACHED*/
+    }
+
+    for (i = 0; i < sizeof(localMetrics) / sizeof(localMetrics[0]); i++)
+	metrics.append(group.addMetric(localMetrics[i]));
+    if (argc == 2) {
+	for (i = 0; i < sizeof(hostMetrics) / sizeof(hostMetrics[0]); i++) {
+	    spec = QString(argv[1]) + ':' + hostMetrics[i];
+	    metrics.append(group.addMetric(spec.toLatin1().constData()));
+	}
+    }
+    pmflush();
+    for (i = 0; i < (unsigned int)metrics.size(); i++) {
+	if (metrics[i]->status() < 0) {
+	    cerr << pmGetProgname() << ": " << metrics[i]->name() << ": "
+		 << pmErrStr(metrics[i]->status()) << Qt::endl;
+	    exit(1);
+	    /*NOTREACHED*/
+	}
+    }
+    cout << "contexts: " << group.numContexts()
+	 << ", metrics: " << metrics.size() << Qt::endl;
+
+    Receiver receiver(&group, metrics, fetches);
+    group.fetchAsync(&receiver, "fetched");
+    app.exec();
+
+    group.fetch();
+    report("sync", 1, metrics);
+
+    return 0;
+}
+
+#include "qmc_fetchasync.moc"
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * pmFetchGroup value extraction microbenchmark - registers one item
+ * per metric/instance pair (by default 10 metrics with 1000 instances,
+ * so 10,000 items) plus one indom item per metric from the MMV file
+ * generated by mmv_bigindom, then times repeated pmFetchGroup calls
+ * and checks every value extracted.
+ */
+#include <pcp/pmapi.h>
+#include <sys/time.h>
+
+int
+main(int ac, char * av[])
+{
+    char		*prefix = (ac > 1) ? av[1] : "mmv.mmv_bigindom";
+    int			nmetrics = (ac > 2) ? atoi(av[2]) : 10;
+    int			ninsts = (ac > 3) ? atoi(av[3]) : 1000;
+    int			nfetch = (ac > 4) ? atoi(av[4]) : 100;
+    int			i, j, k, sts, errors = 0;
+    char		name[MAXPATHLEN], inst[64];
+    pmAtomValue		*values, *ivalues;
+    int			*stss, *istss, *icodes, *inum, *ists;
+    struct timeval	start, end;
+    double		elapsed;
+    pmFG		fg;
+
+    if (nmetrics < 1 || ninsts < 1 || nfetch < 1) {
+	fprintf(stderr, "Usage: %s [prefix [metrics [instances [fetches]]]]\n", av[0]);
+	return 1;
+    }
+    values = calloc(nmetrics * ninsts, sizeof(pmAtomValue));
+    stss = calloc(nmetrics * ninsts, sizeof(int));
+    ivalues = calloc(nmetrics * ninsts, sizeof(pmAtomValue));
+    istss = calloc(nmetrics * ninsts, sizeof(int));
+    icodes = calloc(nmetrics * ninsts, sizeof(int));
+    inum = calloc(nmetrics, sizeof(int));
+    ists = calloc(nmetrics, sizeof(int));
+    if (!values || !stss || !ivalues || !istss || !icodes || !inum || !ists) {
+	fprintf(stderr, "%s: out of memory\n", av[0]);
+	return 1;
+    }
+
+    if ((sts = pmCreateFetchGroup(&fg, PM_CONTEXT_HOST, "local:")) < 0) {
+	fprintf(stderr, "pmCreateFetchGroup: %s\n", pmErrStr(sts));
+	return 1;
+    }
+    for (i = 0; i < nmetrics; i++) {
+	pmsprintf(name, sizeof(name), "%s.m%d", prefix, i);
+	for (j = 0; j < ninsts; j++) {
+	    pmsprintf(inst, sizeof(inst), "i%d", j);
+	    k = i * ninsts + j;
+	    sts = pmExtendFetchGroup_item(fg, name, inst, NULL,
+				&values[k], PM_TYPE_U64, &stss[k]);
+	    if (sts < 0) {
+		fprintf(stderr, "pmExtendFetchGroup_item(%s[%s]): %s\n",
+			name, inst, pmErrStr(sts));
+		return 1;
+	    }
+	}
+	k = i * ninsts;
+	sts = pmExtendFetchGroup_indom(fg, name, NULL, &icodes[k], NULL,
+				&ivalues[k], PM_TYPE_U64, &istss[k],
+				ninsts, (unsigned int *)&inum[i], &ists[i]);
+	if (sts < 0) {
+	    fprintf(stderr, "pmExtendFetchGroup_indom(%s): %s\n",
+		    name, pmErrStr(sts));
+	    return 1;
+	}
+    }
+    printf("%d items, %d indom items\n", nmetrics * ninsts, nmetrics);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < nfetch; i++) {
+	if ((sts = pmFetchGroup(fg)) < 0) {
+	    fprintf(stderr, "pmFetchGroup: %s\n", pmErrStr(sts));
+	    return 1;
+	}
+    }
+    gettimeofday(&end, NULL);
+    elapsed = pmtimevalSub(&end, &start);
+    fprintf(stderr, "%d fetches in %.6f sec, %.6f msec per fetch\n",
+	    nfetch, elapsed, elapsed * 1000 / nfetch);
+
+    for (i = 0; i < nmetrics; i++) {
+	if (ists[i] < 0 || inum[i] != ninsts) {
+	    if (errors++ < 10)
+		printf("m%d: indom sts %d numinst %d\n", i, ists[i], inum[i]);
+	}
+	for (j = 0; j < ninsts; j++) {
+	    k = i * ninsts + j;
+	    if (stss[k] < 0 || values[k].ull != (__uint64_t)k) {
+		if (errors++ < 10)
+		    printf("m%d[i%d]: sts %d value %llu\n", i, j, stss[k],
+			    (unsigned long long)values[k].ull);
+	    }
+	    if (j >= inum[i])
+		continue;
+	    if (istss[k] < 0 ||
+		ivalues[k].ull != (__uint64_t)(i * ninsts + icodes[k])) {
+		if (errors++ < 10)
+		    printf("m%d indom[%d]: sts %d inst %d value %llu\n", i, j,
+			    istss[k], icodes[k],
+			    (unsigned long long)ivalues[k].ull);
+	    }
+	}
+    }
+    printf("%d errors\n", errors);
+
+    pmDestroyFetchGroup(fg);
+    return errors != 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * Exercise interned label sets: parse each JSONB argument twice and
+ * check both intern to the one shared set, then check merges of the
+ * interned sets against pmMergeLabelSets(3) and the merge cache.
+ */
+
+#include <pcp/pmapi.h>
+#include "libpcp.h"
+
+#define MAXSETS	6
+
+int
+main(int argc, char **argv)
+{
+    pmLabelSet	*parsed[MAXSETS], *again[MAXSETS];
+    pmLabelSet	*sets[MAXSETS], *copy, *merged, *cached;
+    char	buffer[PM_MAXLABELJSONLEN];
+    int		c, i, sts, nsets;
+    int		errflag = 0;
+
+    pmSetProgname(argv[0]);
+
+    while ((c = getopt(argc, argv, "D:")) != EOF) {
+	switch (c) {
+	case 'D':	/* debug options */
+	    if ((sts = pmSetDebug(optarg)) < 0) {
+		fprintf(stderr, "%s: unrecognized debug options specification (%s)\n",
+		    pmGetProgname(), optarg);
+		errflag++;
+	    }
+	    break;
+
+	case '?':
+	default:
+	    errflag++;
+	    break;
+	}
+    }
+
+    nsets = argc - optind;
+    if (errflag || nsets < 1 || nsets > MAXSETS) {
+	fprintf(stderr, "Usage: %s [-D debug] json ... (at most %d)\n",
+		pmGetProgname(), MAXSETS);
+	exit(1);
+    }
+
+    for (i = 0; i < nsets; i++) {
+	const char	*json = argv[optind + i];
+
+	if ((sts = __pmParseLabelSet(json, strlen(json), 0, &parsed[i])) < 0 ||
+	    (sts = __pmParseLabelSet(json, strlen(json), 0, &again[i])) < 0) {
+	    fprintf(stderr, "__pmParseLabelSet(%s): %s\n", json, pmErrStr(sts));
+	    exit(1);
+	}
+	sets[i] = __pmInternLabelSet(parsed[i]);
+	copy = __pmInternLabelSet(again[i]);
+	printf("set[%d] %s: %d labels, %s\n", i,
+		sets[i]->json ? sets[i]->json : "(none)", sets[i]->nlabels,
+		sets[i] == copy ? "shared" : "NOT shared");
+	if (sets[i] == parsed[i])
+	    printf("set[%d]: interned set is the source set\n", i);
+	__pmReleaseLabelSet(copy);
+
+	/* same content for another instance is a different set */
+	again[i]->inst = 42;
+	copy = __pmInternLabelSet(again[i]);
+	if (copy == sets[i])
+	    printf("set[%d]: instance 42 shares the set\n", i);
+	__pmReleaseLabelSet(copy);
+    }
+
+    if ((sts = pmMergeLabelSets(sets, nsets, buffer, sizeof(buffer), NULL, NULL)) < 0) {
+	fprintf(stderr, "pmMergeLabelSets: %s\n", pmErrStr(sts));
+	exit(1);
+    }
+    if ((sts = __pmMergeInternedLabelSets(sets, nsets, &merged)) < 0) {
+	fprintf(stderr, "__pmMergeInternedLabelSets: %s\n", pmErrStr(sts));
+	exit(1);
+    }
+    printf("merged: %s (%d labels)\n", merged->json ? merged->json : "", merged->nlabels);
+    printf("merged: %s pmMergeLabelSets\n",
+	    merged->json && strcmp(merged->json, buffer) == 0 ? "matches" : "DIFFERS from");
+    for (i = 0; i < merged->nlabels; i++)
+	printf("    %.*s = %.*s\n",
+		merged->labels[i].namelen, merged->json + merged->labels[i].name,
+		merged->labels[i].valuelen, merged->json + merged->labels[i].value);
+
+    if ((sts = __pmMergeInternedLabelSets(sets, nsets, &cached)) < 0) {
+	fprintf(stderr, "__pmMergeInternedLabelSets: %s\n", pmErrStr(sts));
+	exit(1);
+    }
+    printf("merged again: %s set\n", cached == merged ? "same" : "DIFFERENT");
+    __pmReleaseLabelSet(cached);
+
+    /* merges of sets that are not interned are not cached, still correct */
+    if ((sts = __pmMergeInternedLabelSets(parsed, nsets, &cached)) < 0) {
+	fprintf(stderr, "__pmMergeInternedLabelSets: %s\n", pmErrStr(sts));
+	exit(1);
+    }
+    printf("merged from parsed sets: %s set\n", cached == merged ? "same" : "DIFFERENT");
+    __pmReleaseLabelSet(cached);
+    __pmReleaseLabelSet(merged);
+
+    for (i = 0; i < nsets; i++) {
+	__pmReleaseLabelSet(sets[i]);
+	pmFreeLabelSets(parsed[i], 1);
+	pmFreeLabelSets(again[i], 1);
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * Repeated metadata lookups against a host context, reporting the
+ * number of PDUs sent to pmcd for each round of lookups.  Used with
+ * and without $PCP_METADATA_CACHE to exercise the client-side cache.
+ */
+
+#include <pcp/pmapi.h>
+#include "libpcp.h"
+
+static unsigned int
+pdus_out(void)
+{
+    unsigned int	sum = 0;
+    int			i;
+
+    for (i = 0; i <= PDU_MAX; i++)
+	sum += __pmPDUCntOut[i];
+    return sum;
+}
+
+static void
+lookups(const char *name, int verbose)
+{
+    pmID	pmid;
+    pmDesc	desc;
+    pmLabelSet	*sets;
+    char	*text, **names, *iname;
+    int		*instlist, inst;
+    int		sts, i, n;
+
+    if ((sts = pmLookupName(1, &name, &pmid)) < 0) {
+	printf("pmLookupName(%s): %s\n", name, pmErrStr(sts));
+	return;
+    }
+    if ((sts = pmLookupDesc(pmid, &desc)) < 0) {
+	printf("pmLookupDesc(%s): %s\n", name, pmErrStr(sts));
+	return;
+    }
+    if ((sts = pmLookupDescs(1, &pmid, &desc)) < 0)
+	printf("pmLookupDescs(%s): %s\n", name, pmErrStr(sts));
+    if (verbose)
+	pmPrintDesc(stdout, &desc);
+
+    if ((sts = pmNameID(pmid, &iname)) < 0)
+	printf("pmNameID(%s): %s\n", name, pmErrStr(sts));
+    else {
+	if (verbose)
+	    printf("    name: %s\n", iname);
+	free(iname);
+    }
+    if ((n = pmNameAll(pmid, &names)) < 0)
+	printf("pmNameAll(%s): %s\n", name, pmErrStr(n));
+    else {
+	for (i = 0; verbose && i < n; i++)
+	    printf("    names[%d]: %s\n", i, names[i]);
+	free(names);
+    }
+
+    if ((sts = pmLookupText(pmid, PM_TEXT_ONELINE, &text)) == 0) {
+	if (verbose)
+	    printf("    text: %s\n", text);
+	free(text);
+    }
+
+    if ((n = pmLookupLabels(pmid, &sets)) < 0)
+	printf("pmLookupLabels(%s): %s\n", name, pmErrStr(n));
+    else {
+	for (i = 0; verbose && i < n; i++)
+	    printf("    labels[%d]: %s\n", i, sets[i].json ? sets[i].json : "");
+	pmFreeLabelSets(sets, n);
+    }
+
+    if (desc.indom == PM_INDOM_NULL)
+	return;
+    if ((n = pmGetInDom(desc.indom, &instlist, &names)) < 0) {
+	printf("pmGetInDom(%s): %s\n", name, pmErrStr(n));
+	return;
+    }
+    for (i = 0; i < n; i++) {
+	if ((sts = pmNameInDom(desc.indom, instlist[i], &iname)) < 0)
+	    printf("pmNameInDom(%s, %d): %s\n", name, instlist[i], pmErrStr(sts));
+	else {
+	    if (strcmp(iname, names[i]) != 0)
+		printf("pmNameInDom(%s, %d): %s != %s\n", name, instlist[i], iname, names[i]);
+	    free(iname);
+	}
+	if ((inst = pmLookupInDom(desc.indom, names[i])) < 0)
+	    printf("pmLookupInDom(%s, %s): %s\n", name, names[i], pmErrStr(inst));
+	else if (inst != instlist[i])
+	    printf("pmLookupInDom(%s, %s): %d != %d\n", name, names[i], inst, instlist[i]);
+	else if (verbose)
+	    printf("    inst [%d or \"%s\"]\n", inst, names[i]);
+    }
+    if (n > 0) {
+	free(instlist);
+	free(names);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    int		c, sts, i, r;
+    int		rounds = 3;
+    int		errflag = 0;
+    char	*host = "local:";
+    pmID	pmid;
+    pmResult	*result;
+    unsigned int before;
+
+    pmSetProgname(argv[0]);
+
+    while ((c = getopt(argc, argv, "D:h:r:")) != EOF) {
+	switch (c) {
+	case 'D':	/* debug options */
+	    if ((sts = pmSetDebug(optarg)) < 0) {
+		fprintf(stderr, "%s: unrecognized debug options specification (%s)\n",
+		    pmGetProgname(), optarg);
+		errflag++;
+	    }
+	    break;
+
+	case 'h':	/* contact PMCD on this hostname */
+	    host = optarg;
+	    break;
+
+	case 'r':	/* rounds of lookups */
+	    rounds = atoi(optarg);
+	    break;
+
+	case '?':
+	default:
+	    errflag++;
+	    break;
+	}
+    }
+
+    if (errflag || optind >= argc) {
+	fprintf(stderr, "Usage: %s [-D debug] [-h host] [-r rounds] metric ...\n",
+		pmGetProgname());
+	exit(1);
+    }
+
+    if ((sts = pmNewContext(PM_CONTEXT_HOST, host)) < 0) {
+	fprintf(stderr, "pmNewContext(%s): %s\n", host, pmErrStr(sts));
+	exit(1);
+    }
+
+    for (r = 0; r < rounds; r++) {
+	before = pdus_out();
+	for (i = optind; i < argc; i++)
+	    lookups(argv[i], r == 0);
+	printf("round %d: %u PDUs\n", r, pdus_out() - before);
+
+	/* a fetch between rounds, as a monitoring tool would do */
+	if (pmLookupName(1, (const char **)&argv[optind], &pmid) >= 0 &&
+	    (sts = pmFetch(1, &pmid, &result)) >= 0)
+	    pmFreeResult(result);
+    }
+
+    return 0;
+}
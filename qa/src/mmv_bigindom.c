@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * Generate a large MMV file (by default 100 metrics each with 1000
+ * instances, so 100,000 values) to exercise pmdammv value lookups.
+ * Each value is set to metric * instances + instance for checking.
+ * Metric items are spaced by the given stride (default 1), and given
+ * a dup argument a singular metric "dup" reuses the first item.
+ */
+#include <pcp/pmapi.h>
+#include <pcp/mmv_stats.h>
+#include <pcp/mmv_dev.h>
+
+int
+main(int ac, char * av[])
+{
+    char		*file = (ac > 1) ? av[1] : "mmv_bigindom";
+    int			nmetrics = (ac > 2) ? atoi(av[2]) : 100;
+    int			ninsts = (ac > 3) ? atoi(av[3]) : 1000;
+    int			stride = (ac > 4) ? atoi(av[4]) : 1;
+    int			dup = (ac > 5);
+    int			i, j;
+    void		*addr;
+    char		name[64], inst[64];
+    mmv_disk_header_t	*hdr;
+    mmv_disk_toc_t	*toc;
+    mmv_disk_value_t	*values;
+    mmv_disk_metric_t	*metric1;
+    mmv_disk_metric2_t	*metric2;
+    mmv_disk_instance_t	*instance1;
+    mmv_disk_instance2_t *instance2;
+    __uint32_t		item, indom, internal;
+    pmUnits		units = MMV_UNITS(0,0,1,0,0,PM_COUNT_ONE);
+    mmv_registry_t	*registry = mmv_stats_registry(file, 0, 0);
+
+    if (!registry) {
+	fprintf(stderr, "mmv_stats_registry: %s - %s\n", file, strerror(errno));
+	return 1;
+    }
+    if (nmetrics < 1 || nmetrics > 1023 || ninsts < 1 || stride < 1 ||
+	(nmetrics - 1) * stride + 1 > 1023) {
+	fprintf(stderr, "Usage: %s [file [metrics [instances [stride [dup]]]]]\n", av[0]);
+	return 1;
+    }
+
+    mmv_stats_add_indom(registry, 1, "big indom", NULL);
+    for (j = 0; j < ninsts; j++) {
+	pmsprintf(inst, sizeof(inst), "i%d", j);
+	mmv_stats_add_instance(registry, 1, j, strdup(inst));
+    }
+    for (i = 0; i < nmetrics; i++) {
+	pmsprintf(name, sizeof(name), "m%d", i);
+	mmv_stats_add_metric(registry, strdup(name), i * stride + 1,
+			MMV_TYPE_U64, MMV_SEM_INSTANT, units, 1,
+			"big indom metric", NULL);
+    }
+    if (dup)
+	mmv_stats_add_metric(registry, "dup", 1, MMV_TYPE_U64,
+			MMV_SEM_INSTANT, units, 0,
+			"duplicate item metric", NULL);
+
+    addr = mmv_stats_start(registry);
+    if (!addr) {
+	fprintf(stderr, "mmv_stats_start: %s - %s\n", file, strerror(errno));
+	return 1;
+    }
+
+    /*
+     * Walk the values section directly, as per-value lookups through
+     * mmv_lookup_value_desc() are linear in the number of values.
+     */
+    hdr = (mmv_disk_header_t *)addr;
+    toc = (mmv_disk_toc_t *)((char *)addr + sizeof(mmv_disk_header_t));
+    for (i = 0; i < hdr->tocs; i++) {
+	if (toc[i].type != MMV_TOC_VALUES)
+	    continue;
+	values = (mmv_disk_value_t *)((char *)addr + toc[i].offset);
+	for (j = 0; j < toc[i].count; j++) {
+	    if (hdr->version == MMV_VERSION1) {
+		metric1 = (mmv_disk_metric_t *)((char *)addr + values[j].metric);
+		instance1 = (mmv_disk_instance_t *)((char *)addr + values[j].instance);
+		item = metric1->item;
+		indom = metric1->indom;
+		internal = indom ? instance1->internal : 0;
+	    } else {
+		metric2 = (mmv_disk_metric2_t *)((char *)addr + values[j].metric);
+		instance2 = (mmv_disk_instance2_t *)((char *)addr + values[j].instance);
+		item = metric2->item;
+		indom = metric2->indom;
+		internal = indom ? instance2->internal : 0;
+	    }
+	    if (indom)
+		values[j].value.ull = (__uint64_t)(item - 1) / stride * ninsts + internal;
+	    else	/* the dup metric */
+		values[j].value.ull = 424242;
+	}
+    }
+
+    mmv_stats_stop(file, addr);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * Load the mmv PMDA DSO, fetch the given metrics via pmdaFetch using
+ * the PMDA's batch fetch callback, then again after removing it (so
+ * each value comes from the per-instance fetch callback) and report
+ * any differences between the two results.
+ */
+
+#include <pcp/pmapi.h>
+#include <pcp/pmda.h>
+#include <dlfcn.h>
+
+static pmdaInterface	dispatch;
+
+static int
+compare(int numpmid, pmValueSet **batch, pmValueSet **single, char **names)
+{
+    pmValueSet		*bvsp, *svsp;
+    pmAtomValue		ba, sa;
+    pmDesc		desc;
+    int			i, j, sts, diffs = 0;
+
+    for (i = 0; i < numpmid; i++) {
+	bvsp = batch[i];
+	svsp = single[i];
+	if (bvsp->numval != svsp->numval) {
+	    printf("%s: numval %d (batch) vs %d\n",
+		    names[i], bvsp->numval, svsp->numval);
+	    diffs++;
+	    continue;
+	}
+	if (bvsp->numval <= 0)
+	    continue;
+	if (bvsp->valfmt != svsp->valfmt) {
+	    printf("%s: valfmt %d (batch) vs %d\n",
+		    names[i], bvsp->valfmt, svsp->valfmt);
+	    diffs++;
+	}
+	if ((sts = dispatch.version.any.desc(bvsp->pmid, &desc,
+				dispatch.version.any.ext)) < 0) {
+	    printf("%s: desc: %s\n", names[i], pmErrStr(sts));
+	    diffs++;
+	    continue;
+	}
+	for (j = 0; j < bvsp->numval; j++) {
+	    if (bvsp->vlist[j].inst != svsp->vlist[j].inst) {
+		printf("%s: value[%d] inst %d (batch) vs %d\n", names[i], j,
+			bvsp->vlist[j].inst, svsp->vlist[j].inst);
+		diffs++;
+		continue;
+	    }
+	    pmExtractValue(bvsp->valfmt, &bvsp->vlist[j], desc.type, &ba, desc.type);
+	    pmExtractValue(svsp->valfmt, &svsp->vlist[j], desc.type, &sa, desc.type);
+	    if (desc.type == PM_TYPE_STRING) {
+		sts = strcmp(ba.cp, sa.cp);
+		free(ba.cp);
+		free(sa.cp);
+	    }
+	    else
+		sts = memcmp(&ba, &sa, sizeof(ba));
+	    if (sts != 0) {
+		printf("%s: inst %d values differ\n",
+			names[i], bvsp->vlist[j].inst);
+		diffs++;
+	    }
+	}
+    }
+    return diffs;
+}
+
+int
+main(int argc, char **argv)
+{
+    void		(*init)(pmdaInterface *);
+    void		*handle;
+    pmdaResult		*result;
+    pmValueSet		**batch;
+    pmID		*pmids;
+    int			i, sts, numval;
+
+    pmSetProgname(argv[0]);
+    if (argc < 3) {
+	fprintf(stderr, "Usage: %s dso metric ...\n", pmGetProgname());
+	exit(1);
+    }
+    if ((handle = dlopen(argv[1], RTLD_NOW)) == NULL) {
+	fprintf(stderr, "%s: dlopen: %s\n", pmGetProgname(), dlerror());
+	exit(1);
+    }
+    if ((init = (void (*)(pmdaInterface *))dlsym(handle, "mmv_init")) == NULL) {
+	fprintf(stderr, "%s: dlsym: %s\n", pmGetProgname(), dlerror());
+	exit(1);
+    }
+
+    memset(&dispatch, 0, sizeof(dispatch));
+    dispatch.domain = 70;
+    dispatch.comm.pmda_interface = 0xff;
+    dispatch.comm.pmapi_version = PMAPI_VERSION_2 & 0xff;
+    (*init)(&dispatch);
+    if (dispatch.status != 0) {
+	fprintf(stderr, "%s: mmv_init: %s\n", pmGetProgname(), pmErrStr(dispatch.status));
+	exit(1);
+    }
+
+    argc -= 2;
+    argv += 2;
+    if ((pmids = (pmID *)malloc(argc * sizeof(pmID))) == NULL ||
+	(batch = (pmValueSet **)malloc(argc * sizeof(pmValueSet *))) == NULL) {
+	fprintf(stderr, "%s: out of memory\n", pmGetProgname());
+	exit(1);
+    }
+    for (i = 0; i < argc; i++) {
+	if ((sts = dispatch.version.four.pmid(argv[i], &pmids[i],
+				dispatch.version.any.ext)) < 0) {
+	    fprintf(stderr, "%s: %s: %s\n", pmGetProgname(), argv[i], pmErrStr(sts));
+	    exit(1);
+	}
+    }
+
+    if ((sts = dispatch.version.any.fetch(argc, pmids, &result,
+				dispatch.version.any.ext)) < 0) {
+	fprintf(stderr, "%s: batch fetch: %s\n", pmGetProgname(), pmErrStr(sts));
+	exit(1);
+    }
+    /* pmdaFetch reuses its result, but the value sets are new each time */
+    memcpy(batch, result->vset, argc * sizeof(pmValueSet *));
+
+    pmdaSetFetchBatchCallBack(&dispatch, NULL);
+    if ((sts = dispatch.version.any.fetch(argc, pmids, &result,
+				dispatch.version.any.ext)) < 0) {
+	fprintf(stderr, "%s: per-instance fetch: %s\n", pmGetProgname(), pmErrStr(sts));
+	exit(1);
+    }
+
+    for (i = numval = 0; i < argc; i++)
+	numval += batch[i]->numval > 0 ? batch[i]->numval : 0;
+    printf("%d metrics, %d values\n", argc, numval);
+    if ((sts = compare(argc, batch, result->vset, argv)) == 0)
+	printf("batch and per-instance fetch results match\n");
+    else
+	printf("%d differences\n", sts);
+
+    return sts != 0;
+}
@@ -19,9 +19,16 @@ main(int argc, char **argv)
 
     pmSetProgname(argv[0]);
 
-    while ((c = getopt(argc, argv, "Cc:D:df:h:LSs:")) != EOF) {
+    while ((c = getopt(argc, argv, "BCc:D:df:h:LRSs:")) != EOF) {
 	switch (c) {
 
+	case 'B':
+	    sts = pmdaCacheOp(indom, PMDA_CACHE_BINARY);
+	    fprintf(stderr, "binary(%s) -> %d", pmInDomStr(indom), sts);
+	    if (sts < 0) fprintf(stderr, " %s", pmErrStr(sts));
+	    fputc('\n', stderr);
+	    break;
+
 	case 'C':
 	    sts = pmdaCacheOp(indom, PMDA_CACHE_CULL);
 	    fprintf(stderr, "cull(%s) -> %d", pmInDomStr(indom), sts);
@@ -76,6 +83,13 @@ main(int argc, char **argv)
 	    fputc('\n', stderr);
 	    break;
 
+	case 'R':
+	    sts = pmdaCacheOp(indom, PMDA_CACHE_REORG);
+	    fprintf(stderr, "reorg(%s) -> %d", pmInDomStr(indom), sts);
+	    if (sts < 0) fprintf(stderr, " %s", pmErrStr(sts));
+	    fputc('\n', stderr);
+	    break;
+
 	case 'S':
 	    sts = pmdaCacheOp(indom, PMDA_CACHE_SAVE);
 	    fprintf(stderr, "save(%s) -> %d", pmInDomStr(indom), sts);
@@ -100,6 +114,7 @@ main(int argc, char **argv)
     if (errflag) {
 	fprintf(stderr, "Usage: %s ...\n", pmGetProgname());
 	fprintf(stderr, "options:\n");
+	fprintf(stderr, "-B             save in binary format\n");
 	fprintf(stderr, "-C             cull all\n");
 	fprintf(stderr, "-c inst        cull one inst\n");
 	fprintf(stderr, "-D debug\n");
@@ -108,6 +123,7 @@ main(int argc, char **argv)
 	fprintf(stderr, "               (implies -L)\n");
 	fprintf(stderr, "-h inst        hide\n");
 	fprintf(stderr, "-L             load\n");
+	fprintf(stderr, "-R             reorg\n");
 	fprintf(stderr, "-S             store\n");
 	fprintf(stderr, "-s inst        add one inst\n");
 	exit(1);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * pmdaCache lookup microbenchmark - populates a number of instance
+ * domains (by default 50 indoms with 2000 instances each), culls
+ * every tenth instance, then times repeated lookups by instance name
+ * and identifier interleaved across all the indoms (the access pattern
+ * of a PMDA fetch walking several indoms) and checks every result.
+ */
+#include <pcp/pmapi.h>
+#include <pcp/pmda.h>
+#include <sys/time.h>
+
+int
+main(int ac, char * av[])
+{
+    int			nindoms = (ac > 1) ? atoi(av[1]) : 50;
+    int			ninsts = (ac > 2) ? atoi(av[2]) : 2000;
+    int			nloops = (ac > 3) ? atoi(av[3]) : 20;
+    int			d, i, l, sts, inst, errors = 0;
+    int			nlookups = 0;
+    char		name[64];
+    char		**names;
+    char		*np;
+    pmInDom		indom;
+    struct timeval	start, end;
+    double		elapsed;
+
+    if (nindoms < 1 || ninsts < 1 || nloops < 1) {
+	fprintf(stderr, "Usage: %s [indoms [instances [loops]]]\n", av[0]);
+	return 1;
+    }
+    pmSetProgname(av[0]);
+    if ((names = calloc(nindoms * ninsts, sizeof(char *))) == NULL) {
+	fprintf(stderr, "%s: out of memory\n", av[0]);
+	return 1;
+    }
+
+    gettimeofday(&start, NULL);
+    for (d = 0; d < nindoms; d++) {
+	indom = pmInDom_build(242, d);
+	for (i = 0; i < ninsts; i++) {
+	    pmsprintf(name, sizeof(name), "inst-%d-%d", d, i);
+	    names[d * ninsts + i] = strdup(name);
+	    if ((sts = pmdaCacheStore(indom, PMDA_CACHE_ADD, name, NULL)) != i) {
+		if (errors++ < 10)
+		    printf("store %s: got %d\n", name, sts);
+	    }
+	}
+	for (i = 0; i < ninsts; i += 10) {
+	    if ((sts = pmdaCacheStore(indom, PMDA_CACHE_CULL,
+				names[d * ninsts + i], NULL)) != i) {
+		if (errors++ < 10)
+		    printf("cull %s: got %d\n", names[d * ninsts + i], sts);
+	    }
+	}
+    }
+    gettimeofday(&end, NULL);
+    elapsed = pmtimevalSub(&end, &start);
+    printf("%d indoms, %d instances each\n", nindoms, ninsts);
+    fprintf(stderr, "populate: %.6f sec\n", elapsed);
+
+    gettimeofday(&start, NULL);
+    for (l = 0; l < nloops; l++) {
+	for (i = 0; i < ninsts; i++) {
+	    for (d = 0; d < nindoms; d++) {
+		indom = pmInDom_build(242, d);
+		np = names[d * ninsts + i];
+		sts = pmdaCacheLookupName(indom, np, &inst, NULL);
+		nlookups++;
+		if (i % 10 == 0) {
+		    if (sts != PM_ERR_INST) {
+			if (errors++ < 10)
+			    printf("lookup culled %s: got %d\n", np, sts);
+		    }
+		    continue;
+		}
+		if (sts != PMDA_CACHE_ACTIVE || inst != i) {
+		    if (errors++ < 10)
+			printf("lookup %s: got %d inst %d\n", np, sts, inst);
+		}
+		sts = pmdaCacheLookup(indom, i, &np, NULL);
+		nlookups++;
+		if (sts != PMDA_CACHE_ACTIVE ||
+		    strcmp(np, names[d * ninsts + i]) != 0) {
+		    if (errors++ < 10)
+			printf("lookup %d: got %d\n", i, sts);
+		}
+	    }
+	}
+    }
+    gettimeofday(&end, NULL);
+    elapsed = pmtimevalSub(&end, &start);
+    fprintf(stderr, "%d lookups in %.6f sec, %.3f usec per lookup\n",
+	    nlookups, elapsed, elapsed * 1000000 / nlookups);
+
+    printf("%d errors\n", errors);
+    return errors != 0;
+}
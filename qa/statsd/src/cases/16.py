@@ -0,0 +1,66 @@
+#!/usr/bin/env pmpython
+# -*- coding: utf-8 -*-
+
+# Exercises sharded aggregation: concurrent senders spread over several
+# aggregator shards, including a metric name longer than the hashtable key
+
+import sys
+import socket
+import os
+import time
+
+from threading import Thread
+
+utils_path = os.path.abspath(os.path.join("utils"))
+sys.path.append(utils_path)
+
+import pmdastatsd_test_utils as utils
+
+utils.print_test_file_separator()
+print(os.path.basename(__file__))
+
+ip = "0.0.0.0"
+port = 8125
+
+sharded_config = """
+[global]
+max_udp_packet_size = 4096
+parser_threads = 2
+aggregator_shards = 4
+"""
+
+senders = 4
+repeats = 25
+names = ["shard_test_{}".format(i) for i in range(8)]
+# longer than the 2047 characters kept in a metric's hashtable key
+long_name = "shard_test_long_" + "x" * 2100
+
+def send_datagrams():
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    for x in range(repeats):
+        for name in names:
+            sock.sendto("{}:1|c".format(name).encode("utf-8"), (ip, port))
+        sock.sendto("{}:1|c".format(long_name).encode("utf-8"), (ip, port))
+    sock.close()
+
+def run_test():
+    utils.print_test_section_separator()
+    utils.pmdastatsd_install(sharded_config)
+    threads = [Thread(target=send_datagrams) for x in range(senders)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    time.sleep(2)
+    for name in names:
+        utils.print_metric("statsd." + name)
+    # the long name must be recorded once, not once per shard it hashed to
+    utils.print_metric("statsd.pmda.metrics_tracked")
+    output = utils.request_metric("statsd")
+    for line in output.split("\n"):
+        if line.startswith("statsd.shard_test_long_"):
+            print("long metric name length", len(line))
+    utils.pmdastatsd_remove()
+    utils.restore_config()
+
+run_test()
@@ -371,8 +371,18 @@ bozo - unknown size of pointer !!!
  */
 #define FROM_ANON	0
 
+/*
+ * Scatter-gather PDU segment.  The first segment of a PDU starts with
+ * its __pmPDUHdr, and the header len covers all the segments.
+ */
+typedef struct {
+    const void	*base;
+    size_t	len;
+} __pmPDUVec;
+
 /* PDU type independent send-receive routines */
 PCP_CALL extern int __pmXmitPDU(int, __pmPDU *);
+PCP_CALL extern int __pmXmitPDUVec(int, __pmPDUVec *, int);
 PCP_CALL extern int __pmGetPDU(int, int, int, __pmPDU **);
 PCP_CALL extern int __pmSetPDUCeiling(int);
 
@@ -470,6 +480,7 @@ PCP_CALL extern int __pmSetSockOpt(int, int, int, const void *, __pmSockLen);
 PCP_CALL extern ssize_t __pmWrite(int, const void *, size_t);
 PCP_CALL extern ssize_t __pmRead(int, void *, size_t);
 PCP_CALL extern ssize_t __pmSend(int, const void *, size_t, int);
+PCP_CALL extern ssize_t __pmSendVec(int, const __pmPDUVec *, int);
 PCP_CALL extern ssize_t __pmRecv(int, void *, size_t, int);
 PCP_CALL extern int __pmConnectTo(int, const __pmSockAddr *, int);
 PCP_CALL extern int __pmConnectCheckError(int);
@@ -658,6 +669,9 @@ PCP_CALL extern int __pmAddLabels(pmLabelSet **, const char *, int);
 PCP_CALL extern pmLabelSet *__pmDupLabelSets(pmLabelSet *, int);
 PCP_CALL extern int __pmParseLabelSet(const char *, int, int, pmLabelSet **);
 PCP_CALL extern int __pmEqualLabelSet(const pmLabelSet *, const pmLabelSet *);
+PCP_CALL extern pmLabelSet *__pmInternLabelSet(const pmLabelSet *);
+PCP_CALL extern void __pmReleaseLabelSet(pmLabelSet *);
+PCP_CALL extern int __pmMergeInternedLabelSets(pmLabelSet **, int, pmLabelSet **);
 PCP_CALL extern int __pmGetContextLabels(pmLabelSet **);
 PCP_CALL extern int __pmGetDomainLabels(int, const char *, pmLabelSet **);
 
@@ -946,6 +960,7 @@ typedef struct {
     pmProfile		*c_instprof;	/* instance profile */
     void		*c_dm;		/* derived metrics, if any */
     int			c_flags;	/* ctx flags (set via type/env/attrs) */
+    void		*c_metacache;	/* cached pmcd metadata, if enabled */
     __pmHashCtl		c_attrs;	/* various optional context attributes */
     int			c_handle;	/* context number above PMAPI */
     int			c_slot;		/* index to contexts[] below PMAPI */
@@ -1228,6 +1243,17 @@ PCP_CALL extern int __pmProcessPipe(__pmExecCtl_t **, const char *, int, FILE **
 PCP_CALL extern int __pmProcessPipeClose(FILE *);
 PCP_CALL extern void __pmProcessFree(__pmExecCtl_t **);
 
+/*
+ * Persistent pool of worker threads, for callers that repeatedly spread
+ * a batch of tasks across several threads (task i runs as func(arg, i))
+ */
+typedef struct __pmWorkPool __pmWorkPool;
+typedef void (*__pmWorkFunc)(void *, int);
+PCP_CALL extern __pmWorkPool *__pmWorkPoolCreate(void);
+PCP_CALL extern int __pmWorkPoolStart(__pmWorkPool *, int, __pmWorkFunc, void *);
+PCP_CALL extern void __pmWorkPoolWait(__pmWorkPool *);
+PCP_CALL extern void __pmWorkPoolDestroy(__pmWorkPool *);
+
 /* platform independent environment and filesystem path access */
 typedef void (*__pmConfigCallback)(char *, char *, char *);
 PCP_DATA extern const __pmConfigCallback __pmNativeConfig;
@@ -415,6 +415,7 @@ PCP_CALL extern int pmNewContext(int, const char *);
 #define PM_CTXFLAG_METADATA_ONLY	(1U<<16) /* only open .meta file of archive */
 #define PM_CTXFLAG_LAST_VOLUME	(1U<<17) /* open archive at start of last volume */
 #define PM_CTXFLAG_STREAMING_WRITER	(1U<<18) /* streaming log over a network */
+#define PM_CTXFLAG_METADATA_CACHE	(1U<<19) /* cache pmcd metadata replies */
 
 /*
  * Duplicate current context -- returns handle to new one for pmUseContext()
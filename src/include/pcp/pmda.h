@@ -95,6 +95,16 @@ typedef int (*pmdaFetchCallBack)(pmdaMetric *, unsigned int, pmAtomValue *);
 #define PMDA_FETCH_STATIC	1
 #define PMDA_FETCH_DYNAMIC	2	/* free avp->vp after __pmStuffValue */
 
+/*
+ * Type of function call back used by pmdaFetch to fill in the values of
+ * all requested instances of one metric in a single call - arguments are
+ * the metric, the number of instances, the instance list and the value
+ * and status columns to be filled (one entry per instance, with status
+ * using the same return values as a pmdaFetchCallBack method).
+ */
+typedef int (*pmdaFetchBatchCallBack)(pmdaMetric *, int, const unsigned int *,
+					pmAtomValue *, int *);
+
 /*
  * Type of function call back used by pmdaMain to clean up a pmResult structure
  * after a fetch.
@@ -465,7 +475,13 @@ typedef struct pmdaOptions {
  * pmdaSetFetchCallBack
  *      Allows an application specific routine to be specified for completing a
  *      pmAtom structure with a metrics value. This must be set if pmdaFetch is
- *      used as the fetch callback.
+ *      used as the fetch callback (unless a batch callback handles all metrics).
+ *
+ * pmdaSetFetchBatchCallBack
+ *      Allows an application specific routine to be specified for completing
+ *      the values of all requested instances of a metric in one call.  If the
+ *      routine returns PM_ERR_PMID for a metric, pmdaFetch falls back to the
+ *      per-value fetch callback for that metric.
  *
  * pmdaSetCheckCallBack
  *      Allows an application specific routine to be called upon receipt of any
@@ -510,6 +526,7 @@ PMDA_CALL extern void pmdaSendError(pmdaInterface *, int);
 
 PMDA_CALL extern void pmdaSetResultCallBack(pmdaInterface *, pmdaResultCallBack);
 PMDA_CALL extern void pmdaSetFetchCallBack(pmdaInterface *, pmdaFetchCallBack);
+PMDA_CALL extern void pmdaSetFetchBatchCallBack(pmdaInterface *, pmdaFetchBatchCallBack);
 PMDA_CALL extern void pmdaSetCheckCallBack(pmdaInterface *, pmdaCheckCallBack);
 PMDA_CALL extern void pmdaSetDoneCallBack(pmdaInterface *, pmdaDoneCallBack);
 PMDA_CALL extern void pmdaSetEndContextCallBack(pmdaInterface *, pmdaEndContextCallBack);
@@ -741,6 +758,7 @@ PMDA_CALL extern int pmdaCacheResize(pmInDom, int);
 #define PMDA_CACHE_DUMP			19
 #define PMDA_CACHE_DUMP_ALL		20
 #define PMDA_CACHE_WRITE		21
+#define PMDA_CACHE_BINARY		22
 
 /*
  * Internal libpcp_pmda routines.
@@ -24,6 +24,9 @@
 #ifdef HAVE_NETIOAPI_H
 #include <netioapi.h>
 #endif
+#if !defined(IS_MINGW)
+#include <sys/uio.h>
+#endif
 #define SOCKET_INTERNAL
 #include "internal.h"
 
@@ -1507,6 +1510,38 @@ __pmGetSockOpt(int socket, int level, int option_name, void *option_value,
     return getsockopt(socket, level, option_name, option_value, option_len);
 }
 
+/*
+ * Gather-write PDU segments to a socket or pipe, up to PDU_IOV_MAX of
+ * them in one system call.  Like write(2), may write fewer bytes than
+ * the segments hold in total.
+ */
+#define PDU_IOV_MAX	64
+
+ssize_t
+__pmWriteVec(int fd, const __pmPDUVec *vec, int nvec, int socketipc)
+{
+#if defined(IS_MINGW)
+    if (socketipc)
+	return send(fd, vec->base, vec->len, 0);
+    return write(fd, vec->base, vec->len);
+#else
+    struct iovec	iov[PDU_IOV_MAX];
+    struct msghdr	msg;
+    int			i;
+
+    for (i = 0; i < nvec && i < PDU_IOV_MAX; i++) {
+	iov[i].iov_base = (void *)vec[i].base;
+	iov[i].iov_len = vec[i].len;
+    }
+    if (!socketipc)
+	return writev(fd, iov, i);
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = i;
+    return sendmsg(fd, &msg, 0);
+#endif
+}
+
 #if !defined(HAVE_SECURE_SOCKETS)
 
 void
@@ -1642,6 +1677,15 @@ __pmSend(int socket, const void *buffer, size_t length, int flags)
     return send(socket, buffer, length, flags);
 }
 
+ssize_t
+__pmSendVec(int socket, const __pmPDUVec *vec, int nvec)
+{
+    if (socket < 0)
+	return -EBADF;
+
+    return __pmWriteVec(socket, vec, nvec, 1);
+}
+
 ssize_t
 __pmRecv(int socket, void *buffer, size_t length, int flags)
 {
@@ -504,6 +504,7 @@ ctxflags(__pmHashCtl *attrs, int *flags)
     char *name = NULL;
     char *secure = NULL;
     char *container = NULL;
+    char *cache;
     __pmHashNode *node;
 
     if ((node = __pmHashSearch(PCP_ATTR_PROTOCOL, attrs)) != NULL) {
@@ -528,6 +529,9 @@ ctxflags(__pmHashCtl *attrs, int *flags)
 	    *flags |= PM_CTXFLAG_RELAXED;
 	}
     }
+    cache = getenv("PCP_METADATA_CACHE");		/* THREADSAFE */
+    if (cache != NULL && cache[0] != '\0' && strcmp(cache, "0") != 0)
+	*flags |= PM_CTXFLAG_METADATA_CACHE;
     PM_UNLOCK(__pmLock_extcall);
 
     if (__pmHashSearch(PCP_ATTR_COMPRESS, attrs) != NULL)
@@ -1178,6 +1182,7 @@ static struct {
     { PM_CTXFLAG_METADATA_ONLY,	"metadata_only" },
     { PM_CTXFLAG_LAST_VOLUME,	"last_volume" },
     { PM_CTXFLAG_STREAMING_WRITER,	"streaming_writer" },
+    { PM_CTXFLAG_METADATA_CACHE,	"metadata_cache" },
     { 0,			NULL }
 };
 
@@ -1319,6 +1324,7 @@ INIT_CONTEXT:
     new->c_direction = 0;
     new->c_sent = 0;
     new->c_flags = (type & ~PM_CONTEXT_TYPEMASK);
+    new->c_metacache = NULL;
     if ((new->c_instprof = (pmProfile *)calloc(1, sizeof(pmProfile))) == NULL) {
 	/*
 	 * fail : nothing changed -- actually list is changed, but restoring
@@ -1558,6 +1564,9 @@ pmReconnectContext(int handle)
 	}
     }
 
+    /* pmcd may have changed while we were away, so forget its metadata */
+    __pmMetaCacheInvalidate(ctxp, -1);
+
     /* clear any derived metrics and re-bind */
     __dmclosecontext(ctxp);
     __dmopencontext(ctxp);
@@ -2044,6 +2053,7 @@ pmDestroyContext(int handle)
     }
     __pmFreeProfile(ctxp->c_instprof);
     ctxp->c_instprof = NULL;
+    __pmMetaCacheFree(ctxp);
     /* Note: __dmclosecontext sets ctxp->c_dm = NULL */
     __dmclosecontext(ctxp);
     if (pmDebugOptions.context)
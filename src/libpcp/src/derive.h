@@ -63,8 +63,22 @@ typedef struct {		/* dynamic information for an expression node */
     val_t		*last_ivlist;	/* values from previous fetch for delta() or rate() */
     struct timespec	last_stamp;	/* timestamp from previous fetch for rate() */
     int			bind;		/* for N_COLON: BIND_LEFT, _RIGHT or _BOTH */
+    int			plan;		/* DM_PLAN_* evaluation plan from __dmplan() */
+    int			vec_size;	/* allocated length of each vector in vec */
+    void		*vec;		/* scratch operand vectors for planned evaluation */
 } info_t;
 
+/*
+ * Evaluation plans for binary arithmetic operator nodes, chosen by
+ * __dmplan() once the expression has been bound and checked.  Planned
+ * nodes gather their operands into contiguous vectors with a single
+ * type conversion per operand, then apply the operator over the whole
+ * vector.  DM_PLAN_NONE nodes use the per-value bin_op() tree walk.
+ */
+#define DM_PLAN_NONE		0
+#define DM_PLAN_DOUBLE		1	/* PM_TYPE_DOUBLE result */
+#define DM_PLAN_INTEGER		2	/* PM_TYPE_32, _U32, _64 or _U64 result */
+
 typedef struct {			/* for instance filtering */
     int			ftype;		/* F_REGEX or F_EXACT */
     int			inst;		/* internal instance id if ftype == F_EXACT */
@@ -189,6 +203,7 @@ extern void __dmclosecontext(__pmContext *) _PCP_HIDDEN;
 extern int __dmdesc(__pmContext *, int, pmID, pmDesc *) _PCP_HIDDEN;
 extern int __dmprefetch(__pmContext *, int, const pmID *, pmID **) _PCP_HIDDEN;
 extern void __dmpostfetch(__pmContext *, __pmResult **) _PCP_HIDDEN;
+extern void __dmplan(node_t *) _PCP_HIDDEN;
 extern void __dmdumpexpr(node_t *, int) _PCP_HIDDEN;
 extern char *__dmnode_type_str(int) _PCP_HIDDEN;
 extern int __dmhelptext(pmID, int, char **) _PCP_HIDDEN;
@@ -661,6 +661,232 @@ bin_op(int type, int op, pmAtomValue a, int ltype, int lmul, int ldiv, pmAtomVal
     return res;
 }
 
+/*
+ * Choose evaluation plans for the binary arithmetic operator nodes in
+ * a bound and checked expression tree, see DM_PLAN_* in derive.h.
+ * Relational and boolean operators, PM_TYPE_FLOAT results and anything
+ * with non-numeric operands stay with bin_op().
+ */
+void
+__dmplan(node_t *np)
+{
+    if (np == NULL || np->type == N_PATTERN)
+	return;
+    __dmplan(np->left);
+    __dmplan(np->right);
+    if (np->data.info == NULL || np->left == NULL || np->right == NULL)
+	return;
+    np->data.info->plan = DM_PLAN_NONE;
+    if (np->type != N_PLUS && np->type != N_MINUS &&
+	np->type != N_STAR && np->type != N_SLASH)
+	return;
+    if (np->left->desc.type < PM_TYPE_32 ||
+	np->left->desc.type > PM_TYPE_DOUBLE ||
+	np->right->desc.type < PM_TYPE_32 ||
+	np->right->desc.type > PM_TYPE_DOUBLE)
+	return;
+    switch (np->desc.type) {
+	case PM_TYPE_DOUBLE:
+	    np->data.info->plan = DM_PLAN_DOUBLE;
+	    break;
+	case PM_TYPE_32:
+	case PM_TYPE_U32:
+	case PM_TYPE_64:
+	case PM_TYPE_U64:
+	    /* semantics enforce no N_SLASH for integer results */
+	    if (np->type != N_SLASH &&
+		np->left->desc.type <= PM_TYPE_U64 &&
+		np->right->desc.type <= PM_TYPE_U64)
+		np->data.info->plan = DM_PLAN_INTEGER;
+	    break;
+    }
+    if (pmDebugOptions.derive && pmDebugOptions.appl2)
+	fprintf(stderr, "__dmplan: node " PRINTF_P_PFX "%p %s plan=%d\n",
+		np, __dmnode_type_str(np->type), np->data.info->plan);
+}
+
+/*
+ * Gather the values of operand np into v[0] ... v[n-1] as doubles,
+ * with units scaling as per bin_op().  A singular operand is repeated.
+ */
+static void
+plan_load_double(node_t *np, int n, double *v)
+{
+    const val_t	*vp = np->data.info->ivlist;
+    int		count = np->desc.indom == PM_INDOM_NULL ? 1 : n;
+    double	mul = np->data.info->mul_scale;
+    double	div = np->data.info->div_scale;
+    int		k;
+
+    switch (np->desc.type) {
+	case PM_TYPE_32:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.l;
+	    break;
+	case PM_TYPE_U32:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.ul;
+	    break;
+	case PM_TYPE_64:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.ll;
+	    break;
+	case PM_TYPE_U64:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.ull;
+	    break;
+	case PM_TYPE_FLOAT:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.f;
+	    break;
+	case PM_TYPE_DOUBLE:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.d;
+	    break;
+    }
+    if (mul != 1 || div != 1) {
+	for (k = 0; k < count; k++)
+	    v[k] = (v[k] / div) * mul;
+    }
+    for (k = count; k < n; k++)
+	v[k] = v[0];
+}
+
+/*
+ * Gather the values of operand np into v[0] ... v[n-1] as 64-bit
+ * integers, sign or zero extended as per bin_op() promotion rules.
+ * Two's complement arithmetic on these gives the same low-order bits
+ * as the narrower types would, so one integer kernel serves all.
+ */
+static void
+plan_load_integer(node_t *np, int n, __uint64_t *v)
+{
+    const val_t	*vp = np->data.info->ivlist;
+    int		count = np->desc.indom == PM_INDOM_NULL ? 1 : n;
+    int		k;
+
+    switch (np->desc.type) {
+	case PM_TYPE_32:
+	    for (k = 0; k < count; k++)
+		v[k] = (__int64_t)vp[k].value.l;
+	    break;
+	case PM_TYPE_U32:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.ul;
+	    break;
+	case PM_TYPE_64:
+	case PM_TYPE_U64:
+	    for (k = 0; k < count; k++)
+		v[k] = vp[k].value.ull;
+	    break;
+    }
+    for (k = count; k < n; k++)
+	v[k] = v[0];
+}
+
+/*
+ * Planned evaluation of a binary arithmetic operator node, into the
+ * already allocated np->data.info->ivlist[].  Only handles operands
+ * with matching instances (or singular operands), returns -1 without
+ * touching ivlist[] otherwise, and the caller falls back to the
+ * instance-matching loop over bin_op().
+ */
+static int
+eval_planned(node_t *np)
+{
+    info_t	*ip = np->data.info;
+    info_t	*lp = np->left->data.info;
+    info_t	*rp = np->right->data.info;
+    int		n = ip->numval;
+    int		lindom = np->left->desc.indom != PM_INDOM_NULL;
+    int		rindom = np->right->desc.indom != PM_INDOM_NULL;
+    int		k;
+
+    if (lindom && rindom) {
+	if (lp->numval != n || rp->numval != n)
+	    return -1;
+	for (k = 0; k < n; k++) {
+	    if (lp->ivlist[k].inst != rp->ivlist[k].inst)
+		return -1;
+	}
+    }
+
+    if (ip->vec_size < n) {
+	void	*vec;
+	size_t	need = 2 * n * sizeof(double);
+
+	if ((vec = realloc(ip->vec, need)) == NULL) {
+	    pmNoMem("eval_planned: vec", need, PM_FATAL_ERR);
+	    /*NOTREACHED*/
+	}
+	ip->vec = vec;
+	ip->vec_size = n;
+    }
+
+    if (ip->plan == DM_PLAN_DOUBLE) {
+	double	*l = (double *)ip->vec;
+	double	*r = l + n;
+
+	plan_load_double(np->left, n, l);
+	plan_load_double(np->right, n, r);
+	switch (np->type) {
+	    case N_PLUS:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] + r[k];
+		break;
+	    case N_MINUS:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] - r[k];
+		break;
+	    case N_STAR:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] * r[k];
+		break;
+	    case N_SLASH:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] == 0 ? 0 : l[k] / r[k];
+		break;
+	}
+	for (k = 0; k < n; k++)
+	    ip->ivlist[k].value.d = l[k];
+    }
+    else {
+	__uint64_t	*l = (__uint64_t *)ip->vec;
+	__uint64_t	*r = l + n;
+
+	plan_load_integer(np->left, n, l);
+	plan_load_integer(np->right, n, r);
+	switch (np->type) {
+	    case N_PLUS:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] + r[k];
+		break;
+	    case N_MINUS:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] - r[k];
+		break;
+	    case N_STAR:
+		for (k = 0; k < n; k++)
+		    l[k] = l[k] * r[k];
+		break;
+	}
+	if (np->desc.type == PM_TYPE_64 || np->desc.type == PM_TYPE_U64) {
+	    for (k = 0; k < n; k++)
+		ip->ivlist[k].value.ull = l[k];
+	}
+	else {
+	    for (k = 0; k < n; k++)
+		ip->ivlist[k].value.ul = (__uint32_t)l[k];
+	}
+    }
+
+    for (k = 0; k < n; k++)
+	ip->ivlist[k].inst = lindom ? lp->ivlist[k].inst :
+			     rp->ivlist[rindom ? k : 0].inst;
+
+    return 0;
+}
+
 /*
  * For regular expression instance matching, the hash list of observed
  * instances could grow without bounds for a dynamic indom.
@@ -1856,6 +2082,8 @@ eval_expr(__pmContext *ctxp, node_t *np, struct timespec *stamp, int numpmid,
 		pmNoMem("eval_expr: expr ivlist", np->data.info->numval*sizeof(val_t), PM_FATAL_ERR);
 		/*NOTREACHED*/
 	    }
+	    if (np->data.info->plan != DM_PLAN_NONE && eval_planned(np) == 0)
+		return np->data.info->numval;
 	    /*
 	     * ivlist[k] = left->ivlist[i] <op> right->ivlist[j]
 	     */
@@ -85,11 +85,14 @@ pmLookupDesc_ctx(__pmContext *ctxp, int derive_locked, pmID pmid, pmDesc *desc)
     if (ctxp->c_type == PM_CONTEXT_HOST) {
 	tout = ctxp->c_pmcd->pc_tout_sec;
 	fd = ctxp->c_pmcd->pc_fd;
-	if ((sts = __pmSendDescReq(fd, __pmPtrToHandle(ctxp), pmid)) < 0) {
+	if (__pmMetaCacheGetDesc(ctxp, pmid, desc)) {
+	    sts = 0;
+	} else if ((sts = __pmSendDescReq(fd, __pmPtrToHandle(ctxp), pmid)) < 0) {
 	    sts = __pmMapErrno(sts);
 	} else {
 	    PM_FAULT_POINT("libpcp/" __FILE__ ":1", PM_FAULT_CALL);
-	    sts = __pmRecvDesc(fd, ctxp, tout, desc);
+	    if ((sts = __pmRecvDesc(fd, ctxp, tout, desc)) >= 0)
+		__pmMetaCachePutDesc(ctxp, desc);
 	}
     }
     else if (ctxp->c_type == PM_CONTEXT_LOCAL) {
@@ -231,34 +234,52 @@ pmLookupDescs_ctx(__pmContext *ctxp, int derive_locked, int numpmid, pmID *pmidl
 	tout = ctxp->c_pmcd->pc_tout_sec;
 	fd = ctxp->c_pmcd->pc_fd;
 
-	if ((__pmFeaturesIPC(fd) & PDU_FLAG_DESCS)) {
+	/*
+	 * With every descriptor in the metadata cache (or derived, which
+	 * pmcd knows nothing about), no round trip to pmcd is needed.
+	 */
+	for (i = sts = 0; i < numpmid; i++) {
+	    pmid = pmidlist[i];
+	    if (IS_DERIVED(pmid)) {
+		desclist[i].pmid = PM_ID_NULL;
+		nfail++;
+	    }
+	    else if (__pmMetaCacheGetDesc(ctxp, pmid, &desclist[i]))
+		sts++;
+	    else
+		break;
+	}
+	if (i == numpmid)
+	    ;	/* special case :- all cached or derived metrics */
+	else if ((__pmFeaturesIPC(fd) & PDU_FLAG_DESCS)) {
 	    /* Use the bulk-transfer mechanism from a more modern pmcd */
 	    ctx = __pmPtrToHandle(ctxp);
-	    for (i = sts = 0; i < numpmid; i++)
-		if (!IS_DERIVED(pmidlist[i]))
-		    break;
-	    if (i == numpmid)	/* special case :- all derived metrics */
-		nfail++;
-	    else if ((sts = __pmSendIDList(fd, ctx, numpmid, pmidlist, -1)) < 0)
+	    nfail = 0;
+	    if ((sts = __pmSendIDList(fd, ctx, numpmid, pmidlist, -1)) < 0)
 		sts = __pmMapErrno(sts);
 	    else {
 		PM_FAULT_POINT("libpcp/" __FILE__ ":2", PM_FAULT_CALL);
 		sts = __pmRecvDescs(fd, ctxp, tout, numpmid, desclist);
 		nfail = (sts >= 0) ? numpmid - sts : numpmid;
 	    }
+	    for (i = 0; sts > 0 && i < numpmid; i++)
+		__pmMetaCachePutDesc(ctxp, &desclist[i]);
 	} else {
 	    /* Fallback for down-revision pmcd, desc lookups in a loop */
-	    for (i = sts = 0; i < numpmid; i++) {
+	    for (i = sts = nfail = 0; i < numpmid; i++) {
 		pmid = pmidlist[i];
 		desclist[i].pmid = PM_ID_NULL;
 		if (IS_DERIVED(pmid)) {
 		    lsts = PM_ERR_GENERIC;
 		    nfail++;
+		} else if (__pmMetaCacheGetDesc(ctxp, pmid, &desclist[i])) {
+		    lsts = 0;
 		} else if ((lsts = __pmSendDescReq(fd, ctx, pmid)) < 0) {
 		    lsts = __pmMapErrno(lsts);
 		} else {
 		    PM_FAULT_POINT("libpcp/" __FILE__ ":3", PM_FAULT_CALL);
-		    lsts = __pmRecvDesc(fd, ctxp, tout, &desclist[i]);
+		    if ((lsts = __pmRecvDesc(fd, ctxp, tout, &desclist[i])) >= 0)
+			__pmMetaCachePutDesc(ctxp, &desclist[i]);
 		}
 		if (lsts >= 0)
 		    sts++;
@@ -225,6 +225,9 @@ __pmFetch(__pmContext *ctxp, int numpmid, pmID *pmidlist, __pmResult **result)
 	    else {
 		PM_FAULT_POINT("libpcp/" __FILE__ ":1", PM_FAULT_CALL);
 		sts = __pmRecvFetchPDU(fd, ctxp, tout, pdutype, result);
+		/* PMCD state changes (if any) may make cached metadata stale */
+		if (sts >= 0)
+		    __pmMetaCacheInvalidate(ctxp, sts);
 	    }
 	}
 	else if (ctxp->c_type == PM_CONTEXT_LOCAL) {
@@ -77,6 +77,8 @@ struct __pmFetchGroupItem {
 	    pmID metric_pmid;
 	    pmDesc metric_desc;
 	    int metric_inst;	/* unused if metric_desc.indom == PM_INDOM_NULL */
+	    int vset_hint;	/* expected position of pmid in pmResult */
+	    int inst_hint;	/* position of instance in last pmValueSet */
 	    struct __pmFetchGroupConversionSpec conv;
 	    pmAtomValue *output_value;	/* NB: may be NULL */
 	    int output_type;	/* PM_TYPE_* */
@@ -85,6 +87,7 @@ struct __pmFetchGroupItem {
 	struct {
 	    pmID metric_pmid;
 	    pmDesc metric_desc;
+	    int vset_hint;	/* expected position of pmid in pmResult */
 	    struct __pmFetchGroupConversionSpec conv;
 	    int *output_inst_codes;	/* NB: may be NULL */
 	    char **output_inst_names;	/* NB: may be NULL */
@@ -99,6 +102,7 @@ struct __pmFetchGroupItem {
 	    pmID metric_pmid;
 	    pmDesc metric_desc;
 	    int metric_inst;
+	    int vset_hint;	/* expected position of pmid in pmResult */
 	    pmID field_pmid;
 	    pmDesc field_desc;
 	    struct __pmFetchGroupConversionSpec conv;
@@ -132,10 +136,13 @@ pmfg_timespec_from_timeval(const struct timeval *tv, struct timespec *ts)
 
 /*
  * Update the accumulated set of unique pmIDs sought by given pmFG, so
- * as to precalculate the data pmFetch() will need.
+ * as to precalculate the data pmFetch() will need.  The position of
+ * the pmID in that set is returned via index - pmFetch() returns the
+ * pmValueSets in the same order, so this is where to look for it in
+ * each pmResult.
  */
 static int
-pmfg_add_pmid(pmFG pmfg, pmID pmid)
+pmfg_add_pmid(pmFG pmfg, pmID pmid, int *index)
 {
     size_t i;
 
@@ -156,6 +163,7 @@ pmfg_add_pmid(pmFG pmfg, pmID pmid)
 	pmfg->unique_pmids = new_unique_pmids;
 	pmfg->unique_pmids[pmfg->num_unique_pmids++] = pmid;
     }
+    *index = (int)i;
     return 0;
 }
 
@@ -651,39 +659,90 @@ pmfg_reinit_event(pmFGI item)
     }
 }
 
+/*
+ * Find the pmValueSet for the given pmid in a pmResult, trying the
+ * hinted position first (normally correct, see pmfg_add_pmid) before
+ * falling back to a search from position first_vset onward.
+ */
+static const pmValueSet *
+pmfg_find_vset(pmID pmid, int vset_hint, int first_vset,
+		pmValueSet **vsets, int numpmid)
+{
+    int i;
+
+    if (vset_hint >= first_vset && vset_hint < numpmid &&
+	vsets[vset_hint]->pmid == pmid)
+	return vsets[vset_hint];
+    for (i = first_vset; i < numpmid; i++) {
+	if (vsets[i]->pmid == pmid)
+	    return vsets[i];
+    }
+    return NULL;
+}
+
+/*
+ * Find the position of an instance within a pmValueSet, trying the
+ * hinted position first (instances rarely move between samples) and
+ * otherwise using a binary search - all pmResults seen here have been
+ * through pmSortInstances.  The hint is updated with the outcome.
+ */
+static int
+pmfg_find_inst(const pmValueSet *iv, int inst, int *inst_hint)
+{
+    int lo, hi, mid;
+
+    if (inst_hint && *inst_hint >= 0 && *inst_hint < iv->numval &&
+	iv->vlist[*inst_hint].inst == inst)
+	return *inst_hint;
+
+    lo = 0;
+    hi = iv->numval - 1;
+    while (lo <= hi) {
+	mid = lo + (hi - lo) / 2;
+	if (iv->vlist[mid].inst == inst) {
+	    if (inst_hint)
+		*inst_hint = mid;
+	    return mid;
+	}
+	if (iv->vlist[mid].inst < inst)
+	    lo = mid + 1;
+	else
+	    hi = mid - 1;
+    }
+    return -1;
+}
+
 /*
  * Find the pmValue corresponding to the item within the given
  * valueset.  Convert it to given output type, including possible
  * string<->number conversions.
  */
 static int
-pmfg_extract_item(pmID metric_pmid, int metric_inst, int first_vset,
-		  const pmDesc *metric_desc, pmValueSet **vsets,
-		  int numpmid, pmAtomValue *value, int otype)
+pmfg_extract_item(pmID metric_pmid, int metric_inst, int vset_hint,
+		  int *inst_hint, int first_vset, const pmDesc *metric_desc,
+		  pmValueSet **vsets, int numpmid, pmAtomValue *value,
+		  int otype)
 {
-    int i;
+    const pmValueSet *iv;
+    int j;
 
     assert(metric_desc != NULL);
     assert(vsets != NULL);
     assert(value != NULL);
 
-    for (i = first_vset; i < numpmid; i++) {
-	const pmValueSet *iv = vsets[i];
-	if (iv->pmid == metric_pmid) {
-	    int j;
-
-	    if (iv->numval < 0)	/* Pass error code, if any. */
-		return iv->numval;
-	    for (j = 0; j < iv->numval; j++) {
-		if (metric_desc->indom == PM_INDOM_NULL ||
-		    iv->vlist[j].inst == metric_inst)
-		    return __pmExtractValue2(iv->valfmt, &iv->vlist[j],
-					metric_desc->type, value, otype);
-	    }
-	}
-    }
-
-    return PM_ERR_VALUE;
+    if ((iv = pmfg_find_vset(metric_pmid, vset_hint, first_vset,
+				vsets, numpmid)) == NULL)
+	return PM_ERR_VALUE;
+    if (iv->numval < 0)	/* Pass error code, if any. */
+	return iv->numval;
+    if (iv->numval == 0)
+	return PM_ERR_VALUE;
+    if (metric_desc->indom == PM_INDOM_NULL)
+	j = 0;
+    else if ((j = pmfg_find_inst(iv, metric_inst, inst_hint)) < 0)
+	return PM_ERR_VALUE;
+    return __pmExtractValue2(iv->valfmt, &iv->vlist[j],
+				metric_desc->type, value, otype);
 }
 
 /*
@@ -734,7 +793,8 @@ pmfg_unwrap_counter(pmFG pmfg, int type, double *value)
 
 static int
 pmfg_extract_convert_item(pmFG pmfg, pmID metric_pmid, int metric_inst,
-			  int first_vset, const pmDesc *desc, const pmFGC conv,
+			  int vset_hint, int *inst_hint, int first_vset,
+			  const pmDesc *desc, const pmFGC conv,
 			  pmValueSet **vsets, int numpmid,
 			  const struct timespec *timestamp,
 			  pmAtomValue *oval, int otype)
@@ -745,8 +805,8 @@ pmfg_extract_convert_item(pmFG pmfg, pmID metric_pmid, int metric_inst,
 
     assert(oval != NULL);
 
-    sts = pmfg_extract_item(metric_pmid, metric_inst, first_vset, desc,
-			    vsets, numpmid, &v, PM_TYPE_DOUBLE);
+    sts = pmfg_extract_item(metric_pmid, metric_inst, vset_hint, inst_hint,
+			    first_vset, desc, vsets, numpmid, &v, PM_TYPE_DOUBLE);
     if (sts)
 	return sts;
 
@@ -763,8 +823,9 @@ pmfg_extract_convert_item(pmFG pmfg, pmID metric_pmid, int metric_inst,
 	    if (deltaT < epsilon)	/* avoid division by zero */
 		deltaT = epsilon;	/* (chose not to PM_ERR_CONV here) */
 
-	    sts = pmfg_extract_item(metric_pmid, metric_inst, first_vset,
-				    desc, prev_r->vset, prev_r->numpmid,
+	    sts = pmfg_extract_item(metric_pmid, metric_inst, vset_hint,
+				    inst_hint, first_vset, desc,
+				    prev_r->vset, prev_r->numpmid,
 				    &prev_v, PM_TYPE_DOUBLE);
 	    if (sts)
 		return sts;
@@ -813,7 +874,7 @@ pmfg_fetch_item(pmFG pmfg, pmFGI item, pmResult *newResult)
 {
     int sts;
     pmAtomValue v;
-    int i;
+    const pmValueSet *iv;
 
     assert(item != NULL);
     assert(item->type == pmfg_item);
@@ -824,21 +885,20 @@ pmfg_fetch_item(pmFG pmfg, pmFGI item, pmResult *newResult)
      * be cleared now.
      */
     if (item->u.item.metric_desc.sem == PM_SEM_DISCRETE && pmfg->preserve) {
-	for (i = 0; i < newResult->numpmid; i++) {
-	    if (newResult->vset[i]->pmid == item->u.item.metric_pmid) {
-		if (newResult->vset[i]->numval > 0) {
-		    pmfg_reinit_item(item);
-		    break;
-		} else if (newResult->vset[i]->numval == 0) {
-		    return; /* NB: leave outputs alone. */
-		}
-	    }
+	iv = pmfg_find_vset(item->u.item.metric_pmid, item->u.item.vset_hint,
+			0, newResult->vset, newResult->numpmid);
+	if (iv != NULL) {
+	    if (iv->numval > 0)
+		pmfg_reinit_item(item);
+	    else if (iv->numval == 0)
+		return; /* NB: leave outputs alone. */
 	}
     }
 
     if (item->u.item.conv.rate_convert || item->u.item.conv.unit_convert) {
 	sts = pmfg_extract_convert_item(pmfg,
-			item->u.item.metric_pmid, item->u.item.metric_inst, 0,
+			item->u.item.metric_pmid, item->u.item.metric_inst,
+			item->u.item.vset_hint, &item->u.item.inst_hint, 0,
 		 	&item->u.item.metric_desc, &item->u.item.conv,
 			newResult->vset, newResult->numpmid, &newResult->timestamp,
 			&v, item->u.item.output_type);
@@ -847,8 +907,8 @@ pmfg_fetch_item(pmFG pmfg, pmFGI item, pmResult *newResult)
     }
     else {
 	sts = pmfg_extract_item(item->u.item.metric_pmid,
-			item->u.item.metric_inst, 0,
-			&item->u.item.metric_desc,
+			item->u.item.metric_inst, item->u.item.vset_hint,
+			&item->u.item.inst_hint, 0, &item->u.item.metric_desc,
 			newResult->vset, newResult->numpmid,
 			&v, item->u.item.output_type);
 	if (sts < 0)
@@ -889,10 +949,33 @@ pmfg_fetch_timeval(pmFG pmfg, pmFGI item, pmResult *newResult)
     }
 }
 
+/*
+ * Find an instance in the cached pmGetInDom codes, starting the search
+ * just after the previous match (passed in and updated via pos) - for
+ * the usual case of pmValueSet and cache ordering agreeing, this makes
+ * a walk over all instances linear rather than quadratic.
+ */
+static int
+pmfg_find_cached_inst(const struct __pmInDomCache *cache, int inst,
+		unsigned int *pos)
+{
+    unsigned int	n, k = *pos;
+
+    for (n = 0; n < cache->size; n++, k++) {
+	if (k >= cache->size)
+	    k = 0;
+	if (cache->codes[k] == inst) {
+	    *pos = k;
+	    return k;
+	}
+    }
+    return -1;
+}
+
 static void
 pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
 {
-    int i, sts = 0;
+    int sts = 0;
     unsigned int j, k;
     struct __pmInDomCache *cache;
     const pmValueSet *iv;
@@ -907,15 +990,12 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
      * find the corresponding pmid (and each instance) anew in the previous
      * result.
      */
-    for (i = 0; i < newResult->numpmid; i++) {
-	if (newResult->vset[i]->pmid == item->u.indom.metric_pmid)
-	    break;
-    }
-    if (i >= newResult->numpmid) {
+    iv = pmfg_find_vset(item->u.indom.metric_pmid, item->u.indom.vset_hint,
+			0, newResult->vset, newResult->numpmid);
+    if (iv == NULL) {
 	sts = PM_ERR_VALUE;
 	goto out;
     }
-    iv = newResult->vset[i];
 
     /* Pass error code, if any. */
     if (iv->numval < 0) {
@@ -948,11 +1028,8 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
     }
     if (cache && cache->refreshed &&
 	item->u.indom.output_inst_names) {	/* Caller interested at all? */
-	for (j = 0; j < (unsigned int)iv->numval; j++) {
-	    for (k = 0; k < cache->size; k++)
-		if (cache->codes[k] == iv->vlist[j].inst)
-		    break;
-	    if (k >= cache->size) {
+	for (j = 0, k = 0; j < (unsigned int)iv->numval; j++) {
+	    if (pmfg_find_cached_inst(cache, iv->vlist[j].inst, &k) < 0) {
 		cache->refreshed = 0;
 		break;
 	    }
@@ -989,10 +1066,11 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
      * since we signal individual errors, except once we run out of
      * output space.
      */
-    for (j = 0; j < (unsigned)iv->numval; j++) {
+    for (j = 0, k = 0; j < (unsigned)iv->numval; j++) {
 	const pmValue *jv = &iv->vlist[j];
 	pmAtomValue v;
 	int stss = 0;
+	int hint = j;	/* position of this instance in previous result */
 
 	if (j >= item->u.indom.output_maxnum) {	/* too many instances! */
 	    sts = PM_ERR_TOOBIG;
@@ -1010,18 +1088,13 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
 	if (item->u.indom.output_inst_names) {
 	    if (cache == NULL)
 		item->u.indom.output_inst_names[j] = NULL;
-	    else {
-	        for (k = 0; k < cache->size; k++) {
-		    if (cache->codes[k] == jv->inst) {
-			/*
-			 * NB: copy the indom name char* by value.
-			 * User may not modify / free this pointer,
-			 * nor use it after subsequent fetch / delete.
-			 */
-			item->u.indom.output_inst_names[j] = cache->names[k];
-			break;
-		    }
-		}
+	    else if (pmfg_find_cached_inst(cache, jv->inst, &k) >= 0) {
+		/*
+		 * NB: copy the indom name char* by value.
+		 * User may not modify / free this pointer,
+		 * nor use it after subsequent fetch / delete.
+		 */
+		item->u.indom.output_inst_names[j] = cache->names[k];
 	    }
 	}
 
@@ -1029,7 +1102,8 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
 	if (item->u.indom.conv.rate_convert ||
 	    item->u.indom.conv.unit_convert) {
 	    stss = pmfg_extract_convert_item(pmfg, item->u.indom.metric_pmid,
-				jv->inst, 0, &item->u.indom.metric_desc,
+				jv->inst, item->u.indom.vset_hint, &hint, 0,
+				&item->u.indom.metric_desc,
 				&item->u.indom.conv,
 				newResult->vset, newResult->numpmid,
 				&newResult->timestamp,
@@ -1038,9 +1112,9 @@ pmfg_fetch_indom(pmFG pmfg, pmFGI item, pmResult *newResult)
 		goto out1;
 	}
 	else {
-	    stss = pmfg_extract_item(item->u.indom.metric_pmid, jv->inst,
-				0, &item->u.indom.metric_desc,
-				newResult->vset, newResult->numpmid, &v,
+	    /* value is right here, no need to look it up again */
+	    stss = __pmExtractValue2(iv->valfmt, jv,
+				item->u.indom.metric_desc.type, &v,
 				item->u.indom.output_type);
 	    if (stss < 0)
 		goto out1;
@@ -1106,7 +1180,7 @@ pmfg_fetch_event_field(pmFG pmfg, pmFGI item, unsigned int *output_num,
 	if (item->u.event.conv.rate_convert ||
 	    item->u.event.conv.unit_convert) {
 	    stss = pmfg_extract_convert_item(pmfg,
-				item->u.event.field_pmid, -1, i,
+				item->u.event.field_pmid, -1, i, NULL, i,
 				&item->u.event.field_desc, &item->u.event.conv,
 				vsets, numpmid, timestamp,
 				&v, item->u.event.output_type);
@@ -1114,7 +1188,7 @@ pmfg_fetch_event_field(pmFG pmfg, pmFGI item, unsigned int *output_num,
 		goto out;
 	}
 	else {
-	    stss = pmfg_extract_item(item->u.event.field_pmid, -1,
+	    stss = pmfg_extract_item(item->u.event.field_pmid, -1, i, NULL,
 				i, &item->u.event.field_desc, vsets, numpmid,
 				&v, item->u.event.output_type);
 	    if (stss < 0)
@@ -1154,15 +1228,13 @@ pmfg_fetch_event(pmFG pmfg, pmFGI item, pmResult *newResult)
     assert(newResult != NULL);
 
     /* Find our pmid in the newResult. */
-    for (i = 0; i < newResult->numpmid; i++) {
-	if (newResult->vset[i]->pmid == item->u.event.metric_pmid)
-	    break;
-    }
-    if (i >= newResult->numpmid) {
+    iv = (pmValueSet *)pmfg_find_vset(item->u.event.metric_pmid,
+			item->u.event.vset_hint, 0,
+			newResult->vset, newResult->numpmid);
+    if (iv == NULL) {
 	sts = PM_ERR_VALUE;
 	goto out;
     }
-    iv = newResult->vset[i];
 
     /* Pass error code, if any. */
     if (iv->numval < 0) {
@@ -1397,7 +1469,7 @@ pmExtendFetchGroup_item(pmFG pmfg,
     if (sts != 0)
 	goto out;
 
-    sts = pmfg_add_pmid(pmfg, item->u.item.metric_pmid);
+    sts = pmfg_add_pmid(pmfg, item->u.item.metric_pmid, &item->u.item.vset_hint);
     if (sts != 0)
 	goto out;
 
@@ -1503,7 +1575,7 @@ pmExtendFetchGroup_indom(pmFG pmfg,
     if (sts != 0)
 	goto out;
 
-    sts = pmfg_add_pmid(pmfg, item->u.indom.metric_pmid);
+    sts = pmfg_add_pmid(pmfg, item->u.indom.metric_pmid, &item->u.indom.vset_hint);
     if (sts < 0)
 	goto out;
 
@@ -1626,7 +1698,7 @@ pmExtendFetchGroup_event(pmFG pmfg,
 	goto out;
     }
 
-    sts = pmfg_add_pmid(pmfg, item->u.event.metric_pmid);
+    sts = pmfg_add_pmid(pmfg, item->u.event.metric_pmid, &item->u.event.vset_hint);
     if (sts < 0)
 	goto out;
 
@@ -84,7 +84,14 @@ lookuptext(int ident, int type, char **buffer)
     /* not set on all PDU error paths and fallbacktext() checks this ... */
     *buffer = NULL;
 
-    if (ctxp->c_type == PM_CONTEXT_HOST) {
+    if (ctxp->c_type == PM_CONTEXT_HOST &&
+	(sts = __pmMetaCacheGetText(ctxp, ident, type, buffer)) != 0) {
+	if (sts > 0)
+	    sts = 0;
+    }
+    else if (ctxp->c_type == PM_CONTEXT_HOST) {
+	int	otype = type;
+
 	tout = ctxp->c_pmcd->pc_tout_sec;
 	fd = ctxp->c_pmcd->pc_fd;
 again_host:
@@ -104,6 +111,8 @@ again_host:
 		    goto again_host;
 		}
 	    }
+	    if (sts == 0 && *buffer != NULL)
+		__pmMetaCachePutText(ctxp, ident, otype, *buffer);
 	}
     }
     else if (ctxp->c_type == PM_CONTEXT_LOCAL) {
@@ -48,8 +48,11 @@ pmLookupInDom_ctx(__pmContext *ctxp, pmInDom indom, const char *name)
 	else
 	    PM_ASSERT_IS_LOCKED(ctxp->c_lock);
 	if (ctxp->c_type == PM_CONTEXT_HOST) {
-	    sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, PM_IN_NULL, name);
-	    if (sts < 0)
+	    int		inst;
+
+	    if (__pmMetaCacheLookupInDom(ctxp, indom, name, &inst))
+		sts = inst;
+	    else if ((sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, PM_IN_NULL, name)) < 0)
 		sts = __pmMapErrno(sts);
 	    else {
 		__pmPDU	*pb;
@@ -172,8 +175,11 @@ pmNameInDom_ctx(__pmContext *ctxp, pmInDom indom, int inst, char **name)
 	else
 	    PM_ASSERT_IS_LOCKED(ctxp->c_lock);
 	if (ctxp->c_type == PM_CONTEXT_HOST) {
-	    sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, inst, NULL);
-	    if (sts < 0)
+	    if ((sts = __pmMetaCacheNameInDom(ctxp, indom, inst, name)) != 0) {
+		if (sts > 0)
+		    sts = 0;
+	    }
+	    else if ((sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, inst, NULL)) < 0)
 		sts = __pmMapErrno(sts);
 	    else {
 		__pmPDU	*pb;
@@ -353,8 +359,9 @@ pmGetInDom_ctx(__pmContext *ctxp, pmInDom indom, int **instlist, char ***namelis
 	else
 	    PM_ASSERT_IS_LOCKED(ctxp->c_lock);
 	if (ctxp->c_type == PM_CONTEXT_HOST) {
-	    sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, PM_IN_NULL, NULL);
-	    if (sts < 0)
+	    if (__pmMetaCacheHaveInDom(ctxp, indom))
+		sts = __pmMetaCacheGetInDom(ctxp, indom, instlist, namelist);
+	    else if ((sts = __pmSendInstanceReq(ctxp->c_pmcd->pc_fd, __pmPtrToHandle(ctxp), indom, PM_IN_NULL, NULL)) < 0)
 		sts = __pmMapErrno(sts);
 	    else {
 		__pmPDU	*pb;
@@ -373,6 +380,8 @@ PM_FAULT_POINT("libpcp/" __FILE__ ":1", PM_FAULT_CALL);
 			goto pmapi_return;
 		    }
 		    sts = inresult_to_lists(result, instlist, namelist);
+		    if (sts >= 0)
+			__pmMetaCachePutInDom(ctxp, indom, sts, *instlist, *namelist);
 		}
 		else if (sts == PDU_ERROR)
 		    __pmDecodeError(pb, &sts);
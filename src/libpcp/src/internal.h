@@ -29,6 +29,7 @@
 
 extern int __pmConvertTimeout(int) _PCP_HIDDEN;
 extern int __pmConnectWithFNDELAY(int, void *, __pmSockLen) _PCP_HIDDEN;
+extern ssize_t __pmWriteVec(int, const __pmPDUVec *, int, int) _PCP_HIDDEN;
 
 extern int __pmPtrToHandle(__pmContext *) _PCP_HIDDEN;
 
@@ -111,6 +112,7 @@ extern void __pmDestroyMutex(pthread_mutex_t *) _PCP_HIDDEN;	/* mutex destroyer
 extern void init_pmns_lock(void) _PCP_HIDDEN;
 extern void init_AF_lock(void) _PCP_HIDDEN;
 extern void init_result_lock(void) _PCP_HIDDEN;
+extern void init_labels_lock(void) _PCP_HIDDEN;
 extern void init_secureclient_lock(void) _PCP_HIDDEN;
 extern void init_secureserver_lock(void) _PCP_HIDDEN;
 extern void init_connect_lock(void) _PCP_HIDDEN;
@@ -170,6 +172,7 @@ extern int __pmIsPmnsFixLock(void *) _PCP_HIDDEN;
 extern int __pmIsPmnsPmapiLock(void *) _PCP_HIDDEN;
 extern int __pmIsAFLock(void *) _PCP_HIDDEN;
 extern int __pmIsresultLock(void *) _PCP_HIDDEN;
+extern int __pmIslabelsLock(void *) _PCP_HIDDEN;
 extern int __pmIsSecureclientLock(void *) _PCP_HIDDEN;
 extern int __pmIsSecureserverLock(void *) _PCP_HIDDEN;
 extern int __pmIsConnectLock(void *) _PCP_HIDDEN;
@@ -455,6 +458,27 @@ extern void __pmSetSampleInterval3(pmOptions *, char *) _PCP_HIDDEN;
 /* hook for win32.c initialization */
 extern void __pmSetProgname(const char *) _PCP_HIDDEN;
 
+/*
+ * metacache.c - client-side metadata cache for host contexts
+ */
+extern int __pmMetaCacheGetDesc(__pmContext *, pmID, pmDesc *) _PCP_HIDDEN;
+extern void __pmMetaCachePutDesc(__pmContext *, const pmDesc *) _PCP_HIDDEN;
+extern int __pmMetaCacheGetNames(__pmContext *, pmID, char ***) _PCP_HIDDEN;
+extern void __pmMetaCachePutNames(__pmContext *, pmID, int, char **) _PCP_HIDDEN;
+extern int __pmMetaCacheGetPMID(__pmContext *, const char *, pmID *) _PCP_HIDDEN;
+extern void __pmMetaCachePutPMID(__pmContext *, const char *, pmID) _PCP_HIDDEN;
+extern int __pmMetaCacheGetText(__pmContext *, int, int, char **) _PCP_HIDDEN;
+extern void __pmMetaCachePutText(__pmContext *, int, int, const char *) _PCP_HIDDEN;
+extern int __pmMetaCacheGetLabels(__pmContext *, int, int, pmLabelSet **, int *) _PCP_HIDDEN;
+extern void __pmMetaCachePutLabels(__pmContext *, int, int, pmLabelSet *, int) _PCP_HIDDEN;
+extern int __pmMetaCacheHaveInDom(__pmContext *, pmInDom) _PCP_HIDDEN;
+extern int __pmMetaCacheGetInDom(__pmContext *, pmInDom, int **, char ***) _PCP_HIDDEN;
+extern void __pmMetaCachePutInDom(__pmContext *, pmInDom, int, int *, char **) _PCP_HIDDEN;
+extern int __pmMetaCacheNameInDom(__pmContext *, pmInDom, int, char **) _PCP_HIDDEN;
+extern int __pmMetaCacheLookupInDom(__pmContext *, pmInDom, const char *, int *) _PCP_HIDDEN;
+extern void __pmMetaCacheInvalidate(__pmContext *, int) _PCP_HIDDEN;
+extern void __pmMetaCacheFree(__pmContext *) _PCP_HIDDEN;
+
 /*
  * PMAPI_VERSION_2 interfaces
  */
@@ -1013,20 +1013,16 @@ __pmMergeLabels(const char *a, const char *b, char *buffer, int buflen, int flag
  * An optional user-supplied callback routine allows fine-tuning
  * of the resulting set of labels.
  */
-int
-pmMergeLabelSets(pmLabelSet **sets, int nsets, char *buffer, int buflen,
-		filter_labels filter, void *arg)
+static int
+merge_labelsets(pmLabelSet **sets, int nsets, char *buffer, int buflen,
+		pmLabel *olabels, int *no, filter_labels filter, void *arg)
 {
     __pmHashCtl		*compound, bhash = {0};
-    pmLabel		olabels[MAXLABELSET];
     pmLabel		blabels[MAXLABELSET];
     char		buf[PM_MAXLABELJSONLEN];
     int			nlabels = 0;
     int			i, sts = 0;
 
-    if (!sets || nsets < 1)
-	return -EINVAL;
-
     for (i = 0; i < nsets; i++) {
 	if (sets[i] == NULL || sets[i]->nlabels < 0)
 	    continue;
@@ -1064,9 +1060,23 @@ pmMergeLabelSets(pmLabelSet **sets, int nsets, char *buffer, int buflen,
 	if (sts >= buflen || sts >= PM_MAXLABELJSONLEN)
 	    return -E2BIG;
     }
+    *no = nlabels;
     return sts;
 }
 
+int
+pmMergeLabelSets(pmLabelSet **sets, int nsets, char *buffer, int buflen,
+		filter_labels filter, void *arg)
+{
+    pmLabel		olabels[MAXLABELSET];
+    int			nlabels;
+
+    if (!sets || nsets < 1)
+	return -EINVAL;
+    return merge_labelsets(sets, nsets, buffer, buflen,
+				olabels, &nlabels, filter, arg);
+}
+
 /*
  * Walk the "sets" array left to right (increasing precendence)
  * of JSON and produce the merged set into the supplied buffer.
@@ -1095,6 +1105,375 @@ pmMergeLabels(char **sets, int nsets, char *buffer, int buflen)
     return bytes;
 }
 
+/*
+ * Interned label sets.
+ *
+ * Label sets with the same content (instance, JSONB string and label
+ * index, including flags) are hash-consed into one reference counted
+ * canonical copy, so that callers holding many label sets - one per
+ * metric, indom, instance and so on - share them, and so that the
+ * address of an interned set identifies its content for as long as a
+ * reference is held.
+ *
+ * Merges of interned sets are cached, keyed on the addresses of the
+ * component sets, with the merged result itself an interned set.  A
+ * cache entry holds a reference on each component and on the result,
+ * so none of these addresses can be reused while the entry exists.
+ * Entries not used since the previous sweep are dropped when the cache
+ * reaches its (adaptive) size limit.
+ *
+ * Threadsafe notes.
+ *
+ * - intern_table and merge_cache (and merge_limit) are guarded by the
+ *   labels_lock mutex
+ */
+
+typedef struct {
+    pmLabelSet		set;		/* must be first */
+    unsigned int	key;		/* content hash */
+    unsigned int	refcount;
+} labelintern_t;
+
+#define MAXMERGESETS	8	/* context, domain, indom, ... levels */
+#define MINMERGECACHE	1024	/* lower bound for merge_limit */
+
+typedef struct {
+    unsigned int	key;		/* component addresses hash */
+    unsigned int	used;		/* looked up since the last sweep */
+    int			nsets;
+    pmLabelSet		*sets[MAXMERGESETS];
+    pmLabelSet		*merged;
+} labelmerge_t;
+
+static __pmHashCtl	intern_table;
+static __pmHashCtl	merge_cache;
+static unsigned int	merge_limit = MINMERGECACHE;
+
+#ifdef PM_MULTI_THREAD
+static pthread_mutex_t	labels_lock;
+#else
+void			*labels_lock;
+#endif
+
+#if defined(PM_MULTI_THREAD) && defined(PM_MULTI_THREAD_DEBUG)
+/*
+ * return true if lock == labels_lock
+ */
+int
+__pmIslabelsLock(void *lock)
+{
+    return lock == (void *)&labels_lock;
+}
+#endif
+
+void
+init_labels_lock(void)
+{
+#ifdef PM_MULTI_THREAD
+    __pmInitMutex(&labels_lock);
+#endif
+}
+
+static unsigned int
+hashbytes(unsigned int h, const void *p, size_t length)
+{
+    const unsigned char	*bp = (const unsigned char *)p;
+
+    while (length-- > 0)
+	h = (h ^ *bp++) * 16777619U;	/* FNV-1a */
+    return h;
+}
+
+static unsigned int
+intern_key(const pmLabelSet *set)
+{
+    unsigned int	h = 2166136261U;
+
+    h = hashbytes(h, &set->inst, sizeof(set->inst));
+    if (set->json)
+	h = hashbytes(h, set->json, set->jsonlen);
+    if (set->nlabels > 0)
+	h = hashbytes(h, set->labels, set->nlabels * sizeof(pmLabel));
+    return h;
+}
+
+static int
+intern_match(const pmLabelSet *a, const pmLabelSet *b)
+{
+    if (a->inst != b->inst || a->nlabels != b->nlabels ||
+	a->jsonlen != b->jsonlen || (a->json == NULL) != (b->json == NULL))
+	return 0;
+    if (a->json && memcmp(a->json, b->json, a->jsonlen) != 0)
+	return 0;
+    if (a->nlabels > 0 &&
+	memcmp(a->labels, b->labels, a->nlabels * sizeof(pmLabel)) != 0)
+	return 0;
+    return 1;
+}
+
+static void
+intern_free(labelintern_t *lip)
+{
+    pmLabelSet	*set = &lip->set;
+
+    if (set->nlabels > 0)
+	free(set->labels);
+    if (set->json)
+	free(set->json);
+    if (set->compound && set->hash) {
+	labels_hash_destroy(set->hash);
+	free(set->hash);
+    }
+    free(lip);
+}
+
+/* called with labels_lock held */
+static pmLabelSet *
+intern_labelset(const pmLabelSet *source)
+{
+    labelintern_t	*lip;
+    __pmHashNode	*hp;
+    pmLabelSet		*set;
+    unsigned int	key = intern_key(source);
+    size_t		size;
+
+    for (hp = __pmHashSearch(key, &intern_table); hp; hp = hp->next) {
+	if (hp->key != key)
+	    continue;
+	lip = (labelintern_t *)hp->data;
+	if (intern_match(&lip->set, source)) {
+	    lip->refcount++;
+	    return &lip->set;
+	}
+    }
+
+    if ((lip = (labelintern_t *)calloc(1, sizeof(*lip))) == NULL)
+	return NULL;
+    set = &lip->set;
+    set->inst = source->inst;
+    set->nlabels = source->nlabels;
+    if (source->json) {
+	if ((set->json = malloc(source->jsonlen + 1)) == NULL)
+	    goto fail;
+	memcpy(set->json, source->json, source->jsonlen);
+	set->json[source->jsonlen] = '\0';
+	set->jsonlen = source->jsonlen;
+    }
+    if (source->nlabels > 0) {
+	size = source->nlabels * sizeof(pmLabel);
+	if ((set->labels = malloc(size)) == NULL)
+	    goto fail;
+	memcpy(set->labels, source->labels, size);
+    }
+    if (source->compound && source->hash) {
+	labels_hash_duplicate(source->hash, &set->hash);
+	if (set->hash == NULL)
+	    goto fail;
+	set->compound = 1;
+    }
+    lip->key = key;
+    lip->refcount = 1;
+    if (__pmHashAdd(key, lip, &intern_table) < 0)
+	goto fail;
+    return set;
+
+fail:
+    intern_free(lip);
+    return NULL;
+}
+
+/* called with labels_lock held */
+static void
+release_labelset(pmLabelSet *set)
+{
+    labelintern_t	*lip = (labelintern_t *)set;
+
+    if (--lip->refcount > 0)
+	return;
+    __pmHashDel(lip->key, lip, &intern_table);
+    intern_free(lip);
+}
+
+/*
+ * Return the interned copy of the given label set, with a reference
+ * held for the caller, or NULL if out of memory.  The source is not
+ * modified and may itself be an interned set - interning is also how
+ * an additional reference is taken.
+ */
+pmLabelSet *
+__pmInternLabelSet(const pmLabelSet *source)
+{
+    pmLabelSet		*set;
+
+    if (source == NULL)
+	return NULL;
+    PM_LOCK(labels_lock);
+    set = intern_labelset(source);
+    PM_UNLOCK(labels_lock);
+    return set;
+}
+
+/*
+ * Drop a reference on a set returned from __pmInternLabelSet or
+ * __pmMergeInternedLabelSets.  Never use pmFreeLabelSets on these.
+ */
+void
+__pmReleaseLabelSet(pmLabelSet *set)
+{
+    if (set == NULL)
+	return;
+    PM_LOCK(labels_lock);
+    release_labelset(set);
+    PM_UNLOCK(labels_lock);
+}
+
+static unsigned int
+merge_key(pmLabelSet **sets, int nsets)
+{
+    return hashbytes(2166136261U, sets, nsets * sizeof(pmLabelSet *));
+}
+
+static void
+merge_free(labelmerge_t *lmp)
+{
+    int			i;
+
+    for (i = 0; i < lmp->nsets; i++)
+	if (lmp->sets[i] != NULL)
+	    release_labelset(lmp->sets[i]);
+    if (lmp->merged != NULL)
+	release_labelset(lmp->merged);
+    free(lmp);
+}
+
+static __pmHashWalkState
+merge_sweep_callback(const __pmHashNode *hp, void *arg)
+{
+    labelmerge_t	*lmp = (labelmerge_t *)hp->data;
+
+    (void)arg;
+    if (lmp->used) {
+	lmp->used = 0;
+	return PM_HASH_WALK_NEXT;
+    }
+    merge_free(lmp);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+/*
+ * Drop cache entries unused since the previous sweep, then allow the
+ * cache to grow to twice the size of what remains - a working set of
+ * any size is kept, while entries for sets that went away (instances
+ * that no longer exist, for example) are reclaimed.
+ * Called with labels_lock held.
+ */
+static void
+merge_sweep(void)
+{
+    __pmHashWalkCB(merge_sweep_callback, NULL, &merge_cache);
+    merge_limit = merge_cache.nodes * 2;
+    if (merge_limit < MINMERGECACHE)
+	merge_limit = MINMERGECACHE;
+}
+
+/* called with labels_lock held */
+static labelmerge_t *
+merge_lookup(pmLabelSet **sets, int nsets, unsigned int key)
+{
+    labelmerge_t	*lmp;
+    __pmHashNode	*hp;
+
+    for (hp = __pmHashSearch(key, &merge_cache); hp; hp = hp->next) {
+	if (hp->key != key)
+	    continue;
+	lmp = (labelmerge_t *)hp->data;
+	if (lmp->nsets == nsets &&
+	    memcmp(lmp->sets, sets, nsets * sizeof(pmLabelSet *)) == 0)
+	    return lmp;
+    }
+    return NULL;
+}
+
+/*
+ * Merge interned label sets as pmMergeLabelSets(3) does (without any
+ * filtering), returning the merged labels as an interned set with a
+ * reference held for the caller.  The merged set has no instance and
+ * only direct (flattened) label names.  Results are cached against
+ * the component set addresses, so repeated merges of the same sets
+ * cost a hash lookup rather than a merge.
+ *
+ * Returns the length of the merged JSONB string (zero, with a NULL
+ * json field, if there are no labels) or a negative error code.
+ */
+int
+__pmMergeInternedLabelSets(pmLabelSet **sets, int nsets, pmLabelSet **merged)
+{
+    labelmerge_t	*lmp;
+    pmLabelSet		result = {0};
+    pmLabel		olabels[MAXLABELSET];
+    char		buffer[PM_MAXLABELJSONLEN];
+    unsigned int	key;
+    int			i, sts, nlabels = 0;
+
+    if (!sets || nsets < 1 || !merged)
+	return -EINVAL;
+
+    key = merge_key(sets, nsets);
+    if (nsets <= MAXMERGESETS) {
+	PM_LOCK(labels_lock);
+	if ((lmp = merge_lookup(sets, nsets, key)) != NULL) {
+	    lmp->used = 1;
+	    ((labelintern_t *)lmp->merged)->refcount++;
+	    *merged = lmp->merged;
+	    PM_UNLOCK(labels_lock);
+	    return lmp->merged->jsonlen;
+	}
+	PM_UNLOCK(labels_lock);
+    }
+
+    /* merge outside the lock - the caller holds the component sets */
+    if ((sts = merge_labelsets(sets, nsets, buffer, sizeof(buffer),
+				olabels, &nlabels, NULL, NULL)) < 0)
+	return sts;
+    result.inst = PM_IN_NULL;
+    if (sts > 0) {
+	result.json = buffer;
+	result.jsonlen = sts;
+	result.nlabels = nlabels;
+	result.labels = nlabels > 0 ? olabels : NULL;
+    }
+
+    PM_LOCK(labels_lock);
+    if ((*merged = intern_labelset(&result)) == NULL) {
+	PM_UNLOCK(labels_lock);
+	return -ENOMEM;
+    }
+    if (nsets > MAXMERGESETS || merge_lookup(sets, nsets, key) != NULL ||
+	(lmp = (labelmerge_t *)calloc(1, sizeof(*lmp))) == NULL)
+	goto done;
+    lmp->key = key;
+    lmp->used = 1;
+    lmp->nsets = nsets;
+    for (i = 0; i < nsets; i++) {
+	if (sets[i] == NULL)
+	    continue;
+	/* take references - these are no-op copies for interned sets */
+	if ((lmp->sets[i] = intern_labelset(sets[i])) != sets[i]) {
+	    lmp->nsets = i + 1;	/* not interned, so cannot be cached */
+	    merge_free(lmp);
+	    goto done;
+	}
+    }
+    lmp->merged = intern_labelset(*merged);
+    if (merge_cache.nodes >= merge_limit)
+	merge_sweep();
+    if (__pmHashAdd(key, lmp, &merge_cache) < 0)
+	merge_free(lmp);
+done:
+    PM_UNLOCK(labels_lock);
+    return sts;
+}
+
 static void
 labelfile(const char *path, const char *file, char *buf, int buflen)
 {
@@ -1401,6 +1780,12 @@ getlabels(int ident, int type, pmLabelSet **sets, int *nsets)
 
 	if (!(__pmFeaturesIPC(fd) & PDU_FLAG_LABELS))
 	    sts = PM_ERR_NOLABELS;	/* lack pmcd support */
+	else if (!(type & PM_LABEL_INSTANCES) &&
+		 (sts = __pmMetaCacheGetLabels(ctxp, ident, type, sets, nsets)) != 0) {
+	    /* cached - but never instances, which depend on the profile */
+	    if (sts > 0)
+		sts = 0;
+	}
 	else {
 	    sts = 0;
 	    if ((type & PM_LABEL_INSTANCES) && ctxp->c_sent == 0) {
@@ -1424,6 +1809,8 @@ getlabels(int ident, int type, pmLabelSet **sets, int *nsets)
 		    int x_ident = ident, x_type = type;
 		    PM_FAULT_POINT("libpcp/" __FILE__ ":1", PM_FAULT_CALL);
 		    sts = __pmRecvLabel(fd, ctxp, tout, &x_ident, &x_type, sets, nsets);
+		    if (sts >= 0 && !(type & PM_LABEL_INSTANCES))
+			__pmMetaCachePutLabels(ctxp, ident, type, *sets, *nsets);
 		}
 	    }
 	}
@@ -142,6 +142,8 @@ static char
 	return "exec";
     else if (__pmIsresultLock(lock))
 	return "result";
+    else if (__pmIslabelsLock(lock))
+	return "labels";
     else if (__pmIsThrottleLock(lock))
 	return "throttle";
     else if (__pmIsUnregisterLock(lock))
@@ -391,6 +393,7 @@ __pmInitLocks(void)
 	init_pmns_lock();
 	init_AF_lock();
 	init_result_lock();
+	init_labels_lock();
 	init_secureclient_lock();
 	init_secureserver_lock();
 	init_connect_lock();
@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+
+/*
+ * Client-side metadata cache for PM_CONTEXT_HOST contexts.
+ *
+ * Enabled with PM_CTXFLAG_METADATA_CACHE (or $PCP_METADATA_CACHE), this
+ * remembers descriptors, names, help text, labels and instance domains
+ * returned by pmcd so that repeated lookups avoid a PDU round trip each.
+ * Entries are discarded when pmcd piggybacks a state change on a fetch
+ * (PMCD_AGENT_CHANGE, PMCD_NAMES_CHANGE, PMCD_LABEL_CHANGE), and when
+ * the context is reconnected.  pmcd does not report instance domain
+ * changes at all, so cached instances only live until the next fetch.
+ *
+ * All routines are called with the context lock (c_lock) held.
+ */
+
+#include "pmapi.h"
+#include "libpcp.h"
+#include "internal.h"
+
+enum {
+    MC_DESC,		/* pmID -> pmDesc */
+    MC_NAMES,		/* pmID -> all PMNS names */
+    MC_PMID,		/* PMNS name -> pmID */
+    MC_TEXT,		/* pmID or pmInDom, type -> help text */
+    MC_LABELS,		/* identifier, type -> label sets */
+    MC_INDOM,		/* pmInDom -> instance identifiers and names */
+    MC_COUNT
+};
+
+typedef struct {
+    int		ident;		/* pmID, pmInDom or other identifier */
+    int		type;		/* label or help text type, else zero */
+    int		count;		/* number of names, instances or sets */
+    pmDesc	desc;		/* MC_DESC */
+    char	*text;		/* MC_PMID name or MC_TEXT help text */
+    char	**names;	/* MC_NAMES and MC_INDOM names (one block) */
+    int		*insts;		/* MC_INDOM instance identifiers */
+    pmLabelSet	*labels;	/* MC_LABELS */
+} entry_t;
+
+typedef struct {
+    __pmHashCtl	hash[MC_COUNT];
+} metacache_t;
+
+static unsigned int
+hashkey(int ident, int type)
+{
+    return (unsigned int)ident ^ ((unsigned int)type << 20);
+}
+
+static unsigned int
+hashname(const char *name)
+{
+    unsigned int	h = 2166136261U;	/* FNV-1a */
+
+    while (*name)
+	h = (h ^ (unsigned char)*name++) * 16777619U;
+    return h;
+}
+
+static metacache_t *
+getcache(__pmContext *ctxp, int create)
+{
+    metacache_t		*mcp = (metacache_t *)ctxp->c_metacache;
+    int			i;
+
+    if (mcp != NULL || !create)
+	return mcp;
+    if (ctxp->c_type != PM_CONTEXT_HOST ||
+	(ctxp->c_flags & PM_CTXFLAG_METADATA_CACHE) == 0)
+	return NULL;
+    if ((mcp = (metacache_t *)calloc(1, sizeof(metacache_t))) == NULL)
+	return NULL;
+    for (i = 0; i < MC_COUNT; i++)
+	__pmHashInit(&mcp->hash[i]);
+    ctxp->c_metacache = mcp;
+    return mcp;
+}
+
+static entry_t *
+lookup(__pmContext *ctxp, int kind, int ident, int type)
+{
+    metacache_t		*mcp;
+    __pmHashNode	*hp;
+    entry_t		*ep;
+    unsigned int	key = hashkey(ident, type);
+
+    if ((mcp = getcache(ctxp, 0)) == NULL)
+	return NULL;
+    for (hp = __pmHashSearch(key, &mcp->hash[kind]); hp; hp = hp->next) {
+	ep = (entry_t *)hp->data;
+	if (hp->key == key && ep->ident == ident && ep->type == type)
+	    return ep;
+    }
+    return NULL;
+}
+
+static void
+freeentry(entry_t *ep)
+{
+    free(ep->text);
+    free(ep->names);
+    free(ep->insts);
+    if (ep->labels)
+	pmFreeLabelSets(ep->labels, ep->count);
+    free(ep);
+}
+
+static int
+insert(__pmContext *ctxp, int kind, unsigned int key, entry_t *ep)
+{
+    metacache_t		*mcp;
+
+    if ((mcp = getcache(ctxp, 1)) == NULL ||
+	__pmHashAdd(key, ep, &mcp->hash[kind]) < 0) {
+	freeentry(ep);
+	return -ENOMEM;
+    }
+    return 0;
+}
+
+static entry_t *
+newentry(int ident, int type)
+{
+    entry_t		*ep;
+
+    if ((ep = (entry_t *)calloc(1, sizeof(entry_t))) != NULL) {
+	ep->ident = ident;
+	ep->type = type;
+    }
+    return ep;
+}
+
+/*
+ * Copy a list of names into a single allocation, as returned by
+ * pmNameAll(3) and pmGetInDom(3), so that callers free just one block.
+ */
+static char **
+dupnames(int count, char **names)
+{
+    size_t		need = count * sizeof(char *);
+    char		**list, *p;
+    int			i;
+
+    for (i = 0; i < count; i++)
+	need += strlen(names[i]) + 1;
+    if ((list = (char **)malloc(need)) == NULL)
+	return NULL;
+    p = (char *)&list[count];
+    for (i = 0; i < count; i++) {
+	list[i] = strcpy(p, names[i]);
+	p += strlen(p) + 1;
+    }
+    return list;
+}
+
+int
+__pmMetaCacheGetDesc(__pmContext *ctxp, pmID pmid, pmDesc *desc)
+{
+    entry_t		*ep;
+
+    if ((ep = lookup(ctxp, MC_DESC, (int)pmid, 0)) == NULL)
+	return 0;
+    *desc = ep->desc;
+    return 1;
+}
+
+void
+__pmMetaCachePutDesc(__pmContext *ctxp, const pmDesc *desc)
+{
+    entry_t		*ep;
+
+    if (getcache(ctxp, 1) == NULL || desc->pmid == PM_ID_NULL ||
+	lookup(ctxp, MC_DESC, (int)desc->pmid, 0) != NULL)
+	return;
+    if ((ep = newentry((int)desc->pmid, 0)) == NULL)
+	return;
+    ep->desc = *desc;
+    insert(ctxp, MC_DESC, hashkey(ep->ident, 0), ep);
+}
+
+int
+__pmMetaCacheGetNames(__pmContext *ctxp, pmID pmid, char ***names)
+{
+    entry_t		*ep;
+
+    if ((ep = lookup(ctxp, MC_NAMES, (int)pmid, 0)) == NULL)
+	return 0;
+    if ((*names = dupnames(ep->count, ep->names)) == NULL)
+	return -ENOMEM;
+    return ep->count;
+}
+
+void
+__pmMetaCachePutNames(__pmContext *ctxp, pmID pmid, int count, char **names)
+{
+    entry_t		*ep;
+
+    if (getcache(ctxp, 1) == NULL || count <= 0 ||
+	lookup(ctxp, MC_NAMES, (int)pmid, 0) != NULL)
+	return;
+    if ((ep = newentry((int)pmid, 0)) == NULL)
+	return;
+    ep->count = count;
+    if ((ep->names = dupnames(count, names)) == NULL) {
+	freeentry(ep);
+	return;
+    }
+    insert(ctxp, MC_NAMES, hashkey(ep->ident, 0), ep);
+}
+
+int
+__pmMetaCacheGetPMID(__pmContext *ctxp, const char *name, pmID *pmid)
+{
+    metacache_t		*mcp;
+    __pmHashNode	*hp;
+    entry_t		*ep;
+    unsigned int	key = hashname(name);
+
+    if ((mcp = getcache(ctxp, 0)) == NULL)
+	return 0;
+    for (hp = __pmHashSearch(key, &mcp->hash[MC_PMID]); hp; hp = hp->next) {
+	ep = (entry_t *)hp->data;
+	if (hp->key == key && strcmp(ep->text, name) == 0) {
+	    *pmid = (pmID)ep->ident;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+void
+__pmMetaCachePutPMID(__pmContext *ctxp, const char *name, pmID pmid)
+{
+    entry_t		*ep;
+    pmID		cached;
+
+    if (getcache(ctxp, 1) == NULL || pmid == PM_ID_NULL ||
+	__pmMetaCacheGetPMID(ctxp, name, &cached) != 0)
+	return;
+    if ((ep = newentry((int)pmid, 0)) == NULL)
+	return;
+    if ((ep->text = strdup(name)) == NULL) {
+	freeentry(ep);
+	return;
+    }
+    insert(ctxp, MC_PMID, hashname(name), ep);
+}
+
+int
+__pmMetaCacheGetText(__pmContext *ctxp, int ident, int type, char **buffer)
+{
+    entry_t		*ep;
+
+    if ((ep = lookup(ctxp, MC_TEXT, ident, type)) == NULL)
+	return 0;
+    if ((*buffer = strdup(ep->text)) == NULL)
+	return -ENOMEM;
+    return 1;
+}
+
+void
+__pmMetaCachePutText(__pmContext *ctxp, int ident, int type, const char *buffer)
+{
+    entry_t		*ep;
+
+    if (getcache(ctxp, 1) == NULL || buffer == NULL ||
+	lookup(ctxp, MC_TEXT, ident, type) != NULL)
+	return;
+    if ((ep = newentry(ident, type)) == NULL)
+	return;
+    if ((ep->text = strdup(buffer)) == NULL) {
+	freeentry(ep);
+	return;
+    }
+    insert(ctxp, MC_TEXT, hashkey(ident, type), ep);
+}
+
+int
+__pmMetaCacheGetLabels(__pmContext *ctxp, int ident, int type,
+		pmLabelSet **sets, int *nsets)
+{
+    entry_t		*ep;
+
+    if ((ep = lookup(ctxp, MC_LABELS, ident, type)) == NULL)
+	return 0;
+    if (ep->count == 0)
+	*sets = NULL;
+    else if ((*sets = __pmDupLabelSets(ep->labels, ep->count)) == NULL)
+	return -ENOMEM;
+    *nsets = ep->count;
+    return 1;
+}
+
+void
+__pmMetaCachePutLabels(__pmContext *ctxp, int ident, int type,
+		pmLabelSet *sets, int nsets)
+{
+    entry_t		*ep;
+
+    if (getcache(ctxp, 1) == NULL || nsets < 0 ||
+	lookup(ctxp, MC_LABELS, ident, type) != NULL)
+	return;
+    if ((ep = newentry(ident, type)) == NULL)
+	return;
+    if (nsets > 0 && (ep->labels = __pmDupLabelSets(sets, nsets)) == NULL) {
+	freeentry(ep);
+	return;
+    }
+    ep->count = nsets;
+    insert(ctxp, MC_LABELS, hashkey(ident, type), ep);
+}
+
+int
+__pmMetaCacheGetInDom(__pmContext *ctxp, pmInDom indom,
+		int **instlist, char ***namelist)
+{
+    entry_t		*ep;
+    int			*ilist;
+
+    if ((ep = lookup(ctxp, MC_INDOM, (int)indom, 0)) == NULL)
+	return 0;
+    if (ep->count == 0) {
+	*instlist = NULL;
+	*namelist = NULL;
+	return 0;
+    }
+    if ((ilist = (int *)malloc(ep->count * sizeof(int))) == NULL)
+	return -ENOMEM;
+    if ((*namelist = dupnames(ep->count, ep->names)) == NULL) {
+	free(ilist);
+	return -ENOMEM;
+    }
+    memcpy(ilist, ep->insts, ep->count * sizeof(int));
+    *instlist = ilist;
+    return ep->count;
+}
+
+int
+__pmMetaCacheHaveInDom(__pmContext *ctxp, pmInDom indom)
+{
+    return lookup(ctxp, MC_INDOM, (int)indom, 0) != NULL;
+}
+
+/*
+ * Answer pmNameInDom(3) and pmLookupInDom(3) from a cached instance
+ * domain.  Only exact matches are answered here - anything else (e.g.
+ * a name matched by a PMDA up to the first space) goes to pmcd, so the
+ * PMDA matching rules apply unchanged.
+ */
+int
+__pmMetaCacheNameInDom(__pmContext *ctxp, pmInDom indom, int inst, char **name)
+{
+    entry_t		*ep;
+    int			i;
+
+    if ((ep = lookup(ctxp, MC_INDOM, (int)indom, 0)) == NULL)
+	return 0;
+    for (i = 0; i < ep->count; i++) {
+	if (ep->insts[i] != inst)
+	    continue;
+	if ((*name = strdup(ep->names[i])) == NULL)
+	    return -ENOMEM;
+	return 1;
+    }
+    return 0;
+}
+
+int
+__pmMetaCacheLookupInDom(__pmContext *ctxp, pmInDom indom, const char *name, int *inst)
+{
+    entry_t		*ep;
+    int			i;
+
+    if ((ep = lookup(ctxp, MC_INDOM, (int)indom, 0)) == NULL)
+	return 0;
+    for (i = 0; i < ep->count; i++) {
+	if (strcmp(ep->names[i], name) == 0) {
+	    *inst = ep->insts[i];
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+void
+__pmMetaCachePutInDom(__pmContext *ctxp, pmInDom indom, int count,
+		int *instlist, char **namelist)
+{
+    entry_t		*ep;
+
+    if (getcache(ctxp, 1) == NULL || count < 0 ||
+	lookup(ctxp, MC_INDOM, (int)indom, 0) != NULL)
+	return;
+    if ((ep = newentry((int)indom, 0)) == NULL)
+	return;
+    if (count > 0) {
+	if ((ep->insts = (int *)malloc(count * sizeof(int))) == NULL ||
+	    (ep->names = dupnames(count, namelist)) == NULL) {
+	    freeentry(ep);
+	    return;
+	}
+	memcpy(ep->insts, instlist, count * sizeof(int));
+    }
+    ep->count = count;
+    insert(ctxp, MC_INDOM, hashkey(ep->ident, 0), ep);
+}
+
+static __pmHashWalkState
+freenode(const __pmHashNode *tp, void *cdata)
+{
+    (void)cdata;
+    freeentry((entry_t *)tp->data);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+static void
+clear(metacache_t *mcp, int kind)
+{
+    __pmHashWalkCB(freenode, NULL, &mcp->hash[kind]);
+}
+
+/*
+ * Drop cached entries made stale by the PMCD state changes in flags
+ * (as returned from a fetch), or everything for a negative flags value.
+ * Instance domains are always dropped as pmcd never reports changes.
+ */
+void
+__pmMetaCacheInvalidate(__pmContext *ctxp, int flags)
+{
+    metacache_t		*mcp;
+    int			i;
+
+    if ((mcp = getcache(ctxp, 0)) == NULL)
+	return;
+
+    if (flags < 0 || (flags & PMCD_AGENT_CHANGE)) {
+	for (i = 0; i < MC_COUNT; i++)
+	    clear(mcp, i);
+	if (pmDebugOptions.context)
+	    fprintf(stderr, "__pmMetaCacheInvalidate(%d): all\n", ctxp->c_handle);
+	return;
+    }
+    if (flags & PMCD_NAMES_CHANGE) {
+	clear(mcp, MC_DESC);
+	clear(mcp, MC_NAMES);
+	clear(mcp, MC_PMID);
+	clear(mcp, MC_TEXT);
+    }
+    if (flags & (PMCD_LABEL_CHANGE | PMCD_HOSTNAME_CHANGE))
+	clear(mcp, MC_LABELS);
+    clear(mcp, MC_INDOM);
+}
+
+void
+__pmMetaCacheFree(__pmContext *ctxp)
+{
+    metacache_t		*mcp;
+    int			i;
+
+    if ((mcp = getcache(ctxp, 0)) == NULL)
+	return;
+    for (i = 0; i < MC_COUNT; i++) {
+	clear(mcp, i);
+	__pmHashClear(&mcp->hash[i]);
+    }
+    free(mcp);
+    ctxp->c_metacache = NULL;
+}
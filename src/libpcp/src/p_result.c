@@ -78,16 +78,43 @@ typedef struct {
     __int32_t	data[1];	/* zero or more */
 } log_result_v3_t;
 
+/*
+ * Scatter-gather state while encoding a result to be sent: large
+ * string and aggregate value blocks are sent directly from the caller's
+ * pmValueBlock (only their header, and any bytes past the last whole
+ * __pmPDU, are written to the PDU buffer) rather than being copied.
+ */
+typedef struct {
+    __pmPDUVec	*vec;		/* segments completed so far */
+    int		nvec;
+    char	*seg;		/* start of the current PDU buffer segment */
+    int		refwords;	/* __pmPDUs sent from outside the buffer */
+} pduvec_t;
+
+/* value blocks at least this big are sent by reference */
+#define VBLOCK_BYREF	256
+
+static int
+vblock_byref(const pmValueBlock *vbp)
+{
+    return vbp->vlen >= VBLOCK_BYREF &&
+	   (vbp->vtype == PM_TYPE_STRING || vbp->vtype == PM_TYPE_AGGREGATE ||
+	    vbp->vtype == PM_TYPE_AGGREGATE_STATIC);
+}
+
 /*
  * This routine gets used for both PDUs and external log records, so
  * "type" is one of
  * - PDU_HIGHRES_RESULT - PDU
  * - PDU_RESULT - PDU or V2 archive
  * - PM_LOG_VERS03 - V3 archive
+ *
+ * If nrefp is not NULL, value blocks to be sent by reference are
+ * counted there, and only their in-buffer parts are included in vneed.
  */
-void
-__pmGetResultSize(int type, int numpmid, pmValueSet * const *vset,
-		size_t *needp, size_t *vneedp)
+static void
+getresultsize(int type, int numpmid, pmValueSet * const *vset,
+		size_t *needp, size_t *vneedp, int *nrefp)
 {
     size_t	need;	/* bytes for the PDU */
     size_t	vneed;	/* additional bytes for the pmValueBlocks on the end */
@@ -117,8 +144,19 @@ __pmGetResultSize(int type, int numpmid, pmValueSet * const *vset,
 	    /* plus value, instance pair */
 	    need += sizeof(__pmValue_PDU);
 	    if (vsp->valfmt == PM_VAL_DPTR || vsp->valfmt == PM_VAL_SPTR) {
-		/* plus pmValueBlock */
-		vneed += PM_PDU_SIZE_BYTES(vsp->vlist[j].value.pval->vlen);
+		const pmValueBlock	*vbp = vsp->vlist[j].value.pval;
+
+		if (nrefp != NULL && vblock_byref(vbp)) {
+		    /* header, plus any partial trailing __pmPDU */
+		    vneed += sizeof(__pmPDU);
+		    if ((vbp->vlen - PM_VAL_HDR_SIZE) % sizeof(__pmPDU))
+			vneed += sizeof(__pmPDU);
+		    (*nrefp)++;
+		}
+		else {
+		    /* plus pmValueBlock */
+		    vneed += PM_PDU_SIZE_BYTES(vbp->vlen);
+		}
 	    }
 	}
 	if (j)
@@ -130,11 +168,53 @@ __pmGetResultSize(int type, int numpmid, pmValueSet * const *vset,
     *needp = need;
 }
 
+void
+__pmGetResultSize(int type, int numpmid, pmValueSet * const *vset,
+		size_t *needp, size_t *vneedp)
+{
+    getresultsize(type, numpmid, vset, needp, vneedp, NULL);
+}
+
+/*
+ * Add a value block to a scatter-gather PDU by reference, ending the
+ * current PDU buffer segment after its header.  Returns the position
+ * in the PDU buffer for what follows.
+ */
+static __pmPDU *
+__pmEncodeValueBlockRef(pduvec_t *pvp, __pmPDU *vbp, const pmValueBlock *vb)
+{
+    size_t	len = vb->vlen - PM_VAL_HDR_SIZE;
+    size_t	tail = len % sizeof(__pmPDU);
+    char	*padp;
+
+    memcpy((void *)vbp, (void *)vb, PM_VAL_HDR_SIZE);
+    __htonpmValueBlock((pmValueBlock *)vbp);
+    vbp++;
+
+    pvp->vec[pvp->nvec].base = pvp->seg;
+    pvp->vec[pvp->nvec].len = (char *)vbp - pvp->seg;
+    pvp->nvec++;
+    pvp->vec[pvp->nvec].base = vb->vbuf;
+    pvp->vec[pvp->nvec].len = len - tail;
+    pvp->nvec++;
+    pvp->refwords += (int)((len - tail) / sizeof(__pmPDU));
+    pvp->seg = (char *)vbp;
+
+    if (tail) {
+	/* trailing bytes and padding go in the next buffer segment */
+	padp = (char *)vbp;
+	memcpy(padp, &vb->vbuf[len - tail], tail);
+	memset(padp + tail, '~', sizeof(__pmPDU) - tail);	/* buffer end */
+	vbp++;
+    }
+    return vbp;
+}
+
 static void
 __pmEncodeValueSet(__pmPDU *pdubuf, int numpmid, pmValueSet * const *vset,
-		vlist_t *vlp, __pmPDU *vbp)
+		vlist_t *vlp, __pmPDU *vbp, pduvec_t *pvp)
 {
-    int		i, j, nb, pad, extra;
+    int		i, j, nb, pad, extra, offset;
 
     /*
      * Note: vbp, and hence offset in sent PDU is in units of __pmPDU
@@ -148,6 +228,16 @@ __pmEncodeValueSet(__pmPDU *pdubuf, int numpmid, pmValueSet * const *vset,
 	for (j = 0; j < vsp->numval; j++) {
 	    vlp->vlist[j].inst = htonl(vsp->vlist[j].inst);
 	    if (vsp->valfmt == PM_VAL_DPTR || vsp->valfmt == PM_VAL_SPTR) {
+		offset = (int)(vbp - pdubuf);
+		if (pvp != NULL) {
+		    offset += pvp->refwords;
+		    if (vblock_byref(vsp->vlist[j].value.pval)) {
+			vbp = __pmEncodeValueBlockRef(pvp, vbp,
+					vsp->vlist[j].value.pval);
+			vlp->vlist[j].value.lval = htonl(offset);
+			continue;
+		    }
+		}
 		/*
 		 * pmValueBlocks are harder!
 		 * -- need to copy the len field (len) + len bytes (vbuf)
@@ -162,7 +252,7 @@ __pmEncodeValueSet(__pmPDU *pdubuf, int numpmid, pmValueSet * const *vset,
 		}
 		__htonpmValueBlock((pmValueBlock *)vbp);
 		/* point to the value block at the end of the PDU */
-		vlp->vlist[j].value.lval = htonl((int)(vbp - pdubuf));
+		vlp->vlist[j].value.lval = htonl(offset);
 		vbp += PM_PDU_SIZE(nb);
 	    }
 	    else {
@@ -181,11 +271,42 @@ __pmEncodeValueSet(__pmPDU *pdubuf, int numpmid, pmValueSet * const *vset,
     }
 }
 
+/*
+ * Fill in the fixed fields of a PDU_RESULT or PDU_HIGHRES_RESULT PDU,
+ * returning where its vlists start.
+ */
+static vlist_t *
+__pmEncodeResultHeader(int type, const __pmResult *result, __pmPDU *pdubuf, size_t len)
+{
+    if (type == PDU_HIGHRES_RESULT) {
+	highres_result_t	*pp = (highres_result_t *)pdubuf;
+
+	pp->hdr.len = (int)len;
+	pp->hdr.type = type;
+	pp->numpmid = htonl(result->numpmid);
+	pp->timestamp.tv_sec = result->timestamp.sec;
+	pp->timestamp.tv_nsec = result->timestamp.nsec;
+	__htonll((char *)&pp->timestamp.tv_sec);
+	__htonll((char *)&pp->timestamp.tv_nsec);
+	return (vlist_t *)pp->data;
+    }
+    else {
+	result_t		*pp = (result_t *)pdubuf;
+
+	pp->hdr.len = (int)len;
+	pp->hdr.type = type;
+	__pmPutTimeval(&result->timestamp, (__int32_t *)&pp->timestamp);
+	pp->numpmid = htonl(result->numpmid);
+	return (vlist_t *)pp->data;
+    }
+}
+
 int
 __pmEncodeResult(const __pmLogCtl *lcp, const __pmResult *result, __pmPDU **pdu)
 {
     size_t	need, vneed;
     __pmPDU	*pdubuf;
+    vlist_t	*vlp;
     int		type = PDU_RESULT;
 
     if (lcp != NULL && __pmLogVersion(lcp) == PM_LOG_VERS03)
@@ -207,20 +328,13 @@ __pmEncodeResult(const __pmLogCtl *lcp, const __pmResult *result, __pmPDU **pdu)
 	lrp->type = PDU_RESULT;		/* not used for log records */
 	__pmPutTimestamp(&result->timestamp, &lrp->sec[0]);
 	lrp->numpmid = htonl(result->numpmid);
-	__pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
-			(vlist_t *)lrp->data, pdubuf + need/sizeof(__pmPDU));
+	vlp = (vlist_t *)lrp->data;
     }
     else {
-	result_t	*pp;
-	pp = (result_t *)pdubuf;
-	pp->hdr.len = (int)(need + vneed);
-	pp->hdr.type = type;
-	__pmPutTimeval(&result->timestamp, (__int32_t *)&pp->timestamp);
-	pp->numpmid = htonl(result->numpmid);
-
-	__pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
-			(vlist_t *)pp->data, pdubuf + need/sizeof(__pmPDU));
+	vlp = __pmEncodeResultHeader(type, result, pdubuf, need + vneed);
     }
+    __pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
+			vlp, pdubuf + need/sizeof(__pmPDU), NULL);
 
     /* Note PDU remains pinned ... see thread-safe comments above */
     *pdu = pdubuf;
@@ -232,7 +346,7 @@ __pmEncodeHighResResult(const __pmResult *result, __pmPDU **pdu)
 {
     size_t		need, vneed;
     __pmPDU		*pdubuf;
-    highres_result_t	*pp;
+    vlist_t		*vlp;
     int			type = PDU_HIGHRES_RESULT;
 
     __pmGetResultSize(type, result->numpmid, result->vset, &need, &vneed);
@@ -243,23 +357,71 @@ __pmEncodeHighResResult(const __pmResult *result, __pmPDU **pdu)
      */
     if ((pdubuf = __pmFindPDUBuf((int)(need + vneed + sizeof(int)))) == NULL)
 	return -oserror();
-    pp = (highres_result_t *)pdubuf;
-    pp->hdr.len = (int)(need + vneed);
-    pp->hdr.type = type;
-    pp->numpmid = htonl(result->numpmid);
-    pp->timestamp.tv_sec = result->timestamp.sec;
-    pp->timestamp.tv_nsec = result->timestamp.nsec;
-    __htonll((char *)&pp->timestamp.tv_sec);
-    __htonll((char *)&pp->timestamp.tv_nsec);
-
+    vlp = __pmEncodeResultHeader(type, result, pdubuf, need + vneed);
     __pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
-			(vlist_t *)pp->data, pdubuf + need/sizeof(__pmPDU));
+			vlp, pdubuf + need/sizeof(__pmPDU), NULL);
 
     /* Note PDU remains pinned ... see thread-safe comments above */
     *pdu = pdubuf;
     return 0;
 }
 
+/*
+ * Encode and send a result PDU in one pass over the value sets.  Large
+ * string and aggregate value blocks (process arguments, cgroup paths,
+ * and so on) are not copied into the PDU buffer; instead the PDU goes
+ * out in segments, gathered from the buffer and those value blocks.
+ */
+static int
+__pmSendResultVec(int fd, int from, int type, const __pmResult *result)
+{
+    size_t	need, vneed;
+    int		nrefs = 0;
+    int		sts;
+    __pmPDU	*pdubuf;
+    __pmPDUVec	*vec = NULL;
+    pduvec_t	pv;
+    vlist_t	*vlp;
+
+    /* PDU diagnostics dump the PDU, so it must be contiguous then */
+    getresultsize(type, result->numpmid, result->vset, &need, &vneed,
+		    pmDebugOptions.pdu ? NULL : &nrefs);
+    if (nrefs > 0 &&
+	(vec = (__pmPDUVec *)malloc((2 * nrefs + 1) * sizeof(*vec))) == NULL)
+	return -oserror();
+    if ((pdubuf = __pmFindPDUBuf((int)(need + vneed))) == NULL) {
+	sts = -oserror();
+	if (vec != NULL)
+	    free(vec);
+	return sts;
+    }
+    vlp = __pmEncodeResultHeader(type, result, pdubuf, need + vneed);
+    ((__pmPDUHdr *)pdubuf)->from = from;
+
+    if (vec == NULL) {
+	__pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
+			vlp, pdubuf + need/sizeof(__pmPDU), NULL);
+	sts = __pmXmitPDU(fd, pdubuf);
+    }
+    else {
+	pv.vec = vec;
+	pv.nvec = 0;
+	pv.seg = (char *)pdubuf;
+	pv.refwords = 0;
+	__pmEncodeValueSet(pdubuf, result->numpmid, result->vset,
+			vlp, pdubuf + need/sizeof(__pmPDU), &pv);
+	/* final segment, the rest of the PDU buffer */
+	vec[pv.nvec].base = pv.seg;
+	vec[pv.nvec].len = (char *)pdubuf + need + vneed - pv.seg;
+	pv.nvec++;
+	((__pmPDUHdr *)pdubuf)->len += pv.refwords * sizeof(__pmPDU);
+	sts = __pmXmitPDUVec(fd, vec, pv.nvec);
+	free(vec);
+    }
+    __pmUnpinPDUBuf(pdubuf);
+    return sts;
+}
+
 /*
  * Internal variant of __pmSendResult() with current context.
  */
@@ -278,6 +440,8 @@ __pmSendResult_ctx(__pmContext *ctxp, int fd, int from, const __pmResult *result
 	__pmPrintResult_ctx(ctxp, stderr, result);
     if (ctxp != NULL && ctxp->c_type == PM_CONTEXT_ARCHIVE)
 	lcp = ctxp->c_archctl->ac_log;
+    if (lcp == NULL)
+	return __pmSendResultVec(fd, from, PDU_RESULT, result);
     if ((sts = __pmEncodeResult(lcp, result, &pdubuf)) < 0)
 	return sts;
     pp = (result_t *)pdubuf;
@@ -299,22 +463,12 @@ __pmSendResult(int fd, int from, const __pmResult *result)
 int
 __pmSendHighResResult_ctx(__pmContext *ctxp, int fd, int from, const __pmResult *result)
 {
-    __pmPDU		*pdubuf = NULL;
-    highres_result_t	*pp;
-    int			sts;
-
     if (ctxp != NULL)
 	PM_ASSERT_IS_LOCKED(ctxp->c_lock);
 
     if (pmDebugOptions.pdu)
 	__pmPrintResult_ctx(ctxp, stderr, result);
-    if ((sts = __pmEncodeHighResResult(result, &pdubuf)) < 0)
-	return sts;
-    pp = (highres_result_t *)pdubuf;
-    pp->hdr.from = from;
-    sts = __pmXmitPDU(fd, pdubuf);
-    __pmUnpinPDUBuf(pdubuf);
-    return sts;
+    return __pmSendResultVec(fd, from, PDU_HIGHRES_RESULT, result);
 }
 
 int
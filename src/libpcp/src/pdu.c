@@ -434,13 +434,53 @@ __pmIgnoreSignalPIPE(void)
 void __pmIgnoreSignalPIPE(void) {}
 #endif
 
+/* Error status for a PDU that could not be sent in full */
+static int
+xmiterror(int socketipc, const char *caller)
+{
+    int		sts;
+
+    if (socketipc) {
+	sts = -neterror();
+	if (__pmSocketClosed()) {
+	    if (pmDebugOptions.pdu)
+		fprintf(stderr, "%s: PM_ERR_IPC because __pmSocketClosed() "
+				"(maybe error %d from oserror())\n",
+				caller, oserror());
+	    return PM_ERR_IPC;
+	}
+	if (sts != 0) {
+	    if (pmDebugOptions.pdu)
+		fprintf(stderr, "%s: error %d from neterror()\n", caller, sts);
+	    return sts;
+	}
+	else {
+	    if (pmDebugOptions.pdu)
+		fprintf(stderr, "%s: PM_ERR_IPC on socket path, reason unknown\n",
+				caller);
+	    return PM_ERR_IPC;
+	}
+    }
+    sts = -oserror();
+    if (sts != 0) {
+	if (pmDebugOptions.pdu)
+	    fprintf(stderr, "%s: error %d from oserror()\n", caller, sts);
+	return sts;
+    }
+    else {
+	if (pmDebugOptions.pdu)
+	    fprintf(stderr, "%s: PM_ERR_IPC on non-socket path, reason unknown\n",
+			    caller);
+	return PM_ERR_IPC;
+    }
+}
+
 int
 __pmXmitPDU(int fd, __pmPDU *pdubuf)
 {
     int		socketipc = __pmSocketIPC(fd);
     int		off = 0;
     int		len;
-    int		sts;
     __pmPDUHdr	*php = (__pmPDUHdr *)pdubuf;
 
     if (fd < 0)
@@ -499,42 +539,79 @@ __pmXmitPDU(int fd, __pmPDU *pdubuf)
     php->from = ntohl(php->from);
     php->type = ntohl(php->type);
 
-    if (off != len) {
-	if (socketipc) {
-	    sts = -neterror();
-	    if (__pmSocketClosed()) {
-		if (pmDebugOptions.pdu)
-		    fprintf(stderr, "%s: PM_ERR_IPC because __pmSocketClosed() "
-				    "(maybe error %d from oserror())\n",
-				    "__pmXmitPDU", oserror());
-		return PM_ERR_IPC;
-	    }
-	    if (sts != 0) {
-		if (pmDebugOptions.pdu)
-		    fprintf(stderr, "%s: error %d from neterror()\n",
-				    "__pmXmitPDU", sts);
-		return sts;
-	    }
-	    else {
-		if (pmDebugOptions.pdu)
-		    fprintf(stderr, "%s: PM_ERR_IPC on socket path, reason unknown\n",
-				    "__pmXmitPDU");
-		return PM_ERR_IPC;
-	    }
-	}
-	sts = -oserror();
-	if (sts != 0) {
+    if (off != len)
+	return xmiterror(socketipc, "__pmXmitPDU");
+
+    __pmOverrideLastFd(fd);
+    if (php->type >= PDU_START && php->type <= PDU_FINISH)
+	__pmPDUCntOut[php->type-PDU_START]++;
+    trace_insert(fd, 1, php);
+
+    return off;
+}
+
+/*
+ * Send a PDU held in several segments, typically the PDU buffer plus
+ * large value blocks that remain in the caller's memory (see
+ * __pmSendResult()), using as few system calls as possible.
+ *
+ * The segment array is consumed (updated) as the segments are sent.
+ */
+int
+__pmXmitPDUVec(int fd, __pmPDUVec *vec, int nvec)
+{
+    int		socketipc = __pmSocketIPC(fd);
+    int		off = 0;
+    int		len;
+    ssize_t	n;
+    char	strbuf[20];
+    __pmPDUHdr	*php = (__pmPDUHdr *)vec[0].base;
+
+    if (fd < 0)
+	return -EBADF;
+
+    __pmIgnoreSignalPIPE();
+
+    if (pmDebugOptions.pdu) {
+	if (mypid == -1)
+	    mypid = getpid();
+	fprintf(stderr, "[%" FMT_PID "]%s: %s fd=%d len=%d segments=%d\n",
+		mypid, "pmXmitPDUVec",
+		__pmPDUTypeStr_r(php->type, strbuf, sizeof(strbuf)),
+		fd, php->len, nvec);
+    }
+    len = php->len;
+
+    php->len = htonl(php->len);
+    php->from = htonl(php->from);
+    php->type = htonl(php->type);
+    while (nvec > 0) {
+	n = socketipc ? __pmSendVec(fd, vec, nvec) : __pmWriteVec(fd, vec, nvec, 0);
+	if (n < 0) {
 	    if (pmDebugOptions.pdu)
-		fprintf(stderr, "%s: error %d from oserror()\n", "__pmXmitPDU", sts);
-	    return sts;
+		fprintf(stderr, "%s: %s result %d != %d\n", "__pmXmitPDUVec",
+			socketipc ? "socket __pmSendVec()" : "non-socket writev()",
+			(int)n, len-off);
+	    break;
 	}
-	else {
-	    if (pmDebugOptions.pdu)
-		fprintf(stderr, "%s: PM_ERR_IPC on non-socket path, reason unknown\n",
-				"__pmXmitPDU");
-	    return PM_ERR_IPC;
+	off += n;
+	/* step over the segments sent, and into a partially sent one */
+	while (nvec > 0 && (size_t)n >= vec->len) {
+	    n -= vec->len;
+	    vec++;
+	    nvec--;
+	}
+	if (nvec > 0) {
+	    vec->base = (const char *)vec->base + n;
+	    vec->len -= n;
 	}
     }
+    php->len = ntohl(php->len);
+    php->from = ntohl(php->from);
+    php->type = ntohl(php->type);
+
+    if (off != len)
+	return xmiterror(socketipc, "__pmXmitPDUVec");
 
     __pmOverrideLastFd(fd);
     if (php->type >= PDU_START && php->type <= PDU_FINISH)
@@ -1915,6 +1915,16 @@ pmLookupName_ctx(__pmContext *ctxp, int derive_locked, int numpmid, const char *
 	    fputc('\n', stderr);
 	}
 
+	/* no round trip to pmcd if every name is in the metadata cache */
+	for (i = 0; i < numpmid; i++) {
+	    if (!__pmMetaCacheGetPMID(ctxp, namelist[i], &pmidlist[i]))
+		break;
+	}
+	if (i == numpmid)
+	    sts = base = num_ok = numpmid;
+	else
+	    memset(pmidlist, PM_ID_NULL, numpmid * sizeof(pmID));
+
 	/*
 	 * Avoid false DoS response from pmcd ...
 	 * pmcd has a hard 64 Kbyte max PDU length, so we need to be sure
@@ -2007,8 +2017,11 @@ PM_FAULT_POINT("libpcp/" __FILE__ ":1", PM_FAULT_CALL);
 	    base += num;
 	}
 
-	if (sts >= 0)
+	if (sts >= 0) {
 	    nfail = numpmid - num_ok;
+	    for (i = 0; i < numpmid; i++)
+		__pmMetaCachePutPMID(ctxp, namelist[i], pmidlist[i]);
+	}
 	if (pmDebugOptions.pmns) {
 	    fprintf(stderr, "pmLookupName: receive_names <-");
 	    if (sts >= 0) {
@@ -2642,13 +2655,29 @@ PM_FAULT_POINT("libpcp/" __FILE__ ":3", PM_FAULT_CALL);
     return n;
 }
 
+/*
+ * All names for pmid from pmcd, unless already in the metadata cache
+ */
+static int
+remote_namesbyid(__pmContext *ctxp, pmID pmid, char ***namelist)
+{
+    int n;
+
+    if ((n = __pmMetaCacheGetNames(ctxp, pmid, namelist)) != 0)
+	return n;
+    if ((n = request_namebypmid(ctxp, pmid)) >= 0 &&
+	(n = receive_namesbyid(ctxp, namelist)) > 0)
+	__pmMetaCachePutNames(ctxp, pmid, n, *namelist);
+    return n;
+}
+
 static int 
-receive_a_name(__pmContext *ctxp, char **name)
+remote_a_name(__pmContext *ctxp, pmID pmid, char **name)
 {
     int n;
     char **namelist;
 
-    if ((n = receive_namesbyid(ctxp, &namelist)) >= 0) {
+    if ((n = remote_namesbyid(ctxp, pmid, &namelist)) >= 0) {
 	char *newname = strdup(namelist[0]);
 	free(namelist);
 	if (newname == NULL) {
@@ -2753,9 +2782,7 @@ pmNameID(pmID pmid, char **name)
     else {
 	/* assume PMNS_REMOTE */
 	assert(c_type == PM_CONTEXT_HOST);
-	if ((sts = request_namebypmid(ctxp, pmid)) >= 0) {
-	    sts = receive_a_name(ctxp, name);
-	}
+	sts = remote_a_name(ctxp, pmid, name);
     }
 
     if (sts >= 0)
@@ -2923,9 +2950,7 @@ pmNameAll_ctx(__pmContext *ctxp, pmID pmid, char ***namelist)
     else {
 	/* assume PMNS_REMOTE */
 	assert(c_type == PM_CONTEXT_HOST);
-	if ((sts = request_namebypmid (ctxp, pmid)) >= 0) {
-	    sts = receive_namesbyid (ctxp, namelist);
-	}
+	sts = remote_namesbyid(ctxp, pmid, namelist);
 	if (sts > 0)
 	    goto pmapi_return;
     }
@@ -1428,6 +1428,20 @@ __pmSend(int fd, const void *buffer, size_t length, int flags)
     return send(fd, buffer, length, flags);
 }
 
+ssize_t
+__pmSendVec(int fd, const __pmPDUVec *vec, int nvec)
+{
+    __pmSecureSocket ss;
+
+    if (fd < 0)
+	return -EBADF;
+
+    /* TLS records are written one segment at a time */
+    if (__pmDataIPC(fd, &ss) == 0 && ss.ssl)
+	return __pmSend(fd, vec->base, vec->len, 0);
+    return __pmWriteVec(fd, vec, nvec, 1);
+}
+
 ssize_t
 __pmRecv(int fd, void *buffer, size_t length, int flags)
 {
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * Persistent worker threads, for PMDAs and tools that spread each of a
+ * series of batches (one per fetch, say) across several threads and would
+ * otherwise create and join those threads every time.
+ *
+ * Thread-safe notes
+ *
+ * Each pool has its own lock, protecting all of its fields.  A pool is
+ * driven by one thread at a time, which posts a batch with
+ * __pmWorkPoolStart(), may do work of its own, then waits for the batch
+ * to complete with __pmWorkPoolWait() before posting the next one.
+ */
+
+#include "pmapi.h"
+#include "libpcp.h"
+#include "internal.h"
+
+#ifdef PM_MULTI_THREAD
+typedef struct {
+    __pmWorkPool	*pool;
+    pthread_t		thread;
+    int			id;		/* task number this worker runs */
+    int			pending;	/* task posted, not yet started */
+} worker_t;
+#endif
+
+struct __pmWorkPool {
+#ifdef PM_MULTI_THREAD
+    pthread_mutex_t	lock;
+    pthread_cond_t	work;		/* tasks posted, or exiting */
+    pthread_cond_t	done;		/* last task of the batch completed */
+    __pmWorkFunc	func;
+    void		*arg;
+    int			nbusy;		/* tasks of the batch not completed */
+    int			exiting;
+    int			nworkers;
+    worker_t		**workers;
+#else
+    int			unused;
+#endif
+};
+
+#ifdef PM_MULTI_THREAD
+static void *
+worker(void *arg)
+{
+    worker_t		*wp = (worker_t *)arg;
+    __pmWorkPool	*pool = wp->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+	while (!wp->pending && !pool->exiting)
+	    pthread_cond_wait(&pool->work, &pool->lock);
+	if (pool->exiting)
+	    break;
+	wp->pending = 0;
+	pthread_mutex_unlock(&pool->lock);
+	pool->func(pool->arg, wp->id);
+	pthread_mutex_lock(&pool->lock);
+	if (--pool->nbusy == 0)
+	    pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+#endif
+
+__pmWorkPool *
+__pmWorkPoolCreate(void)
+{
+    __pmWorkPool	*pool;
+
+    if ((pool = (__pmWorkPool *)calloc(1, sizeof(*pool))) == NULL)
+	return NULL;
+#ifdef PM_MULTI_THREAD
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+#endif
+    return pool;
+}
+
+/*
+ * Post tasks 0 to ntasks-1 to the pool, starting more threads as needed.
+ * Returns the number of tasks posted, which is less than ntasks if no
+ * more threads could be started - the caller must run the remainder.
+ */
+int
+__pmWorkPoolStart(__pmWorkPool *pool, int ntasks, __pmWorkFunc func, void *arg)
+{
+#ifdef PM_MULTI_THREAD
+    worker_t		*wp;
+    void		*tmp;
+    int			i;
+
+    pthread_mutex_lock(&pool->lock);
+    if (ntasks > pool->nworkers) {
+	if ((tmp = realloc(pool->workers, ntasks * sizeof(worker_t *))) != NULL)
+	    pool->workers = (worker_t **)tmp;
+	else
+	    ntasks = pool->nworkers;
+    }
+    while (pool->nworkers < ntasks) {
+	if ((wp = (worker_t *)calloc(1, sizeof(*wp))) == NULL)
+	    break;
+	wp->pool = pool;
+	wp->id = pool->nworkers;
+	if (pthread_create(&wp->thread, NULL, worker, wp) != 0) {
+	    free(wp);
+	    break;
+	}
+	pool->workers[pool->nworkers++] = wp;
+    }
+    if (ntasks > pool->nworkers)
+	ntasks = pool->nworkers;
+
+    pool->func = func;
+    pool->arg = arg;
+    pool->nbusy = ntasks;
+    for (i = 0; i < ntasks; i++)
+	pool->workers[i]->pending = 1;
+    if (ntasks > 0)
+	pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    return ntasks;
+#else
+    (void)pool; (void)ntasks; (void)func; (void)arg;
+    return 0;
+#endif
+}
+
+/*
+ * Wait for all tasks posted by the last __pmWorkPoolStart() to complete
+ */
+void
+__pmWorkPoolWait(__pmWorkPool *pool)
+{
+#ifdef PM_MULTI_THREAD
+    pthread_mutex_lock(&pool->lock);
+    while (pool->nbusy > 0)
+	pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+#else
+    (void)pool;
+#endif
+}
+
+void
+__pmWorkPoolDestroy(__pmWorkPool *pool)
+{
+#ifdef PM_MULTI_THREAD
+    int			i;
+#endif
+
+    if (pool == NULL)
+	return;
+#ifdef PM_MULTI_THREAD
+    __pmWorkPoolWait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->exiting = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->nworkers; i++) {
+	pthread_join(pool->workers[i]->thread, NULL);
+	free(pool->workers[i]);
+    }
+    free(pool->workers);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+    free(pool);
+}
@@ -22,27 +22,87 @@
 #include <sys/stat.h>
 
 /*
- * simple linked list for each cache at this stage
+ * linked list of entries for each cache, in instance identifier order,
+ * indexed by open-addressing hash tables on instance and name
  */
 typedef struct entry {
     struct entry	*next;		/* in inst identifier order */
-    struct entry	*h_inst;	/* inst hash chain */
-    struct entry	*h_name;	/* name hash chain */
     int			inst;
     char		*name;
     int			hashlen;	/* smaller of strlen(name) and chars to first space */
     int			keylen;		/* > 0 if have key from pmdaCacheStoreKey() */
     void		*key;		/* != NULL if have key from pmdaCacheStoreKey() */
     int			state;
+    int			saved;		/* recorded in binary cache journal */
     void		*private;
     time_t		stamp;
+    time_t		jstamp;		/* stamp recorded in binary journal */
 } entry_t;
 
+/*
+ * entries are carved from contiguous arenas, and recycled via a
+ * free list rather than returned to malloc
+ */
+#define ARENA_ENTRIES	256
+
+typedef struct arena {
+    struct arena	*next;
+    int			nused;
+    entry_t		entries[ARENA_ENTRIES];
+} arena_t;
+
+/*
+ * hash table slot, keyed by inst (for ctl_inst) or by name hash (for
+ * ctl_name) so most probes need not touch the entry itself; linear
+ * probing, a NULL entry terminates the probe sequence
+ */
+typedef struct {
+    unsigned int	key;
+    entry_t		*entry;
+} slot_t;
+
 #define CACHE_VERSION1	1
 #define CACHE_VERSION2	2
-#define CACHE_VERSION	CACHE_VERSION2	/* version of external file format */
+#define CACHE_VERSION3	3
+#define CACHE_VERSION	CACHE_VERSION2	/* version of external text format */
 #define MAX_HASH_TRY	10
 
+/*
+ * Binary (CACHE_VERSION3) external format, used for caches marked with
+ * PMDA_CACHE_BINARY ... a fixed header followed by a journal of records,
+ * all fields in network byte order.  Saves append records describing
+ * just the changes since the last save, and the whole journal is only
+ * rewritten (compacted) when it holds many more records than entries.
+ * Text files (CACHE_VERSION1 and CACHE_VERSION2) are still loaded, and
+ * converted to the binary format on the next save.
+ */
+#define CACHE_MAGIC	"\177PMC"
+
+typedef struct {
+    char		magic[4];	/* CACHE_MAGIC */
+    __int32_t		version;	/* CACHE_VERSION3 */
+    __int32_t		ins_mode;
+    __int32_t		maxinst;
+} cache_header_t;
+
+typedef struct {
+    __int32_t		type;		/* CACHE_REC_* */
+    __int32_t		inst;
+    __int32_t		stamp_hi;
+    __int32_t		stamp_lo;
+    __int32_t		keylen;
+    __int32_t		namelen;	/* name follows key, not null-terminated */
+} cache_record_t;
+
+#define CACHE_REC_ADD	1	/* new entry, with stamp, key and name */
+#define CACHE_REC_DEL	2	/* entry culled */
+#define CACHE_REC_STAMP	3	/* entry stamp updated */
+
+#define CACHE_REC_SIZE(keylen, namelen) \
+	((sizeof(cache_record_t) + (keylen) + (namelen) + 3) & ~3)
+#define CACHE_COMPACT_MIN	1024	/* journal records before compaction */
+#define CACHE_STAMP_SLACK	60	/* seconds before journaling new stamp */
+
 /*
  * linked list of cache headers
  */
@@ -51,16 +111,27 @@ typedef struct hdr {
     entry_t		*first;		/* in inst order */
     entry_t		*last;		/* in inst order */
     entry_t		*save;		/* used in cache_walk() */
-    entry_t		**ctl_inst;	/* hash by inst chains */
-    entry_t		**ctl_name;	/* hash by name chains */
+    slot_t		*ctl_inst;	/* hash by inst table */
+    slot_t		*ctl_name;	/* hash by name table */
+    arena_t		*arena;		/* entry allocation arenas */
+    entry_t		*free;		/* recycled entries */
     pmInDom		indom;
-    int			hsize;
-    int			hbits;
+    int			hsize;		/* slots in each hash table */
+    int			hbits;		/* hsize - 1 */
+    int			hshift;		/* 32 - log2(hsize) */
+    int			hused;		/* slots used in each hash table */
+    int			hlimit;		/* entries before culled are reclaimed */
     int			nentry;		/* number of entries */
     int			ins_mode;	/* see insert_cache() */
     int			hstate;		/* dirty/clean/string state */
     int			keyhash_cnt[MAX_HASH_TRY];
     int			maxinst;	/* maximum inst */
+    int			journal;	/* binary journal matches saved entries */
+    int			nrecord;	/* records in binary journal */
+    int			nsaved;		/* entries saved in binary journal */
+    int			ndropped;	/* saved entries freed before next save */
+    int			maxdropped;
+    int			*dropped;	/* instances of those freed entries */
 } hdr_t;
 
 #define DEFAULT_MAXINST 0x7fffffff
@@ -69,8 +140,13 @@ typedef struct hdr {
 #define DIRTY_INSTANCE	0x1
 #define DIRTY_STAMP	0x2
 #define CACHE_STRINGS	0x4
+#define CACHE_BINARY	0x8
 
 static hdr_t	*base;		/* start of cache headers */
+static hdr_t	*lastcache;	/* most recently used cache header */
+static hdr_t	**indoms;	/* cache headers hashed by indom */
+static int	nindoms;	/* number of cache headers */
+static int	maxindoms;	/* slots in indoms table (power of 2) */
 static char 	filename[MAXPATHLEN];
 				/* for load/save ops */
 static char	*vdp;		/* first trip mkdir for load/save */
@@ -160,18 +236,78 @@ key_eq(entry_t *e, int keylen, const char *key)
     return 1;
 }
 
+static unsigned int
+hash_indom(pmInDom indom, int size)
+{
+    return (((unsigned int)indom * 0x9e3779b1U) >> 7) & (size - 1);
+}
+
+/*
+ * Lookup (but do not create) the cache header for an indom,
+ * from the open-addressing indom table
+ */
 static hdr_t *
-find_cache(pmInDom indom, int *sts)
+lookup_cache(pmInDom indom)
 {
     hdr_t	*h;
     int		i;
 
-    for (h = base; h != NULL; h = h->next) {
+    if ((h = lastcache) != NULL && h->indom == indom)
+	return h;
+    if (indoms == NULL)
+	return NULL;
+    for (i = hash_indom(indom, maxindoms); ; i = (i + 1) & (maxindoms - 1)) {
+	if ((h = indoms[i]) == NULL)
+	    return NULL;
 	if (h->indom == indom)
-	    return h;
+	    return (lastcache = h);
+    }
+}
+
+static int
+index_cache(hdr_t *h)
+{
+    hdr_t	**table;
+    hdr_t	*hp;
+    int		size, i;
+
+    if ((nindoms + 1) * 2 > maxindoms) {
+	size = maxindoms ? maxindoms * 2 : 64;
+	if ((table = (hdr_t **)calloc(size, sizeof(hdr_t *))) == NULL)
+	    return -oserror();
+	for (hp = base; hp != NULL; hp = hp->next) {
+	    for (i = hash_indom(hp->indom, size); table[i] != NULL; i = (i + 1) & (size - 1))
+		;
+	    table[i] = hp;
+	}
+	free(indoms);
+	indoms = table;
+	maxindoms = size;
     }
+    for (i = hash_indom(h->indom, maxindoms); indoms[i] != NULL; i = (i + 1) & (maxindoms - 1))
+	;
+    indoms[i] = h;
+    nindoms++;
+    return 0;
+}
+
+static hdr_t *
+find_cache(pmInDom indom, int *sts)
+{
+    hdr_t	*h;
+    int		i;
 
-    if ((h = (hdr_t *)malloc(sizeof(hdr_t))) == NULL) {
+    if ((h = lookup_cache(indom)) != NULL)
+	return h;
+
+    if ((h = (hdr_t *)malloc(sizeof(hdr_t))) != NULL) {
+	h->indom = indom;
+	if (index_cache(h) < 0) {
+	    free(h);
+	    h = NULL;
+	}
+    }
+    if (h == NULL) {
 	char	strbuf[20];
 	pmNotifyErr(LOG_ERR, 
 	     "find_cache: indom %s: unable to allocate memory for hdr_t",
@@ -183,18 +319,75 @@ find_cache(pmInDom indom, int *sts)
     base = h;
     h->first = NULL;
     h->last = NULL;
+    h->save = NULL;
+    h->arena = NULL;
+    h->free = NULL;
     h->hsize = 16;
     h->hbits = 0xf;
-    h->ctl_inst = (entry_t **)calloc(h->hsize, sizeof(entry_t *));
-    h->ctl_name = (entry_t **)calloc(h->hsize, sizeof(entry_t *));
-    h->indom = indom;
+    h->hshift = 32 - 4;
+    h->hused = 0;
+    h->hlimit = 4 * h->hsize;
+    h->ctl_inst = (slot_t *)calloc(h->hsize, sizeof(slot_t));
+    h->ctl_name = (slot_t *)calloc(h->hsize, sizeof(slot_t));
+    if (h->ctl_inst == NULL || h->ctl_name == NULL) {
+	/* no hash tables, use linear search */
+	free(h->ctl_inst);
+	free(h->ctl_name);
+	h->ctl_inst = h->ctl_name = NULL;
+    }
     h->nentry = 0;
     h->ins_mode = 0;
     h->hstate = 0;
     for (i = 0; i < MAX_HASH_TRY; i++)
 	h->keyhash_cnt[i] = 0;
     h->maxinst = DEFAULT_MAXINST;
-    return h;
+    h->journal = 0;
+    h->nrecord = 0;
+    h->nsaved = 0;
+    h->ndropped = 0;
+    h->maxdropped = 0;
+    h->dropped = NULL;
+    return (lastcache = h);
+}
+
+/*
+ * Entry allocation from the arenas, and release back to the free list
+ */
+static entry_t *
+alloc_entry(hdr_t *h)
+{
+    arena_t	*ap;
+    entry_t	*e;
+
+    if ((e = h->free) != NULL) {
+	h->free = e->next;
+	return e;
+    }
+    if ((ap = h->arena) == NULL || ap->nused == ARENA_ENTRIES) {
+	if ((ap = (arena_t *)malloc(sizeof(arena_t))) == NULL)
+	    return NULL;
+	ap->next = h->arena;
+	ap->nused = 0;
+	h->arena = ap;
+    }
+    return &ap->entries[ap->nused++];
+}
+
+static void
+free_entry(hdr_t *h, entry_t *e)
+{
+    e->next = h->free;
+    h->free = e;
+}
+
+/*
+ * Instance identifiers are often dense or strided, so spread them
+ * with a multiplicative hash and use the high order bits
+ */
+static inline unsigned int
+inst_slot(hdr_t *h, int inst)
+{
+    return ((unsigned int)inst * 0x9e3779b1U) >> h->hshift;
 }
 
 /*
@@ -216,34 +409,33 @@ walk_cache(hdr_t *h, int op)
 }
 
 /*
- * inst_or_name is 0 for inst hash list, 1 for name hash list
+ * inst_or_name is 0 for inst hash table, 1 for name hash table,
+ * the occupied slots and longest probe sequence are reported
  */
 static void
-dump_hash_list(FILE *fp, hdr_t *h, int inst_or_name, int i)
+dump_hash_stats(FILE *fp, hdr_t *h, int inst_or_name)
 {
-    entry_t	*e;
+    slot_t		*table = inst_or_name ? h->ctl_name : h->ctl_inst;
+    unsigned int	home;
+    unsigned int	probe;
+    unsigned int	maxprobe = 0;
+    int			used = 0;
+    int			i;
 
-    fprintf(fp, " [%03d]", i);
-    if (inst_or_name == 1) {
-	for (e = h->ctl_name[i]; e != NULL; e = e->h_name) {
-	    fprintf(fp, " -> %d", e->inst);
-	    if (e->state == PMDA_CACHE_EMPTY)
-		fputc('E', fp);
-	    else if (e->state == PMDA_CACHE_INACTIVE)
-		fputc('I', fp);
-	}
-	fputc('\n', fp);
-    }
-    else {
-	for (e = h->ctl_inst[i]; e != NULL; e = e->h_inst) {
-	    fprintf(fp, " -> %d", e->inst);
-	    if (e->state == PMDA_CACHE_EMPTY)
-		fputc('E', fp);
-	    else if (e->state == PMDA_CACHE_INACTIVE)
-		fputc('I', fp);
-	}
-	fputc('\n', fp);
+    for (i = 0; i < h->hsize; i++) {
+	if (table[i].entry == NULL)
+	    continue;
+	used++;
+	if (inst_or_name)
+	    home = table[i].key & h->hbits;
+	else
+	    home = inst_slot(h, (int)table[i].key);
+	probe = ((i - home) & h->hbits) + 1;
+	if (probe > maxprobe)
+	    maxprobe = probe;
     }
+    fprintf(fp, "%s hash: %d of %d slots used, longest probe %u\n",
+	    inst_or_name ? "name" : "inst", used, h->hsize, maxprobe);
 }
 
 static void
@@ -293,18 +485,10 @@ dump(FILE *fp, hdr_t *h, int do_hash)
 	}
     }
 
-    if (h->ctl_inst != NULL) {
-	fprintf(fp, "inst hash\n");
-	for (i = 0; i < h->hsize; i++) {
-	    dump_hash_list(fp, h, 0, i);
-	}
-    }
-    if (h->ctl_name != NULL) {
-	fprintf(fp, "name hash\n");
-	for (i = 0; i < h->hsize; i++) {
-	    dump_hash_list(fp, h, 1, i);
-	}
-    }
+    if (h->ctl_inst != NULL)
+	dump_hash_stats(fp, h, 0);
+    if (h->ctl_name != NULL)
+	dump_hash_stats(fp, h, 1);
 }
 
 static entry_t *
@@ -346,6 +530,9 @@ static entry_t *
 find_entry(hdr_t *h, const char *name, int inst, int *sts)
 {
     entry_t	*e;
+    slot_t	*sp;
+    unsigned int	i;
+    unsigned int	key;
 
     *sts = 0;
     if (name == NULL) {
@@ -355,8 +542,12 @@ find_entry(hdr_t *h, const char *name, int inst, int *sts)
 	if (h->ctl_inst == NULL)
 	    /* no hash, use linear search */
 	    return find_inst(h, inst);
-	for (e = h->ctl_inst[inst & h->hbits]; e != NULL; e = e->h_inst) {
-	    if (e->inst == inst && e->state != PMDA_CACHE_EMPTY)
+	key = (unsigned int)inst;
+	for (i = inst_slot(h, inst); ; i = (i + 1) & h->hbits) {
+	    sp = &h->ctl_inst[i];
+	    if ((e = sp->entry) == NULL)
+		break;
+	    if (sp->key == key && e->state != PMDA_CACHE_EMPTY)
 		return e;
 	}
     }
@@ -369,8 +560,12 @@ find_entry(hdr_t *h, const char *name, int inst, int *sts)
 	if (h->ctl_name == NULL)
 	    /* no hash, use linear search */
 	    return find_name(h, name, sts);
-	for (e = h->ctl_name[hash_str((const signed char *)name, hashlen) & h->hbits]; e != NULL; e = e->h_name) {
-	    if (e->state != PMDA_CACHE_EMPTY) {
+	key = hash_str((const signed char *)name, hashlen);
+	for (i = key & h->hbits; ; i = (i + 1) & h->hbits) {
+	    sp = &h->ctl_name[i];
+	    if ((e = sp->entry) == NULL)
+		break;
+	    if (sp->key == key && e->state != PMDA_CACHE_EMPTY) {
 		if ((*sts = name_eq(e, name, hashlen)))
 		    return e;
 	    }
@@ -381,143 +576,107 @@ find_entry(hdr_t *h, const char *name, int inst, int *sts)
 }
 
 /*
- * optionally resize the hash table first (if resize == 1)
- *
- * then re-order each hash chain so that active entries are
- * before inactive entries, and culled entries dropped
- *
- * applies to _both_ the inst and name hashes
+ * add an entry to both hash tables, which must have a free slot
  */
 static void
-redo_hash(hdr_t *h, int resize)
+hash_entry(hdr_t *h, entry_t *e)
 {
-    entry_t	*e;
-    entry_t	*last_e = NULL;
-    entry_t	*t;
-    int		i;
-    entry_t	*last_active;
-    entry_t	*inactive;
-    entry_t	*last_inactive;
-
-    if (resize) {
-	entry_t		**old_inst;
-	entry_t		**old_name;
-	int		oldsize;
-	int		oldi;
-
-	old_inst = h->ctl_inst;
-	old_name = h->ctl_name;
-	oldsize = h->hsize;
-	h->hsize <<= 1;
-	h->ctl_inst = (entry_t **)calloc(h->hsize, sizeof(entry_t *));
-	if (h->ctl_inst == NULL) {
-	    h->ctl_inst = old_inst;
-	    h->hsize = oldsize;
-	    goto reorder;
-	}
-	h->ctl_name = (entry_t **)calloc(h->hsize, sizeof(entry_t *));
-	if (h->ctl_name == NULL) {
-	    free(h->ctl_inst);
-	    h->ctl_inst = old_inst;
-	    h->ctl_name = old_name;
-	    h->hsize = oldsize;
-	    goto reorder;
-	}
-	h->hbits = (h->hbits << 1) | 1;
-	for (oldi = 0; oldi < oldsize; oldi++) {
-	    for (e = old_inst[oldi]; e != NULL; ) {
-		t = e;
-		e = e->h_inst;
-		i = t->inst & h->hbits;
-		t->h_inst = h->ctl_inst[i];
-		h->ctl_inst[i] = t;
-	    }
-	}
-	for (oldi = 0; oldi < oldsize; oldi++) {
-	    for (e = old_name[oldi]; e != NULL; ) {
-		t = e;
-		e = e->h_name;
-		i = hash_str((const signed char *)t->name, t->hashlen) & h->hbits;
-		t->h_name = h->ctl_name[i];
-		h->ctl_name[i] = t;
-	    }
-	}
-	free(old_inst);
-	free(old_name);
-    }
-reorder:
+    unsigned int	i;
+    unsigned int	key;
 
-    /*
-     * first the inst hash list, moving active entries before inactive ones,
-     * and unlinking any empty ones
-     */ 
-    for (i = 0; i < h->hsize; i++) {
-	last_active = NULL;
-	inactive = NULL;
-	last_inactive = NULL;
-	e = h->ctl_inst[i];
-	h->ctl_inst[i] = NULL;
-	while (e != NULL) {
-	    t = e;
-	    e = e->h_inst;
-	    t->h_inst = NULL;
-	    if (t->state == PMDA_CACHE_ACTIVE) {
-		if (last_active == NULL)
-		    h->ctl_inst[i] = t;
-		else
-		    last_active->h_inst = t;
-		last_active = t;
-	    }
-	    else if (t->state == PMDA_CACHE_INACTIVE) {
-		if (last_inactive == NULL)
-		    inactive = t;
-		else
-		    last_inactive->h_inst = t;
-		last_inactive = t;
-	    }
+    for (i = inst_slot(h, e->inst); h->ctl_inst[i].entry != NULL; i = (i + 1) & h->hbits)
+	;
+    h->ctl_inst[i].key = (unsigned int)e->inst;
+    h->ctl_inst[i].entry = e;
+
+    key = hash_str((const signed char *)e->name, e->hashlen);
+    for (i = key & h->hbits; h->ctl_name[i].entry != NULL; i = (i + 1) & h->hbits)
+	;
+    h->ctl_name[i].key = key;
+    h->ctl_name[i].entry = e;
+
+    h->hused++;
+}
+
+/*
+ * An entry recorded in the binary journal is being freed, remember
+ * the instance so the next save can journal its removal (or failing
+ * that, compact the journal)
+ */
+static void
+drop_saved(hdr_t *h, int inst)
+{
+    int		*dropped;
+    int		size;
+
+    if (h->ndropped == h->maxdropped) {
+	size = h->maxdropped ? h->maxdropped * 2 : 16;
+	if ((dropped = realloc(h->dropped, size * sizeof(int))) == NULL) {
+	    h->journal = 0;
+	    return;
 	}
-	if (last_active == NULL)
-	    h->ctl_inst[i] = inactive;
-	else
-	    last_active->h_inst = inactive;
+	h->dropped = dropped;
+	h->maxdropped = size;
     }
+    h->dropped[h->ndropped++] = inst;
+}
 
-    /*
-     * and now the name hash list, doing the same thing
-     */
-    for (i = 0; i < h->hsize; i++) {
-	last_active = NULL;
-	inactive = NULL;
-	last_inactive = NULL;
-	e = h->ctl_name[i];
-	h->ctl_name[i] = NULL;
-	while (e != NULL) {
-	    t = e;
-	    e = e->h_name;
-	    t->h_name = NULL;
-	    if (t->state == PMDA_CACHE_ACTIVE) {
-		if (last_active == NULL)
-		    h->ctl_name[i] = t;
-		else
-		    last_active->h_name = t;
-		last_active = t;
-	    }
-	    else if (t->state == PMDA_CACHE_INACTIVE) {
-		if (last_inactive == NULL)
-		    inactive = t;
-		else
-		    last_inactive->h_name = t;
-		last_inactive = t;
-	    }
-	}
-	if (last_active == NULL)
-	    h->ctl_name[i] = inactive;
-	else
-	    last_active->h_name = inactive;
+
+/*
+ * rebuild both hash tables from all entries in the instance list,
+ * culled or not, sized for at least count entries
+ */
+static void
+build_hash(hdr_t *h, int count)
+{
+    entry_t	*e;
+    slot_t	*new_inst;
+    slot_t	*new_name;
+    int		size, shift;
+
+    /* keep the load factor below one half, with room to grow */
+    for (size = 16, shift = 32 - 4; size < 2 * (count + 1); size <<= 1)
+	shift--;
+
+    new_inst = (slot_t *)calloc(size, sizeof(slot_t));
+    new_name = (slot_t *)calloc(size, sizeof(slot_t));
+    free(h->ctl_inst);
+    free(h->ctl_name);
+    if (new_inst == NULL || new_name == NULL) {
+	/* no memory for the hash tables, fall back to linear search */
+	free(new_inst);
+	free(new_name);
+	new_inst = new_name = NULL;
+	size = 16;
+	shift = 32 - 4;
+    }
+    h->ctl_inst = new_inst;
+    h->ctl_name = new_name;
+    h->hsize = size;
+    h->hbits = size - 1;
+    h->hshift = shift;
+    h->hused = 0;
+    if (new_inst != NULL) {
+	for (e = h->first; e != NULL; e = e->next)
+	    hash_entry(h, e);
     }
+}
+
+/*
+ * drop culled entries from the instance list, then rebuild both hash
+ * tables from the remaining entries - optionally (if resize == 1)
+ * sizing the tables for more entries, else for the current entries
+ */
+static void
+redo_hash(hdr_t *h, int resize)
+{
+    entry_t	*e;
+    entry_t	*last_e = NULL;
+    entry_t	*t;
+    int		count = 0;
 
     /*
-     * now walk the instance list, removing any culled entries and
+     * walk the instance list, removing any culled entries and
      * rebuilding the linked list
      */
     e = h->first;
@@ -525,18 +684,30 @@ reorder:
 	t = e;
 	e = e->next;
 	if (t->state == PMDA_CACHE_EMPTY) {
+	    if (h->save == t)
+		h->save = e;
 	    if (last_e == NULL)
 		h->first = e;
 	    else
 		last_e->next = e;
+	    if (t->saved)
+		drop_saved(h, t->inst);
 	    if (t->name)
 		free(t->name);
-	    free(t);
+	    if (t->key)
+		free(t->key);
+	    free_entry(h, t);
 	}
-	else
+	else {
 	    last_e = t;
+	    count++;
+	}
     }
+    h->last = last_e;
 
+    if (resize)
+	count = count > h->hused ? count : h->hused;
+    build_hash(h, count);
 }
 
 /*
@@ -558,7 +729,6 @@ insert_cache(hdr_t *h, const char *name, int inst, int *sts)
     entry_t	*e;
     entry_t	*last_e = NULL;
     char	*dup;
-    int		i;
     int		hashlen;
 
     *sts = 0;
@@ -688,7 +858,7 @@ retry:
 	}
     }
 
-    if ((e = (entry_t *)malloc(sizeof(entry_t))) == NULL) {
+    if ((e = alloc_entry(h)) == NULL) {
 	char	strbuf[20];
 	pmNotifyErr(LOG_ERR, 
 	     "insert_cache: indom %s: unable to allocate memory for entry_t",
@@ -713,6 +883,7 @@ retry:
     e->hashlen = get_hashlen(h, dup);
     e->key = NULL;
     e->state = PMDA_CACHE_INACTIVE;
+    e->saved = 0;
     e->private = NULL;
     e->stamp = 0;
     if (h->last == NULL || h->last->inst < inst)
@@ -720,31 +891,403 @@ retry:
     h->nentry++;
 
     /*
-     * try to keep hash table sized so there are on average no
-     * more than 4 entries per hash chain
+     * culled entries are reclaimed each time the number of entries
+     * doubles (and not as the hash tables grow), so instance
+     * identifiers are reused no sooner than they always have been
      */
-    if (h->hsize > 0 && h->nentry > 4 * h->hsize)
-	redo_hash(h, 1);
+    if (h->nentry > h->hlimit) {
+	h->hlimit <<= 1;
+	redo_hash(h, 1);	/* rebuilt tables include this entry */
+    }
+    /*
+     * keep the open-addressing hash tables no more than three
+     * quarters full, culled entries still take their slots
+     */
+    else if (h->ctl_inst != NULL) {
+	if ((h->hused + 1) * 4 > h->hsize * 3)
+	    build_hash(h, h->hused + 1);	/* including this entry */
+	else
+	    hash_entry(h, e);
+    }
 
-    /* link into the inst hash list, if any */
-    if (h->ctl_inst != NULL) {
-	i = inst & h->hbits;
-	e->h_inst = h->ctl_inst[i];
-	h->ctl_inst[i] = e;
+    return e;
+}
+
+/*
+ * Growable buffer used to build binary cache journal records
+ */
+typedef struct {
+    char	*buf;
+    size_t	len;
+    size_t	size;
+} journal_t;
+
+static int
+put_record(journal_t *jp, int type, entry_t *e, int inst)
+{
+    cache_record_t	rec;
+    size_t		need, size;
+    char		*p;
+    int			keylen = 0;
+    int			namelen = 0;
+    __uint64_t		stamp = 0;
+
+    if (type == CACHE_REC_ADD) {
+	keylen = e->keylen > 0 ? e->keylen : 0;
+	namelen = strlen(e->name);
+    }
+    if (e != NULL)
+	stamp = (__uint64_t)e->stamp;
+
+    need = CACHE_REC_SIZE(keylen, namelen);
+    if (jp->len + need > jp->size) {
+	size = jp->size ? jp->size * 2 : 8192;
+	while (size < jp->len + need)
+	    size *= 2;
+	if ((p = (char *)realloc(jp->buf, size)) == NULL)
+	    return -oserror();
+	jp->buf = p;
+	jp->size = size;
     }
-    else
-	e->h_inst = NULL;
 
-    /* link into the name hash list, if any */
-    if (h->ctl_name != NULL) {
-	i = hash_str((const signed char *)e->name, e->hashlen) & h->hbits;
-	e->h_name = h->ctl_name[i];
-	h->ctl_name[i] = e;
+    rec.type = htonl(type);
+    rec.inst = htonl(inst);
+    rec.stamp_hi = htonl((__uint32_t)(stamp >> 32));
+    rec.stamp_lo = htonl((__uint32_t)(stamp & 0xffffffff));
+    rec.keylen = htonl(keylen);
+    rec.namelen = htonl(namelen);
+    p = jp->buf + jp->len;
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+    if (keylen > 0) {
+	memcpy(p, e->key, keylen);
+	p += keylen;
+    }
+    if (namelen > 0) {
+	memcpy(p, e->name, namelen);
+	p += namelen;
+    }
+    memset(p, 0, need - sizeof(rec) - keylen - namelen);
+    jp->len += need;
+    return 0;
+}
+
+static void
+put_header(hdr_t *h, cache_header_t *hdr)
+{
+    memcpy(hdr->magic, CACHE_MAGIC, sizeof(hdr->magic));
+    hdr->version = htonl(CACHE_VERSION3);
+    hdr->ins_mode = htonl(h->ins_mode);
+    hdr->maxinst = htonl(h->maxinst);
+}
+
+/*
+ * Replay a binary cache journal, the first byte of which has been
+ * consumed already
+ */
+static int
+load_binary(hdr_t *h, FILE *fp)
+{
+    cache_header_t	hdr;
+    cache_record_t	rec;
+    struct stat		sbuf;
+    entry_t		*e;
+    char		*buf, *p, *end, *name;
+    char		save;
+    __uint64_t		stamp;
+    int			type, inst, keylen, namelen;
+    int			expect;
+    int			culled = 0;
+    int			sts;
+
+    if (fstat(fileno(fp), &sbuf) < 0)
+	return -oserror();
+    if (sbuf.st_size < sizeof(hdr))
+	goto badhdr;
+    if ((buf = (char *)malloc(sbuf.st_size + 1)) == NULL) {
+	char	strbuf[20];
+	pmNotifyErr(LOG_ERR, 
+	     "load_cache: indom %s: unable to allocate %lld bytes for %s",
+	     pmInDomStr_r(h->indom, strbuf, sizeof(strbuf)),
+	     (long long)sbuf.st_size, filename);
+	return PM_ERR_GENERIC;
+    }
+    rewind(fp);
+    if (fread(buf, 1, sbuf.st_size, fp) != sbuf.st_size) {
+	free(buf);
+	goto badhdr;
+    }
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) != 0 ||
+	ntohl(hdr.version) != CACHE_VERSION3 ||
+	(int)ntohl(hdr.ins_mode) < 0 || (int)ntohl(hdr.ins_mode) > 1 ||
+	(int)ntohl(hdr.maxinst) < 0) {
+	free(buf);
+	goto badhdr;
+    }
+    h->ins_mode = ntohl(hdr.ins_mode);
+    h->maxinst = ntohl(hdr.maxinst);
+    h->nrecord = 0;
+
+    /* size hash tables for the expected number of entries up front */
+    expect = (sbuf.st_size - sizeof(hdr)) / CACHE_REC_SIZE(0, 8);
+    if (h->ctl_inst != NULL && (h->hused + expect) * 4 > h->hsize * 3)
+	build_hash(h, h->hused + expect);
+
+    end = buf + sbuf.st_size;
+    for (p = buf + sizeof(hdr); p + sizeof(rec) <= end;
+	 p += CACHE_REC_SIZE(keylen, namelen)) {
+	memcpy(&rec, p, sizeof(rec));
+	type = ntohl(rec.type);
+	inst = ntohl(rec.inst);
+	keylen = ntohl(rec.keylen);
+	namelen = ntohl(rec.namelen);
+	if (keylen < 0 || namelen < 0 ||
+	    CACHE_REC_SIZE(keylen, namelen) > end - p)
+	    break;
+	stamp = ((__uint64_t)ntohl(rec.stamp_hi) << 32) | ntohl(rec.stamp_lo);
+	h->nrecord++;
+
+	if (type == CACHE_REC_ADD) {
+	    /* name is not null-terminated in the journal */
+	    name = p + sizeof(rec) + keylen;
+	    save = name[namelen];
+	    name[namelen] = '\0';
+	    e = insert_cache(h, name, inst, &sts);
+	    if (e == NULL) {
+		free(buf);
+		return sts;
+	    }
+	    if (sts != 0) {
+		pmNotifyErr(LOG_WARNING,
+		    "pmdaCacheOp: %s: loading instance %d (\"%s\") ignored, already in cache as %d (\"%s\")",
+		    filename, inst, name, e->inst, e->name);
+		name[namelen] = save;
+		continue;
+	    }
+	    name[namelen] = save;
+	    if (e->key != NULL)
+		free(e->key);
+	    e->key = NULL;
+	    e->keylen = 0;
+	    if (keylen > 0) {
+		if ((e->key = malloc(keylen)) == NULL) {
+		    char	strbuf[20];
+		    pmNotifyErr(LOG_ERR, 
+			 "load_cache: indom %s: unable to allocate memory for keylen=%d",
+			 pmInDomStr_r(h->indom, strbuf, sizeof(strbuf)), keylen);
+		    free(buf);
+		    return PM_ERR_GENERIC;
+		}
+		memcpy(e->key, p + sizeof(rec), keylen);
+		e->keylen = keylen;
+	    }
+	    e->stamp = e->jstamp = (time_t)stamp;
+	    if (!e->saved) {
+		e->saved = 1;
+		h->nsaved++;
+	    }
+	}
+	else if (type == CACHE_REC_DEL) {
+	    if ((e = find_entry(h, NULL, inst, &sts)) != NULL) {
+		e->state = PMDA_CACHE_EMPTY;
+		if (e->saved) {
+		    e->saved = 0;
+		    h->nsaved--;
+		}
+		culled++;
+	    }
+	}
+	else if (type == CACHE_REC_STAMP) {
+	    if ((e = find_entry(h, NULL, inst, &sts)) != NULL)
+		e->stamp = e->jstamp = (time_t)stamp;
+	}
+	else {
+	    h->nrecord--;
+	    break;
+	}
+    }
+    free(buf);
+
+    if (p != end) {
+	/* torn or corrupt trailing record, rewrite journal at next save */
+	pmNotifyErr(LOG_WARNING,
+	     "pmdaCacheOp: %s: ignoring %d bytes after %d cache records",
+	     filename, (int)(end - p), h->nrecord);
+	h->journal = 0;
+	h->hstate |= DIRTY_INSTANCE;
     }
     else
-	e->h_name = NULL;
+	h->journal = 1;
+    h->ndropped = 0;
 
-    return e;
+    /* release culled entries, already removed from the journal */
+    if (culled) {
+	redo_hash(h, 0);
+	h->nentry -= culled;
+    }
+
+    if (pmDebugOptions.indom) {
+	fprintf(stderr, "After PMDA_CACHE_LOAD (binary, %d records)\n",
+		h->nrecord);
+	dump(stderr, h, 0);
+    }
+
+    return h->nsaved;
+
+badhdr:
+    pmNotifyErr(LOG_ERR, 
+	 "pmdaCacheOp: %s: illegal binary cache header", filename);
+    return PM_ERR_GENERIC;
+}
+
+/*
+ * Write a compacted binary cache journal, with one record for each
+ * entry, via a temporary file so a failure leaves the previous one
+ */
+static int
+write_binary(hdr_t *h, time_t now)
+{
+    cache_header_t	hdr;
+    journal_t		journal = { NULL, 0, 0 };
+    entry_t		*e;
+    char		tmpname[MAXPATHLEN+4];
+    int			cnt = 0;
+    int			fd, sts = 0;
+
+    h->journal = 0;
+    for (e = h->first; e != NULL; e = e->next) {
+	e->saved = 0;
+	if (e->state == PMDA_CACHE_EMPTY)
+	    continue;
+	if (e->stamp == 0)
+	    e->stamp = now;
+	if ((sts = put_record(&journal, CACHE_REC_ADD, e, e->inst)) < 0)
+	    goto done;
+	cnt++;
+    }
+
+    put_header(h, &hdr);
+    pmsprintf(tmpname, sizeof(tmpname), "%s.new", filename);
+    if ((fd = open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0666)) < 0) {
+	sts = -oserror();
+	goto done;
+    }
+    if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	(journal.len > 0 && write(fd, journal.buf, journal.len) != journal.len)) {
+	sts = -oserror();
+	close(fd);
+	unlink(tmpname);
+	goto done;
+    }
+    close(fd);
+    if (rename(tmpname, filename) < 0) {
+	sts = -oserror();
+	unlink(tmpname);
+	goto done;
+    }
+
+    for (e = h->first; e != NULL; e = e->next) {
+	if (e->state != PMDA_CACHE_EMPTY) {
+	    e->saved = 1;
+	    e->jstamp = e->stamp;
+	}
+    }
+    h->nrecord = h->nsaved = cnt;
+    h->ndropped = 0;
+    h->journal = 1;
+    sts = cnt;
+
+done:
+    if (journal.buf)
+	free(journal.buf);
+    return sts;
+}
+
+/*
+ * Append records for the changes since the last save to the binary
+ * cache journal - removals first, as an instance identifier may have
+ * been culled and then reused for a new entry
+ */
+static int
+append_binary(hdr_t *h, time_t now)
+{
+    cache_header_t	hdr;
+    journal_t		journal = { NULL, 0, 0 };
+    entry_t		*e;
+    int			i, fd, sts = 0;
+    int			nrecord = 0;
+    int			nsaved = h->nsaved;
+
+    for (i = 0; i < h->ndropped; i++) {
+	if ((sts = put_record(&journal, CACHE_REC_DEL, NULL, h->dropped[i])) < 0)
+	    goto fail;
+	nrecord++;
+	nsaved--;
+    }
+    for (e = h->first; e != NULL; e = e->next) {
+	if (e->state != PMDA_CACHE_EMPTY || !e->saved)
+	    continue;
+	if ((sts = put_record(&journal, CACHE_REC_DEL, e, e->inst)) < 0)
+	    goto fail;
+	nrecord++;
+	nsaved--;
+    }
+    for (e = h->first; e != NULL; e = e->next) {
+	if (e->state == PMDA_CACHE_EMPTY)
+	    continue;
+	if (e->stamp == 0)
+	    e->stamp = now;
+	if (!e->saved) {
+	    if ((sts = put_record(&journal, CACHE_REC_ADD, e, e->inst)) < 0)
+		goto fail;
+	    nrecord++;
+	    nsaved++;
+	}
+	else if (e->stamp - e->jstamp >= CACHE_STAMP_SLACK) {
+	    if ((sts = put_record(&journal, CACHE_REC_STAMP, e, e->inst)) < 0)
+		goto fail;
+	    nrecord++;
+	}
+    }
+
+    /* header is rewritten in place, ins_mode or maxinst may change */
+    put_header(h, &hdr);
+    if ((fd = open(filename, O_WRONLY)) < 0) {
+	sts = -oserror();
+	goto fail;
+    }
+    if (pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	lseek(fd, 0, SEEK_END) < 0 ||
+	(journal.len > 0 && write(fd, journal.buf, journal.len) != journal.len)) {
+	sts = -oserror();
+	close(fd);
+	goto fail;
+    }
+    close(fd);
+    if (journal.buf)
+	free(journal.buf);
+
+    for (e = h->first; e != NULL; e = e->next) {
+	if (e->state == PMDA_CACHE_EMPTY)
+	    e->saved = 0;
+	else {
+	    if (!e->saved || e->stamp - e->jstamp >= CACHE_STAMP_SLACK)
+		e->jstamp = e->stamp;
+	    e->saved = 1;
+	}
+    }
+    h->nrecord += nrecord;
+    h->nsaved = nsaved;
+    h->ndropped = 0;
+    return nsaved;
+
+fail:
+    /* journal may now be inconsistent, rewrite it at the next save */
+    h->journal = 0;
+    if (journal.buf)
+	free(journal.buf);
+    return sts;
 }
 
 static int
@@ -780,6 +1323,12 @@ load_cache(hdr_t *h)
 		pmInDomStr_r(h->indom, strbuf, sizeof(strbuf)));
     if ((fp = fopen(filename, "r")) == NULL)
 	return -oserror();
+    if ((s = getc(fp)) == CACHE_MAGIC[0]) {
+	cnt = load_binary(h, fp);
+	fclose(fp);
+	return cnt;
+    }
+    ungetc(s, fp);
     if (fgets(buf, sizeof(buf), fp) == NULL) {
 	pmNotifyErr(LOG_ERR, 
 	     "pmdaCacheOp: %s: empty file?", filename);
@@ -904,6 +1453,11 @@ bad:
     }
     fclose(fp);
 
+    /* text format, convert to binary on the next save if requested */
+    h->journal = 0;
+    if (h->hstate & CACHE_BINARY)
+	h->hstate |= DIRTY_INSTANCE;
+
     if (pmDebugOptions.indom) {
 	fprintf(stderr, "After PMDA_CACHE_LOAD\n");
 	dump(stderr, h, 0);
@@ -942,11 +1496,22 @@ save_cache(hdr_t *h, int hstate)
     pmsprintf(filename, sizeof(filename), "%s%cconfig%cpmda%c%s",
 		vdp, sep, sep, sep,
 		pmInDomStr_r(h->indom, strbuf, sizeof(strbuf)));
+    now = time(NULL);
+
+    if (h->hstate & CACHE_BINARY) {
+	if (h->journal && h->nrecord <= 2 * h->nsaved + CACHE_COMPACT_MIN)
+	    cnt = append_binary(h, now);
+	else
+	    cnt = write_binary(h, now);
+	if (cnt < 0)
+	    return cnt;
+	goto saved;
+    }
+
     if ((fp = fopen(filename, "w")) == NULL)
 	return -oserror();
     fprintf(fp, "%d %d %d\n", CACHE_VERSION, h->ins_mode, h->maxinst);
 
-    now = time(NULL);
     cnt = 0;
     for (e = h->first; e != NULL; e = e->next) {
 	if (e->state == PMDA_CACHE_EMPTY)
@@ -966,6 +1531,9 @@ save_cache(hdr_t *h, int hstate)
 	cnt++;
     }
     fclose(fp);
+    h->journal = 0;
+
+saved:
     h->hstate &= ~(DIRTY_INSTANCE | DIRTY_STAMP);
 
     if (pmDebugOptions.indom) {
@@ -1229,11 +1797,7 @@ int pmdaCacheOp(pmInDom indom, int op)
 
     if (op == PMDA_CACHE_CHECK) {
 	/* is there a cache for this one? */
-	for (h = base; h != NULL; h = h->next) {
-	    if (h->indom == indom)
-		return 1;
-	}
-	return 0;
+	return lookup_cache(indom) != NULL;
     }
 
     if ((h = find_cache(indom, &sts)) == NULL)
@@ -1252,6 +1816,15 @@ int pmdaCacheOp(pmInDom indom, int op)
 	case PMDA_CACHE_SYNC:
 	    return save_cache(h, DIRTY_INSTANCE|DIRTY_STAMP);
 
+	case PMDA_CACHE_BINARY:
+	    /* existing cache files are converted at the next save */
+	    if ((h->hstate & CACHE_BINARY) == 0) {
+		h->hstate |= CACHE_BINARY;
+		if (h->nentry > 0 && !h->journal)
+		    h->hstate |= DIRTY_INSTANCE;
+	    }
+	    return 0;
+
 	case PMDA_CACHE_STRINGS:
 	    /* must be set before any cache entries are added */
 	    if (h->nentry > 0)
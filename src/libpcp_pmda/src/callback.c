@@ -493,9 +493,207 @@ __pmdaEncodeStatus(pmdaResult *result, unsigned char byte)
 
 #define PMDA_STATUS_CHANGE (PMDA_EXT_LABEL_CHANGE|PMDA_EXT_NAMES_CHANGE)
 
+/*
+ * Report an error returned from a fetch callback for one metric instance
+ */
+static void
+__pmdaFetchError(pmID pmid, int inst, int sts)
+{
+    char		strbuf[20];
+
+    pmIDStr_r(pmid, strbuf, sizeof(strbuf));
+    if (sts == PM_ERR_PMID) {
+	pmNotifyErr(LOG_ERR, 
+	    "pmdaFetch: PMID %s not handled by fetch callback\n",
+		    strbuf);
+    }
+    else if (sts == PM_ERR_INST) {
+	pmNotifyErr(LOG_WARNING,
+	    "pmdaFetch: Instance %d of PMID %s not handled by fetch callback\n",
+	    inst, strbuf);
+    }
+    else if (sts == PM_ERR_VALUE ||
+	     sts == PM_ERR_APPVERSION ||
+	     sts == PM_ERR_PERMISSION ||
+	     sts == PM_ERR_AGAIN ||
+	     sts == PM_ERR_NYI) {
+	if (pmDebugOptions.libpmda) {
+	    logmsg(NULL,
+		 "Fetch callback error from metric PMID %s[%d]: %s\n",
+		strbuf, inst, pmErrStr(sts));
+	}
+    }
+    else {
+	pmNotifyErr(LOG_ERR,
+	    "pmdaFetch: Fetch callback error from metric PMID %s[%d]: %s\n",
+		    strbuf, inst, pmErrStr(sts));
+    }
+}
+
+/*
+ * Ensure the batch callback instance, value and status columns
+ * have room for at least need entries.
+ */
+static int
+__pmdaBatchResize(e_ext_t *extp, int need)
+{
+    unsigned int	*instlist;
+    pmAtomValue		*values;
+    int			*stslist;
+    int			size;
+
+    if (need <= extp->maxbatch)
+	return 0;
+    size = extp->maxbatch * 2;
+    if (size < need)
+	size = need;
+    if ((instlist = realloc(extp->batchinst, size * sizeof(*instlist))) == NULL)
+	return -oserror();
+    extp->batchinst = instlist;
+    if ((values = realloc(extp->batchvalues, size * sizeof(*values))) == NULL)
+	return -oserror();
+    extp->batchvalues = values;
+    if ((stslist = realloc(extp->batchsts, size * sizeof(*stslist))) == NULL)
+	return -oserror();
+    extp->batchsts = stslist;
+    extp->maxbatch = size;
+    return 0;
+}
+
+/*
+ * Release the batch callback columns, once the PMDA is done with
+ * the batch callback or is shutting down.
+ */
+void
+__pmdaBatchFree(e_ext_t *extp)
+{
+    free(extp->batchinst);
+    extp->batchinst = NULL;
+    free(extp->batchvalues);
+    extp->batchvalues = NULL;
+    free(extp->batchsts);
+    extp->batchsts = NULL;
+    extp->maxbatch = 0;
+}
+
+/*
+ * Fill in the value set for all instances of one metric required in
+ * the profile from a single call to the batch fetch callback, which
+ * completes a column of values rather than one pmAtomValue at a time.
+ *
+ * Returns PM_ERR_PMID if the metric is not handled by the batch
+ * callback and should be passed to the per-value fetch callback,
+ * or a (fatal) error after freeing the value set.
+ */
+static int
+__pmdaFetchBatch(pmdaExt *pmda, e_ext_t *extp, int version,
+		pmdaMetric *metap, pmValueSet **vsetp, int numval)
+{
+    pmValueSet		*vset = *vsetp;
+    pmValueSet		*tmp_vset;
+    pmDesc		*dp = &metap->m_desc;
+    pmAtomValue		*atom;
+    int			type = dp->type;
+    int			i, j, n, inst, sts, lsts;
+    char		idbuf[20];
+    char		strbuf[20];
+
+    if ((sts = __pmdaBatchResize(extp, numval)) < 0)
+	goto fail;
+
+    if (dp->indom == PM_INDOM_NULL) {
+	extp->batchinst[0] = PM_IN_NULL;
+	n = 1;
+    }
+    else {
+	__pmdaStartInst(dp->indom, pmda);
+	for (n = 0; __pmdaNextInst(&inst, pmda); n++) {
+	    if ((sts = __pmdaBatchResize(extp, n + 1)) < 0)
+		goto fail;
+	    extp->batchinst[n] = inst;
+	}
+    }
+    if (n == 0) {
+	vset->numval = 0;
+	return 0;
+    }
+
+    memset(extp->batchsts, 0, n * sizeof(int));
+    if ((sts = (*extp->batchCallBack)(metap, n, extp->batchinst,
+				extp->batchvalues, extp->batchsts)) < 0) {
+	if (sts == PM_ERR_PMID && pmda->e_fetchCallBack != NULL)
+	    return sts;
+	__pmdaFetchError(dp->pmid, PM_IN_NULL, sts);
+	vset->numval = sts;
+	return 0;
+    }
+
+    if (n > numval) {
+	/* more instances than expected! */
+	*vsetp = tmp_vset = (pmValueSet *)realloc(vset,
+			    sizeof(pmValueSet) + (n - 1)*sizeof(pmValue));
+	if (tmp_vset == NULL) {
+	    sts = -oserror();
+	    goto fail;
+	}
+	vset = tmp_vset;
+    }
+
+    /* same interpretation of status as for the per-value callback */
+    for (i = j = 0; i < n; i++) {
+	if ((sts = extp->batchsts[i]) < 0) {
+	    __pmdaFetchError(dp->pmid, extp->batchinst[i], sts);
+	    continue;
+	}
+	if (version != PMDA_INTERFACE_2 && sts == 0)
+	    continue;
+	atom = &extp->batchvalues[i];
+	vset->vlist[j].inst = extp->batchinst[i];
+	if (type == PM_TYPE_32 || type == PM_TYPE_U32) {
+	    /* common case, insitu value needs no allocation */
+	    vset->vlist[j++].value.lval = atom->l;
+	    continue;
+	}
+	if ((lsts = __pmStuffValue(atom, &vset->vlist[j], type)) == PM_ERR_TYPE) {
+	    pmNotifyErr(LOG_ERR, "pmdaFetch: Descriptor type (%s) for metric %s is bad",
+			pmTypeStr_r(type, strbuf, sizeof(strbuf)),
+			pmIDStr_r(dp->pmid, idbuf, sizeof(idbuf)));
+	}
+	else if (lsts >= 0) {
+	    vset->valfmt = lsts;
+	    j++;
+	}
+	if (version >= PMDA_INTERFACE_5 && sts == PMDA_FETCH_DYNAMIC) {
+	    if (type == PM_TYPE_STRING)
+		free(atom->cp);
+	    else if (type == PM_TYPE_AGGREGATE)
+		free(atom->vbp);
+	    else {
+		pmNotifyErr(LOG_WARNING, "pmdaFetch: Attempt to free value for metric %s of wrong type %s\n",
+			    pmIDStr_r(dp->pmid, idbuf, sizeof(idbuf)),
+			    pmTypeStr_r(type, strbuf, sizeof(strbuf)));
+	    }
+	}
+	if (lsts < 0)
+	    sts = lsts;
+    }
+
+    if (j == 0)
+	vset->numval = sts;
+    else
+	vset->numval = j;
+    return 0;
+
+fail:
+    free(vset);
+    *vsetp = NULL;
+    return sts;
+}
+
 /*
  * Resize the pmdaResult and call the e_callback for each metric instance
- * required in the profile.
+ * required in the profile (or the batch callback once for each metric,
+ * if one has been set).
  */
 
 int
@@ -598,6 +796,15 @@ pmdaFetch(int numpmid, pmID pmidlist[], pmdaResult **resp, pmdaExt *pmda)
 	if (vset->numval <= 0)
 	    continue;
 
+	if (extp->batchCallBack != NULL) {
+	    sts = __pmdaFetchBatch(pmda, extp, version, metap,
+				    &extp->res->vset[i], numval);
+	    if (sts == 0)
+		continue;
+	    if (sts != PM_ERR_PMID)
+		goto error;
+	}
+
 	if (dp->indom == PM_INDOM_NULL)
 	    inst = PM_IN_NULL;
 	else {
@@ -623,33 +830,7 @@ pmdaFetch(int numpmid, pmID pmidlist[], pmdaResult **resp, pmdaExt *pmda)
 	    vset->vlist[j].inst = inst;
 
 	    if ((sts = (*(pmda->e_fetchCallBack))(metap, inst, &atom)) < 0) {
-		pmIDStr_r(dp->pmid, strbuf, sizeof(strbuf));
-		if (sts == PM_ERR_PMID) {
-		    pmNotifyErr(LOG_ERR, 
-		        "pmdaFetch: PMID %s not handled by fetch callback\n",
-				strbuf);
-		}
-		else if (sts == PM_ERR_INST) {
-		    pmNotifyErr(LOG_WARNING,
-			"pmdaFetch: Instance %d of PMID %s not handled by fetch callback\n",
-			inst, strbuf);
-		}
-		else if (sts == PM_ERR_VALUE ||
-			 sts == PM_ERR_APPVERSION ||
-			 sts == PM_ERR_PERMISSION ||
-			 sts == PM_ERR_AGAIN ||
-			 sts == PM_ERR_NYI) {
-		    if (pmDebugOptions.libpmda) {
-			logmsg(NULL,
-			     "Fetch callback error from metric PMID %s[%d]: %s\n",
-			    strbuf, inst, pmErrStr(sts));
-		    }
-		}
-		else {
-		    pmNotifyErr(LOG_ERR,
-			"pmdaFetch: Fetch callback error from metric PMID %s[%d]: %s\n",
-				strbuf, inst, pmErrStr(sts));
-		}
+		__pmdaFetchError(dp->pmid, inst, sts);
 	    }
 	    else {
 		/*
@@ -37,8 +37,18 @@ typedef struct {
     int			ndynamics;	/* number of dynamics entries, below */
     struct dynamic	*dynamics;	/* dynamic metric manipulation table */
     void		*privdata;	/* private (user) data for this PMDA */
+    pmdaFetchBatchCallBack batchCallBack; /* all instances of a metric */
+    int			maxbatch;	/* high-water allocation for */
+    unsigned int	*batchinst;	/* batch callback instance, */
+    pmAtomValue		*batchvalues;	/* value and status columns */
+    int			*batchsts;
 } e_ext_t;
 
+/*
+ * Release the fetch batch callback columns
+ */
+extern void __pmdaBatchFree(e_ext_t *);
+
 /*
  * Local hash function
  */
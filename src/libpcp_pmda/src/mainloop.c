@@ -734,6 +734,8 @@ pmdaMain(pmdaInterface *dispatch)
 	if (__pmdaMainPDU(dispatch) < 0)
 	    break;
     }
+    if (HAVE_ANY(dispatch->comm.pmda_interface))
+	__pmdaBatchFree((e_ext_t *)dispatch->version.any.ext->e_ext);
 }
 
 void
@@ -772,6 +774,24 @@ pmdaSetFetchCallBack(pmdaInterface *dispatch, pmdaFetchCallBack callback)
     }
 }
 
+void
+pmdaSetFetchBatchCallBack(pmdaInterface *dispatch, pmdaFetchBatchCallBack callback)
+{
+    e_ext_t	*extp;
+
+    if (HAVE_ANY(dispatch->comm.pmda_interface)) {
+	extp = (e_ext_t *)dispatch->version.any.ext->e_ext;
+	extp->batchCallBack = callback;
+	if (callback == NULL)
+	    __pmdaBatchFree(extp);
+    }
+    else {
+	pmNotifyErr(LOG_CRIT, "Unable to set fetch batch callback for PMDA interface version %d.",
+		     dispatch->comm.pmda_interface);
+	dispatch->status = PM_ERR_GENERIC;
+    }
+}
+
 void
 pmdaSetCheckCallBack(pmdaInterface *dispatch, pmdaCheckCallBack callback)
 {
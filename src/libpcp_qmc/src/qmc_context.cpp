@@ -29,6 +29,9 @@ QmcContext::QmcContext(QmcSource* source)
     my.context = -1;
     my.source = source;
     my.needReconnect = false;
+    my.result = NULL;
+    my.fetchStatus = 0;
+    my.fetchTried = false;
     memset(&my.currentTime, 0, sizeof(my.currentTime));
     memset(&my.previousTime, 0, sizeof(my.previousTime));
 
@@ -51,6 +54,8 @@ QmcContext::~QmcContext()
     while (my.indoms.isEmpty() == false) {
 	delete my.indoms.takeFirst();
     }
+    if (my.result)
+	qmcFreeResult(my.result);
     if (my.context >= 0)
 	my.source->delContext(my.context);
 }
@@ -273,24 +278,20 @@ QmcContext::addMetric(QmcMetric *metric)
 int
 QmcContext::fetch(bool update)
 {
-    int i, sts;
-    qmcResult *result;
-
     if (pmDebugOptions.pmc) {
 	QTextStream cerr(stderr);
 	cerr << "QmcContext::fetch: update=" << update << Qt::endl;
     }
 
-    for (i = 0; i < my.metrics.size(); i++) {
-	QmcMetric *metric = my.metrics[i];
-	if (metric->status() < 0)
-	    continue;
-	metric->shiftValues();
-	if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
-	    QTextStream cerr(stderr);
-	    cerr << "QmcContext::fetch: shiftValues " << &metric << " metric[" << i << "] status=" << metric->status() << Qt::endl;
-	}
-    }
+    fetchSetup();
+    fetchValues();
+    return fetchUpdate(update);
+}
+
+void
+QmcContext::fetchSetup()
+{
+    int i, sts;
 
     // Inform each indom that we are about to do a new fetch so any
     // indom changes are now irrelevant
@@ -309,6 +310,22 @@ QmcContext::fetch(bool update)
 	cerr << "QmcContext::fetch: Unable to switch to this context: "
 	     << pmErrStr(sts) << Qt::endl;
     }
+    my.fetchStatus = sts;
+}
+
+//
+// Only the PMAPI context and the list of pmIDs are used here, and no
+// metric is modified, so this may be called from a worker thread (the
+// current PMAPI context is per-thread) while the metric values from the
+// previous fetch remain in use by the thread owning them.
+//
+int
+QmcContext::fetchValues()
+{
+    int sts = my.fetchStatus;
+
+    if (sts >= 0)
+	sts = pmUseContext(my.context);
 
     if (sts >= 0 && my.needReconnect) {
 	sts = pmReconnectContext(my.context);
@@ -333,66 +350,96 @@ QmcContext::fetch(bool update)
 	    cerr << "QmcContext::fetch: fetching context " << *this << Qt::endl;
 	}
 
+	my.fetchTried = true;
 	sts = qmcFetch(my.pmids.size(), 
-		      (pmID *)(my.pmids.toVector().data()), &result);
-	if (sts >= 0) {
-	    my.previousTime = my.currentTime;
-	    my.currentTime = result->timestamp;
-	    my.delta = pmtimevalSub(&my.currentTime, &my.previousTime);
-	    for (i = 0; i < my.metrics.size(); i++) {
-		QmcMetric *metric = my.metrics[i];
-		if (metric->status() < 0) {
-		    if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
-			QTextStream cerr(stderr);
-			cerr << "QmcContext::fetch: " << metric << " metric[" << i << "] status=" << metric->status() << Qt::endl;
-		    }
-		    continue;
-		}
-		Q_ASSERT((int)metric->idIndex() < result->numpmid);
-		metric->extractValues(result->vset[metric->idIndex()]);
-		if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
-		    int	j;
-		    QTextStream cerr(stderr);
-		    cerr << "QmcContext::fetch: " << metric << " metric[" << i << "]" << Qt::endl;
-		    for (j = 0; j < metric->numValues(); j++) {
-			cerr << "  ";
-			metric->dump(cerr, false, j);
-		    }
-		}
-	    }
-	    qmcFreeResult(result);
-	}
-	else {
+		      (pmID *)(my.pmids.toVector().data()), &my.result);
+	if (sts < 0) {
+	    my.result = NULL;
 	    if (pmDebugOptions.pmc) {
 		QTextStream cerr(stderr);
 		cerr << "QmcContext::fetch: pmFetch: " << pmErrStr(sts) << Qt::endl;
 	    }
-	    for (i = 0; i < my.metrics.size(); i++) {
-		QmcMetric *metric = my.metrics[i];
-		if (metric->status() < 0)
-		    continue;
-		metric->setError(sts);
-	    }
 	    if (sts == PM_ERR_IPC || sts == PM_ERR_TIMEOUT)
 		my.needReconnect = true;
 	}
+    }
+    else if (pmDebugOptions.pmc) {
+	QTextStream cerr(stderr);
+	cerr << "QmcContext::fetch: nothing to fetch" << Qt::endl;
+    }
 
-	if (update) {
+    my.fetchStatus = sts;
+    return sts;
+}
+
+int
+QmcContext::fetchUpdate(bool update)
+{
+    int i, sts = my.fetchStatus;
+
+    for (i = 0; i < my.metrics.size(); i++) {
+	QmcMetric *metric = my.metrics[i];
+	if (metric->status() < 0)
+	    continue;
+	metric->shiftValues();
+	if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
+	    QTextStream cerr(stderr);
+	    cerr << "QmcContext::fetch: shiftValues " << &metric << " metric[" << i << "] status=" << metric->status() << Qt::endl;
+	}
+    }
+
+    if (my.fetchTried == false)
+	return sts;
+    my.fetchTried = false;
+
+    if (my.result) {
+	my.previousTime = my.currentTime;
+	my.currentTime = my.result->timestamp;
+	my.delta = pmtimevalSub(&my.currentTime, &my.previousTime);
+	for (i = 0; i < my.metrics.size(); i++) {
+	    QmcMetric *metric = my.metrics[i];
+	    if (metric->status() < 0) {
+		if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
+		    QTextStream cerr(stderr);
+		    cerr << "QmcContext::fetch: " << metric << " metric[" << i << "] status=" << metric->status() << Qt::endl;
+		}
+		continue;
+	    }
+	    Q_ASSERT((int)metric->idIndex() < my.result->numpmid);
+	    metric->extractValues(my.result->vset[metric->idIndex()]);
 	    if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
+		int	j;
 		QTextStream cerr(stderr);
-		cerr << "QmcContext::fetch: Updating metrics" << Qt::endl;
-	    }
-	    for (i = 0; i < my.metrics.size(); i++) {
-		QmcMetric *metric = my.metrics[i];
-		if (metric->status() < 0)
-		    continue;
-		metric->update();
+		cerr << "QmcContext::fetch: " << metric << " metric[" << i << "]" << Qt::endl;
+		for (j = 0; j < metric->numValues(); j++) {
+		    cerr << "  ";
+		    metric->dump(cerr, false, j);
+		}
 	    }
 	}
+	qmcFreeResult(my.result);
+	my.result = NULL;
     }
-    else if (pmDebugOptions.pmc) {
-	QTextStream cerr(stderr);
-	cerr << "QmcContext::fetch: nothing to fetch" << Qt::endl;
+    else {
+	for (i = 0; i < my.metrics.size(); i++) {
+	    QmcMetric *metric = my.metrics[i];
+	    if (metric->status() < 0)
+		continue;
+	    metric->setError(sts);
+	}
+    }
+
+    if (update) {
+	if (pmDebugOptions.pmc && pmDebugOptions.desperate) {
+	    QTextStream cerr(stderr);
+	    cerr << "QmcContext::fetch: Updating metrics" << Qt::endl;
+	}
+	for (i = 0; i < my.metrics.size(); i++) {
+	    QmcMetric *metric = my.metrics[i];
+	    if (metric->status() < 0)
+		continue;
+	    metric->update();
+	}
     }
 
     return sts;
@@ -83,6 +83,14 @@ public:
 
     int fetch(bool update);		// Fetch metrics using this context
 
+    // The three phases of fetch(), so that the PMAPI fetch itself can
+    // be issued from a worker thread.  The metrics are only modified by
+    // fetchSetup() and fetchUpdate(), which must be called by the thread
+    // owning them; fetchValues() keeps its result pending until then.
+    void fetchSetup();			// Send any changed profiles
+    int fetchValues();			// Fetch a new (pending) result
+    int fetchUpdate(bool update);	// Update metrics from the result
+
     struct timeval const& timeStamp() const
 	{ return my.currentTime; }
 
@@ -106,6 +114,9 @@ private:
 	QList<pmID> pmids;		// List of valid PMIDs to be fetched
 	QList<QmcIndom*> indoms;	// List of requested indoms 
 	QList<QmcMetric*> metrics;	// List of metrics using this context
+	qmcResult *result;		// Result pending fetchUpdate()
+	int fetchStatus;		// Status of the pending fetch
+	bool fetchTried;		// Was the pending fetch attempted
 	struct timeval currentTime;	// Time of current fetch
 	struct timeval previousTime;	// Time of previous fetch
 	double delta;			// Time between fetches
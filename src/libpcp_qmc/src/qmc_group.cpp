@@ -24,6 +24,10 @@
 #include "qmc_context.h"
 #include "qmc_metric.h"
 
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+
 int QmcGroup::tzLocal = -1;
 bool QmcGroup::tzLocalInit = false;
 QString	QmcGroup::tzLocalString;
@@ -40,6 +44,12 @@ QmcGroup::QmcGroup(bool restrictArchives)
     my.tzUser = -1;
     my.tzGroupIndex = 0;
     my.timeEndReal = 0.0;
+    my.fetchPool = NULL;
+    my.fetchGeneration = 0;
+    my.fetchPending = false;
+    my.fetchUpdate = false;
+    my.fetchReceiver = NULL;
+    my.fetchMember = NULL;
 
     // Get timezone from environment
     if (tzLocalInit == false) {
@@ -66,6 +76,10 @@ QmcGroup::QmcGroup(bool restrictArchives)
 
 QmcGroup::~QmcGroup()
 {
+    if (my.fetchPool) {
+	my.fetchPool->waitForDone();
+	delete my.fetchPool;
+    }
     for (int i = 0; i < my.contexts.size(); i++)
 	if (my.contexts[i])
 	    delete my.contexts[i];
@@ -78,6 +92,8 @@ QmcGroup::use(int type, const QString &theSource, int flags)
     unsigned int i;
     QString source(theSource);
 
+    fetchWait();
+
     if (type == PM_CONTEXT_LOCAL) {
 	for (i = 0; i < numContexts(); i++)
 	    if (my.contexts[i]->source().type() == type)
@@ -458,6 +474,7 @@ QmcGroup::addMetric(char const *string, double theScale, bool active)
 	cerr << "QmcGroup::addMetric: string=" << string << Qt::endl;
     }
 
+    fetchWait();
     QmcMetric *metric = new QmcMetric(this, string, theScale, active);
     if (metric->status() >= 0)
 	metric->context()->addMetric(metric);
@@ -471,6 +488,7 @@ QmcGroup::addMetric(pmMetricSpec *theMetric, double theScale, bool active)
 	QTextStream cerr(stderr);
 	cerr << "QmcGroup::addMetric: theMetric: isarch=" << theMetric->isarch << " source=" << theMetric->source << " metric=" << theMetric->metric  << Qt::endl;
     }
+    fetchWait();
     QmcMetric *metric = new QmcMetric(this, theMetric, theScale, active);
     if (metric->status() >= 0)
 	metric->context()->addMetric(metric);
@@ -487,6 +505,10 @@ QmcGroup::fetch(bool update)
 	cerr << "QmcGroup::fetch: " << numContexts() << " contexts" << Qt::endl;
     }
 
+    // Any asynchronous fetch in progress is finished, and superseded
+    fetchWait();
+    my.fetchGeneration++;
+
     for (unsigned int i = 0; i < numContexts(); i++)
 	my.contexts[i]->fetch(update);
 
@@ -501,11 +523,134 @@ QmcGroup::fetch(bool update)
     return sts;
 }
 
+//
+// Worker for fetchAsync, fetching a new result for one context.
+//
+class QmcFetchTask : public QRunnable
+{
+public:
+    QmcFetchTask(QmcGroup *group, QmcContext *context, int generation)
+    {
+	my.group = group;
+	my.context = context;
+	my.generation = generation;
+    }
+
+    void run()
+    {
+	my.context->fetchValues();
+	my.group->fetchFinished(my.generation);
+    }
+
+private:
+    struct {
+	QmcGroup *group;
+	QmcContext *context;
+	int generation;
+    } my;
+};
+
+void
+QmcGroup::fetchAsync(QObject *receiver, const char *member, bool update)
+{
+    unsigned int i;
+
+    if (pmDebugOptions.pmc) {
+	QTextStream cerr(stderr);
+	cerr << "QmcGroup::fetchAsync: " << numContexts() << " contexts"
+	     << Qt::endl;
+    }
+
+    fetchWait();
+    my.fetchGeneration++;
+    my.fetchPending = true;
+    my.fetchUpdate = update;
+    my.fetchReceiver = receiver;
+    my.fetchMember = member;
+
+    if (numContexts() == 0) {
+	QMetaObject::invokeMethod(receiver, member, Qt::QueuedConnection,
+				  Q_ARG(int, my.fetchGeneration));
+	return;
+    }
+
+    // Profile changes are made here, as they use the indom state shared
+    // with the metrics; the fetches themselves run concurrently, one
+    // worker thread per context.  Local contexts are the exception - the
+    // DSO PMDAs may only be called from the thread that created them
+    // (otherwise PM_ERR_THREAD), so those are fetched right here.
+    for (i = 0; i < numContexts(); i++)
+	my.contexts[i]->fetchSetup();
+    useContext();
+
+    my.fetchCount.storeRelease(numContexts());
+    for (i = 0; i < numContexts(); i++) {
+	if (my.contexts[i]->source().type() == PM_CONTEXT_LOCAL)
+	    continue;
+	if (my.fetchPool == NULL)
+	    my.fetchPool = new QThreadPool();
+	if (my.fetchPool->maxThreadCount() < (int)numContexts())
+	    my.fetchPool->setMaxThreadCount(numContexts());
+	my.fetchPool->start(new QmcFetchTask(this, my.contexts[i],
+					     my.fetchGeneration));
+    }
+    for (i = 0; i < numContexts(); i++) {
+	if (my.contexts[i]->source().type() != PM_CONTEXT_LOCAL)
+	    continue;
+	my.contexts[i]->fetchValues();
+	fetchFinished(my.fetchGeneration);
+    }
+    useContext();
+}
+
+//
+// Called from each worker thread as its fetch completes; the last one
+// notifies the receiver, in the receiver's own thread.
+//
+void
+QmcGroup::fetchFinished(int generation)
+{
+    if (my.fetchCount.fetchAndAddOrdered(-1) != 1)
+	return;
+    QMetaObject::invokeMethod(my.fetchReceiver, my.fetchMember,
+			      Qt::QueuedConnection, Q_ARG(int, generation));
+}
+
+bool
+QmcGroup::fetchComplete(int generation)
+{
+    if (generation != my.fetchGeneration)
+	return false;
+    fetchWait();
+    return true;
+}
+
+void
+QmcGroup::fetchWait()
+{
+    if (my.fetchPending == false)
+	return;
+    if (my.fetchPool)
+	my.fetchPool->waitForDone();
+    for (unsigned int i = 0; i < numContexts(); i++)
+	my.contexts[i]->fetchUpdate(my.fetchUpdate);
+    my.fetchPending = false;
+    if (numContexts())
+	useContext();
+
+    if (pmDebugOptions.pmc) {
+	QTextStream cerr(stderr);
+	cerr << "QmcGroup::fetchWait: Done" << Qt::endl;
+    }
+}
+
 int
 QmcGroup::setArchiveMode(int mode, const struct timespec *when, const struct timespec *delta)
 {
     int sts, result = 0;
 
+    fetchWait();
+
     for (unsigned int i = 0; i < numContexts(); i++) {
 	if (my.contexts[i]->source().type() != PM_CONTEXT_ARCHIVE)
 	    continue;
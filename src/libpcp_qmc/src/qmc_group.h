@@ -20,6 +20,11 @@
 #include "qmc_config.h"
 #include "qmc_context.h"
 
+#include <qatomic.h>
+
+class QObject;
+class QThreadPool;
+
 class QmcGroup
 {
 public:
@@ -57,6 +62,18 @@ public:
     // By default, do all rate conversions and counter wraps
     int fetch(bool update = true);
 
+    // Fetch all the metrics in this group from worker threads, with all
+    // contexts fetched concurrently and without blocking the caller
+    // (except for a local context, which is fetched by the caller).
+    // Once every context has a result, the receiver's slot named member
+    // (taking one int argument) is invoked through a queued connection and
+    // must pass that argument to fetchComplete() to update the metrics.
+    // Until then, the values from the previous fetch remain unchanged.
+    void fetchAsync(QObject *receiver, const char *member, bool update = true);
+    bool fetchComplete(int generation);	// false if superseded
+    bool fetchPending() const { return my.fetchPending; }
+    void fetchWait();			// Finish any asynchronous fetch
+
     // Set the archive position and mode
     int setArchiveMode(int mode, const struct timespec *when, const struct timespec *delta);
 
@@ -91,8 +108,19 @@ private:
 	struct timeval timeStart;	// Start of first archive
 	struct timeval timeEnd;		// End of last archive
 	double timeEndReal;		// End of last archive
+
+	QThreadPool *fetchPool;		// Worker threads for fetchAsync
+	QAtomicInt fetchCount;		// Contexts still being fetched
+	int fetchGeneration;		// Identifies the latest fetchAsync
+	bool fetchPending;		// Metrics awaiting fetchAsync results
+	bool fetchUpdate;		// Update argument to fetchAsync
+	QObject *fetchReceiver;		// Notified once all contexts fetched
+	const char *fetchMember;	// Slot of fetchReceiver to invoke
     } my;
 
+    friend class QmcFetchTask;
+    void fetchFinished(int generation);
+
     // Timezone for localhost from environment
     static bool tzLocalInit;	// got TZ from environment
     static int tzLocal;		// handle to environment TZ
@@ -0,0 +1,720 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#include <math.h>
+#include <errno.h>
+#include <assert.h>
+#include "chunks.h"
+
+/*
+ * Record layout: one header byte (record kind, plus a sync flag), then
+ * for sync records the value type and absolute timestamp, otherwise the
+ * zig-zag encoded delta-of-delta of the timestamp.  Value records then
+ * have a list of (slot+1, [name,] value) terminated by a zero slot, the
+ * name present only for the first use of a slot within an encoder run.
+ */
+#define CHUNK_VALUES	0
+#define CHUNK_ERROR	1
+#define CHUNK_EMPTY	2
+#define CHUNK_KINDS	3
+#define CHUNK_SYNC	4
+
+#define CHUNK_NAMELEN	20	/* instance name hash, zero for singular */
+
+seriesChunk *
+seriesChunkCreate(int type, __int64_t span)
+{
+    seriesChunk		*chunk;
+
+    if ((chunk = calloc(1, sizeof(seriesChunk))) != NULL) {
+	chunk->type = type;
+	chunk->span = span;
+	chunk->sync = 1;
+	chunk->refcount = 1;
+    }
+    return chunk;
+}
+
+/*
+ * Chunks are shared by their metric and an outstanding lookup of the
+ * last stored window, which may complete after the metric is freed.
+ */
+void
+seriesChunkReference(seriesChunk *chunk)
+{
+    chunk->refcount++;
+}
+
+void
+seriesChunkFree(seriesChunk *chunk)
+{
+    if (chunk && --chunk->refcount == 0) {
+	seriesChunkDequeue(chunk);
+	if (chunk->slots)
+	    free(chunk->slots);
+	free(chunk);
+    }
+}
+
+/*
+ * Hold an encoded record (and the summary of the window it seals, if
+ * any) until the loader knows whether it has been stored before; the
+ * queue takes ownership of both strings.
+ */
+int
+seriesChunkQueue(seriesChunk *chunk, __int64_t window, unsigned int first,
+		sds record, __int64_t sealed, sds summary)
+{
+    chunkQueued		*queued;
+    size_t		size = (chunk->nqueued + 1) * sizeof(chunkQueued);
+
+    if ((queued = realloc(chunk->queued, size)) == NULL)
+	return -ENOMEM;
+    chunk->queued = queued;
+    queued = &chunk->queued[chunk->nqueued++];
+    queued->window = window;
+    queued->sealed = sealed;
+    queued->first = first;
+    queued->record = record;
+    queued->summary = summary;
+    return 0;
+}
+
+void
+seriesChunkDequeue(seriesChunk *chunk)
+{
+    unsigned int	i;
+
+    for (i = 0; i < chunk->nqueued; i++) {
+	sdsfree(chunk->queued[i].record);
+	sdsfree(chunk->queued[i].summary);
+    }
+    if (chunk->queued)
+	free(chunk->queued);
+    chunk->queued = NULL;
+    chunk->nqueued = 0;
+}
+
+/* convert a stream identifier ("milliseconds-microseconds") to usec */
+__int64_t
+seriesChunkStamp(const char *stamp)
+{
+    __uint64_t		milliseconds, fractions = 0;
+    char		*point = NULL;
+
+    milliseconds = strtoull(stamp, &point, 10);
+    if (point && *point == '-')
+	fractions = strtoull(point + 1, NULL, 10);
+    return (__int64_t)(milliseconds * 1000 + fractions);
+}
+
+static char *
+chunk_stamp_str(__int64_t stamp, char *buffer, int buflen)
+{
+    pmsprintf(buffer, buflen, "%" FMT_UINT64 "-%" FMT_UINT64,
+		(__uint64_t)stamp / 1000, (__uint64_t)stamp % 1000);
+    return buffer;
+}
+
+/*
+ * Check whether a sample at the given time can be appended; returns
+ * a negative value if it is not later than the previous one, else
+ * one if it begins a new time window after an earlier (now complete)
+ * window - allowing the caller to store its summary - or zero.
+ */
+int
+seriesChunkNext(seriesChunk *chunk, __int64_t stamp)
+{
+    __int64_t		window = stamp - (stamp % chunk->span);
+
+    if (chunk->count == 0)
+	return 0;
+    if (stamp <= chunk->stamp)
+	return -1;
+    return (window != chunk->window);
+}
+
+/*
+ * Summary of a complete chunk window - the count of records, then for
+ * numeric values the count, minimum, maximum and sum of those values.
+ */
+sds
+seriesChunkSummary(seriesChunk *chunk)
+{
+    if (chunk->nvalues == 0)
+	return sdscatfmt(sdsempty(), "%u", chunk->count);
+    return sdscatprintf(sdsempty(), "%u %u %.17g %.17g %.17g",
+			chunk->count, chunk->nvalues,
+			chunk->min, chunk->max, chunk->sum);
+}
+
+static inline __uint64_t
+zigzag(__int64_t value)
+{
+    return ((__uint64_t)value << 1) ^ (__uint64_t)(value >> 63);
+}
+
+static inline __int64_t
+unzigzag(__uint64_t value)
+{
+    return (__int64_t)(value >> 1) ^ -(__int64_t)(value & 1);
+}
+
+static sds
+chunk_varint(sds record, __uint64_t value)
+{
+    unsigned char	buffer[10];
+    int			n = 0;
+
+    while (value >= 0x80) {
+	buffer[n++] = (unsigned char)(value | 0x80);
+	value >>= 7;
+    }
+    buffer[n++] = (unsigned char)value;
+    return sdscatlen(record, buffer, n);
+}
+
+/* XOR of consecutive floating point values, dropping zero bytes */
+static sds
+chunk_xor(sds record, __uint64_t value)
+{
+    unsigned char	buffer[9];
+    int			lead, trail, n;
+
+    if (value == 0)
+	return sdscatlen(record, "", 1);
+    lead = __builtin_clzll(value) / 8;
+    trail = __builtin_ctzll(value) / 8;
+    value >>= trail * 8;
+    buffer[0] = (trail << 4) | (8 - lead - trail);
+    for (n = 1; n <= 8 - lead - trail; n++) {
+	buffer[n] = (unsigned char)value;
+	value >>= 8;
+    }
+    return sdscatlen(record, buffer, n);
+}
+
+static sds
+chunk_header(seriesChunk *chunk, sds record, __int64_t stamp, int kind)
+{
+    __int64_t		window = stamp - (stamp % chunk->span);
+    __int64_t		delta;
+    unsigned char	byte = kind;
+
+    if (chunk->count == 0 || window != chunk->window) {
+	chunk->window = window;
+	chunk->count = 0;
+	chunk->nvalues = 0;
+	chunk->min = chunk->max = chunk->sum = 0.0;
+	chunk->sync = 1;
+    }
+    if (chunk->sync) {
+	byte |= CHUNK_SYNC;
+	record = sdscatlen(record, &byte, 1);
+	record = chunk_varint(record, (__uint64_t)chunk->type);
+	record = chunk_varint(record, (__uint64_t)stamp);
+	chunk->delta = 0;
+	chunk->nslots = 0;
+	chunk->sync = 0;
+    } else {
+	delta = stamp - chunk->stamp;
+	record = sdscatlen(record, &byte, 1);
+	record = chunk_varint(record, zigzag(delta - chunk->delta));
+	chunk->delta = delta;
+    }
+    chunk->stamp = stamp;
+    chunk->count++;
+    chunk->next = 0;
+    return record;
+}
+
+sds
+seriesChunkValues(seriesChunk *chunk, sds record, __int64_t stamp)
+{
+    return chunk_header(chunk, record, stamp, CHUNK_VALUES);
+}
+
+sds
+seriesChunkEnd(seriesChunk *chunk, sds record)
+{
+    (void)chunk;
+    return chunk_varint(record, 0);
+}
+
+sds
+seriesChunkError(seriesChunk *chunk, sds record, __int64_t stamp, int sts)
+{
+    record = chunk_header(chunk, record, stamp, CHUNK_ERROR);
+    return chunk_varint(record, zigzag(sts));
+}
+
+sds
+seriesChunkEmpty(seriesChunk *chunk, sds record, __int64_t stamp)
+{
+    return chunk_header(chunk, record, stamp, CHUNK_EMPTY);
+}
+
+static chunkSlot *
+chunk_slot(seriesChunk *chunk, int inst, unsigned int *slotp, int *added)
+{
+    unsigned int	i, hint = chunk->next;
+    chunkSlot		*slots;
+    size_t		size;
+
+    /* instances usually arrive in the same order as the last sample */
+    if (hint < chunk->nslots && chunk->slots[hint].inst == inst) {
+	*slotp = hint;
+	*added = 0;
+	return &chunk->slots[hint];
+    }
+    for (i = 0; i < chunk->nslots; i++) {
+	if (chunk->slots[i].inst == inst) {
+	    *slotp = i;
+	    *added = 0;
+	    return &chunk->slots[i];
+	}
+    }
+    if (chunk->nslots == chunk->maxslots) {
+	size = chunk->maxslots ? chunk->maxslots * 2 : 8;
+	if ((slots = realloc(chunk->slots, size * sizeof(chunkSlot))) == NULL)
+	    return NULL;
+	chunk->slots = slots;
+	chunk->maxslots = size;
+    }
+    *slotp = i = chunk->nslots++;
+    *added = 1;
+    chunk->slots[i].inst = inst;
+    chunk->slots[i].value = 0;
+    return &chunk->slots[i];
+}
+
+static void
+chunk_summarise(seriesChunk *chunk, double value)
+{
+    if (chunk->nvalues++ == 0) {
+	chunk->min = chunk->max = chunk->sum = value;
+	return;
+    }
+    if (value < chunk->min)
+	chunk->min = value;
+    if (value > chunk->max)
+	chunk->max = value;
+    chunk->sum += value;
+}
+
+/*
+ * Append one instance value to the current record; name is the SHA1
+ * hash of the instance name, or NULL for metrics without an indom.
+ */
+sds
+seriesChunkValue(seriesChunk *chunk, sds record, int inst,
+		const unsigned char *name, pmAtomValue *avp)
+{
+    chunkSlot		*slot;
+    __uint64_t		bits;
+    double		value;
+    size_t		length;
+    unsigned int	index;
+    int			added;
+
+    if ((slot = chunk_slot(chunk, inst, &index, &added)) == NULL) {
+	chunk->sync = 1;	/* restart encoding with the next record */
+	return record;
+    }
+    chunk->next = index + 1;
+    record = chunk_varint(record, (__uint64_t)index + 1);
+    if (added) {
+	length = name ? CHUNK_NAMELEN : 0;
+	record = chunk_varint(record, length);
+	record = sdscatlen(record, name, length);
+    }
+
+    switch (chunk->type) {
+    case PM_TYPE_32:
+	bits = (__uint64_t)(__int64_t)avp->l;
+	value = avp->l;
+	goto integer;
+    case PM_TYPE_U32:
+	bits = avp->ul;
+	value = avp->ul;
+	goto integer;
+    case PM_TYPE_64:
+	bits = (__uint64_t)avp->ll;
+	value = avp->ll;
+	goto integer;
+    case PM_TYPE_U64:
+	bits = avp->ull;
+	value = avp->ull;
+    integer:
+	record = chunk_varint(record, zigzag((__int64_t)(bits - slot->value)));
+	slot->value = bits;
+	chunk_summarise(chunk, value);
+	break;
+
+    case PM_TYPE_FLOAT:
+	value = avp->f;
+	goto floating;
+    case PM_TYPE_DOUBLE:
+	value = avp->d;
+    floating:
+	memcpy(&bits, &value, sizeof(bits));
+	record = chunk_xor(record, bits ^ slot->value);
+	slot->value = bits;
+	if (!isnan(value))
+	    chunk_summarise(chunk, value);
+	break;
+
+    case PM_TYPE_STRING:
+    case PM_TYPE_AGGREGATE:
+    case PM_TYPE_AGGREGATE_STATIC:
+	length = avp->cp ? sdslen(avp->cp) : 0;
+	record = chunk_varint(record, length);
+	record = sdscatlen(record, avp->cp, length);
+	break;
+
+    default:
+	break;
+    }
+    return record;
+}
+
+/*
+ * Decoding into reply structures shaped like XRANGE responses, so
+ * chunks can be fed through the existing stream reply handling.
+ */
+typedef struct chunkReader {
+    const unsigned char	*p;
+    const unsigned char	*end;
+} chunkReader;
+
+typedef struct chunkName {
+    unsigned int	length;
+    unsigned char	name[CHUNK_NAMELEN];
+    __uint64_t		value;
+} chunkName;
+
+static int
+chunk_read_varint(chunkReader *r, __uint64_t *value)
+{
+    __uint64_t		result = 0;
+    unsigned int	shift = 0;
+
+    while (r->p < r->end && shift < 64) {
+	result |= (__uint64_t)(*r->p & 0x7f) << shift;
+	if ((*r->p++ & 0x80) == 0) {
+	    *value = result;
+	    return 0;
+	}
+	shift += 7;
+    }
+    return -EINVAL;
+}
+
+static int
+chunk_read_xor(chunkReader *r, __uint64_t *value)
+{
+    unsigned int	trail, n, i;
+    __uint64_t		result = 0;
+
+    if (r->p >= r->end)
+	return -EINVAL;
+    trail = *r->p >> 4;
+    n = *r->p++ & 0xf;
+    if (n > 8 || trail + n > 8 || r->p + n > r->end)
+	return -EINVAL;
+    for (i = 0; i < n; i++)
+	result |= (__uint64_t)*r->p++ << (8 * i);
+    *value = result << (8 * trail);
+    return 0;
+}
+
+static respReply *
+chunk_reply_string(const void *str, size_t length)
+{
+    respReply		*reply;
+
+    if ((reply = calloc(1, sizeof(respReply))) == NULL)
+	return NULL;
+    if ((reply->str = malloc(length + 1)) == NULL) {
+	free(reply);
+	return NULL;
+    }
+    memcpy(reply->str, str, length);
+    reply->str[length] = '\0';
+    reply->len = length;
+    reply->type = RESP_REPLY_STRING;
+    return reply;
+}
+
+static void
+chunk_reply_free(respReply *reply)
+{
+    size_t		i;
+
+    if (reply == NULL)
+	return;
+    if (reply->type == RESP_REPLY_ARRAY) {
+	for (i = 0; i < reply->elements; i++)
+	    chunk_reply_free(reply->element[i]);
+	free(reply->element);
+    } else {
+	free(reply->str);
+    }
+    free(reply);
+}
+
+void
+seriesChunkFreeReplies(respReply **replies, size_t count)
+{
+    size_t		i;
+
+    for (i = 0; i < count; i++)
+	chunk_reply_free(replies[i]);
+    free(replies);
+}
+
+/* append one name:value pair to a sample value array */
+static int
+chunk_reply_pair(respReply *values, const void *name, size_t namelen, sds value)
+{
+    respReply		**element;
+    size_t		size = (values->elements + 2) * sizeof(respReply *);
+
+    if ((element = realloc(values->element, size)) == NULL)
+	return -ENOMEM;
+    values->element = element;
+    element[values->elements] = chunk_reply_string(name, namelen);
+    element[values->elements + 1] = chunk_reply_string(value, sdslen(value));
+    values->elements += 2;
+    if (!element[values->elements - 2] || !element[values->elements - 1])
+	return -ENOMEM;
+    return 0;
+}
+
+/*
+ * Append one XRANGE-style sample with a single value for a metric
+ * without an instance domain, such as a value from a chunk summary.
+ */
+int
+seriesChunkSample(__int64_t stamp, sds value, respReply ***replies, size_t *count)
+{
+    respReply		*sample, *values, **list;
+    char		stampbuf[64];
+
+    if ((sample = calloc(1, sizeof(respReply))) == NULL)
+	return -ENOMEM;
+    sample->type = RESP_REPLY_ARRAY;
+    if ((sample->element = calloc(2, sizeof(respReply *))) == NULL ||
+	(values = calloc(1, sizeof(respReply))) == NULL) {
+	chunk_reply_free(sample);
+	return -ENOMEM;
+    }
+    sample->elements = 2;
+    sample->element[0] = chunk_reply_string(stampbuf,
+		strlen(chunk_stamp_str(stamp, stampbuf, sizeof(stampbuf))));
+    sample->element[1] = values;
+    values->type = RESP_REPLY_ARRAY;
+    if (sample->element[0] == NULL ||
+	chunk_reply_pair(values, "", 0, value) < 0 ||
+	(list = realloc(*replies, (*count + 1) * sizeof(respReply *))) == NULL) {
+	chunk_reply_free(sample);
+	return -ENOMEM;
+    }
+    list[(*count)++] = sample;
+    *replies = list;
+    return 0;
+}
+
+static sds
+chunk_value_str(sds s, int type, __uint64_t bits, chunkReader *r)
+{
+    __uint64_t		length;
+    double		value;
+
+    switch (type) {
+    case PM_TYPE_32:
+	return sdscatfmt(s, "%i", (__int32_t)bits);
+    case PM_TYPE_U32:
+	return sdscatfmt(s, "%u", (__uint32_t)bits);
+    case PM_TYPE_64:
+	return sdscatfmt(s, "%I", (__int64_t)bits);
+    case PM_TYPE_U64:
+	return sdscatfmt(s, "%U", bits);
+    case PM_TYPE_FLOAT:
+    case PM_TYPE_DOUBLE:
+	memcpy(&value, &bits, sizeof(value));
+	return sdscatprintf(s, "%e", value);
+    case PM_TYPE_STRING:
+    case PM_TYPE_AGGREGATE:
+    case PM_TYPE_AGGREGATE_STATIC:
+	if (chunk_read_varint(r, &length) < 0 ||
+	    length > (__uint64_t)(r->end - r->p))
+	    return NULL;
+	s = sdscatlen(s, r->p, length);
+	r->p += length;
+	return s;
+    default:
+	break;
+    }
+    return sdscatfmt(s, "%i", PM_ERR_NYI);
+}
+
+/*
+ * Decode the records of one chunk, appending those within the time
+ * window [start, end] (end of zero means no limit) to the replies
+ * array as XRANGE-style [timestamp, [name, value, ...]] entries.
+ */
+int
+seriesChunkDecode(const char *buffer, size_t length, __int64_t start,
+		__int64_t end, respReply ***replies, size_t *count)
+{
+    chunkReader		reader = { (const unsigned char *)buffer,
+				   (const unsigned char *)buffer + length };
+    chunkReader		*r = &reader;
+    chunkName		*names = NULL, *np;
+    respReply		*sample = NULL, *values, **list;
+    __uint64_t		u, type = 0, nnames = 0, maxnames = 0, slot;
+    __int64_t		stamp = 0, delta = 0, last = 0;
+    unsigned int	kind, setup = 0;
+    char		stampbuf[64];
+    sds			value = sdsempty();
+    int			sts = 0;
+
+    while (r->p < r->end) {
+	kind = *r->p++;
+	if (kind & CHUNK_SYNC) {
+	    if ((sts = chunk_read_varint(r, &type)) < 0 ||
+		(sts = chunk_read_varint(r, &u)) < 0)
+		break;
+	    stamp = (__int64_t)u;
+	    delta = 0;
+	    nnames = 0;
+	    setup = 1;
+	} else if (setup == 0 || (sts = chunk_read_varint(r, &u)) < 0) {
+	    sts = -EINVAL;
+	    break;
+	} else {
+	    delta += unzigzag(u);
+	    stamp += delta;
+	}
+	kind &= CHUNK_KINDS;
+
+	if ((sample = calloc(1, sizeof(respReply))) == NULL ||
+	    (sample->element = calloc(2, sizeof(respReply *))) == NULL ||
+	    (values = calloc(1, sizeof(respReply))) == NULL) {
+	    sts = -ENOMEM;
+	    break;
+	}
+	sample->type = RESP_REPLY_ARRAY;
+	sample->elements = 2;
+	sample->element[0] = chunk_reply_string(stampbuf,
+		strlen(chunk_stamp_str(stamp, stampbuf, sizeof(stampbuf))));
+	sample->element[1] = values;
+	values->type = RESP_REPLY_ARRAY;
+
+	if (kind == CHUNK_ERROR) {
+	    if ((sts = chunk_read_varint(r, &u)) < 0)
+		break;
+	    sdsclear(value);
+	    value = sdscatfmt(value, "%i", (int)unzigzag(u));
+	    if ((sts = chunk_reply_pair(values, "-1", 2, value)) < 0)
+		break;
+	} else if (kind == CHUNK_EMPTY) {
+	    value = sdscpylen(value, "0", 1);
+	    if ((sts = chunk_reply_pair(values, "0", 1, value)) < 0)
+		break;
+	} else {
+	    for (;;) {
+		if ((sts = chunk_read_varint(r, &slot)) < 0)
+		    break;
+		if (slot-- == 0)
+		    break;
+		if (slot > nnames) {
+		    sts = -EINVAL;
+		    break;
+		}
+		if (slot == nnames) {
+		    if (nnames == maxnames) {
+			maxnames = maxnames ? maxnames * 2 : 8;
+			if ((np = realloc(names, maxnames * sizeof(chunkName))) == NULL) {
+			    sts = -ENOMEM;
+			    break;
+			}
+			names = np;
+		    }
+		    np = &names[nnames++];
+		    if ((sts = chunk_read_varint(r, &u)) < 0)
+			break;
+		    if (u > CHUNK_NAMELEN || u > (__uint64_t)(r->end - r->p)) {
+			sts = -EINVAL;
+			break;
+		    }
+		    np->length = u;
+		    memcpy(np->name, r->p, u);
+		    r->p += u;
+		    np->value = 0;
+		}
+		np = &names[slot];
+		switch (type) {
+		case PM_TYPE_32:
+		case PM_TYPE_U32:
+		case PM_TYPE_64:
+		case PM_TYPE_U64:
+		    if ((sts = chunk_read_varint(r, &u)) < 0)
+			break;
+		    np->value += (__uint64_t)unzigzag(u);
+		    break;
+		case PM_TYPE_FLOAT:
+		case PM_TYPE_DOUBLE:
+		    if ((sts = chunk_read_xor(r, &u)) < 0)
+			break;
+		    np->value ^= u;
+		    break;
+		default:
+		    break;
+		}
+		if (sts < 0)
+		    break;
+		sdsclear(value);
+		if ((value = chunk_value_str(value, type, np->value, r)) == NULL) {
+		    value = sdsempty();
+		    sts = -EINVAL;
+		    break;
+		}
+		if ((sts = chunk_reply_pair(values, np->name, np->length, value)) < 0)
+		    break;
+	    }
+	    if (sts < 0)
+		break;
+	}
+
+	/* drop samples outside the window, or repeated after a restart */
+	if (stamp < start || (end && stamp > end) || (last && stamp <= last)) {
+	    chunk_reply_free(sample);
+	} else {
+	    if ((list = realloc(*replies, (*count + 1) * sizeof(respReply *))) == NULL) {
+		sts = -ENOMEM;
+		break;
+	    }
+	    list[(*count)++] = sample;
+	    *replies = list;
+	    last = stamp;
+	}
+	sample = NULL;
+    }
+    chunk_reply_free(sample);
+    if (names)
+	free(names);
+    sdsfree(value);
+    return sts;
+}
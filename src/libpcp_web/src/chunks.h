@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#ifndef SERIES_CHUNKS_H
+#define SERIES_CHUNKS_H
+
+#include "pmapi.h"
+#include "sds.h"
+#include "keys.h"
+
+/*
+ * Compressed, chunked series values - an alternative to one stream
+ * entry per sample.  Samples of a series are appended to a chunk for
+ * a fixed time window; each sample is one record holding the delta-
+ * of-delta of its timestamp (microseconds) and then its values, with
+ * integers as deltas and floating point as XOR of the previous value
+ * of the same instance (byte-aligned, so records can be APPENDed to a
+ * key server string).  The first record of each encoder run carries
+ * the absolute timestamp, value type and instance names, so a chunk
+ * remains decodable after the loader restarts mid-window.
+ */
+typedef struct chunkSlot {
+    int			inst;		/* internal instance identifier */
+    __uint64_t		value;		/* previous value (encoded bits) */
+} chunkSlot;
+
+/*
+ * Records encoded while a restarted loader looks up the last window it
+ * stored for a series, written (or skipped) once that is known.
+ */
+typedef struct chunkQueued {
+    __int64_t		window;		/* chunk time window of the record */
+    __int64_t		sealed;		/* window summarised, if any */
+    unsigned int	first;		/* first record of its window */
+    sds			record;
+    sds			summary;
+} chunkQueued;
+
+typedef struct seriesChunk {
+    int			type;		/* PMAPI type of the values */
+    unsigned int	sync : 1;	/* next record restarts encoding */
+    unsigned int	lookup : 1;	/* awaiting last stored window */
+    unsigned int	padding : 30;
+    unsigned int	refcount;	/* owning metric and any lookup */
+    __int64_t		span;		/* chunk time window length */
+    __int64_t		resume;		/* last window stored before start */
+    __int64_t		window;		/* start of chunk time window */
+    __int64_t		stamp;		/* previous record timestamp */
+    __int64_t		delta;		/* previous record time delta */
+    unsigned int	count;		/* records in this chunk window */
+    unsigned int	nvalues;	/* numeric values summarised */
+    double		min;		/* chunk-level value summaries */
+    double		max;
+    double		sum;
+    unsigned int	next;		/* expected slot of the next value */
+    unsigned int	nslots;		/* instances seen in this chunk */
+    unsigned int	maxslots;
+    chunkSlot		*slots;
+    unsigned int	nqueued;	/* records held during the lookup */
+    chunkQueued		*queued;
+} seriesChunk;
+
+extern seriesChunk *seriesChunkCreate(int, __int64_t);
+extern void seriesChunkReference(seriesChunk *);
+extern void seriesChunkFree(seriesChunk *);
+
+extern __int64_t seriesChunkStamp(const char *);
+extern int seriesChunkNext(seriesChunk *, __int64_t);
+extern sds seriesChunkSummary(seriesChunk *);
+extern int seriesChunkQueue(seriesChunk *, __int64_t, unsigned int, sds,
+		__int64_t, sds);
+extern void seriesChunkDequeue(seriesChunk *);
+
+extern sds seriesChunkValues(seriesChunk *, sds, __int64_t);
+extern sds seriesChunkValue(seriesChunk *, sds, int, const unsigned char *, pmAtomValue *);
+extern sds seriesChunkEnd(seriesChunk *, sds);
+extern sds seriesChunkError(seriesChunk *, sds, __int64_t, int);
+extern sds seriesChunkEmpty(seriesChunk *, sds, __int64_t);
+
+extern int seriesChunkDecode(const char *, size_t, __int64_t, __int64_t,
+		respReply ***, size_t *);
+extern int seriesChunkSample(__int64_t, sds, respReply ***, size_t *);
+extern void seriesChunkFreeReplies(respReply **, size_t);
+
+#endif	/* SERIES_CHUNKS_H */
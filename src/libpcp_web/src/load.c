@@ -1357,7 +1357,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 
 	if ((labels = pmwebapi_labelsetdup(sets)) != NULL) {
 	    if (cp->labelset)
-		pmFreeLabelSets(cp->labelset, 1);
+		pmwebapi_labelsetfree(cp->labelset);
 	    cp->labelset = labels;
 	    pmwebapi_locate_context(cp);
 	    cp->updated = 1;
@@ -1375,7 +1375,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 
 	if (domain && (labels = pmwebapi_labelsetdup(sets)) != NULL) {
 	    if (domain->labelset)
-		pmFreeLabelSets(domain->labelset, 1);
+		pmwebapi_labelsetfree(domain->labelset);
 	    domain->labelset = labels;
 	    domain->updated = 1;
 	} else if (domain) {
@@ -1392,7 +1392,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 
 	if (cluster && (labels = pmwebapi_labelsetdup(sets)) != NULL) {
 	    if (cluster->labelset)
-		pmFreeLabelSets(cluster->labelset, 1);
+		pmwebapi_labelsetfree(cluster->labelset);
 	    cluster->labelset = labels;
 	    cluster->updated = 1;
 	} else if (cluster) {
@@ -1409,7 +1409,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 
 	if (metric && (labels = pmwebapi_labelsetdup(sets)) != NULL) {
 	    if (metric->labelset)
-		pmFreeLabelSets(metric->labelset, 1);
+		pmwebapi_labelsetfree(metric->labelset);
 	    metric->labelset = labels;
 	    metric->updated = 1;
 	} else if (metric) {
@@ -1427,7 +1427,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 
 	if (indom && (labels = pmwebapi_labelsetdup(sets)) != NULL) {
 	    if (indom->labelset)
-		pmFreeLabelSets(indom->labelset, 1);
+		pmwebapi_labelsetfree(indom->labelset);
 		    indom->labelset = labels;
 	    indom->updated = 1;
 	} else if (indom) {
@@ -1457,7 +1457,7 @@ pmSeriesDiscoverLabels(pmDiscoverEvent *event,
 		moduleinfo(event->module, PMLOG_ERROR, msg, arg);
 	    }
 	    if (instance->labelset)
-		pmFreeLabelSets(instance->labelset, 1);
+		pmwebapi_labelsetfree(instance->labelset);
 	    instance->labelset = labels;
 	    pmwebapi_instance_hash(indom, instance);
 	    indom->updated = 1;
@@ -143,6 +143,8 @@ typedef struct metric {
 	pmAtomValue	atom;		/* singleton value (PM_IN_NULL) */
 	valuelist_t	*vlist;		/* instance values and metadata */
     } u;
+    struct seriesChunk	*chunk;		/* compressed values encoder state */
+    struct seriesRollup	*rollups;	/* downsampled tiers (optional) */
 } metric_t;
 
 struct seriesGetContext;
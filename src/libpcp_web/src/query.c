@@ -24,6 +24,8 @@
 #include "schema.h"
 #include "slots.h"
 #include "maps.h"
+#include "chunks.h"
+#include "rollup.h"
 #include <math.h>
 #include <fnmatch.h>
 
@@ -75,6 +77,7 @@ static int series_calculate(node_t *, int, void *);
 static void series_key_hash_expression(seriesQueryBaton *, char *, int);
 static void series_node_get_metric_name(seriesQueryBaton *, seriesGetSID *, series_sample_set_t *);
 static void series_node_get_desc(seriesQueryBaton *, sds, series_sample_set_t *);
+static int series_extract_type(char *);
 static void series_lookup_services(void *);
 static void series_lookup_mapping(void *);
 static void series_lookup_finished(void *);
@@ -82,6 +85,7 @@ static void series_query_mapping(void *arg);
 static void series_instances_reply_callback(keyClusterAsyncContext *, void *, void *);
 
 sds	cursorcount;	/* number of elements in each SCAN call */
+int	chunkvalues;	/* series values held in compressed chunks */
 
 static void
 initSeriesGetQuery(seriesQueryBaton *baton, node_t *root, timing_t *timing)
@@ -125,6 +129,15 @@ freeSeriesQueryNode(node_t *np)
 		}
 		free(np->value_set.series_values[i].series_sample[j].series_instance);
 	    }
+	    for (j = 0; j < np->value_set.series_values[i].num_weights; j++) {
+		for (k = 0; k < np->value_set.series_values[i].weights[j].num_instances; k++) {
+		    sdsfree(np->value_set.series_values[i].weights[j].series_instance[k].timestamp);
+		    sdsfree(np->value_set.series_values[i].weights[j].series_instance[k].series);
+		    sdsfree(np->value_set.series_values[i].weights[j].series_instance[k].data);
+		}
+		free(np->value_set.series_values[i].weights[j].series_instance);
+	    }
+	    free(np->value_set.series_values[i].weights);
 	    sdsfree(np->value_set.series_values[i].sid->name);
 	    free(np->value_set.series_values[i].sid);
 	    free(np->value_set.series_values[i].series_sample);
@@ -1539,6 +1552,810 @@ series_query_expr_reply(keyClusterAsyncContext *c, void *r, void *arg)
     series_query_end_phase(baton);
 }
 
+/*
+ * Reading values from compressed chunks - the chunk windows of a series
+ * overlapping the time range are found from its index, then each chunk
+ * is fetched and decoded, and the samples handed on as one XRANGE-style
+ * reply to the usual values callback.
+ *
+ * When a statistic over the whole time range is wanted (as for rollup
+ * tiers) the summaries of chunks lying entirely within the range stand
+ * in for their values, for series without an instance domain (chunk
+ * summaries cover all instances) - these are decoded only for maxima
+ * and minima, and then only the one chunk holding the extreme value.
+ * The first and last chunks are always decoded.
+ */
+typedef enum seriesChunkSelect {
+    CHUNK_VALUES,	/* decode every chunk */
+    CHUNK_MIN,		/* summaries for all but the least minimum */
+    CHUNK_MAX,		/* summaries for all but the greatest maximum */
+    CHUNK_MEANS,	/* summary means, weighted by summary counts */
+} seriesChunkSelect;
+
+typedef struct seriesChunkRead {
+    seriesQueryBaton	*baton;
+    keyClusterCallbackFn *callback;
+    void		*arg;
+    sds			name;
+    __int64_t		start;
+    __int64_t		end;		/* zero means no end */
+    unsigned int	reverse;	/* count of most recent samples */
+    unsigned int	nchunks;
+    unsigned int	pending;
+    seriesChunkSelect	select;		/* chunks answered from summaries */
+    unsigned int	singular;	/* numeric series without an indom */
+    series_sample_set_t	*weights;	/* sample weights, for summaries */
+    struct seriesChunkGet {
+	struct seriesChunkRead	*read;
+	sds			buffer;
+	__int64_t		window;
+	__int64_t		span;
+	unsigned int		interior : 1;	/* within the time range */
+	unsigned int		summary : 1;	/* summary values are known */
+	unsigned int		skip : 1;	/* not fetched, nor decoded */
+	unsigned int		mean : 1;	/* one sample, from the summary */
+	unsigned int		padding : 28;
+	unsigned int		nvalues;
+	double			min;
+	double			max;
+	double			sum;
+    }			*chunks;
+} seriesChunkRead;
+
+static void
+series_chunk_read_done(seriesChunkRead *read, respReply *reply)
+{
+    unsigned int	i;
+
+    read->callback(NULL, reply, read->arg);
+
+    for (i = 0; i < read->nchunks; i++)
+	sdsfree(read->chunks[i].buffer);
+    free(read->chunks);
+    sdsfree(read->name);
+    free(read);
+}
+
+/*
+ * Samples standing for whole chunks are weighted by the number of
+ * values summarised, and all others count once; stored alongside the
+ * samples, and aligned with them, as for rollup tier sample counts.
+ */
+static void
+series_chunk_weights(seriesChunkRead *read, unsigned int *counts, size_t count)
+{
+    series_sample_set_t	*set = read->weights;
+    pmSeriesValue	*value;
+    size_t		i;
+
+    if ((set->weights = calloc(count, sizeof(series_instance_set_t))) == NULL)
+	return;
+    set->num_weights = count;
+    for (i = 0; i < count; i++) {
+	if ((value = calloc(1, sizeof(pmSeriesValue))) == NULL)
+	    break;
+	value->series = sdsdup(read->name);
+	value->data = sdscatfmt(sdsempty(), "%u", counts[i]);
+	set->weights[i].series_instance = value;
+	set->weights[i].num_instances = 1;
+    }
+}
+
+static void
+series_chunk_decode(seriesChunkRead *read)
+{
+    struct seriesChunkGet *chunk;
+    respReply		reply = {0}, **replies = NULL, *swap;
+    size_t		count = 0, before, i;
+    unsigned int	*counts = NULL, *tmp;
+    sds			msg, mean;
+    int			sts;
+
+    for (i = 0; i < read->nchunks; i++) {
+	/* the index was read newest-first when looking for recent samples */
+	chunk = &read->chunks[read->reverse ? read->nchunks - i - 1 : i];
+	before = count;
+	if (chunk->mean) {
+	    mean = sdscatprintf(sdsempty(), "%.17g", chunk->sum / chunk->nvalues);
+	    sts = seriesChunkSample(chunk->window, mean, &replies, &count);
+	    sdsfree(mean);
+	} else if (chunk->buffer == NULL) {	/* skipped, or expired */
+	    continue;
+	} else {
+	    sts = seriesChunkDecode(chunk->buffer, sdslen(chunk->buffer),
+			read->start, read->end, &replies, &count);
+	}
+	if (sts < 0) {
+	    msg = NULL;
+	    infofmt(msg, "failed to decode %s values chunk: %s",
+			read->name, pmErrStr(sts));
+	    batoninfo(read->baton, PMLOG_RESPONSE, msg);
+	}
+	if (read->weights && count > before) {
+	    if ((tmp = realloc(counts, count * sizeof(unsigned int))) == NULL) {
+		read->weights = NULL;
+		continue;
+	    }
+	    counts = tmp;
+	    while (before < count)
+		counts[before++] = chunk->mean ? chunk->nvalues : 1;
+	}
+    }
+    if (read->weights && counts)
+	series_chunk_weights(read, counts, count);
+    free(counts);
+
+    reply.type = RESP_REPLY_ARRAY;
+    reply.element = replies;
+    reply.elements = count;
+    if (read->reverse) {
+	for (i = 0; i < count / 2; i++) {
+	    swap = replies[i];
+	    replies[i] = replies[count - i - 1];
+	    replies[count - i - 1] = swap;
+	}
+	if (reply.elements > read->reverse)
+	    reply.elements = read->reverse;
+    }
+    series_chunk_read_done(read, &reply);
+    seriesChunkFreeReplies(replies, count);
+}
+
+static void
+series_chunk_get_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    struct seriesChunkGet *chunk = (struct seriesChunkGet *)arg;
+    seriesChunkRead	*read = chunk->read;
+    respReply		*reply = r;
+
+    if (reply && reply->type == RESP_REPLY_STRING)
+	chunk->buffer = sdsnewlen(reply->str, reply->len);
+    if (--read->pending == 0)
+	series_chunk_decode(read);
+}
+
+static void
+series_chunk_get(seriesChunkRead *read)
+{
+    struct seriesChunkGet *chunk;
+    unsigned int	i;
+    char		window[64];
+    sds			key, cmd;
+
+    for (i = 0; i < read->nchunks; i++)
+	if (read->chunks[i].skip == 0 && read->chunks[i].mean == 0)
+	    read->pending++;
+    if (read->pending == 0) {
+	series_chunk_decode(read);
+	return;
+    }
+    for (i = 0; i < read->nchunks; i++) {
+	chunk = &read->chunks[i];
+	if (chunk->skip || chunk->mean)
+	    continue;
+	pmsprintf(window, sizeof(window), "%lld:%lld",
+			(long long)chunk->window, (long long)chunk->span);
+	key = sdscatfmt(sdsempty(), "pcp:chunk:series:%S:%s", read->name, window);
+	cmd = resp_command(2);
+	cmd = resp_param_str(cmd, GETS, GETS_LEN);
+	cmd = resp_param_sds(cmd, key);
+	sdsfree(key);
+	keySlotsRequest(read->baton->slots, cmd, series_chunk_get_reply, chunk);
+	sdsfree(cmd);
+    }
+}
+
+/*
+ * Choose the chunks whose summaries stand in for their values - for
+ * means, all of those with summaries; for extremes, all but the first
+ * chunk holding the most extreme summarised value (decoded in full, so
+ * the time of that value is reported, as for the raw values).
+ */
+static void
+series_chunk_select(seriesChunkRead *read)
+{
+    struct seriesChunkGet *chunk, *best = NULL;
+    unsigned int	i;
+
+    for (i = 0; i < read->nchunks; i++) {
+	chunk = &read->chunks[i];
+	if (!read->singular || !chunk->summary)
+	    continue;
+	if (read->select == CHUNK_MEANS) {
+	    chunk->mean = 1;
+	    continue;
+	}
+	chunk->skip = 1;
+	if (best == NULL ||
+	    (read->select == CHUNK_MAX && chunk->max > best->max) ||
+	    (read->select == CHUNK_MIN && chunk->min < best->min))
+	    best = chunk;
+    }
+    if (best)
+	best->skip = 0;
+    series_chunk_get(read);
+}
+
+static void
+series_chunk_desc_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesChunkRead	*read = (seriesChunkRead *)arg;
+    respReply		*reply = r, *indom, *type;
+
+    if (reply && reply->type == RESP_REPLY_ARRAY && reply->elements == 2) {
+	indom = reply->element[0];
+	type = reply->element[1];
+	if (indom->type == RESP_REPLY_STRING &&
+	    type->type == RESP_REPLY_STRING &&
+	    strcmp(indom->str, "none") == 0 &&
+	    series_extract_type(type->str) != PM_TYPE_UNKNOWN)
+	    read->singular = 1;
+    }
+    if (--read->pending == 0)
+	series_chunk_select(read);
+}
+
+static void
+series_chunk_summary_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesChunkRead	*read = (seriesChunkRead *)arg;
+    struct seriesChunkGet *chunk;
+    respReply		*reply = r, *summary;
+    unsigned int	i, n = 0, count;
+
+    if (reply && reply->type == RESP_REPLY_ARRAY) {
+	for (i = 0; i < read->nchunks; i++) {
+	    chunk = &read->chunks[i];
+	    if (!chunk->interior || n >= reply->elements)
+		continue;
+	    summary = reply->element[n++];
+	    /* count of records, then count, min, max and sum of values */
+	    if (summary->type == RESP_REPLY_STRING &&
+		sscanf(summary->str, "%u %u %lf %lf %lf", &count,
+			&chunk->nvalues, &chunk->min, &chunk->max,
+			&chunk->sum) == 5 && chunk->nvalues > 0)
+		chunk->summary = 1;
+	}
+    }
+    if (--read->pending == 0)
+	series_chunk_select(read);
+}
+
+/*
+ * Request the descriptor of the series and the summaries of the chunks
+ * lying entirely within the time range.
+ */
+static void
+series_chunk_summaries(seriesChunkRead *read, unsigned int ninterior)
+{
+    seriesQueryBaton	*baton = read->baton;
+    unsigned int	i;
+    char		window[64];
+    int			length;
+    sds			key, cmd;
+
+    read->pending = 2;
+
+    key = sdscatfmt(sdsempty(), "pcp:desc:series:%S", read->name);
+    cmd = resp_command(4);	/* HMGET key indom type */
+    cmd = resp_param_str(cmd, HMGET, HMGET_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, "indom", sizeof("indom")-1);
+    cmd = resp_param_str(cmd, "type", sizeof("type")-1);
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, series_chunk_desc_reply, read);
+    sdsfree(cmd);
+
+    key = sdscatfmt(sdsempty(), "pcp:chunksum:series:%S", read->name);
+    cmd = resp_command(2 + ninterior);	/* HMGET key window ... */
+    cmd = resp_param_str(cmd, HMGET, HMGET_LEN);
+    cmd = resp_param_sds(cmd, key);
+    for (i = 0; i < read->nchunks; i++) {
+	if (!read->chunks[i].interior)
+	    continue;
+	length = pmsprintf(window, sizeof(window), "%lld:%lld",
+			(long long)read->chunks[i].window,
+			(long long)read->chunks[i].span);
+	cmd = resp_param_str(cmd, window, length);
+    }
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, series_chunk_summary_reply, read);
+    sdsfree(cmd);
+}
+
+/*
+ * Chunk index members name each chunk as "window:span" (usec), so the
+ * span the loader used is known for every chunk, whatever the span
+ * configured for the query.
+ */
+static int
+series_chunk_member(respReply *member, __int64_t *window, __int64_t *span)
+{
+    char		*end;
+
+    if (member == NULL || member->type != RESP_REPLY_STRING)
+	return -1;
+    *window = strtoll(member->str, &end, 10);
+    if (*end != ':' || (*span = strtoll(end + 1, NULL, 10)) <= 0)
+	return -1;
+    return 0;
+}
+
+static void
+series_chunk_index_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesChunkRead	*read = (seriesChunkRead *)arg;
+    struct seriesChunkGet *chunk;
+    respReply		*reply = r, empty = {0};
+    unsigned int	i, ninterior = 0;
+
+    if (UNLIKELY(reply == NULL || reply->type != RESP_REPLY_ARRAY)) {
+	series_chunk_read_done(read, reply);
+	return;
+    }
+    if (reply->elements == 0 ||
+	(read->chunks = calloc(reply->elements,
+				sizeof(struct seriesChunkGet))) == NULL) {
+	empty.type = RESP_REPLY_ARRAY;
+	series_chunk_read_done(read, &empty);
+	return;
+    }
+    read->nchunks = reply->elements;
+    for (i = 0; i < reply->elements; i++) {
+	chunk = &read->chunks[i];
+	chunk->read = read;
+	if (series_chunk_member(reply->element[i], &chunk->window, &chunk->span) < 0)
+	    chunk->skip = 1;
+	/* the first and last chunks may have values outside the range */
+	else if (read->select != CHUNK_VALUES && i > 0 && i < reply->elements - 1 &&
+	    chunk->window >= read->start &&
+	    (read->end == 0 || chunk->window + chunk->span - 1 <= read->end)) {
+	    chunk->interior = 1;
+	    ninterior++;
+	}
+    }
+    if (ninterior)
+	series_chunk_summaries(read, ninterior);
+    else
+	series_chunk_get(read);
+}
+
+static __int64_t
+series_chunk_usec(struct timespec *stamp)
+{
+    return (__int64_t)stamp->tv_sec * 1000000 + stamp->tv_nsec / 1000;
+}
+
+/*
+ * Request the chunk windows from the given minimum (the window covering
+ * the start of the time range, else the start) to the end of the range.
+ */
+static void
+series_chunk_index(seriesChunkRead *read, __int64_t min)
+{
+    char		minbuf[32], maxbuf[32];
+    unsigned int	minlen, maxlen;
+    sds			key, cmd;
+
+    minlen = pmsprintf(minbuf, sizeof(minbuf), "%lld", (long long)min);
+    if (read->end)
+	maxlen = pmsprintf(maxbuf, sizeof(maxbuf), "%lld", (long long)read->end);
+    else
+	maxlen = pmsprintf(maxbuf, sizeof(maxbuf), "+inf");
+
+    key = sdscatfmt(sdsempty(), "pcp:chunks:series:%S", read->name);
+    cmd = resp_command(4);	/* ZRANGEBYSCORE key min max */
+    cmd = resp_param_str(cmd, ZRANGEBYSCORE, ZRANGEBYSCORE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, minbuf, minlen);
+    cmd = resp_param_str(cmd, maxbuf, maxlen);
+    sdsfree(key);
+    keySlotsRequest(read->baton->slots, cmd, series_chunk_index_reply, read);
+    sdsfree(cmd);
+}
+
+static void
+series_chunk_prior_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesChunkRead	*read = (seriesChunkRead *)arg;
+    respReply		*reply = r;
+    __int64_t		window, span;
+
+    /* the last window beginning at or before the start may cover it */
+    if (reply && reply->type == RESP_REPLY_ARRAY && reply->elements > 0 &&
+	series_chunk_member(reply->element[0], &window, &span) == 0 &&
+	window + span > read->start)
+	series_chunk_index(read, window);
+    else
+	series_chunk_index(read, read->start);
+}
+
+/* chunk summaries answering a rollup statistic, as for the tiers */
+static seriesChunkSelect
+series_chunk_select_stat(int stat)
+{
+    switch (stat) {
+    case ROLLUP_MIN:
+	return CHUNK_MIN;
+    case ROLLUP_MAX:
+	return CHUNK_MAX;
+    case ROLLUP_COUNT:	/* interval means weighted by sample counts */
+	return CHUNK_MEANS;
+    default:
+	break;
+    }
+    return CHUNK_VALUES;
+}
+
+/*
+ * Request values of one series from the chunks overlapping the time
+ * window; the callback is invoked once, as for an X[REV]RANGE reply.
+ * Given a selection other than CHUNK_VALUES, and somewhere for the
+ * sample weights, chunk summaries may stand in for some values.
+ */
+static void
+series_chunk_read(seriesQueryBaton *baton, sds name, timing_t *tp,
+		unsigned int reverse, seriesChunkSelect select,
+		series_sample_set_t *weights,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    seriesChunkRead	*read;
+    respReply		empty = {0};
+    char		minbuf[32], revbuf[32];
+    unsigned int	minlen, revlen;
+    sds			key, cmd;
+
+    if ((read = calloc(1, sizeof(seriesChunkRead))) == NULL) {
+	empty.type = RESP_REPLY_ARRAY;
+	callback(NULL, &empty, arg);
+	return;
+    }
+    read->baton = baton;
+    read->callback = callback;
+    read->arg = arg;
+    read->name = sdsdup(name);
+    read->reverse = reverse;
+    read->select = (reverse || weights == NULL) ? CHUNK_VALUES : select;
+    read->weights = (read->select == CHUNK_MEANS) ? weights : NULL;
+
+    key = sdscatfmt(sdsempty(), "pcp:chunks:series:%S", name);
+    if (reverse) {
+	/* each chunk holds at least one sample, so at most 'count' chunks */
+	revlen = pmsprintf(revbuf, sizeof(revbuf), "%u", reverse);
+	cmd = resp_command(7);	/* ZREVRANGEBYSCORE key max min LIMIT 0 N */
+	cmd = resp_param_str(cmd, ZREVRANGEBYSCORE, ZREVRANGEBYSCORE_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_str(cmd, "+inf", 4);
+	cmd = resp_param_str(cmd, "-inf", 4);
+	cmd = resp_param_str(cmd, "LIMIT", sizeof("LIMIT")-1);
+	cmd = resp_param_str(cmd, "0", 1);
+	cmd = resp_param_str(cmd, revbuf, revlen);
+	sdsfree(key);
+	keySlotsRequest(baton->slots, cmd, series_chunk_index_reply, read);
+	sdsfree(cmd);
+	return;
+    }
+
+    read->start = series_chunk_usec(&tp->start);
+    if (tp->end.tv_sec)
+	read->end = series_chunk_usec(&tp->end);
+    minlen = pmsprintf(minbuf, sizeof(minbuf), "%lld", (long long)read->start);
+    cmd = resp_command(7);	/* ZREVRANGEBYSCORE key start -inf LIMIT 0 1 */
+    cmd = resp_param_str(cmd, ZREVRANGEBYSCORE, ZREVRANGEBYSCORE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, minbuf, minlen);
+    cmd = resp_param_str(cmd, "-inf", 4);
+    cmd = resp_param_str(cmd, "LIMIT", sizeof("LIMIT")-1);
+    cmd = resp_param_str(cmd, "0", 1);
+    cmd = resp_param_str(cmd, "1", 1);
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, series_chunk_prior_reply, read);
+    sdsfree(cmd);
+}
+
+static void
+series_time_range(timing_t *tp, unsigned int reverse, sds *start, sds *end)
+{
+    char		buffer[64];
+
+    if (reverse)
+	*start = sdsnew("+");
+    else
+	*start = sdsnew(timespec_stream_str(&tp->start, buffer, sizeof(buffer)));
+
+    if (reverse)
+	*end = sdsnew("-");
+    else if (tp->end.tv_sec)
+	*end = sdsnew(timespec_stream_str(&tp->end, buffer, sizeof(buffer)));
+    else
+	*end = sdsnew("+");	/* "+" means "no end" - to the most recent */
+}
+
+/*
+ * Request values of one series from a stream within the time window,
+ * else the given count of most recent values (reverse), optionally
+ * limited to the first 'count' values in the window.
+ */
+static void
+series_stream_read(seriesQueryBaton *baton, sds key, timing_t *tp,
+		unsigned int reverse, unsigned int count,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    char		buffer[64];
+    unsigned int	length;
+    sds			start, end, cmd;
+
+    series_time_range(tp, reverse, &start, &end);
+
+    /* X[REV]RANGE key t1 t2 [count N] */
+    if (reverse) {
+	count = reverse;
+	cmd = resp_command(6);
+	cmd = resp_param_str(cmd, XREVRANGE, XREVRANGE_LEN);
+    } else {
+	cmd = resp_command(count ? 6 : 4);
+	cmd = resp_param_str(cmd, XRANGE, XRANGE_LEN);
+    }
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_sds(cmd, start);
+    cmd = resp_param_sds(cmd, end);
+    if (count) {
+	length = pmsprintf(buffer, sizeof(buffer), "%u", count);
+	cmd = resp_param_str(cmd, "COUNT", sizeof("COUNT")-1);
+	cmd = resp_param_str(cmd, buffer, length);
+    }
+    keySlotsRequest(baton->slots, cmd, callback, arg);
+    sdsfree(cmd);
+    sdsfree(start);
+    sdsfree(end);
+}
+
+/*
+ * Request values of one series in the time window - one statistic of a
+ * rollup tier if given (tier >= 0), else the raw values from chunks or
+ * the values stream; the callback is invoked once, with an X[REV]RANGE
+ * style reply.
+ */
+static void
+series_values_read(seriesQueryBaton *baton, sds name, timing_t *tp,
+		unsigned int reverse, int tier, int stat,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    sds			key;
+
+    if (tier >= 0) {
+	key = seriesRollupKey(rolluptiers[tier], stat, name);
+    } else if (chunkvalues) {
+	series_chunk_read(baton, name, tp, reverse, CHUNK_VALUES, NULL,
+			callback, arg);
+	return;
+    } else {
+	key = sdscatfmt(sdsempty(), "pcp:values:series:%S", name);
+    }
+    series_stream_read(baton, key, tp, reverse, 0, callback, arg);
+    sdsfree(key);
+}
+
+/*
+ * Rollup tiers hold numeric values only, from when they were first
+ * configured, and the last value (not the mean) of each interval for
+ * counters.  Before reading from a tier check the series type (and its
+ * semantics, for the weighted means), and that the tier began no later
+ * than the first raw sample in the time window; else the raw values are
+ * read instead (tier -1).
+ */
+typedef void (*seriesRollupCallBack)(seriesQueryBaton *, int, void *);
+
+typedef struct seriesRollupCheck {
+    seriesQueryBaton	*baton;
+    seriesRollupCallBack callback;
+    void		*arg;
+    int			tier;
+    int			stat;
+    int			numeric;	/* series type and semantics rolled up */
+    unsigned int	pending;
+    sds			name;
+    __int64_t		start;		/* start of the time window (usec) */
+    __int64_t		end;		/* end of the time window, or zero */
+    __int64_t		first;		/* first raw sample in window, or -1 */
+    __int64_t		rollup;		/* first interval of the tier, or -1 */
+} seriesRollupCheck;
+
+static void
+series_rollup_check_done(seriesRollupCheck *check)
+{
+    int			tier = check->tier;
+
+    if (--check->pending > 0)
+	return;
+    if (!check->numeric || check->rollup < 0 ||
+	(check->first >= 0 && check->rollup > check->first))
+	tier = -1;
+    check->callback(check->baton, tier, check->arg);
+    sdsfree(check->name);
+    free(check);
+}
+
+/* time of the first entry of an XRANGE reply, or the first chunk window */
+static __int64_t
+series_rollup_stamp(respReply *reply)
+{
+    respReply		*entry;
+
+    if (reply == NULL || reply->type != RESP_REPLY_ARRAY || reply->elements == 0)
+	return -1;
+    entry = reply->element[0];
+    if (entry->type == RESP_REPLY_STRING)
+	return strtoll(entry->str, NULL, 10);
+    if (entry->type == RESP_REPLY_ARRAY && entry->elements > 0 &&
+	entry->element[0]->type == RESP_REPLY_STRING)
+	return seriesChunkStamp(entry->element[0]->str);
+    return -1;
+}
+
+static void
+series_rollup_desc_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesRollupCheck	*check = (seriesRollupCheck *)arg;
+    respReply		*reply = r, *type, *semantics;
+
+    if (reply && reply->type == RESP_REPLY_ARRAY && reply->elements == 2) {
+	type = reply->element[0];
+	semantics = reply->element[1];
+	if (type->type == RESP_REPLY_STRING &&
+	    semantics->type == RESP_REPLY_STRING &&
+	    series_extract_type(type->str) != PM_TYPE_UNKNOWN &&
+	    (check->stat != ROLLUP_COUNT || strcmp(semantics->str, "counter") != 0))
+	    check->numeric = 1;
+    }
+    series_rollup_check_done(check);
+}
+
+static void
+series_rollup_first_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesRollupCheck	*check = (seriesRollupCheck *)arg;
+
+    check->first = series_rollup_stamp(r);
+    series_rollup_check_done(check);
+}
+
+static void
+series_rollup_prior_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesRollupCheck	*check = (seriesRollupCheck *)arg;
+    respReply		*reply = r;
+    __int64_t		window, span;
+    char		minbuf[32], maxbuf[32];
+    unsigned int	minlen, maxlen;
+    sds			key, cmd;
+
+    /* the last window beginning at or before the start may cover it */
+    if (reply && reply->type == RESP_REPLY_ARRAY && reply->elements > 0 &&
+	series_chunk_member(reply->element[0], &window, &span) == 0 &&
+	window + span > check->start) {
+	check->first = check->start;
+	series_rollup_check_done(check);
+	return;
+    }
+
+    /* else the first window beginning within the time window */
+    minlen = pmsprintf(minbuf, sizeof(minbuf), "(%lld", (long long)check->start);
+    if (check->end)
+	maxlen = pmsprintf(maxbuf, sizeof(maxbuf), "%lld", (long long)check->end);
+    else
+	maxlen = pmsprintf(maxbuf, sizeof(maxbuf), "+inf");
+    key = sdscatfmt(sdsempty(), "pcp:chunks:series:%S", check->name);
+    cmd = resp_command(7);	/* ZRANGEBYSCORE key min max LIMIT 0 1 */
+    cmd = resp_param_str(cmd, ZRANGEBYSCORE, ZRANGEBYSCORE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, minbuf, minlen);
+    cmd = resp_param_str(cmd, maxbuf, maxlen);
+    cmd = resp_param_str(cmd, "LIMIT", sizeof("LIMIT")-1);
+    cmd = resp_param_str(cmd, "0", 1);
+    cmd = resp_param_str(cmd, "1", 1);
+    sdsfree(key);
+    keySlotsRequest(check->baton->slots, cmd, series_rollup_first_reply, check);
+    sdsfree(cmd);
+}
+
+static void
+series_rollup_tier_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesRollupCheck	*check = (seriesRollupCheck *)arg;
+
+    check->rollup = series_rollup_stamp(r);
+    series_rollup_check_done(check);
+}
+
+static void
+series_rollup_check(seriesQueryBaton *baton, sds name, timing_t *tp,
+		int tier, int stat, seriesRollupCallBack callback, void *arg)
+{
+    seriesRollupCheck	*check;
+    char		minbuf[32];
+    unsigned int	minlen;
+    sds			key, cmd;
+
+    if ((check = calloc(1, sizeof(seriesRollupCheck))) == NULL) {
+	callback(baton, -1, arg);
+	return;
+    }
+    check->baton = baton;
+    check->callback = callback;
+    check->arg = arg;
+    check->tier = tier;
+    check->stat = stat;
+    check->name = sdsdup(name);
+    check->start = series_chunk_usec(&tp->start);
+    if (tp->end.tv_sec)
+	check->end = series_chunk_usec(&tp->end);
+    check->first = check->rollup = -1;
+    check->pending = 3;
+
+    key = sdscatfmt(sdsempty(), "pcp:desc:series:%S", name);
+    cmd = resp_command(4);	/* HMGET key type semantics */
+    cmd = resp_param_str(cmd, HMGET, HMGET_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, "type", sizeof("type")-1);
+    cmd = resp_param_str(cmd, "semantics", sizeof("semantics")-1);
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, series_rollup_desc_reply, check);
+    sdsfree(cmd);
+
+    if (chunkvalues) {
+	key = sdscatfmt(sdsempty(), "pcp:chunks:series:%S", name);
+	minlen = pmsprintf(minbuf, sizeof(minbuf), "%lld", (long long)check->start);
+	cmd = resp_command(7);	/* ZREVRANGEBYSCORE key start -inf LIMIT 0 1 */
+	cmd = resp_param_str(cmd, ZREVRANGEBYSCORE, ZREVRANGEBYSCORE_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_str(cmd, minbuf, minlen);
+	cmd = resp_param_str(cmd, "-inf", 4);
+	cmd = resp_param_str(cmd, "LIMIT", sizeof("LIMIT")-1);
+	cmd = resp_param_str(cmd, "0", 1);
+	cmd = resp_param_str(cmd, "1", 1);
+	sdsfree(key);
+	keySlotsRequest(baton->slots, cmd, series_rollup_prior_reply, check);
+	sdsfree(cmd);
+    } else {
+	key = sdscatfmt(sdsempty(), "pcp:values:series:%S", name);
+	series_stream_read(baton, key, tp, 0, 1, series_rollup_first_reply, check);
+	sdsfree(key);
+    }
+
+    /* all statistics of an interval are written together */
+    key = seriesRollupKey(rolluptiers[tier], stat, name);
+    cmd = resp_command(6);	/* XRANGE key - + COUNT 1 */
+    cmd = resp_param_str(cmd, XRANGE, XRANGE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, "-", 1);
+    cmd = resp_param_str(cmd, "+", 1);
+    cmd = resp_param_str(cmd, "COUNT", sizeof("COUNT")-1);
+    cmd = resp_param_str(cmd, "1", 1);
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, series_rollup_tier_reply, check);
+    sdsfree(cmd);
+}
+
+/* use the coarsest rollup tier that satisfies the sampling interval */
+static int
+series_rollup_tier(timing_t *tp, unsigned int reverse)
+{
+    if (reverse || rollupcount == 0 ||
+	(tp->delta.tv_sec == 0 && tp->delta.tv_nsec == 0))
+	return -1;
+    return seriesRollupTier(&tp->delta);
+}
+
 static void
 series_prepare_time_reply(
 	keyClusterAsyncContext *c, void *r, void *arg)
@@ -1598,36 +2415,37 @@ series_value_count_only(timing_t *tp)
     return tp->count;
 }
 
+static void
+series_prepare_time_read(seriesQueryBaton *baton, int tier, void *arg)
+{
+    seriesGetSID	*sid = (seriesGetSID *)arg;
+
+    series_values_read(baton, sid->name, &baton->query.timing, 0,
+			tier, ROLLUP_VALUE, series_prepare_time_reply, sid);
+}
+
 static void
 series_prepare_time(seriesQueryBaton *baton, series_set_t *result)
 {
     timing_t		*tp = &baton->query.timing;
     unsigned char	*series = result->series;
     seriesGetSID	*sid;
-    char		buffer[64], revbuf[64];
-    sds			start, end, key, cmd;
-    unsigned int	i, revlen = 0, reverse = 0;
+    char		buffer[64];
+    sds			start, end;
+    unsigned int	i, reverse;
+    int			tier;
 
     /* if only 'count' is requested, work back from most recent value */
-    if ((reverse = series_value_count_only(tp)) != 0) {
-	revlen = pmsprintf(revbuf, sizeof(revbuf), "%u", reverse);
-	start = sdsnew("+");
-    } else {
-	start = sdsnew(timespec_stream_str(&tp->start, buffer, sizeof(buffer)));
-    }
+    reverse = series_value_count_only(tp);
+    tier = series_rollup_tier(tp, reverse);
 
-    if (pmDebugOptions.series)
+    if (pmDebugOptions.series) {
+	series_time_range(tp, reverse, &start, &end);
 	fprintf(stderr, "START: %s\n", start);
-
-    if (reverse)
-	end = sdsnew("-");
-    else if (tp->end.tv_sec)
-	end = sdsnew(timespec_stream_str(&tp->end, buffer, sizeof(buffer)));
-    else
-	end = sdsnew("+");	/* "+" means "no end" - to the most recent */
-
-    if (pmDebugOptions.series)
 	fprintf(stderr, "END: %s\n", end);
+	sdsfree(start);
+	sdsfree(end);
+    }
 
     /*
      * Query cache for the time series range (groups of instance:value
@@ -1640,30 +2458,13 @@ series_prepare_time(seriesQueryBaton *baton, series_set_t *result)
 	initSeriesGetSID(sid, buffer, 1, baton);
 	seriesBatonReference(baton, "series_prepare_time");
 
-	key = sdscatfmt(sdsempty(), "pcp:values:series:%S", sid->name);
-
-	/* X[REV]RANGE key t1 t2 [count N] */
-	if (reverse) {
-	    cmd = resp_command(6);
-	    cmd = resp_param_str(cmd, XREVRANGE, XREVRANGE_LEN);
-	} else {
-	    cmd = resp_command(4);
-	    cmd = resp_param_str(cmd, XRANGE, XRANGE_LEN);
-	}
-	cmd = resp_param_sds(cmd, key);
-	cmd = resp_param_sds(cmd, start);
-	cmd = resp_param_sds(cmd, end);
-	if (reverse) {
-	    cmd = resp_param_str(cmd, "COUNT", sizeof("COUNT")-1);
-	    cmd = resp_param_str(cmd, revbuf, revlen);
-	}
-	sdsfree(key);
-	keySlotsRequest(baton->slots, cmd,
+	if (tier >= 0)
+	    series_rollup_check(baton, sid->name, tp, tier, ROLLUP_VALUE,
+				series_prepare_time_read, sid);
+	else
+	    series_values_read(baton, sid->name, tp, reverse, -1, ROLLUP_VALUE,
 				series_prepare_time_reply, sid);
-	sdsfree(cmd);
     }
-    sdsfree(start);
-    sdsfree(end);
 }
 
 static void
@@ -1798,13 +2599,13 @@ series_query_expr(void *arg)
 
 static int
 series_instance_store_to_node(seriesQueryBaton *baton, sds series,
-	pmSeriesValue *value, int nelements, respReply **elements, node_t *np, int idx_sample)
+	pmSeriesValue *value, int nelements, respReply **elements,
+	series_instance_set_t *sample)
 {
     char		hashbuf[42];
     sds			inst;
     int			i, sts = 0;
     int			idx_instance = 0;
-    int			idx_series = np->value_set.num_series;
 
     for (i = 0; i < nelements; i += 2) {
 	inst = value->series;
@@ -1827,7 +2628,7 @@ series_instance_store_to_node(seriesQueryBaton *baton, sds series,
 	    sts = -EPROTO;
 	else {
 	    /* update value instance */
-	    pmSeriesValue *valinst = &np->value_set.series_values[idx_series].series_sample[idx_sample].series_instance[idx_instance];
+	    pmSeriesValue *valinst = &sample->series_instance[idx_instance];
 
 	    valinst->ts = value->ts; /* struct pmTimespec assign */
 	    valinst->timestamp = sdsnew(value->timestamp);
@@ -1839,17 +2640,21 @@ series_instance_store_to_node(seriesQueryBaton *baton, sds series,
     return sts;
 }
 
-/* Do something like memcpy */
+/*
+ * Do something like memcpy - into the samples array, which has one entry
+ * per reply sample; all are used for rollup statistics (unsampled), else
+ * only those selected for the requested sampling interval.
+ */
 static void
 series_values_store_to_node(seriesQueryBaton *baton, sds series,
-		int nsamples, respReply **samples, node_t *np)
+		int nsamples, respReply **samples,
+		series_instance_set_t *set, int unsampled)
 {
     seriesSampling	sampling = {0};
+    series_instance_set_t *dest;
     respReply		*reply, *sample, **elements;
     timing_t		*tp = &baton->query.timing;
     int			i, sts, next, nelements;
-    int			idx_series = np->value_set.num_series;
-    int			idx_sample = 0;
     sds			msg = NULL, save_timestamp;
 
     sampling.value.timestamp = sdsempty();
@@ -1882,7 +2687,8 @@ series_values_store_to_node(seriesQueryBaton *baton, sds series,
 	}
 
 	/* setup state variables used internally during selection process */
-	if (sampling.setup == 0 && (tp->delta.tv_sec || tp->delta.tv_nsec)) {
+	if (sampling.setup == 0 && !unsampled &&
+	    (tp->delta.tv_sec || tp->delta.tv_nsec)) {
 	    /* 'next' is a nanosecond precision time interval to step with */
 	    sampling.delta.tv_sec = tp->delta.tv_sec;
 	    sampling.delta.tv_nsec = tp->delta.tv_nsec;
@@ -1937,15 +2743,15 @@ series_values_store_to_node(seriesQueryBaton *baton, sds series,
 	if (tp->count && sampling.count++ >= tp->count)
 	    break;
 	
-	idx_sample = i;
-	np->value_set.series_values[idx_series].series_sample[idx_sample].num_instances = reply->elements/2;
-	if ((np->value_set.series_values[idx_series].series_sample[idx_sample].series_instance =
+	dest = &set[i];
+	dest->num_instances = reply->elements/2;
+	if ((dest->series_instance =
 		(pmSeriesValue *)calloc(reply->elements/2, sizeof(pmSeriesValue))) == NULL) {
 	    /* TODO: error report here */
 	    baton->error = -ENOMEM;
 	}
 	if ((sts = series_instance_store_to_node(baton, series, &sampling.value,
-				reply->elements, reply->element, np, idx_sample)) < 0) {
+				reply->elements, reply->element, dest)) < 0) {
 	    baton->error = sts;
 	    goto last_sample;
 	}
@@ -2166,19 +2972,26 @@ series_node_get_metric_name(
     sdsfree(cmd);
 }
 
+/*
+ * Each series of a data node is read separately, and the replies may
+ * complete out of order, so the series index is passed explicitly.
+ */
+typedef struct seriesNodeRead {
+    node_t			*np;
+    int				idx;
+    int				stat;		/* rollup statistic to read */
+} seriesNodeRead;
+
 /* 
  * Redis has returned replies about samples of series, save them into the corresponding node.
  */
 static void
-series_node_prepare_time_reply(
-	keyClusterAsyncContext *c, void *r, void *arg)
+series_node_prepare_time_values(node_t *np, int idx, respReply *reply)
 {
-    node_t			*np = (node_t *)arg;
     seriesQueryBaton		*baton = (seriesQueryBaton *)np->baton;
-    respReply			*reply = r;
+    series_sample_set_t		*set = &np->value_set.series_values[idx];
     sds				msg = NULL;
-    int				idx = np->value_set.num_series;
-    seriesGetSID		*sid = np->value_set.series_values[idx].sid;
+    seriesGetSID		*sid = set->sid;
 
     /* 
      * Got an reply contains series values which need to be saved into the corresponding 
@@ -2196,62 +3009,157 @@ series_node_prepare_time_reply(
 	baton->error = -EPROTO;
     } else {
 	/* calloc space to store series samples */
-	np->value_set.series_values[idx].num_samples = reply->elements;
-	if ((np->value_set.series_values[idx].series_sample =
+	set->num_samples = reply->elements;
+	if ((set->series_sample =
 	    (series_instance_set_t *)calloc(reply->elements, sizeof(series_instance_set_t))) == NULL) {
 	    /* TODO: error report here */
 	    baton->error = -ENOMEM;
 	}
 	/* Query for the desc of idx-th series */
-	np->value_set.series_values[idx].baton = baton;
-	series_node_get_desc(baton, sid->name, &np->value_set.series_values[idx]);
-	series_node_get_metric_name(baton, sid, &np->value_set.series_values[idx]);
+	set->baton = baton;
+	series_node_get_desc(baton, sid->name, set);
+	series_node_get_metric_name(baton, sid, set);
 	
-	series_values_store_to_node(baton, sid->name, reply->elements, reply->element, np);
+	series_values_store_to_node(baton, sid->name, reply->elements,
+			reply->element, set->series_sample, set->rollup);
 	np->value_set.num_series++;
     }
     series_query_end_phase(baton);
 }
 
 static void
-series_node_prepare_time(seriesQueryBaton *baton, series_set_t *query_series_set, node_t *np)
+series_node_prepare_time_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesNodeRead		*read = (seriesNodeRead *)arg;
+
+    series_node_prepare_time_values(read->np, read->idx, r);
+    free(read);
+}
+
+/*
+ * Sample counts of each rollup interval, used to weight the interval
+ * means when summing or averaging over time.
+ */
+static void
+series_node_prepare_weights_reply(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    series_sample_set_t		*set = (series_sample_set_t *)arg;
+    seriesQueryBaton		*baton = (seriesQueryBaton *)set->baton;
+    respReply			*reply = r;
+
+    seriesBatonCheckMagic(baton, MAGIC_QUERY, "series_node_prepare_weights_reply");
+
+    /* without weights each interval counts once, so not fatal */
+    if (reply && reply->type == RESP_REPLY_ARRAY && reply->elements > 0 &&
+	(set->weights = (series_instance_set_t *)calloc(reply->elements,
+			sizeof(series_instance_set_t))) != NULL) {
+	set->num_weights = reply->elements;
+	series_values_store_to_node(baton, set->sid->name, reply->elements,
+			reply->element, set->weights, 1);
+    }
+    series_query_end_phase(baton);
+}
+
+static void
+series_node_prepare_read(seriesQueryBaton *baton, int tier, void *arg)
+{
+    seriesNodeRead		*read = (seriesNodeRead *)arg;
+    node_t			*np = read->np;
+    series_sample_set_t		*set = &np->value_set.series_values[read->idx];
+    int				stat = read->stat;
+
+    if (tier < 0) {
+	/* chunk summaries answer statistics over every raw value */
+	if (chunkvalues && stat > ROLLUP_VALUE && np->time.count == 0 &&
+	    np->time.delta.tv_sec == 0 && np->time.delta.tv_nsec == 0) {
+	    series_chunk_read(baton, set->sid->name, &np->time, 0,
+				series_chunk_select_stat(stat), set,
+				series_node_prepare_time_reply, read);
+	    return;
+	}
+	stat = ROLLUP_VALUE;
+    } else if (stat != ROLLUP_VALUE) {
+	/* statistics of every interval in the window, not subsampled */
+	set->rollup = 1;
+	if (stat == ROLLUP_COUNT) {
+	    seriesBatonReference(baton, "series_node_prepare_weights");
+	    series_values_read(baton, set->sid->name, &np->time, 0, tier,
+			ROLLUP_COUNT, series_node_prepare_weights_reply, set);
+	    stat = ROLLUP_VALUE;
+	}
+    }
+    series_values_read(baton, set->sid->name, &np->time,
+			series_value_count_only(&np->time), tier, stat,
+			series_node_prepare_time_reply, read);
+}
+
+/*
+ * Rollup statistic that answers the function applied to a data node over
+ * time - the interval minima and maxima, or the interval means weighted
+ * by their sample counts - or -1 for functions needing raw values.
+ */
+static int
+series_rollup_stat(node_t *parent)
+{
+    if (parent == NULL)
+	return ROLLUP_VALUE;
+    switch (parent->type) {
+    case N_MAX:
+    case N_MAX_INST:
+	return ROLLUP_MAX;
+    case N_MIN:
+    case N_MIN_INST:
+	return ROLLUP_MIN;
+    case N_AVG:
+    case N_AVG_INST:
+    case N_SUM:
+    case N_SUM_INST:
+	return ROLLUP_COUNT;
+    case N_STDEV_INST:
+    case N_TOPK_INST:
+    case N_NTH_PERCENTILE_INST:
+	return -1;
+    default:
+	break;
+    }
+    return ROLLUP_VALUE;
+}
+
+static void
+series_node_prepare_time(seriesQueryBaton *baton, series_set_t *query_series_set,
+		node_t *np, node_t *parent)
 {
     timing_t			*tp = &np->time;
     unsigned char		*series = query_series_set->series;
+    seriesNodeRead		*read;
     seriesGetSID		*sid;
-    char			buffer[64], revbuf[64];
-    sds				start, end, key, cmd;
-    unsigned int		i, revlen = 0, reverse = 0;
+    char			buffer[64];
+    sds				start, end;
+    unsigned int		i, reverse;
     int				nseries = query_series_set->nseries;
+    int				stat, tier;
 
     /* if only 'count' is requested, work back from most recent value */
-    if ((reverse = series_value_count_only(tp)) != 0) {
-	revlen = pmsprintf(revbuf, sizeof(revbuf), "%u", reverse);
-	start = sdsnew("+");
-    } else {
-	start = sdsnew(timespec_stream_str(&tp->start, buffer, sizeof(buffer)));
-    }
-
-    if (pmDebugOptions.series)
-	fprintf(stderr, "START: %s\n", start);
-
-    if (reverse)
-	end = sdsnew("-");
-    else if (tp->end.tv_sec)
-	end = sdsnew(timespec_stream_str(&tp->end, buffer, sizeof(buffer)));
+    reverse = series_value_count_only(tp);
+    if ((stat = series_rollup_stat(parent)) < 0)
+	tier = -1;
     else
-	end = sdsnew("+");	/* "+" means "no end" - to the most recent */
+	tier = series_rollup_tier(tp, reverse);
 
-    if (pmDebugOptions.series)
+    if (pmDebugOptions.series) {
+	series_time_range(tp, reverse, &start, &end);
+	fprintf(stderr, "START: %s\n", start);
 	fprintf(stderr, "END: %s\n", end);
-    
+	sdsfree(start);
+	sdsfree(end);
+    }
 
     /* calloc nseries samples store space */
     if ((np->value_set.series_values =
     	(series_sample_set_t *)calloc(nseries, sizeof(series_sample_set_t))) == NULL) {
 	baton->error = -ENOMEM;
-	sdsfree(start);
-	sdsfree(end);
 	return;
     }
 
@@ -2260,40 +3168,27 @@ series_node_prepare_time(seriesQueryBaton *baton, series_set_t *query_series_set
      * pairs, with an associated timestamp).
      */
     for (i = 0; i < nseries; i++, series += SHA1SZ) {
+	if ((read = calloc(1, sizeof(seriesNodeRead))) == NULL) {
+	    baton->error = -ENOMEM;
+	    return;
+	}
 	sid = calloc(1, sizeof(seriesGetSID));
 	pmwebapi_hash_str(series, buffer, sizeof(buffer));
 
 	initSeriesGetSID(sid, buffer, 1, baton);
 	seriesBatonReference(baton, "series_prepare_time");
-
-	key = sdscatfmt(sdsempty(), "pcp:values:series:%S", sid->name);
-
-	/* X[REV]RANGE key t1 t2 [count N] */
-	if (reverse) {
-	    cmd = resp_command(6);
-	    cmd = resp_param_str(cmd, XREVRANGE, XREVRANGE_LEN);
-	} else {
-	    cmd = resp_command(4);
-	    cmd = resp_param_str(cmd, XRANGE, XRANGE_LEN);
-	}
-	cmd = resp_param_sds(cmd, key);
-	cmd = resp_param_sds(cmd, start);
-	cmd = resp_param_sds(cmd, end);
-	if (reverse) {
-	    cmd = resp_param_str(cmd, "COUNT", sizeof("COUNT")-1);
-	    cmd = resp_param_str(cmd, revbuf, revlen);
-	}
-	sdsfree(key);
 	np->value_set.series_values[i].baton = baton;
 	np->value_set.series_values[i].sid = sid;
-	/* Note: np->series_set.num_series is not equal to nseries in this function */
-	keySlotsRequest(baton->slots, cmd,
-				series_node_prepare_time_reply, np);
-	sdsfree(cmd);
-	
+	read->np = np;
+	read->idx = i;
+	read->stat = stat;
+
+	if (tier >= 0)
+	    series_rollup_check(baton, sid->name, tp, tier, stat,
+				series_node_prepare_read, read);
+	else
+	    series_node_prepare_read(baton, -1, read);
     }
-    sdsfree(start);
-    sdsfree(end);
 }
 
 /* 
@@ -2303,7 +3198,7 @@ series_node_prepare_time(seriesQueryBaton *baton, series_set_t *query_series_set
  * the top node of a subtree at the parser tree's bottom. 
  */
 static int
-series_process_func(seriesQueryBaton *baton, node_t *np, int level)
+series_process_func(seriesQueryBaton *baton, node_t *np, node_t *parent, int level)
 {
     int		sts, nelements = 0;
 
@@ -2313,13 +3208,13 @@ series_process_func(seriesQueryBaton *baton, node_t *np, int level)
     if ((nelements = np->result.nseries) != 0) {
 	np->value_set.num_series = 0;
 	np->baton = baton;
-	series_node_prepare_time(baton, &np->result, np);
+	series_node_prepare_time(baton, &np->result, np, parent);
 	return baton->error;
     }
 
-    if ((sts = series_process_func(baton, np->left, level+1)) < 0)
+    if ((sts = series_process_func(baton, np->left, np, level+1)) < 0)
 	return sts;
-    return series_process_func(baton, np->right, level+1);
+    return series_process_func(baton, np->right, np, level+1);
 }
 
 static sds
@@ -3746,6 +4641,31 @@ series_calculate_time_domain_statistical(node_t *np, void *arg)
     }
 }
 
+/*
+ * Check the samples are rollup interval means with a sample count for
+ * each instance of every interval, so they can be weighted by those.
+ */
+static int
+series_weighted(series_sample_set_t *set)
+{
+    int			i, j;
+
+    if (set->num_weights == 0 || set->num_weights != set->num_samples)
+	return 0;
+    for (i = 0; i < set->num_samples; i++) {
+	if (set->weights[i].num_instances != set->series_sample[i].num_instances)
+	    return 0;
+	for (j = 0; j < set->series_sample[i].num_instances; j++) {
+	    if (set->weights[i].series_instance[j].series == NULL ||
+		set->series_sample[i].series_instance[j].series == NULL ||
+		strcmp(set->weights[i].series_instance[j].series,
+		       set->series_sample[i].series_instance[j].series) != 0)
+		return 0;
+	}
+    }
+    return 1;
+}
+
 /*
  * calculate sum or avg series per-instance over time samples
  */
@@ -3755,7 +4675,8 @@ series_calculate_statistical(node_t *np, void *arg)
     seriesQueryBaton	*baton = (seriesQueryBaton *)arg;
     nodetype_t		func = np->type;
     unsigned int	n_series, n_samples, n_instances, i, j, k;
-    double		sum_data, data;
+    double		sum_data, sum_weights, data, weight;
+    int			weighted;
     char		sum_data_str[64];
     sds			msg = NULL;
 
@@ -3772,8 +4693,10 @@ series_calculate_statistical(node_t *np, void *arg)
 	    n_instances = np->left->value_set.series_values[i].series_sample[0].num_instances;
 	    np->value_set.series_values[i].series_sample[0].num_instances = n_instances;
 	    np->value_set.series_values[i].series_sample[0].series_instance = (pmSeriesValue *)calloc(n_instances, sizeof(pmSeriesValue));
+	    /* rollup interval means count once for each sample in them */
+	    weighted = series_weighted(&np->left->value_set.series_values[i]);
 	    for (k = 0; k < n_instances; k++) {
-		sum_data = 0.0;
+		sum_data = sum_weights = 0.0;
 		for (j = 0; j < n_samples; j++) {
 		    if (np->left->value_set.series_values[i].series_sample[j].num_instances != n_instances) {
 			if (pmDebugOptions.query && pmDebugOptions.desperate) {
@@ -3783,7 +4706,9 @@ series_calculate_statistical(node_t *np, void *arg)
 			continue;
 		    }
 		    data = strtod(np->left->value_set.series_values[i].series_sample[j].series_instance[k].data, NULL);
-		    sum_data += data;
+		    weight = weighted ? strtod(np->left->value_set.series_values[i].weights[j].series_instance[k].data, NULL) : 1.0;
+		    sum_data += data * weight;
+		    sum_weights += weight;
 		}
 		np->value_set.series_values[i].series_sample[0].series_instance[k].timestamp = 
 			sdsnew(np->left->value_set.series_values[i].series_sample[0].series_instance[k].timestamp);
@@ -3796,7 +4721,8 @@ series_calculate_statistical(node_t *np, void *arg)
 		    break;
 		case N_AVG:
 		case N_AVG_INST:
-		    pmsprintf(sum_data_str, sizeof(sum_data_str), "%le", sum_data / n_samples);
+		    pmsprintf(sum_data_str, sizeof(sum_data_str), "%le",
+				sum_data / (weighted ? sum_weights : n_samples));
 		    break;
 		default:
 		    /* .. TODO: standard deviation, variance, mode, median, etc */
@@ -5157,7 +6083,7 @@ series_query_funcs(void *arg)
 
     seriesBatonReference(baton, "series_query_funcs");
     /* Process function-type node */
-    series_process_func(baton, baton->query.root, 0);
+    series_process_func(baton, baton->query.root, NULL, 0);
     series_query_end_phase(baton);
 }
 
@@ -136,6 +136,11 @@ typedef struct series_sample_set {
     /* Number of series samples */
     int				num_samples;
     series_instance_set_t	*series_sample;
+    /* Samples are rollup statistics of every interval (not subsampled) */
+    unsigned int		rollup;
+    /* Sample counts of each rollup interval, weighting the samples */
+    int				num_weights;
+    series_instance_set_t	*weights;
 } series_sample_set_t;
 
 typedef struct series_value_set {
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#include <ctype.h>
+#include "pmapi.h"
+#include "libpcp.h"
+#include "rollup.h"
+
+unsigned int	rollupcount;	/* number of configured rollup tiers */
+__int64_t	rolluptiers[SERIES_MAXROLLUPS];	/* ascending, usec */
+
+static const char *rollupstats[] = { NULL, "min", "max", "count" };
+
+/*
+ * Parse a comma-separated list of tier intervals (pmParseInterval
+ * format, e.g. "1min, 1hour") into the ascending tiers array.
+ */
+int
+seriesRollupTiers(const char *string, char **errmsg)
+{
+    struct timespec	interval;
+    __int64_t		usec, swap;
+    unsigned int	i, j;
+    char		buffer[64], *p;
+    int			length, sts;
+
+    rollupcount = 0;
+    while (string && *string) {
+	while (isspace((int)*string) || *string == ',')
+	    string++;
+	if (*string == '\0')
+	    break;
+	for (length = 0; string[length] && string[length] != ','; length++)
+	    ;
+	if (length >= sizeof(buffer))
+	    return -E2BIG;
+	memcpy(buffer, string, length);
+	buffer[length] = '\0';
+	for (p = buffer + length - 1; p > buffer && isspace((int)*p); p--)
+	    *p = '\0';
+	string += length;
+
+	if ((sts = pmParseInterval(buffer, &interval, errmsg)) < 0)
+	    return sts;
+	usec = (__int64_t)interval.tv_sec * 1000000 + interval.tv_nsec / 1000;
+	if (usec < 1000000)	/* sub-second tiers are of no use here */
+	    return -EINVAL;
+	if (rollupcount == SERIES_MAXROLLUPS)
+	    return -E2BIG;
+	rolluptiers[rollupcount++] = usec;
+    }
+
+    for (i = 1; i < rollupcount; i++) {
+	for (j = i; j > 0 && rolluptiers[j-1] > rolluptiers[j]; j--) {
+	    swap = rolluptiers[j];
+	    rolluptiers[j] = rolluptiers[j-1];
+	    rolluptiers[j-1] = swap;
+	}
+    }
+    return rollupcount;
+}
+
+/*
+ * Select the coarsest tier no longer than a query sampling interval,
+ * returning its index or -1 to indicate the raw values must be used.
+ */
+int
+seriesRollupTier(struct timespec *delta)
+{
+    __int64_t		usec;
+    int			i;
+
+    usec = (__int64_t)delta->tv_sec * 1000000 + delta->tv_nsec / 1000;
+    for (i = rollupcount - 1; i >= 0; i--)
+	if (rolluptiers[i] <= usec)
+	    return i;
+    return -1;
+}
+
+/*
+ * Key of the stream holding one statistic of a tier for a series - the
+ * representative value (mean, or last value for counters), minimum,
+ * maximum or count of samples in each interval.
+ */
+sds
+seriesRollupKey(__int64_t interval, int stat, const char *series)
+{
+    if (rollupstats[stat] == NULL)
+	return sdscatfmt(sdsempty(), "pcp:rollup:%I:series:%s",
+			(long long)(interval / 1000000), series);
+    return sdscatfmt(sdsempty(), "pcp:rollup:%I:%s:series:%s",
+			(long long)(interval / 1000000), rollupstats[stat], series);
+}
+
+seriesRollup *
+seriesRollupCreate(void)
+{
+    seriesRollup	*rollups;
+    unsigned int	i;
+
+    if ((rollups = calloc(rollupcount, sizeof(seriesRollup))) == NULL)
+	return NULL;
+    for (i = 0; i < rollupcount; i++)
+	rollups[i].interval = rolluptiers[i];
+    return rollups;
+}
+
+void
+seriesRollupFree(seriesRollup *rollups)
+{
+    unsigned int	i;
+
+    for (i = 0; i < rollupcount; i++)
+	if (rollups[i].values)
+	    free(rollups[i].values);
+    free(rollups);
+}
+
+/*
+ * Returns non-zero if a sample at the given time (usec) falls beyond
+ * the current interval of a tier holding values - the caller writes
+ * out that interval and then resets the tier for the new sample.
+ */
+int
+seriesRollupDone(seriesRollup *rollup, __int64_t stamp)
+{
+    return rollup->nvalues > 0 && stamp >= rollup->bucket + rollup->interval;
+}
+
+void
+seriesRollupReset(seriesRollup *rollup, __int64_t stamp)
+{
+    rollup->bucket = stamp - (stamp % rollup->interval);
+    rollup->nvalues = 0;
+    rollup->next = 0;
+}
+
+int
+seriesRollupAdd(seriesRollup *rollup, int inst, const unsigned char *name,
+		double value)
+{
+    rollupValue		*rp;
+    unsigned int	i, size;
+
+    /* instances mostly arrive in the same order each sample */
+    for (i = rollup->next; i < rollup->nvalues; i++)
+	if (rollup->values[i].inst == inst)
+	    goto found;
+    for (i = 0; i < rollup->next && i < rollup->nvalues; i++)
+	if (rollup->values[i].inst == inst)
+	    goto found;
+
+    if (rollup->nvalues == rollup->maxvalues) {
+	size = rollup->maxvalues ? rollup->maxvalues * 2 : 4;
+	if ((rp = realloc(rollup->values, size * sizeof(rollupValue))) == NULL)
+	    return -ENOMEM;
+	rollup->values = rp;
+	rollup->maxvalues = size;
+    }
+    rollup->next = rollup->nvalues + 1;
+    rp = &rollup->values[rollup->nvalues++];
+    rp->inst = inst;
+    if ((rp->named = (name != NULL)) != 0)
+	memcpy(rp->name, name, sizeof(rp->name));
+    rp->count = 1;
+    rp->min = rp->max = rp->sum = rp->last = value;
+    return 0;
+
+found:
+    rollup->next = i + 1;
+    rp = &rollup->values[i];
+    rp->count++;
+    if (value < rp->min)
+	rp->min = value;
+    if (value > rp->max)
+	rp->max = value;
+    rp->sum += value;
+    rp->last = value;
+    return 0;
+}
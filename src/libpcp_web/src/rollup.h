@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#ifndef SERIES_ROLLUP_H
+#define SERIES_ROLLUP_H
+
+#include "pmapi.h"
+#include "sds.h"
+
+/*
+ * Downsampled rollup tiers of numeric series values, accumulated while
+ * loading and written as one stream entry per tier interval.  Queries
+ * with a sampling interval at least as long as a tier read its (much
+ * shorter) streams in place of the raw values.
+ */
+#define SERIES_MAXROLLUPS	8
+
+/* statistics of each tier interval, each kept in a separate stream */
+enum { ROLLUP_VALUE, ROLLUP_MIN, ROLLUP_MAX, ROLLUP_COUNT, NUM_ROLLUP_STATS };
+
+typedef struct rollupValue {
+    int			inst;		/* internal instance identifier */
+    unsigned int	named : 1;	/* instance name hash is present */
+    unsigned int	count : 31;	/* values accumulated in interval */
+    unsigned char	name[20];	/* instance name hash (SHA1) */
+    double		min;
+    double		max;
+    double		sum;
+    double		last;
+} rollupValue;
+
+typedef struct seriesRollup {
+    __int64_t		interval;	/* tier length (usec) */
+    __int64_t		bucket;		/* start of current interval */
+    unsigned int	nvalues;	/* instances in current interval */
+    unsigned int	maxvalues;
+    unsigned int	next;		/* expected index of next instance */
+    rollupValue		*values;
+} seriesRollup;
+
+extern unsigned int rollupcount;
+extern __int64_t rolluptiers[SERIES_MAXROLLUPS];
+
+extern int seriesRollupTiers(const char *, char **);
+extern int seriesRollupTier(struct timespec *);
+extern sds seriesRollupKey(__int64_t, int, const char *);
+
+extern seriesRollup *seriesRollupCreate(void);
+extern void seriesRollupFree(seriesRollup *);
+extern int seriesRollupDone(seriesRollup *, __int64_t);
+extern void seriesRollupReset(seriesRollup *, __int64_t);
+extern int seriesRollupAdd(seriesRollup *, int, const unsigned char *, double);
+
+#endif	/* SERIES_ROLLUP_H */
@@ -12,6 +12,7 @@
  * License for more details.
  */
 #include <assert.h>
+#include <math.h>
 #include "pmapi.h"
 #include "pmda.h"
 #include "search.h"
@@ -19,6 +20,8 @@
 #include "discover.h"
 #include "util.h"
 #include "sha1.h"
+#include "chunks.h"
+#include "rollup.h"
 
 #define STRINGIFY(s)	#s
 #define TO_STRING(s)	STRINGIFY(s)
@@ -26,11 +29,15 @@
 #define OLDEST_VERSION	5
 
 extern sds		cursorcount;
+extern int		chunkvalues;
+static __int64_t	chunkspan = 3600 * 1000000LL;	/* usec */
 static sds		maxstreamlen;
 static sds		streamexpire;
+static sds		rollupexpire;
 static sds		DEFAULT_CURSORCOUNT;
 static sds		DEFAULT_MAXSTREAMLEN;
 static sds		DEFAULT_STREAMEXPIRE;
+static sds		DEFAULT_ROLLUPEXPIRE;
 
 static void
 initKeySlotsBaton(keySlotsBaton *baton,
@@ -1154,6 +1161,520 @@ keys_series_stream(keySlots *slots, sds stamp, metric_t *metric,
     sdsfree(cmd);
 }
 
+static void
+keys_series_chunk_callback(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesLoadBaton	*baton = (seriesLoadBaton *)arg;
+    respReply		*reply = r;
+
+    seriesBatonCheckMagic(baton, MAGIC_LOAD, "keys_series_chunk_callback");
+    checkIntegerReply(baton->info, baton->userdata, c, reply,
+			"%s: %s", APPEND, "appending series chunk values");
+    doneSeriesLoadBaton(baton, "keys_series_chunk_callback");
+}
+
+static void
+keys_series_chunks_callback(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesLoadBaton	*baton = (seriesLoadBaton *)arg;
+    respReply		*reply = r;
+
+    seriesBatonCheckMagic(baton, MAGIC_LOAD, "keys_series_chunks_callback");
+    checkIntegerReply(baton->info, baton->userdata, c, reply,
+			"%s: %s", ZADD, "indexing series chunk windows");
+    doneSeriesLoadBaton(baton, "keys_series_chunks_callback");
+}
+
+static void
+keys_series_chunksum_callback(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesLoadBaton	*baton = (seriesLoadBaton *)arg;
+    respReply		*reply = r;
+
+    seriesBatonCheckMagic(baton, MAGIC_LOAD, "keys_series_chunksum_callback");
+    checkIntegerReply(baton->info, baton->userdata, c, reply,
+			"%s: %s", HSET, "summarising series chunk values");
+    doneSeriesLoadBaton(baton, "keys_series_chunksum_callback");
+}
+
+static void
+keys_series_expire(keySlots *slots, sds key, sds timer, void *arg)
+{
+    sds				cmd;
+
+    seriesBatonReference(arg, "keys_series_expire");
+    cmd = resp_command(3);	/* EXPIRE key timer */
+    cmd = resp_param_str(cmd, EXPIRE, EXPIRE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_sds(cmd, timer);
+    keySlotsRequest(slots, cmd, keys_series_timer_callback, arg);
+    sdsfree(cmd);
+}
+
+/*
+ * Append one encoded sample (if any) to the chunk of a series covering
+ * its time window, creating the window index entry for a new chunk and
+ * saving the summary of the chunk it replaces (if any).  Each chunk is
+ * named by its window start and span ("window:span", in usec) in its
+ * key, its index entry (scored by the window start) and its summary,
+ * so queries need not know the span configured for the loader.
+ */
+static void
+keys_series_chunk(keySlots *slots, __int64_t start, __int64_t span,
+		unsigned int first, sds record, __int64_t sealed, sds summary,
+		const char *hash, void *arg)
+{
+    sds				cmd, key;
+    char			score[32], window[64];
+    int				length, scorelen;
+
+    length = pmsprintf(window, sizeof(window), "%lld:%lld",
+			(long long)start, (long long)span);
+    if (record) {
+	seriesBatonReference(arg, "keys_series_chunk");
+	key = sdscatfmt(sdsempty(), "pcp:chunk:series:%s:%s", hash, window);
+	cmd = resp_command(3);	/* APPEND key record */
+	cmd = resp_param_str(cmd, APPEND, APPEND_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_sds(cmd, record);
+	keySlotsRequest(slots, cmd, keys_series_chunk_callback, arg);
+	sdsfree(cmd);
+	keys_series_expire(slots, key, streamexpire, arg);
+	sdsfree(key);
+    }
+
+    if (record && first) {	/* first record in this chunk window */
+	seriesBatonReference(arg, "keys_series_chunk");
+	key = sdscatfmt(sdsempty(), "pcp:chunks:series:%s", hash);
+	scorelen = pmsprintf(score, sizeof(score), "%lld", (long long)start);
+	cmd = resp_command(4);	/* ZADD key score member */
+	cmd = resp_param_str(cmd, ZADD, ZADD_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_str(cmd, score, scorelen);
+	cmd = resp_param_str(cmd, window, length);
+	keySlotsRequest(slots, cmd, keys_series_chunks_callback, arg);
+	sdsfree(cmd);
+	keys_series_expire(slots, key, streamexpire, arg);
+	sdsfree(key);
+    }
+
+    if (summary) {
+	seriesBatonReference(arg, "keys_series_chunk");
+	length = pmsprintf(window, sizeof(window), "%lld:%lld",
+			(long long)sealed, (long long)span);
+	key = sdscatfmt(sdsempty(), "pcp:chunksum:series:%s", hash);
+	cmd = resp_command(4);	/* HSET key window summary */
+	cmd = resp_param_str(cmd, HSET, HSET_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_str(cmd, window, length);
+	cmd = resp_param_sds(cmd, summary);
+	keySlotsRequest(slots, cmd, keys_series_chunksum_callback, arg);
+	sdsfree(cmd);
+	keys_series_expire(slots, key, streamexpire, arg);
+	sdsfree(key);
+    }
+}
+
+/*
+ * Write an encoded sample to the chunk of each series identifier given.
+ * Windows before the last one stored when the loader started are
+ * complete, so are skipped (as stream entries at or before the last
+ * stored entry are rejected); the summary of that last window would
+ * only cover samples since the restart, so it is skipped too.
+ */
+static void
+keys_series_chunk_write(seriesLoadBaton *baton, seriesChunk *chunk,
+		char (*hashes)[42], unsigned int numhashes, __int64_t window,
+		unsigned int first, sds record, __int64_t sealed, sds summary)
+{
+    unsigned int		i;
+
+    if (window < chunk->resume)
+	record = NULL;
+    if (sealed <= chunk->resume)
+	summary = NULL;
+    if (record == NULL && summary == NULL)
+	return;
+
+    for (i = 0; i < numhashes; i++)
+	keys_series_chunk(baton->slots, window, chunk->span, first, record,
+			sealed, summary, hashes[i], baton);
+}
+
+/*
+ * The metric can be freed before the lookup completes, so the lookup
+ * holds a reference to the chunk and a copy of the series identifiers.
+ */
+typedef struct seriesChunkResume {
+    seriesLoadBaton		*baton;
+    seriesChunk			*chunk;
+    unsigned int		numhashes;
+    char			(*hashes)[42];
+} seriesChunkResume;
+
+static void
+keys_series_chunk_resume_callback(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesChunkResume		*resume = (seriesChunkResume *)arg;
+    seriesLoadBaton		*baton = resume->baton;
+    seriesChunk			*chunk = resume->chunk;
+    chunkQueued			*queued;
+    respReply			*reply = r;
+    unsigned int		i;
+
+    seriesBatonCheckMagic(baton, MAGIC_LOAD, "keys_series_chunk_resume_callback");
+    if (checkArrayReply(baton->info, baton->userdata, c, reply,
+			"%s: %s", ZREVRANGEBYSCORE, "finding last series chunk") == 0 &&
+	reply->elements > 0 && reply->element[0]->type == RESP_REPLY_STRING)
+	chunk->resume = strtoll(reply->element[0]->str, NULL, 10);
+    chunk->lookup = 0;
+
+    for (i = 0; i < chunk->nqueued; i++) {
+	queued = &chunk->queued[i];
+	keys_series_chunk_write(baton, chunk, resume->hashes, resume->numhashes,
+			queued->window, queued->first, queued->record,
+			queued->sealed, queued->summary);
+    }
+    seriesChunkDequeue(chunk);
+    seriesChunkFree(chunk);
+    free(resume->hashes);
+    free(resume);
+    doneSeriesLoadBaton(baton, "keys_series_chunk_resume_callback");
+}
+
+/*
+ * Find the last chunk window stored for a series before the loader
+ * started (all its series identifiers share the same chunks).
+ */
+static void
+keys_series_chunk_resume(seriesLoadBaton *baton, metric_t *metric)
+{
+    seriesChunkResume		*resume;
+    unsigned int		i;
+    sds				cmd, key;
+
+    if (metric->numnames == 0 ||
+	(resume = calloc(1, sizeof(seriesChunkResume))) == NULL)
+	return;
+    if ((resume->hashes = calloc(metric->numnames, sizeof(*resume->hashes))) == NULL) {
+	free(resume);
+	return;
+    }
+    for (i = 0; i < metric->numnames; i++)
+	pmwebapi_hash_str(metric->names[i].hash, resume->hashes[i],
+			sizeof(resume->hashes[i]));
+    resume->numhashes = metric->numnames;
+    resume->baton = baton;
+    resume->chunk = metric->chunk;
+    seriesChunkReference(resume->chunk);
+    metric->chunk->lookup = 1;
+
+    seriesBatonReference(baton, "keys_series_chunk_resume");
+    key = sdscatfmt(sdsempty(), "pcp:chunks:series:%s", resume->hashes[0]);
+    cmd = resp_command(7);	/* ZREVRANGEBYSCORE key +inf -inf LIMIT 0 1 */
+    cmd = resp_param_str(cmd, ZREVRANGEBYSCORE, ZREVRANGEBYSCORE_LEN);
+    cmd = resp_param_sds(cmd, key);
+    cmd = resp_param_str(cmd, "+inf", 4);
+    cmd = resp_param_str(cmd, "-inf", 4);
+    cmd = resp_param_str(cmd, "LIMIT", sizeof("LIMIT")-1);
+    cmd = resp_param_str(cmd, "0", 1);
+    cmd = resp_param_str(cmd, "1", 1);
+    sdsfree(key);
+    keySlotsRequest(baton->slots, cmd, keys_series_chunk_resume_callback, resume);
+    sdsfree(cmd);
+}
+
+/*
+ * Encode a sample once into the compressed chunk form, then append
+ * it to the chunk of every series identifier for this metric.
+ */
+static void
+keys_series_chunked(sds stamp, metric_t *metric, void *arg)
+{
+    seriesLoadBaton		*baton = (seriesLoadBaton *)arg;
+    seriesChunk			*chunk;
+    instance_t			*inst;
+    dictEntry			*entry;
+    value_t			*v;
+    __int64_t			when, sealed = 0;
+    char			hashbuf[42];
+    sds				msg, record, summary = NULL;
+    int				i, sts, updated = 0;
+
+    if ((chunk = metric->chunk) == NULL) {
+	if ((chunk = seriesChunkCreate(metric->desc.type, chunkspan)) == NULL) {
+	    msg = NULL;
+	    infofmt(msg, "OOM creating series chunk");
+	    batoninfo(baton, PMLOG_ERROR, msg);
+	    return;
+	}
+	metric->chunk = chunk;
+	keys_series_chunk_resume(baton, metric);
+    }
+
+    when = seriesChunkStamp(stamp);
+    if ((sts = seriesChunkNext(chunk, when)) < 0) {
+	/* as for streams, only show duplicates in desperate mode */
+	if (UNLIKELY(pmDebugOptions.desperate)) {
+	    msg = NULL;
+	    infofmt(msg, "duplicate or early chunk insert at time %s", stamp);
+	    batoninfo(baton, PMLOG_DEBUG, msg);
+	}
+	return;
+    }
+    if (sts > 0) {
+	sealed = chunk->window;
+	summary = seriesChunkSummary(chunk);
+    }
+
+    record = sdsempty();
+    if (metric->error < 0) {
+	record = seriesChunkError(chunk, record, when, metric->error);
+    } else if (metric->desc.indom == PM_INDOM_NULL || metric->u.vlist == NULL) {
+	record = seriesChunkValues(chunk, record, when);
+	record = seriesChunkValue(chunk, record, PM_IN_NULL, NULL, &metric->u.atom);
+	record = seriesChunkEnd(chunk, record);
+    } else {
+	for (i = 0; i < metric->u.vlist->listcount; i++) {
+	    v = &metric->u.vlist->value[i];
+	    if (v->updated == 0)
+		continue;
+	    if ((entry = dictFind(metric->indom->insts, &v->inst)) == NULL)
+		continue;
+	    inst = (instance_t *)dictGetVal(entry);
+	    if (updated++ == 0)
+		record = seriesChunkValues(chunk, record, when);
+	    record = seriesChunkValue(chunk, record, v->inst,
+				inst->name.hash, &v->atom);
+	}
+	if (updated)
+	    record = seriesChunkEnd(chunk, record);
+	else
+	    record = seriesChunkEmpty(chunk, record, when);
+    }
+
+    if (chunk->lookup) {
+	if (seriesChunkQueue(chunk, chunk->window, chunk->count == 1,
+				record, sealed, summary) < 0) {
+	    msg = NULL;
+	    infofmt(msg, "OOM queueing series chunk");
+	    batoninfo(baton, PMLOG_ERROR, msg);
+	    sdsfree(summary);
+	    sdsfree(record);
+	}
+	return;
+    }
+    for (i = 0; i < metric->numnames; i++) {
+	pmwebapi_hash_str(metric->names[i].hash, hashbuf, sizeof(hashbuf));
+	keys_series_chunk_write(baton, chunk, &hashbuf, 1, chunk->window,
+			chunk->count == 1, record, sealed, summary);
+    }
+    sdsfree(summary);
+    sdsfree(record);
+}
+
+static void
+keys_series_rollup_callback(
+	keyClusterAsyncContext *c, void *r, void *arg)
+{
+    seriesLoadBaton	*baton = (seriesLoadBaton *)arg;
+    respReply		*reply = r;
+    sds			msg;
+
+    seriesBatonCheckMagic(baton, MAGIC_LOAD, "keys_series_rollup_callback");
+    /* as for streams, repeated intervals are expected after a restart */
+    if (reply && reply->type == RESP_REPLY_ERROR &&
+	!testReplyError(reply, RESP_ESTREAMXADD)) {
+	msg = NULL;
+	infofmt(msg, "%s: %s - %s", XADD, "adding series rollup interval",
+		reply->str);
+	batoninfo(baton, PMLOG_RESPONSE, msg);
+    }
+    doneSeriesLoadBaton(baton, "keys_series_rollup_callback");
+}
+
+static sds
+series_rollup_value(int type, double value)
+{
+    switch (type) {
+    case PM_TYPE_32:
+	return sdscatfmt(sdsempty(), "%i", (int)rint(value));
+    case PM_TYPE_U32:
+	return sdscatfmt(sdsempty(), "%u", (unsigned int)rint(value));
+    case PM_TYPE_64:
+	return sdscatfmt(sdsempty(), "%I", (long long)llrint(value));
+    case PM_TYPE_U64:
+	return sdscatfmt(sdsempty(), "%U", (unsigned long long)llrint(value));
+    default:
+	break;
+    }
+    return sdscatprintf(sdsempty(), "%e", value);
+}
+
+/*
+ * Write one completed interval of a rollup tier as an entry in each of
+ * the tier streams - the representative value (the mean, or the last
+ * value for counters so that rates remain correct), minimum, maximum
+ * and count of samples - trimming entries older than the expiry time.
+ */
+static void
+keys_series_rollup(keySlots *slots, metric_t *metric, seriesRollup *rollup,
+		const char *hash, void *arg)
+{
+    rollupValue			*rp;
+    long long			expire = strtoll(rollupexpire, NULL, 10);
+    unsigned int		i, s, count;
+    double			value = 0;
+    char			stamp[32], minid[32];
+    int				stamplen, minlen, type;
+    sds				cmd, key, name, stream;
+
+    stamplen = pmsprintf(stamp, sizeof(stamp), "%lld-0",
+			(long long)(rollup->bucket / 1000));
+    minlen = pmsprintf(minid, sizeof(minid), "%lld",
+			(long long)(rollup->bucket / 1000 - expire * 1000));
+    name = sdsempty();
+
+    for (s = 0; s < NUM_ROLLUP_STATS; s++) {
+	key = seriesRollupKey(rollup->interval, s, hash);
+	type = (s == ROLLUP_COUNT) ? PM_TYPE_U32 : metric->desc.type;
+	stream = sdsempty();
+	count = 6;	/* XADD key MINID ~ id stamp */
+	for (i = 0; i < rollup->nvalues; i++) {
+	    rp = &rollup->values[i];
+	    switch (s) {
+	    case ROLLUP_VALUE:
+		value = (metric->desc.sem == PM_SEM_COUNTER) ?
+			rp->last : rp->sum / rp->count;
+		break;
+	    case ROLLUP_MIN:
+		value = rp->min;
+		break;
+	    case ROLLUP_MAX:
+		value = rp->max;
+		break;
+	    case ROLLUP_COUNT:
+		value = rp->count;
+		break;
+	    }
+	    if (rp->named)
+		name = sdscpylen(name, (const char *)rp->name, sizeof(rp->name));
+	    else
+		sdsclear(name);
+	    stream = series_stream_append(stream, name,
+				series_rollup_value(type, value));
+	    count += 2;
+	}
+
+	seriesBatonReference(arg, "keys_series_rollup");
+	cmd = resp_command(count);
+	cmd = resp_param_str(cmd, XADD, XADD_LEN);
+	cmd = resp_param_sds(cmd, key);
+	cmd = resp_param_str(cmd, "MINID", sizeof("MINID")-1);
+	cmd = resp_param_str(cmd, "~", 1);
+	cmd = resp_param_str(cmd, minid, minlen);
+	cmd = resp_param_str(cmd, stamp, stamplen);
+	cmd = resp_param_raw(cmd, stream);
+	sdsfree(stream);
+	keySlotsRequest(slots, cmd, keys_series_rollup_callback, arg);
+	sdsfree(cmd);
+	keys_series_expire(slots, key, rollupexpire, arg);
+	sdsfree(key);
+    }
+    sdsfree(name);
+}
+
+static double
+series_rollup_atom(int type, pmAtomValue *atom)
+{
+    switch (type) {
+    case PM_TYPE_32:
+	return atom->l;
+    case PM_TYPE_U32:
+	return atom->ul;
+    case PM_TYPE_64:
+	return atom->ll;
+    case PM_TYPE_U64:
+	return atom->ull;
+    case PM_TYPE_FLOAT:
+	return atom->f;
+    case PM_TYPE_DOUBLE:
+	return atom->d;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*
+ * Accumulate a sample into each rollup tier of a numeric metric,
+ * first writing out any tier interval that this sample completes.
+ */
+static void
+keys_series_rollups(sds stamp, metric_t *metric, void *arg)
+{
+    seriesLoadBaton		*baton = (seriesLoadBaton *)arg;
+    seriesRollup		*rollup;
+    instance_t			*inst;
+    dictEntry			*entry;
+    value_t			*v;
+    __int64_t			when;
+    unsigned int		t;
+    char			hashbuf[42];
+    sds				msg;
+    int				i, type = metric->desc.type;
+
+    if (type == PM_TYPE_STRING || type == PM_TYPE_AGGREGATE ||
+	type == PM_TYPE_AGGREGATE_STATIC || type == PM_TYPE_EVENT ||
+	type == PM_TYPE_HIGHRES_EVENT)
+	return;
+
+    if (metric->rollups == NULL &&
+	(metric->rollups = seriesRollupCreate()) == NULL) {
+	msg = NULL;
+	infofmt(msg, "OOM creating series rollups");
+	batoninfo(baton, PMLOG_ERROR, msg);
+	return;
+    }
+
+    when = seriesChunkStamp(stamp);
+    for (t = 0; t < rollupcount; t++) {
+	rollup = &metric->rollups[t];
+	if (when < rollup->bucket)	/* early sample, as for streams */
+	    continue;
+	if (seriesRollupDone(rollup, when)) {
+	    for (i = 0; i < metric->numnames; i++) {
+		pmwebapi_hash_str(metric->names[i].hash, hashbuf, sizeof(hashbuf));
+		keys_series_rollup(baton->slots, metric, rollup, hashbuf, arg);
+	    }
+	    seriesRollupReset(rollup, when);
+	} else if (rollup->nvalues == 0) {
+	    seriesRollupReset(rollup, when);
+	}
+	if (metric->error < 0)
+	    continue;
+	if (metric->desc.indom == PM_INDOM_NULL || metric->u.vlist == NULL) {
+	    seriesRollupAdd(rollup, PM_IN_NULL, NULL,
+			series_rollup_atom(type, &metric->u.atom));
+	    continue;
+	}
+	for (i = 0; i < metric->u.vlist->listcount; i++) {
+	    v = &metric->u.vlist->value[i];
+	    if (v->updated == 0)
+		continue;
+	    if ((entry = dictFind(metric->indom->insts, &v->inst)) == NULL)
+		continue;
+	    inst = (instance_t *)dictGetVal(entry);
+	    seriesRollupAdd(rollup, v->inst, inst->name.hash,
+			series_rollup_atom(type, &v->atom));
+	}
+    }
+}
+
 static void
 keys_series_streamed(sds stamp, metric_t *metric, void *arg)
 {
@@ -1162,6 +1683,14 @@ keys_series_streamed(sds stamp, metric_t *metric, void *arg)
     char			hashbuf[42];
     int				i;
 
+    if (rollupcount)
+	keys_series_rollups(stamp, metric, arg);
+
+    if (chunkvalues) {
+	keys_series_chunked(stamp, metric, arg);
+	return;
+    }
+
     for (i = 0; i < metric->numnames; i++) {
 	pmwebapi_hash_str(metric->names[i].hash, hashbuf, sizeof(hashbuf));
 	keys_series_stream(slots, stamp, metric, hashbuf, arg);
@@ -1488,7 +2017,10 @@ keysSchemaLoad(keySlots *slots, keySlotsFlags flags,
     /* Register the pmsearch schema with RediSearch if needed */
     if (flags & SLOTS_SEARCH) {
 	/* if we got a route update means we are in cluster mode */
-	if (slots->acc && slots->acc->cc.route_version > 0) {
+	if (slots->store) {
+	    pmNotifyErr(LOG_INFO, "disabling search module "
+			"because it is not supported by the embedded store\n");
+	} else if (slots->acc && slots->acc->cc.route_version > 0) {
 	    pmNotifyErr(LOG_INFO, "disabling search module "
 			"because it does not support cluster mode\n");
 	} else {
@@ -1591,6 +2123,33 @@ keysSeriesInit(struct dict *config)
 	else	/* default value: 1 day (without changes) */
 	    streamexpire = DEFAULT_STREAMEXPIRE = sdsnew("86400");
     }
+
+    if ((option = pmIniFileLookup(config, "pmseries", "stream.chunks")))
+	chunkvalues = (strcmp(option, "true") == 0);
+
+    if ((option = pmIniFileLookup(config, "pmseries", "stream.chunkspan")) &&
+	strtoll(option, NULL, 10) > 0)
+	chunkspan = strtoll(option, NULL, 10) * 1000000;
+
+    if ((option = pmIniFileLookup(config, "pmseries", "stream.rollups"))) {
+	char	*error = NULL;
+
+	if (seriesRollupTiers(option, &error) < 0) {
+	    pmNotifyErr(LOG_WARNING, "ignoring [pmseries] stream.rollups "
+			"\"%s\"%s%s\n", option, error ? ": " : "",
+			error ? error : "");
+	    rollupcount = 0;
+	}
+	if (error)
+	    free(error);
+    }
+
+    if (!rollupexpire) {
+	if ((option = pmIniFileLookup(config, "pmseries", "stream.rollupexpire")))
+	    rollupexpire = option;
+	else	/* default value: 30 days (without changes) */
+	    rollupexpire = DEFAULT_ROLLUPEXPIRE = sdsnew("2592000");
+    }
 }
 
 static void
@@ -1608,6 +2167,10 @@ keysSeriesClose(void)
 	sdsfree(DEFAULT_STREAMEXPIRE);
 	DEFAULT_STREAMEXPIRE = NULL;
     }
+    if (DEFAULT_ROLLUPEXPIRE) {
+	sdsfree(DEFAULT_ROLLUPEXPIRE);
+	DEFAULT_ROLLUPEXPIRE = NULL;
+    }
 }
 
 void
@@ -24,6 +24,8 @@
 #include "slots.h"
 #include "query.h"
 
+#define APPEND		"APPEND"
+#define APPEND_LEN	(sizeof(APPEND)-1)
 #define COMMAND		"COMMAND"
 #define COMMAND_LEN	(sizeof(COMMAND)-1)
 #define CLUSTER		"CLUSTER"
@@ -70,6 +72,12 @@
 #define XRANGE_LEN	(sizeof(XRANGE)-1)
 #define XREVRANGE	"XREVRANGE"
 #define XREVRANGE_LEN	(sizeof(XREVRANGE)-1)
+#define ZADD		"ZADD"
+#define ZADD_LEN	(sizeof(ZADD)-1)
+#define ZRANGEBYSCORE	"ZRANGEBYSCORE"
+#define ZRANGEBYSCORE_LEN	(sizeof(ZRANGEBYSCORE)-1)
+#define ZREVRANGEBYSCORE	"ZREVRANGEBYSCORE"
+#define ZREVRANGEBYSCORE_LEN	(sizeof(ZREVRANGEBYSCORE)-1)
 
 /* create a RESP command (e.g. XADD, SMEMBER) */
 static inline sds
@@ -14,6 +14,7 @@
 #include "schema.h"
 #include "batons.h"
 #include "slots.h"
+#include "store.h"
 #include "util.h"
 #include <ctype.h>
 #include <search.h>
@@ -164,6 +165,7 @@ keySlotsInit(dict *config, void *events)
     sds			def_servers = NULL;
     sds			username = NULL;
     sds			password = NULL;
+    sds			embedded, msg = NULL;
 
     if ((context = (keySlotsContext *)calloc(1, sizeof(keySlotsContext))) == NULL) {
 	pmNotifyErr(LOG_ERR, "%s: failed to allocate keySlotsContext\n",
@@ -190,6 +192,22 @@ keySlotsInit(dict *config, void *events)
 	return NULL;
     }
 
+    /* an in-process store replaces the key server connection */
+    embedded = pmIniFileLookup(config, "keys", "embedded");
+    if (embedded && strcmp(embedded, "true") == 0) {
+	context->slots.store = keyStoreCreate(events,
+			pmIniFileLookup(config, "keys", "embedded.path"), &msg);
+	if (context->slots.store == NULL) {
+	    pmNotifyErr(LOG_ERR, "%s: embedded key store: %s\n",
+			"keySlotsInit", msg);
+	    sdsfree(msg);
+	    dictRelease(context->slots.keymap->dict);
+	    free(context->slots.keymap);
+	    free(context);
+	    return NULL;
+	}
+    }
+
     servers = pmIniFileLookup(config, "keys", "servers");
     if (servers == NULL)
 	servers = pmIniFileLookup(config, "redis", "servers"); // back-compat
@@ -264,6 +282,16 @@ keySlotsReconnect(keySlots *slots, keySlotsFlags flags,
     slots->state = SLOTS_CONNECTING;
     slots->conn_seq++;
 
+    if (slots->store) {
+	if (pmDebugOptions.series)
+	    fprintf(stderr, "Using embedded key store (%lu keys)\n",
+			keyStoreKeys(slots->store));
+	slots->cluster = 0;
+	slots->state = SLOTS_CONNECTED;
+	keysSchemaLoad(slots, flags, info, done, userdata, events, arg);
+	return;
+    }
+
     /* Free old async context if this is a reconnect */
     if (slots->acc != NULL) {
 	/* reset key server context in case of reconnect */
@@ -411,6 +439,7 @@ keySlotsConnect(dict *config, keySlotsFlags flags,
 void
 keySlotsFree(keySlots *slots)
 {
+    keyStoreFree(slots->store);
     keyClusterAsyncDisconnect(slots->acc);
     keyClusterAsyncFree(slots->acc);
     if (slots->keymap) {
@@ -446,6 +475,7 @@ keySlotsContextFree(keySlotsContext *context)
      * callbacks from issuing new requests during shutdown */
     context->slots.state = SLOTS_DISCONNECTED;
 
+    keyStoreFree(context->slots.store);
     keyClusterAsyncDisconnect(context->slots.acc);
     keyClusterAsyncFree(context->slots.acc);
     if (context->slots.keymap) {
@@ -614,7 +644,7 @@ keySlotsRequest(keySlots *slots, const sds cmd,
     if (UNLIKELY(slots->state != SLOTS_CONNECTED && slots->state != SLOTS_READY))
 	return -ENOTCONN;
 
-    if (!slots->cluster)
+    if (!slots->cluster || slots->store)
 	return keySlotsRequestFirstNode(slots, cmd, callback, arg);
 
     if (UNLIKELY(pmDebugOptions.desperate))
@@ -645,6 +675,46 @@ keySlotsRequest(keySlots *slots, const sds cmd,
     return RESP_OK;
 }
 
+/*
+ * Submit a request to the embedded key store, with the same accounting
+ * and reply callback wrapping as for a key server node.
+ */
+static int
+keySlotsRequestStore(keySlots *slots, const sds cmd,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    keySlotsReplyData	*srd;
+    uint64_t		size;
+    int			sts;
+
+    if (UNLIKELY(pmDebugOptions.desperate))
+	fprintf(stderr, "%s: executing raw key server command:\n%s",
+			"keySlotsRequestStore", cmd);
+
+    size = sdslen(cmd);
+    if ((srd = keySlotsReplyDataAlloc(slots, size, callback, arg)) == NULL) {
+	mmv_inc(slots->map, slots->metrics[SLOT_REQUESTS_ERROR]);
+	pmNotifyErr(LOG_ERR, "%s: failed to allocate reply data (%llu bytes)",
+			"keySlotsRequestStore", (unsigned long long)size);
+	return -ENOMEM;
+    }
+    if ((sts = keyStoreRequest(slots->store, cmd, size,
+			keySlotsReplyCallback, srd)) < 0) {
+	mmv_inc(slots->map, slots->metrics[SLOT_REQUESTS_ERROR]);
+	pmNotifyErr(LOG_ERR, "%s: %s (%s)\n",
+		"keySlotsRequestStore", pmErrStr(sts), cmd);
+	keySlotsReplyDataFree(srd);
+	return sts;
+    }
+
+    mmv_add(slots->map, slots->metrics[SLOT_REQUESTS_INFLIGHT_BYTES], &size);
+    mmv_add(slots->map, slots->metrics[SLOT_REQUESTS_TOTAL_BYTES], &size);
+    mmv_inc(slots->map, slots->metrics[SLOT_REQUESTS_INFLIGHT_TOTAL]);
+    mmv_inc(slots->map, slots->metrics[SLOT_REQUESTS_TOTAL]);
+
+    return RESP_OK;
+}
+
 int
 keySlotsRequestFirstNode(keySlots *slots, const sds cmd,
 		keyClusterCallbackFn *callback, void *arg)
@@ -662,6 +732,9 @@ keySlotsRequestFirstNode(keySlots *slots, const sds cmd,
     if (UNLIKELY(slots->state != SLOTS_CONNECTED && slots->state != SLOTS_READY))
 	return -ENOTCONN;
 
+    if (slots->store)
+	return keySlotsRequestStore(slots, cmd, callback, arg);
+
     {
 	dictIterator iter;
 	dictInitIterator(&iter, slots->acc->cc.nodes);
@@ -766,8 +839,8 @@ keySlotsProxyConnect(keySlots *slots, keysInfoCallBack info,
 	if (sts != RESP_OK) {
 	    respReply *errorReply = calloc(1, sizeof(respReply));
 	    errorReply->type = RESP_REPLY_ERROR;
-	    errorReply->str = slots->acc->errstr;
-	    errorReply->len = strlen(slots->acc->errstr);
+	    errorReply->str = slots->acc ? slots->acc->errstr : "ERR request failed";
+	    errorReply->len = strlen(errorReply->str);
 	    callback(slots->acc, errorReply, arg);
 	}
     }
@@ -801,9 +874,9 @@ reportReplyError(keysInfoCallBack info, void *userdata,
     msg = sdscatvprintf(sdsempty(), format, argp);
     if (reply && reply->type == RESP_REPLY_ERROR)
 	msg = sdscatfmt(msg, "\nRESP reply error: %s", reply->str);
-    else if (acc->err)
+    else if (acc && acc->err)
 	msg = sdscatfmt(msg, "\nRESP acc error: %s", acc->errstr);
-    else if (acc->cc.err)
+    else if (acc && acc->cc.err)
 	msg = sdscatfmt(msg, "\nRESP cc error: %s", acc->cc.errstr);
     info(PMLOG_RESPONSE, msg, userdata);
     sdsfree(msg);
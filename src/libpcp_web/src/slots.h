@@ -59,6 +59,7 @@ typedef struct keySlots {
     unsigned int	conn_seq;	/* connection sequence (incremented for every connection) */
     unsigned int	search : 1;	/* search module enabled */
     unsigned int	cluster : 1;	/* cluster mode enabled */
+    struct keyStore	*store;		/* embedded store, no key server */
     keyMap		*keymap;	/* map command names to key position */
     void		*events;	/* libuv event loop */
     mmv_registry_t	*registry;	/* MMV metrics for instrumentation */
@@ -0,0 +1,2155 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <math.h>
+#include "pmapi.h"
+#include "libpcp.h"
+#include "store.h"
+#include "util.h"
+#ifdef HAVE_STRINGS_H
+#include <strings.h>
+#endif
+#if defined(HAVE_LIBUV)
+#include <uv.h>
+#endif
+
+#if defined(HAVE_LIBUV)
+
+#define STORE_SWEEP_MSEC	60000	/* interval between expiry sweeps */
+#define STORE_WRONGTYPE	\
+	"WRONGTYPE Operation against a key holding the wrong kind of value"
+
+typedef enum storeType {
+    STORE_STRING,
+    STORE_HASH,
+    STORE_SET,
+    STORE_ZSET,
+    STORE_STREAM,
+} storeType;
+
+typedef struct storeEntry {
+    __uint64_t		ms;		/* stream entry identifier */
+    __uint64_t		seq;
+    unsigned int	nfields;	/* name and value pairs */
+    sds			*fields;	/* interned names, owned values */
+} storeEntry;
+
+typedef struct storeStream {
+    struct keyStore	*store;		/* owner of interned field names */
+    __uint64_t		lastms;		/* most recent identifier added */
+    __uint64_t		lastseq;
+    size_t		first;		/* index of oldest live entry */
+    size_t		count;		/* entries, including trimmed */
+    size_t		size;
+    storeEntry		*entries;
+} storeStream;
+
+typedef struct storeMember {
+    double		score;
+    sds			member;
+} storeMember;
+
+typedef struct storeZset {
+    size_t		count;
+    size_t		size;
+    storeMember		*members;	/* ordered by score, then member */
+} storeZset;
+
+typedef struct storeValue {
+    storeType		type;
+    __int64_t		expires;	/* absolute expiry (msec) or zero */
+    union {
+	sds		string;
+	dict		*hash;		/* field -> value */
+	dict		*set;		/* member -> NULL */
+	storeZset	*zset;
+	storeStream	*stream;
+    } u;
+} storeValue;
+
+typedef struct storeArg {
+    const char		*str;		/* not necessarily NUL-terminated */
+    size_t		len;
+} storeArg;
+
+typedef struct storeReply {
+    keyClusterCallbackFn *callback;
+    void		*arg;
+    respReply		*reply;
+    struct storeReply	*next;
+} storeReply;
+
+struct keyStore {
+    dict		*keys;		/* key name -> storeValue */
+    dict		*strings;	/* interned names -> reference count */
+    sds			lookup;		/* scratch key for dictionary lookups */
+    sds			scratch;	/* scratch NUL-terminated argument */
+    storeArg		*argv;		/* arguments of the current command */
+    unsigned int	maxargs;
+    unsigned int	replaying : 1;	/* executing commands from the log */
+    unsigned int	delivering : 1;	/* inside reply callbacks */
+    unsigned int	freed : 1;	/* keyStoreFree during delivery */
+    unsigned int	padding : 29;
+    unsigned int	closing;	/* handles awaiting close callbacks */
+    storeReply		*head;		/* replies awaiting delivery */
+    storeReply		**tail;
+    sds			path;		/* command log, if persistent */
+    FILE		*log;
+    char		idbuf[48];	/* argument rewriting for the log */
+    char		msbuf[32];
+    uv_idle_t		idle;
+    uv_timer_t		timer;
+};
+
+typedef respReply *(*storeCommandFn)(struct keyStore *, int, storeArg *);
+
+typedef struct storeCommand {
+    const char		*name;
+    storeCommandFn	func;
+    int			arity;		/* minimum arguments, with name */
+    int			write;		/* modifies the store (logged) */
+} storeCommand;
+
+static __int64_t
+store_now(void)
+{
+    struct timespec	now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (__int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+ * Dictionary callbacks - store keys are owned sds strings, values
+ * are released according to their type.
+ */
+static uint64_t
+store_hash(const void *key)
+{
+    return dictGenHashFunction((unsigned char *)key, sdslen((sds)key));
+}
+
+static int
+store_compare(const void *key1, const void *key2)
+{
+    size_t		l1 = sdslen((sds)key1), l2 = sdslen((sds)key2);
+
+    return l1 == l2 && memcmp(key1, key2, l1) == 0;
+}
+
+static void
+store_sdsfree(void *value)
+{
+    sdsfree((sds)value);
+}
+
+static void store_value_free(void *);
+
+static dictType storeKeysCallBacks = {
+    .hashFunction	= store_hash,
+    .keyCompare		= store_compare,
+    .keyDestructor	= store_sdsfree,
+    .valDestructor	= store_value_free,
+};
+
+static dictType storeStringsCallBacks = {
+    .hashFunction	= store_hash,
+    .keyCompare		= store_compare,
+    .keyDestructor	= store_sdsfree,
+};
+
+/*
+ * Stream field names (instance name hashes, mostly) repeat in every
+ * entry of a stream - share one reference counted copy of each.
+ */
+static sds
+store_intern(struct keyStore *store, const char *name, size_t length)
+{
+    dictEntry		*entry;
+    sds			key;
+
+    store->lookup = sdscpylen(store->lookup, name, length);
+    if ((entry = dictFind(store->strings, store->lookup)) != NULL) {
+	dictSetVal(store->strings, entry,
+		(void *)((uintptr_t)dictGetVal(entry) + 1));
+	return dictGetKey(entry);
+    }
+    if ((key = sdsnewlen(name, length)) == NULL)
+	return NULL;
+    if (dictAdd(store->strings, key, (void *)(uintptr_t)1) != DICT_OK) {
+	sdsfree(key);
+	return NULL;
+    }
+    return key;
+}
+
+static void
+store_release(struct keyStore *store, sds name)
+{
+    dictEntry		*entry;
+    uintptr_t		count;
+
+    if ((entry = dictFind(store->strings, name)) == NULL)
+	return;
+    if ((count = (uintptr_t)dictGetVal(entry)) > 1)
+	dictSetVal(store->strings, entry, (void *)(count - 1));
+    else
+	dictDelete(store->strings, name);
+}
+
+static void
+store_entry_free(storeStream *stream, storeEntry *entry)
+{
+    unsigned int	i;
+
+    for (i = 0; i < entry->nfields; i += 2) {
+	store_release(stream->store, entry->fields[i]);
+	sdsfree(entry->fields[i+1]);
+    }
+    free(entry->fields);
+}
+
+static void
+store_stream_free(storeStream *stream)
+{
+    size_t		i;
+
+    for (i = stream->first; i < stream->count; i++)
+	store_entry_free(stream, &stream->entries[i]);
+    free(stream->entries);
+    free(stream);
+}
+
+static void
+store_zset_free(storeZset *zset)
+{
+    size_t		i;
+
+    for (i = 0; i < zset->count; i++)
+	sdsfree(zset->members[i].member);
+    free(zset->members);
+    free(zset);
+}
+
+static void
+store_value_free(void *arg)
+{
+    storeValue		*value = (storeValue *)arg;
+
+    if (value == NULL)
+	return;
+    switch (value->type) {
+    case STORE_STRING:
+	sdsfree(value->u.string);
+	break;
+    case STORE_HASH:
+	dictRelease(value->u.hash);
+	break;
+    case STORE_SET:
+	dictRelease(value->u.set);
+	break;
+    case STORE_ZSET:
+	store_zset_free(value->u.zset);
+	break;
+    case STORE_STREAM:
+	store_stream_free(value->u.stream);
+	break;
+    }
+    free(value);
+}
+
+/*
+ * Reply construction - these mirror the reply objects produced by
+ * the RESP reader for a server connection.
+ */
+static respReply *
+store_reply(int type)
+{
+    respReply		*reply;
+
+    if ((reply = calloc(1, sizeof(respReply))) != NULL)
+	reply->type = type;
+    return reply;
+}
+
+static void
+store_reply_free(respReply *reply)
+{
+    size_t		i;
+
+    if (reply == NULL)
+	return;
+    if (reply->element) {
+	for (i = 0; i < reply->elements; i++)
+	    store_reply_free(reply->element[i]);
+	free(reply->element);
+    }
+    free(reply->str);
+    free(reply);
+}
+
+static respReply *
+store_reply_text(int type, const char *str, size_t length)
+{
+    respReply		*reply;
+
+    if ((reply = store_reply(type)) == NULL)
+	return NULL;
+    if ((reply->str = malloc(length + 1)) == NULL) {
+	free(reply);
+	return NULL;
+    }
+    memcpy(reply->str, str, length);
+    reply->str[length] = '\0';
+    reply->len = length;
+    return reply;
+}
+
+static respReply *
+store_reply_string(const char *str, size_t length)
+{
+    return store_reply_text(RESP_REPLY_STRING, str, length);
+}
+
+static respReply *
+store_reply_status(const char *status)
+{
+    return store_reply_text(RESP_REPLY_STATUS, status, strlen(status));
+}
+
+static respReply *
+store_reply_error(const char *format, ...)
+{
+    char		buffer[256];
+    va_list		argp;
+    int			length;
+
+    va_start(argp, format);
+    length = vsnprintf(buffer, sizeof(buffer), format, argp);
+    va_end(argp);
+    if (length >= (int)sizeof(buffer))
+	length = sizeof(buffer) - 1;
+    return store_reply_text(RESP_REPLY_ERROR, buffer, length);
+}
+
+static respReply *
+store_reply_integer(long long value)
+{
+    respReply		*reply;
+
+    if ((reply = store_reply(RESP_REPLY_INTEGER)) != NULL)
+	reply->integer = value;
+    return reply;
+}
+
+static respReply *
+store_reply_nil(void)
+{
+    return store_reply(RESP_REPLY_NIL);
+}
+
+static respReply *
+store_reply_array(size_t count)
+{
+    respReply		*reply;
+
+    if ((reply = store_reply(RESP_REPLY_ARRAY)) == NULL)
+	return NULL;
+    if (count && (reply->element = calloc(count, sizeof(respReply *))) == NULL) {
+	free(reply);
+	return NULL;
+    }
+    reply->elements = count;
+    return reply;
+}
+
+/* shrink an array reply to the elements actually filled in */
+static respReply *
+store_reply_trim(respReply *reply, size_t count)
+{
+    size_t		i;
+
+    for (i = 0; i < count; i++) {
+	if (reply->element[i] == NULL) {
+	    store_reply_free(reply);
+	    return NULL;
+	}
+    }
+    reply->elements = count;
+    return reply;
+}
+
+/*
+ * Argument helpers - arguments point into the (RESP encoded) request
+ * and are followed by a CRLF, so numeric conversions stop correctly.
+ */
+static int
+store_arg_is(storeArg *arg, const char *name)
+{
+    size_t		length = strlen(name);
+
+    return arg->len == length && strncasecmp(arg->str, name, length) == 0;
+}
+
+static int
+store_arg_ll(storeArg *arg, long long *value)
+{
+    char		*end;
+
+    if (arg->len == 0 || arg->len > 20)
+	return -EINVAL;
+    errno = 0;
+    *value = strtoll(arg->str, &end, 10);
+    if (errno || end != arg->str + arg->len)
+	return -EINVAL;
+    return 0;
+}
+
+static int
+store_arg_double(storeArg *arg, double *value, int *exclusive)
+{
+    const char		*str = arg->str;
+    size_t		length = arg->len;
+    char		*end;
+
+    if (exclusive)
+	*exclusive = 0;
+    if (length && *str == '(' && exclusive) {
+	*exclusive = 1;
+	str++, length--;
+    }
+    if (length == 4 && strncasecmp(str, "-inf", 4) == 0)
+	*value = -INFINITY;
+    else if ((length == 4 && strncasecmp(str, "+inf", 4) == 0) ||
+	     (length == 3 && strncasecmp(str, "inf", 3) == 0))
+	*value = INFINITY;
+    else if (length == 0)
+	return -EINVAL;
+    else {
+	*value = strtod(str, &end);
+	if (end != str + length || isnan(*value))
+	    return -EINVAL;
+    }
+    return 0;
+}
+
+static const char *
+store_arg_string(struct keyStore *store, storeArg *arg)
+{
+    store->scratch = sdscpylen(store->scratch, arg->str, arg->len);
+    return store->scratch;
+}
+
+/*
+ * Keyspace access, with lazy expiry of keys past their deadline.
+ */
+static storeValue *
+store_lookup(struct keyStore *store, storeArg *key)
+{
+    dictEntry		*entry;
+    storeValue		*value;
+
+    store->lookup = sdscpylen(store->lookup, key->str, key->len);
+    if ((entry = dictFind(store->keys, store->lookup)) == NULL)
+	return NULL;
+    value = (storeValue *)dictGetVal(entry);
+    if (value->expires && value->expires <= store_now()) {
+	dictDelete(store->keys, store->lookup);
+	return NULL;
+    }
+    return value;
+}
+
+static storeValue *
+store_lookup_type(struct keyStore *store, storeArg *key, storeType type,
+		respReply **error)
+{
+    storeValue		*value;
+
+    *error = NULL;
+    if ((value = store_lookup(store, key)) != NULL && value->type != type) {
+	*error = store_reply_error(STORE_WRONGTYPE);
+	return NULL;
+    }
+    return value;
+}
+
+static storeValue *
+store_create(struct keyStore *store, storeArg *key, storeType type)
+{
+    storeValue		*value;
+    sds			name;
+
+    if ((value = calloc(1, sizeof(storeValue))) == NULL)
+	return NULL;
+    value->type = type;
+    switch (type) {
+    case STORE_STRING:
+	value->u.string = sdsempty();
+	break;
+    case STORE_HASH:
+	value->u.hash = dictCreate(&sdsDictCallBacks);
+	break;
+    case STORE_SET:
+	value->u.set = dictCreate(&sdsKeyDictCallBacks);
+	break;
+    case STORE_ZSET:
+	value->u.zset = calloc(1, sizeof(storeZset));
+	break;
+    case STORE_STREAM:
+	if ((value->u.stream = calloc(1, sizeof(storeStream))) != NULL)
+	    value->u.stream->store = store;
+	break;
+    }
+    if (value->u.string == NULL ||
+	(name = sdsnewlen(key->str, key->len)) == NULL) {
+	store_value_free(value);
+	return NULL;
+    }
+    if (dictAdd(store->keys, name, value) != DICT_OK) {
+	sdsfree(name);
+	store_value_free(value);
+	return NULL;
+    }
+    return value;
+}
+
+static respReply *
+store_oom(void)
+{
+    return store_reply_error("OOM command not allowed when used memory > 'maxmemory'");
+}
+
+static respReply *
+store_syntax(void)
+{
+    return store_reply_error("ERR syntax error");
+}
+
+/*
+ * Server and keyspace commands.
+ */
+static respReply *
+store_ping(struct keyStore *store, int argc, storeArg *argv)
+{
+    if (argc > 1)
+	return store_reply_string(argv[1].str, argv[1].len);
+    return store_reply_status("PONG");
+}
+
+static respReply *
+store_info(struct keyStore *store, int argc, storeArg *argv)
+{
+    sds			info;
+    respReply		*reply;
+
+    /* the version satisfies the schema check in keys_load_version */
+    info = sdscatfmt(sdsempty(),
+		"# Server\r\nredis_version:7.2.4\r\n"
+		"server_name:pcp-embedded\r\n\r\n"
+		"# Keyspace\r\ndb0:keys=%U\r\n",
+		(uint64_t)dictSize(store->keys));
+    reply = store_reply_string(info, sdslen(info));
+    sdsfree(info);
+    return reply;
+}
+
+static respReply *
+store_command(struct keyStore *store, int argc, storeArg *argv)
+{
+    /* no key positions - every request is served locally */
+    return store_reply_array(0);
+}
+
+static respReply *
+store_publish(struct keyStore *store, int argc, storeArg *argv)
+{
+    return store_reply_integer(0);	/* no subscribers */
+}
+
+static respReply *
+store_flushall(struct keyStore *store, int argc, storeArg *argv)
+{
+    dict		*keys;
+
+    if ((keys = dictCreate(&storeKeysCallBacks)) == NULL)
+	return store_oom();
+    dictRelease(store->keys);
+    store->keys = keys;
+    return store_reply_status("OK");
+}
+
+static respReply *
+store_dbsize(struct keyStore *store, int argc, storeArg *argv)
+{
+    return store_reply_integer(dictSize(store->keys));
+}
+
+static respReply *
+store_del(struct keyStore *store, int argc, storeArg *argv)
+{
+    long long		count = 0;
+    int			i;
+
+    for (i = 1; i < argc; i++) {
+	if (store_lookup(store, &argv[i]) == NULL)
+	    continue;
+	dictDelete(store->keys, store->lookup);
+	count++;
+    }
+    return store_reply_integer(count);
+}
+
+static respReply *
+store_exists(struct keyStore *store, int argc, storeArg *argv)
+{
+    long long		count = 0;
+    int			i;
+
+    for (i = 1; i < argc; i++)
+	if (store_lookup(store, &argv[i]) != NULL)
+	    count++;
+    return store_reply_integer(count);
+}
+
+/*
+ * EXPIRE is logged as PEXPIREAT, so that replaying the log later does
+ * not extend the lifetime of keys.
+ */
+static respReply *
+store_expire(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    long long		when;
+    int			length;
+
+    if (store_arg_ll(&argv[2], &when) < 0)
+	return store_reply_error("ERR value is not an integer or out of range");
+    if ((value = store_lookup(store, &argv[1])) == NULL)
+	return store_reply_integer(0);
+    if (store_arg_is(&argv[0], "EXPIRE"))
+	when = store_now() + when * 1000;
+    value->expires = when > 0 ? when : 1;
+
+    length = pmsprintf(store->msbuf, sizeof(store->msbuf), "%lld", when);
+    argv[0].str = "PEXPIREAT";
+    argv[0].len = sizeof("PEXPIREAT") - 1;
+    argv[2].str = store->msbuf;
+    argv[2].len = length;
+    return store_reply_integer(1);
+}
+
+static respReply *
+store_keys_match(struct keyStore *store, const char *pattern, int type)
+{
+    dictIterator	iterator;
+    dictEntry		*entry;
+    storeValue		*value;
+    respReply		*reply;
+    size_t		count = 0;
+    __int64_t		now = store_now();
+    sds			key;
+
+    if ((reply = store_reply_array(dictSize(store->keys))) == NULL)
+	return NULL;
+    dictInitIterator(&iterator, store->keys);
+    while ((entry = dictNext(&iterator)) != NULL) {
+	key = (sds)dictGetKey(entry);
+	value = (storeValue *)dictGetVal(entry);
+	if (value->expires && value->expires <= now)
+	    continue;
+	if (type >= 0 && value->type != type)
+	    continue;
+	if (pattern && fnmatch(pattern, key, 0) != 0)
+	    continue;
+	reply->element[count++] = store_reply_string(key, sdslen(key));
+    }
+    return store_reply_trim(reply, count);
+}
+
+static respReply *
+store_keys(struct keyStore *store, int argc, storeArg *argv)
+{
+    return store_keys_match(store, store_arg_string(store, &argv[1]), -1);
+}
+
+/* complete iteration in one call, returning a zero cursor */
+static respReply *
+store_cursor(respReply *result)
+{
+    respReply		*reply;
+
+    if (result == NULL)
+	return NULL;
+    if ((reply = store_reply_array(2)) == NULL) {
+	store_reply_free(result);
+	return NULL;
+    }
+    reply->element[0] = store_reply_string("0", 1);
+    reply->element[1] = result;
+    return store_reply_trim(reply, 2);
+}
+
+static respReply *
+store_scan(struct keyStore *store, int argc, storeArg *argv)
+{
+    const char		*pattern = NULL;
+    int			i, type = -1;
+
+    for (i = 2; i + 1 < argc; i += 2) {
+	if (store_arg_is(&argv[i], "MATCH"))
+	    pattern = store_arg_string(store, &argv[i+1]);
+	else if (store_arg_is(&argv[i], "TYPE")) {
+	    if (store_arg_is(&argv[i+1], "string")) type = STORE_STRING;
+	    else if (store_arg_is(&argv[i+1], "hash")) type = STORE_HASH;
+	    else if (store_arg_is(&argv[i+1], "set")) type = STORE_SET;
+	    else if (store_arg_is(&argv[i+1], "zset")) type = STORE_ZSET;
+	    else if (store_arg_is(&argv[i+1], "stream")) type = STORE_STREAM;
+	}
+    }
+    return store_cursor(store_keys_match(store, pattern, type));
+}
+
+/*
+ * String commands.
+ */
+static respReply *
+store_get(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_STRING, &error)) == NULL)
+	return error ? error : store_reply_nil();
+    return store_reply_string(value->u.string, sdslen(value->u.string));
+}
+
+static respReply *
+store_strlen(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_STRING, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    return store_reply_integer(sdslen(value->u.string));
+}
+
+static respReply *
+store_set(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    sds			string;
+    int			i, nx = 0, xx = 0;
+
+    for (i = 3; i < argc; i++) {
+	if (store_arg_is(&argv[i], "NX"))
+	    nx = 1;
+	else if (store_arg_is(&argv[i], "XX"))
+	    xx = 1;
+	else
+	    return store_syntax();
+    }
+    if ((value = store_lookup(store, &argv[1])) != NULL) {
+	if (nx)
+	    return store_reply_nil();
+	dictDelete(store->keys, store->lookup);
+    } else if (xx)
+	return store_reply_nil();
+
+    if ((string = sdsnewlen(argv[2].str, argv[2].len)) == NULL)
+	return store_oom();
+    if ((value = store_create(store, &argv[1], STORE_STRING)) == NULL) {
+	sdsfree(string);
+	return store_oom();
+    }
+    sdsfree(value->u.string);
+    value->u.string = string;
+    return store_reply_status("OK");
+}
+
+static respReply *
+store_append(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    sds			string;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_STRING, &error)) == NULL) {
+	if (error)
+	    return error;
+	if ((value = store_create(store, &argv[1], STORE_STRING)) == NULL)
+	    return store_oom();
+    }
+    if ((string = sdscatlen(value->u.string, argv[2].str, argv[2].len)) == NULL)
+	return store_oom();
+    value->u.string = string;
+    return store_reply_integer(sdslen(string));
+}
+
+/*
+ * Hash commands.
+ */
+static respReply *
+store_hset(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    long long		count = 0;
+    sds			field;
+    int			i;
+
+    if ((argc % 2) != 0)
+	return store_reply_error("ERR wrong number of arguments for '%.*s' command",
+			(int)argv[0].len, argv[0].str);
+    if ((value = store_lookup_type(store, &argv[1], STORE_HASH, &error)) == NULL) {
+	if (error)
+	    return error;
+	if ((value = store_create(store, &argv[1], STORE_HASH)) == NULL)
+	    return store_oom();
+    }
+    for (i = 2; i < argc; i += 2) {
+	field = sdsnewlen(argv[i+1].str, argv[i+1].len);
+	store->lookup = sdscpylen(store->lookup, argv[i].str, argv[i].len);
+	if (dictReplace(value->u.hash, store->lookup, field) == 1)
+	    count++;
+    }
+    if (store_arg_is(&argv[0], "HMSET"))
+	return store_reply_status("OK");
+    return store_reply_integer(count);
+}
+
+static respReply *
+store_hget(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    dictEntry		*entry;
+    sds			field;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_HASH, &error)) == NULL)
+	return error ? error : store_reply_nil();
+    store->lookup = sdscpylen(store->lookup, argv[2].str, argv[2].len);
+    if ((entry = dictFind(value->u.hash, store->lookup)) == NULL)
+	return store_reply_nil();
+    field = (sds)dictGetVal(entry);
+    return store_reply_string(field, sdslen(field));
+}
+
+static respReply *
+store_hmget(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error, *reply;
+    dictEntry		*entry;
+    sds			field;
+    int			i;
+
+    value = store_lookup_type(store, &argv[1], STORE_HASH, &error);
+    if (error)
+	return error;
+    if ((reply = store_reply_array(argc - 2)) == NULL)
+	return NULL;
+    for (i = 2; i < argc; i++) {
+	store->lookup = sdscpylen(store->lookup, argv[i].str, argv[i].len);
+	if (value && (entry = dictFind(value->u.hash, store->lookup)) != NULL) {
+	    field = (sds)dictGetVal(entry);
+	    reply->element[i-2] = store_reply_string(field, sdslen(field));
+	} else {
+	    reply->element[i-2] = store_reply_nil();
+	}
+    }
+    return store_reply_trim(reply, argc - 2);
+}
+
+enum { HASH_KEYS = 0x1, HASH_VALUES = 0x2 };
+
+static respReply *
+store_hash_reply(dict *hash, int flags, const char *pattern)
+{
+    dictIterator	iterator;
+    dictEntry		*entry;
+    respReply		*reply;
+    size_t		count = 0, size;
+    sds			key, field;
+
+    size = dictSize(hash) * ((flags == (HASH_KEYS|HASH_VALUES)) ? 2 : 1);
+    if ((reply = store_reply_array(size)) == NULL)
+	return NULL;
+    dictInitIterator(&iterator, hash);
+    while ((entry = dictNext(&iterator)) != NULL) {
+	key = (sds)dictGetKey(entry);
+	if (pattern && fnmatch(pattern, key, 0) != 0)
+	    continue;
+	if (flags & HASH_KEYS)
+	    reply->element[count++] = store_reply_string(key, sdslen(key));
+	if (flags & HASH_VALUES) {
+	    field = (sds)dictGetVal(entry);
+	    reply->element[count++] = store_reply_string(field, sdslen(field));
+	}
+    }
+    return store_reply_trim(reply, count);
+}
+
+static respReply *
+store_hgetall(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    int			flags = HASH_KEYS|HASH_VALUES;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_HASH, &error)) == NULL)
+	return error ? error : store_reply_array(0);
+    if (store_arg_is(&argv[0], "HKEYS"))
+	flags = HASH_KEYS;
+    else if (store_arg_is(&argv[0], "HVALS"))
+	flags = HASH_VALUES;
+    return store_hash_reply(value->u.hash, flags, NULL);
+}
+
+static respReply *
+store_hlen(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_HASH, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    return store_reply_integer(dictSize(value->u.hash));
+}
+
+static respReply *
+store_hscan(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    const char		*pattern = NULL;
+    int			i;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_HASH, &error)) == NULL)
+	return error ? error : store_cursor(store_reply_array(0));
+    for (i = 3; i + 1 < argc; i += 2)
+	if (store_arg_is(&argv[i], "MATCH"))
+	    pattern = store_arg_string(store, &argv[i+1]);
+    return store_cursor(store_hash_reply(value->u.hash,
+				HASH_KEYS|HASH_VALUES, pattern));
+}
+
+/*
+ * Set commands.
+ */
+static respReply *
+store_sadd(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    long long		count = 0;
+    int			i;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_SET, &error)) == NULL) {
+	if (error)
+	    return error;
+	if ((value = store_create(store, &argv[1], STORE_SET)) == NULL)
+	    return store_oom();
+    }
+    for (i = 2; i < argc; i++) {
+	store->lookup = sdscpylen(store->lookup, argv[i].str, argv[i].len);
+	if (dictAdd(value->u.set, store->lookup, NULL) == DICT_OK)
+	    count++;
+    }
+    return store_reply_integer(count);
+}
+
+static respReply *
+store_smembers(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_SET, &error)) == NULL)
+	return error ? error : store_reply_array(0);
+    return store_hash_reply(value->u.set, HASH_KEYS, NULL);
+}
+
+static respReply *
+store_scard(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_SET, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    return store_reply_integer(dictSize(value->u.set));
+}
+
+/*
+ * Sorted set commands - members are held in an array ordered by score
+ * (then member), which suits the small per-series chunk indexes.
+ */
+static int
+store_member_compare(double score, const char *member, size_t length,
+		storeMember *mp)
+{
+    size_t		mlength = sdslen(mp->member);
+    int			sts;
+
+    if (score < mp->score)
+	return -1;
+    if (score > mp->score)
+	return 1;
+    sts = memcmp(member, mp->member, length < mlength ? length : mlength);
+    if (sts == 0)
+	sts = (length > mlength) - (length < mlength);
+    return sts;
+}
+
+static int
+store_zset_add(storeZset *zset, double score, storeArg *member)
+{
+    storeMember		*mp;
+    size_t		i, size, lo, hi, mid;
+
+    for (i = 0; i < zset->count; i++) {
+	mp = &zset->members[i];
+	if (sdslen(mp->member) == member->len &&
+	    memcmp(mp->member, member->str, member->len) == 0)
+	    break;
+    }
+    if (i < zset->count) {
+	if (zset->members[i].score == score)
+	    return 0;
+	sdsfree(zset->members[i].member);
+	memmove(&zset->members[i], &zset->members[i+1],
+		(zset->count - i - 1) * sizeof(storeMember));
+	zset->count--;
+	i = 0;	/* updated, rather than added */
+    } else {
+	i = 1;
+    }
+
+    if (zset->count == zset->size) {
+	size = zset->size ? zset->size * 2 : 4;
+	if ((mp = realloc(zset->members, size * sizeof(storeMember))) == NULL)
+	    return -ENOMEM;
+	zset->members = mp;
+	zset->size = size;
+    }
+    for (lo = 0, hi = zset->count; lo < hi; ) {
+	mid = lo + (hi - lo) / 2;
+	if (store_member_compare(score, member->str, member->len,
+				&zset->members[mid]) > 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    mp = &zset->members[lo];
+    memmove(mp + 1, mp, (zset->count - lo) * sizeof(storeMember));
+    if ((mp->member = sdsnewlen(member->str, member->len)) == NULL) {
+	memmove(mp, mp + 1, (zset->count - lo) * sizeof(storeMember));
+	return -ENOMEM;
+    }
+    mp->score = score;
+    zset->count++;
+    return i;
+}
+
+static respReply *
+store_zadd(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    long long		count = 0;
+    double		score;
+    int			i, sts;
+
+    if ((argc % 2) != 0)
+	return store_syntax();
+    for (i = 2; i < argc; i += 2)
+	if (store_arg_double(&argv[i], &score, NULL) < 0)
+	    return store_reply_error("ERR value is not a valid float");
+    if ((value = store_lookup_type(store, &argv[1], STORE_ZSET, &error)) == NULL) {
+	if (error)
+	    return error;
+	if ((value = store_create(store, &argv[1], STORE_ZSET)) == NULL)
+	    return store_oom();
+    }
+    for (i = 2; i < argc; i += 2) {
+	store_arg_double(&argv[i], &score, NULL);
+	if ((sts = store_zset_add(value->u.zset, score, &argv[i+1])) < 0)
+	    return store_oom();
+	count += sts;
+    }
+    return store_reply_integer(count);
+}
+
+/*
+ * GEOADD is accepted for the source location index, which is written
+ * but never queried by this library - the members are kept in a zset.
+ */
+static respReply *
+store_geoadd(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+    long long		count = 0;
+    double		lon, lat;
+    int			i, sts;
+
+    if (((argc - 2) % 3) != 0)
+	return store_syntax();
+    if ((value = store_lookup_type(store, &argv[1], STORE_ZSET, &error)) == NULL) {
+	if (error)
+	    return error;
+	if ((value = store_create(store, &argv[1], STORE_ZSET)) == NULL)
+	    return store_oom();
+    }
+    for (i = 2; i < argc; i += 3) {
+	if (store_arg_double(&argv[i], &lon, NULL) < 0 ||
+	    store_arg_double(&argv[i+1], &lat, NULL) < 0)
+	    return store_reply_error("ERR value is not a valid float");
+	if ((sts = store_zset_add(value->u.zset, 0.0, &argv[i+2])) < 0)
+	    return store_oom();
+	count += sts;
+    }
+    return store_reply_integer(count);
+}
+
+/* ZRANGE key start stop [WITHSCORES] - by rank only */
+static respReply *
+store_zrank_range(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    storeMember		*mp;
+    respReply		*error, *reply;
+    long long		start, stop, total;
+    size_t		count = 0;
+    char		buffer[64];
+    int			scores = 0, length;
+
+    if (store_arg_ll(&argv[2], &start) < 0 || store_arg_ll(&argv[3], &stop) < 0)
+	return store_reply_error("ERR value is not an integer or out of range");
+    if (argc == 5 && store_arg_is(&argv[4], "WITHSCORES"))
+	scores = 1;
+    else if (argc != 4)
+	return store_syntax();
+    if ((value = store_lookup_type(store, &argv[1], STORE_ZSET, &error)) == NULL)
+	return error ? error : store_reply_array(0);
+
+    total = value->u.zset->count;
+    if (start < 0 && (start += total) < 0)
+	start = 0;
+    if (stop < 0)
+	stop += total;
+    if (stop >= total)
+	stop = total - 1;
+    if (start > stop)
+	return store_reply_array(0);
+
+    if ((reply = store_reply_array((stop - start + 1) * (scores ? 2 : 1))) == NULL)
+	return NULL;
+    for (; start <= stop; start++) {
+	mp = &value->u.zset->members[start];
+	reply->element[count++] = store_reply_string(mp->member, sdslen(mp->member));
+	if (scores) {
+	    length = pmsprintf(buffer, sizeof(buffer), "%.17g", mp->score);
+	    reply->element[count++] = store_reply_string(buffer, length);
+	}
+    }
+    return store_reply_trim(reply, count);
+}
+
+static respReply *
+store_zrange(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    storeMember		*mp;
+    respReply		*error, *reply;
+    long long		offset = 0, limit = -1;
+    double		min, max;
+    size_t		i, count = 0, skipped = 0, size;
+    char		buffer[64];
+    int			minex, maxex, reverse, scores = 0, length, n;
+
+    reverse = store_arg_is(&argv[0], "ZREVRANGEBYSCORE");
+    n = reverse ? 3 : 2;	/* ZREVRANGEBYSCORE key max min */
+    if (store_arg_double(&argv[n], &min, &minex) < 0 ||
+	store_arg_double(&argv[reverse ? 2 : 3], &max, &maxex) < 0)
+	return store_reply_error("ERR min or max is not a float");
+    for (n = 4; n < argc; n++) {
+	if (store_arg_is(&argv[n], "WITHSCORES"))
+	    scores = 1;
+	else if (store_arg_is(&argv[n], "LIMIT") && n + 2 < argc &&
+		store_arg_ll(&argv[n+1], &offset) == 0 &&
+		store_arg_ll(&argv[n+2], &limit) == 0)
+	    n += 2;
+	else
+	    return store_syntax();
+    }
+    if ((value = store_lookup_type(store, &argv[1], STORE_ZSET, &error)) == NULL)
+	return error ? error : store_reply_array(0);
+
+    size = value->u.zset->count * (scores ? 2 : 1);
+    if ((reply = store_reply_array(size)) == NULL)
+	return NULL;
+    for (i = 0; i < value->u.zset->count; i++) {
+	mp = &value->u.zset->members[reverse ? value->u.zset->count - i - 1 : i];
+	if (mp->score < min || (minex && mp->score == min) ||
+	    mp->score > max || (maxex && mp->score == max))
+	    continue;
+	if (skipped++ < (size_t)offset)
+	    continue;
+	if (limit >= 0 && count >= (size_t)limit * (scores ? 2 : 1))
+	    break;
+	reply->element[count++] = store_reply_string(mp->member, sdslen(mp->member));
+	if (scores) {
+	    length = pmsprintf(buffer, sizeof(buffer), "%.17g", mp->score);
+	    reply->element[count++] = store_reply_string(buffer, length);
+	}
+    }
+    return store_reply_trim(reply, count);
+}
+
+static respReply *
+store_zcard(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_ZSET, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    return store_reply_integer(value->u.zset->count);
+}
+
+/*
+ * Stream commands - entries are appended to an array in identifier
+ * order, and trimmed from the front; field names are interned.
+ */
+static int
+store_stream_id(storeArg *arg, __uint64_t *ms, __uint64_t *seq, int *auto_seq)
+{
+    const char		*p = arg->str, *end = arg->str + arg->len;
+    char		*endp;
+
+    if (auto_seq)
+	*auto_seq = 0;
+    if (p == end || !isdigit((int)*p))
+	return -EINVAL;
+    errno = 0;
+    *ms = strtoull(p, &endp, 10);
+    if (errno)
+	return -EINVAL;
+    if ((const char *)endp == end)
+	return 1;	/* sequence number not given */
+    if (*endp != '-' || ++endp == end)
+	return -EINVAL;
+    if (auto_seq && *endp == '*' && endp + 1 == end) {
+	*auto_seq = 1;
+	return 0;
+    }
+    if (!isdigit((int)*endp))
+	return -EINVAL;
+    *seq = strtoull(endp, &endp, 10);
+    if (errno || (const char *)endp != end)
+	return -EINVAL;
+    return 0;
+}
+
+static int
+store_id_compare(__uint64_t ms1, __uint64_t seq1, __uint64_t ms2, __uint64_t seq2)
+{
+    if (ms1 != ms2)
+	return ms1 < ms2 ? -1 : 1;
+    if (seq1 != seq2)
+	return seq1 < seq2 ? -1 : 1;
+    return 0;
+}
+
+/* index of the first live entry with an identifier at or after ms-seq */
+static size_t
+store_stream_seek(storeStream *stream, __uint64_t ms, __uint64_t seq)
+{
+    storeEntry		*entry;
+    size_t		lo = stream->first, hi = stream->count, mid;
+
+    while (lo < hi) {
+	mid = lo + (hi - lo) / 2;
+	entry = &stream->entries[mid];
+	if (store_id_compare(entry->ms, entry->seq, ms, seq) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+static void
+store_stream_trim(storeStream *stream, size_t upto)
+{
+    size_t		live;
+
+    while (stream->first < upto)
+	store_entry_free(stream, &stream->entries[stream->first++]);
+    /* reclaim the trimmed prefix once it dominates the array */
+    live = stream->count - stream->first;
+    if (stream->first > 0 && stream->first >= live) {
+	memmove(stream->entries, &stream->entries[stream->first],
+		live * sizeof(storeEntry));
+	stream->count = live;
+	stream->first = 0;
+    }
+}
+
+static respReply *
+store_xadd(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    storeStream		*stream;
+    storeEntry		*entry;
+    respReply		*error;
+    __uint64_t		ms = 0, seq = 0, minms = 0, minseq = 0;
+    long long		maxlen = -1;
+    size_t		size;
+    int			i, sts, length, nomkstream = 0, minid = 0, auto_seq;
+
+    for (i = 2; i < argc; i++) {
+	if (store_arg_is(&argv[i], "NOMKSTREAM")) {
+	    nomkstream = 1;
+	} else if (store_arg_is(&argv[i], "MAXLEN") ||
+		   store_arg_is(&argv[i], "MINID")) {
+	    minid = store_arg_is(&argv[i], "MINID");
+	    if (i + 1 < argc && (store_arg_is(&argv[i+1], "~") ||
+				 store_arg_is(&argv[i+1], "=")))
+		i++;
+	    if (++i >= argc)
+		return store_syntax();
+	    if (minid) {
+		if (store_stream_id(&argv[i], &minms, &minseq, NULL) < 0)
+		    return store_reply_error("ERR Invalid stream ID specified as stream command argument");
+	    } else if (store_arg_ll(&argv[i], &maxlen) < 0 || maxlen < 0) {
+		return store_reply_error("ERR value is not an integer or out of range");
+	    }
+	} else if (store_arg_is(&argv[i], "LIMIT")) {
+	    i++;	/* trimming is always exact here */
+	} else {
+	    break;
+	}
+    }
+    if (i >= argc || ((argc - i - 1) % 2) != 0 || argc - i - 1 == 0)
+	return store_reply_error("ERR wrong number of arguments for 'xadd' command");
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_STREAM, &error)) == NULL) {
+	if (error)
+	    return error;
+	if (nomkstream)
+	    return store_reply_nil();
+	if ((value = store_create(store, &argv[1], STORE_STREAM)) == NULL)
+	    return store_oom();
+    }
+    stream = value->u.stream;
+
+    /* assign the entry identifier, which must always increase */
+    if (store_arg_is(&argv[i], "*")) {
+	ms = store_now();
+	if (ms <= stream->lastms) {
+	    ms = stream->lastms;
+	    seq = stream->lastseq + 1;
+	}
+    } else if ((sts = store_stream_id(&argv[i], &ms, &seq, &auto_seq)) < 0) {
+	return store_reply_error("ERR Invalid stream ID specified as stream command argument");
+    } else if (auto_seq) {
+	seq = (ms == stream->lastms && stream->count) ? stream->lastseq + 1 : 0;
+    }
+    if (stream->count && store_id_compare(ms, seq,
+				stream->lastms, stream->lastseq) <= 0)
+	return store_reply_error(RESP_ESTREAMXADD);
+    if (ms == 0 && seq == 0)
+	return store_reply_error("ERR The ID specified in XADD must be greater than 0-0");
+
+    if (stream->count == stream->size) {
+	size = stream->size ? stream->size * 2 : 8;
+	if ((entry = realloc(stream->entries, size * sizeof(storeEntry))) == NULL)
+	    return store_oom();
+	stream->entries = entry;
+	stream->size = size;
+    }
+    entry = &stream->entries[stream->count];
+    entry->ms = ms;
+    entry->seq = seq;
+    entry->nfields = argc - i - 1;
+    if ((entry->fields = calloc(entry->nfields, sizeof(sds))) == NULL)
+	return store_oom();
+    for (sts = 0; sts < entry->nfields; sts += 2) {
+	entry->fields[sts] = store_intern(store, argv[i+1+sts].str, argv[i+1+sts].len);
+	entry->fields[sts+1] = sdsnewlen(argv[i+2+sts].str, argv[i+2+sts].len);
+    }
+    stream->count++;
+    stream->lastms = ms;
+    stream->lastseq = seq;
+
+    if (maxlen >= 0 && stream->count - stream->first > (size_t)maxlen)
+	store_stream_trim(stream, stream->count - maxlen);
+    else if (minid)
+	store_stream_trim(stream, store_stream_seek(stream, minms, minseq));
+
+    /* log the assigned identifier, not the request */
+    length = pmsprintf(store->idbuf, sizeof(store->idbuf), "%llu-%llu",
+			(unsigned long long)ms, (unsigned long long)seq);
+    argv[i].str = store->idbuf;
+    argv[i].len = length;
+    return store_reply_string(store->idbuf, length);
+}
+
+static respReply *
+store_entry_reply(storeEntry *entry)
+{
+    respReply		*reply, *fields;
+    unsigned int	i;
+    char		buffer[48];
+    int			length;
+
+    if ((reply = store_reply_array(2)) == NULL)
+	return NULL;
+    length = pmsprintf(buffer, sizeof(buffer), "%llu-%llu",
+		(unsigned long long)entry->ms, (unsigned long long)entry->seq);
+    reply->element[0] = store_reply_string(buffer, length);
+    if ((fields = reply->element[1] = store_reply_array(entry->nfields)) != NULL) {
+	for (i = 0; i < entry->nfields; i++)
+	    fields->element[i] = store_reply_string(entry->fields[i],
+					sdslen(entry->fields[i]));
+	if (store_reply_trim(fields, entry->nfields) == NULL)
+	    reply->element[1] = NULL;
+    }
+    return store_reply_trim(reply, 2);
+}
+
+/* parse a range boundary: "-", "+", "ms", "ms-seq", optionally "(" exclusive */
+static int
+store_range_id(storeArg *arg, int end, __uint64_t *ms, __uint64_t *seq)
+{
+    storeArg		id = *arg;
+    int			exclusive = 0, sts;
+
+    if (store_arg_is(arg, "-")) {
+	*ms = *seq = 0;
+	return 0;
+    }
+    if (store_arg_is(arg, "+")) {
+	*ms = *seq = UINT64_MAX;
+	return 0;
+    }
+    if (id.len && *id.str == '(') {
+	exclusive = 1;
+	id.str++, id.len--;
+    }
+    if ((sts = store_stream_id(&id, ms, seq, NULL)) < 0)
+	return sts;
+    if (sts == 1)
+	*seq = end ? UINT64_MAX : 0;
+    if (exclusive) {
+	if (end) {
+	    if ((*seq)-- == 0) {
+		if ((*ms)-- == 0)
+		    return -ERANGE;
+		*seq = UINT64_MAX;
+	    }
+	} else if (++(*seq) == 0) {
+	    if (++(*ms) == 0)
+		return -ERANGE;
+	}
+    }
+    return 0;
+}
+
+static respReply *
+store_xrange(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    storeStream		*stream;
+    respReply		*error, *reply;
+    __uint64_t		startms, startseq, endms, endseq;
+    long long		limit = -1;
+    size_t		start, end, count = 0, i;
+    int			reverse;
+
+    reverse = store_arg_is(&argv[0], "XREVRANGE");
+    if (store_range_id(&argv[reverse ? 3 : 2], 0, &startms, &startseq) < 0 ||
+	store_range_id(&argv[reverse ? 2 : 3], 1, &endms, &endseq) < 0)
+	return store_reply_error("ERR Invalid stream ID specified as stream command argument");
+    if (argc == 6 && store_arg_is(&argv[4], "COUNT")) {
+	if (store_arg_ll(&argv[5], &limit) < 0)
+	    return store_reply_error("ERR value is not an integer or out of range");
+    } else if (argc != 4) {
+	return store_syntax();
+    }
+    if ((value = store_lookup_type(store, &argv[1], STORE_STREAM, &error)) == NULL)
+	return error ? error : store_reply_array(0);
+    stream = value->u.stream;
+
+    start = store_stream_seek(stream, startms, startseq);
+    if (endseq == UINT64_MAX && endms == UINT64_MAX)
+	end = stream->count;
+    else if (endseq == UINT64_MAX)
+	end = store_stream_seek(stream, endms + 1, 0);
+    else
+	end = store_stream_seek(stream, endms, endseq + 1);
+    if (end < start || store_id_compare(startms, startseq, endms, endseq) > 0)
+	end = start;
+    if (limit >= 0 && (size_t)limit < end - start) {
+	if (reverse)
+	    start = end - limit;
+	else
+	    end = start + limit;
+    }
+
+    if ((reply = store_reply_array(end - start)) == NULL)
+	return NULL;
+    for (i = 0; i < end - start; i++)
+	reply->element[count++] = store_entry_reply(
+			&stream->entries[reverse ? end - i - 1 : start + i]);
+    return store_reply_trim(reply, count);
+}
+
+static respReply *
+store_xlen(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    respReply		*error;
+
+    if ((value = store_lookup_type(store, &argv[1], STORE_STREAM, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    return store_reply_integer(value->u.stream->count - value->u.stream->first);
+}
+
+static respReply *
+store_xtrim(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeValue		*value;
+    storeStream		*stream;
+    respReply		*error;
+    __uint64_t		minms, minseq;
+    long long		maxlen;
+    size_t		live, upto;
+    int			i = 3, minid;
+
+    if (!(minid = store_arg_is(&argv[2], "MINID")) &&
+	!store_arg_is(&argv[2], "MAXLEN"))
+	return store_syntax();
+    if (argc > 4 && (store_arg_is(&argv[3], "~") || store_arg_is(&argv[3], "=")))
+	i++;
+    if (i + 1 != argc && !(i + 3 == argc && store_arg_is(&argv[i+1], "LIMIT")))
+	return store_syntax();	/* trimming is always exact here */
+    if (minid) {
+	if (store_stream_id(&argv[i], &minms, &minseq, NULL) < 0)
+	    return store_reply_error("ERR Invalid stream ID specified as stream command argument");
+    } else if (store_arg_ll(&argv[i], &maxlen) < 0 || maxlen < 0) {
+	return store_reply_error("ERR value is not an integer or out of range");
+    }
+    if ((value = store_lookup_type(store, &argv[1], STORE_STREAM, &error)) == NULL)
+	return error ? error : store_reply_integer(0);
+    stream = value->u.stream;
+
+    live = stream->count - stream->first;
+    if (minid)
+	upto = store_stream_seek(stream, minms, minseq);
+    else
+	upto = live > (size_t)maxlen ? stream->count - maxlen : stream->first;
+    store_stream_trim(stream, upto);
+    return store_reply_integer(live - (stream->count - stream->first));
+}
+
+/* sorted by name, for bsearch */
+static storeCommand commands[] = {
+    { "APPEND",		store_append,	3, 1 },
+    { "COMMAND",	store_command,	1, 0 },
+    { "DBSIZE",		store_dbsize,	1, 0 },
+    { "DEL",		store_del,	2, 1 },
+    { "EXISTS",		store_exists,	2, 0 },
+    { "EXPIRE",		store_expire,	3, 1 },
+    { "FLUSHALL",	store_flushall,	1, 1 },
+    { "FLUSHDB",	store_flushall,	1, 1 },
+    { "GEOADD",		store_geoadd,	5, 1 },
+    { "GET",		store_get,	2, 0 },
+    { "HGET",		store_hget,	3, 0 },
+    { "HGETALL",	store_hgetall,	2, 0 },
+    { "HKEYS",		store_hgetall,	2, 0 },
+    { "HLEN",		store_hlen,	2, 0 },
+    { "HMGET",		store_hmget,	3, 0 },
+    { "HMSET",		store_hset,	4, 1 },
+    { "HSCAN",		store_hscan,	3, 0 },
+    { "HSET",		store_hset,	4, 1 },
+    { "HVALS",		store_hgetall,	2, 0 },
+    { "INFO",		store_info,	1, 0 },
+    { "KEYS",		store_keys,	2, 0 },
+    { "PEXPIREAT",	store_expire,	3, 1 },
+    { "PING",		store_ping,	1, 0 },
+    { "PUBLISH",	store_publish,	3, 0 },
+    { "SADD",		store_sadd,	3, 1 },
+    { "SCAN",		store_scan,	2, 0 },
+    { "SCARD",		store_scard,	2, 0 },
+    { "SET",		store_set,	3, 1 },
+    { "SMEMBERS",	store_smembers,	2, 0 },
+    { "STRLEN",		store_strlen,	2, 0 },
+    { "XADD",		store_xadd,	5, 1 },
+    { "XLEN",		store_xlen,	2, 0 },
+    { "XRANGE",		store_xrange,	4, 0 },
+    { "XREVRANGE",	store_xrange,	4, 0 },
+    { "XTRIM",		store_xtrim,	4, 1 },
+    { "ZADD",		store_zadd,	4, 1 },
+    { "ZCARD",		store_zcard,	2, 0 },
+    { "ZRANGE",		store_zrank_range, 4, 0 },
+    { "ZRANGEBYSCORE",	store_zrange,	4, 0 },
+    { "ZREVRANGEBYSCORE", store_zrange,	4, 0 },
+};
+
+static int
+store_command_compare(const void *key, const void *entry)
+{
+    const storeArg	*arg = (const storeArg *)key;
+    const storeCommand	*command = (const storeCommand *)entry;
+    size_t		length = strlen(command->name);
+    int			sts;
+
+    sts = strncasecmp(arg->str, command->name,
+			arg->len < length ? arg->len : length);
+    if (sts == 0)
+	sts = (arg->len > length) - (arg->len < length);
+    return sts;
+}
+
+/*
+ * Split one RESP-encoded command (an array of bulk strings) into the
+ * argument vector.  Returns the bytes consumed, zero for an incomplete
+ * command or a negative error code.  Empty lines are skipped as by the
+ * server (the stream appends end with one), with an argument count of
+ * zero when nothing else remains.
+ */
+static ssize_t
+store_parse(struct keyStore *store, const char *buffer, size_t length, int *argcp)
+{
+    const char		*p = buffer, *end = buffer + length;
+    storeArg		*argv;
+    long long		count, size;
+    char		*endp;
+    int			i;
+
+    while (p < end && (*p == '\r' || *p == '\n'))
+	p++;
+    if (p == end) {
+	*argcp = 0;
+	return p - buffer;
+    }
+    if (*p++ != '*')
+	return -EPROTO;
+    count = strtoll(p, &endp, 10);
+    if (endp == p || count <= 0 || count > INT_MAX / 2)
+	return -EPROTO;
+    if (endp + 2 > end)
+	return 0;
+    p = endp + 2;	/* CRLF */
+
+    if (count > store->maxargs) {
+	if ((argv = realloc(store->argv, count * sizeof(storeArg))) == NULL)
+	    return -ENOMEM;
+	store->argv = argv;
+	store->maxargs = count;
+    }
+    for (i = 0; i < count; i++) {
+	if (p >= end)
+	    return 0;
+	if (*p++ != '$')
+	    return -EPROTO;
+	size = strtoll(p, &endp, 10);
+	if (endp == p || size < 0)
+	    return -EPROTO;
+	p = endp + 2;
+	if (p + size + 2 > end)
+	    return 0;
+	store->argv[i].str = p;
+	store->argv[i].len = size;
+	p += size + 2;
+    }
+    *argcp = count;
+    return p - buffer;
+}
+
+static void
+store_log(struct keyStore *store, int argc, storeArg *argv)
+{
+    int			i;
+
+    fprintf(store->log, "*%d\r\n", argc);
+    for (i = 0; i < argc; i++) {
+	fprintf(store->log, "$%zu\r\n", argv[i].len);
+	fwrite(argv[i].str, 1, argv[i].len, store->log);
+	fputs("\r\n", store->log);
+    }
+}
+
+static respReply *
+store_execute(struct keyStore *store, int argc, storeArg *argv)
+{
+    storeCommand	*command;
+    respReply		*reply;
+
+    command = bsearch(&argv[0], commands, sizeof(commands)/sizeof(commands[0]),
+			sizeof(storeCommand), store_command_compare);
+    if (command == NULL)
+	return store_reply_error("ERR unknown command '%.*s'",
+				(int)argv[0].len, argv[0].str);
+    if (argc < command->arity)
+	return store_reply_error("ERR wrong number of arguments for '%s' command",
+				command->name);
+    reply = command->func(store, argc, argv);
+    if (reply && reply->type != RESP_REPLY_ERROR &&
+	command->write && store->log && !store->replaying)
+	store_log(store, argc, argv);
+    return reply;
+}
+
+/*
+ * Persistence - write a compacted log of the current keyspace, as
+ * the commands that would recreate it.
+ */
+static void
+store_write_arg(FILE *fp, const char *str, size_t length)
+{
+    fprintf(fp, "$%zu\r\n", length);
+    fwrite(str, 1, length, fp);
+    fputs("\r\n", fp);
+}
+
+static void
+store_write_command(FILE *fp, const char *name, sds key, size_t args)
+{
+    fprintf(fp, "*%zu\r\n", args + 2);
+    store_write_arg(fp, name, strlen(name));
+    store_write_arg(fp, key, sdslen(key));
+}
+
+static void
+store_write_value(FILE *fp, sds key, storeValue *value)
+{
+    dictIterator	iterator;
+    dictEntry		*entry;
+    storeStream		*stream;
+    storeEntry		*sep;
+    storeMember		*mp;
+    unsigned int	j;
+    size_t		i;
+    char		buffer[64];
+    int			length;
+    sds			field;
+
+    switch (value->type) {
+    case STORE_STRING:
+	store_write_command(fp, "SET", key, 1);
+	store_write_arg(fp, value->u.string, sdslen(value->u.string));
+	break;
+
+    case STORE_HASH:
+    case STORE_SET:
+	if (value->type == STORE_HASH)
+	    store_write_command(fp, "HSET", key, dictSize(value->u.hash) * 2);
+	else
+	    store_write_command(fp, "SADD", key, dictSize(value->u.set));
+	dictInitIterator(&iterator, value->u.hash);
+	while ((entry = dictNext(&iterator)) != NULL) {
+	    field = (sds)dictGetKey(entry);
+	    store_write_arg(fp, field, sdslen(field));
+	    if (value->type == STORE_HASH) {
+		field = (sds)dictGetVal(entry);
+		store_write_arg(fp, field, sdslen(field));
+	    }
+	}
+	break;
+
+    case STORE_ZSET:
+	store_write_command(fp, "ZADD", key, value->u.zset->count * 2);
+	for (i = 0; i < value->u.zset->count; i++) {
+	    mp = &value->u.zset->members[i];
+	    length = pmsprintf(buffer, sizeof(buffer), "%.17g", mp->score);
+	    store_write_arg(fp, buffer, length);
+	    store_write_arg(fp, mp->member, sdslen(mp->member));
+	}
+	break;
+
+    case STORE_STREAM:
+	stream = value->u.stream;
+	for (i = stream->first; i < stream->count; i++) {
+	    sep = &stream->entries[i];
+	    store_write_command(fp, "XADD", key, sep->nfields + 1);
+	    length = pmsprintf(buffer, sizeof(buffer), "%llu-%llu",
+			(unsigned long long)sep->ms, (unsigned long long)sep->seq);
+	    store_write_arg(fp, buffer, length);
+	    for (j = 0; j < sep->nfields; j++)
+		store_write_arg(fp, sep->fields[j], sdslen(sep->fields[j]));
+	}
+	break;
+    }
+
+    if (value->expires) {
+	store_write_command(fp, "PEXPIREAT", key, 1);
+	length = pmsprintf(buffer, sizeof(buffer), "%lld", (long long)value->expires);
+	store_write_arg(fp, buffer, length);
+    }
+}
+
+static int
+store_compact(struct keyStore *store, sds *errmsg)
+{
+    dictIterator	iterator;
+    dictEntry		*entry;
+    storeValue		*value;
+    __int64_t		now = store_now();
+    FILE		*fp;
+    sds			tmp;
+    int			sts = 0;
+
+    tmp = sdscatfmt(sdsempty(), "%S.tmp", store->path);
+    if ((fp = fopen(tmp, "w")) == NULL) {
+	sts = -oserror();
+	infofmt(*errmsg, "cannot create %s: %s", tmp, pmErrStr(sts));
+	sdsfree(tmp);
+	return sts;
+    }
+    dictInitIterator(&iterator, store->keys);
+    while ((entry = dictNext(&iterator)) != NULL) {
+	value = (storeValue *)dictGetVal(entry);
+	if (value->expires && value->expires <= now)
+	    continue;
+	store_write_value(fp, (sds)dictGetKey(entry), value);
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+	sts = -oserror();
+	infofmt(*errmsg, "cannot write %s: %s", tmp, pmErrStr(sts));
+    }
+    fclose(fp);
+    if (sts == 0 && rename(tmp, store->path) < 0) {
+	sts = -oserror();
+	infofmt(*errmsg, "cannot rename %s: %s", tmp, pmErrStr(sts));
+    }
+    if (sts < 0)
+	unlink(tmp);
+    sdsfree(tmp);
+    return sts;
+}
+
+/*
+ * Replay a command log - the file is mapped and each command executed
+ * in turn; a trailing partial command (interrupted write) is ignored.
+ */
+static int
+store_replay(struct keyStore *store, sds *errmsg)
+{
+    struct stat		sbuf;
+    respReply		*reply;
+    ssize_t		bytes;
+    size_t		offset = 0;
+    char		*map;
+    int			fd, argc, sts = 0;
+
+    if ((fd = open(store->path, O_RDONLY)) < 0) {
+	if (oserror() == ENOENT)
+	    return 0;
+	sts = -oserror();
+	infofmt(*errmsg, "cannot open %s: %s", store->path, pmErrStr(sts));
+	return sts;
+    }
+    if (fstat(fd, &sbuf) < 0 || sbuf.st_size == 0) {
+	close(fd);
+	return 0;
+    }
+    map = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+	sts = -oserror();
+	infofmt(*errmsg, "cannot map %s: %s", store->path, pmErrStr(sts));
+	return sts;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, sbuf.st_size, MADV_SEQUENTIAL);
+#endif
+
+    store->replaying = 1;
+    while (offset < (size_t)sbuf.st_size) {
+	bytes = store_parse(store, map + offset, sbuf.st_size - offset, &argc);
+	if (bytes <= 0) {
+	    if (bytes < 0 || pmDebugOptions.series)
+		pmNotifyErr(LOG_WARNING, "%s: ignoring %s after offset %zu\n",
+			"keyStoreCreate", bytes < 0 ? "corrupt log" :
+			"partial command", offset);
+	    break;
+	}
+	offset += bytes;
+	if (argc == 0)
+	    continue;
+	reply = store_execute(store, argc, store->argv);
+	if (reply && reply->type == RESP_REPLY_ERROR && pmDebugOptions.series)
+	    fprintf(stderr, "%s: replay at offset %zu: %s\n",
+			"keyStoreCreate", offset, reply->str);
+	store_reply_free(reply);
+    }
+    store->replaying = 0;
+    munmap(map, sbuf.st_size);
+
+    if (pmDebugOptions.series)
+	fprintf(stderr, "%s: replayed %zu bytes from %s, %lu keys\n",
+		"keyStoreCreate", offset, store->path,
+		(unsigned long)dictSize(store->keys));
+    return sts;
+}
+
+/*
+ * Event loop integration - replies are delivered from an idle handle
+ * so that callbacks never run inside the request that caused them.
+ */
+static void
+store_release_all(struct keyStore *store)
+{
+    storeReply		*rp, *next;
+
+    for (rp = store->head; rp; rp = next) {
+	next = rp->next;
+	store_reply_free(rp->reply);
+	free(rp);
+    }
+    store->head = NULL;
+    store->tail = &store->head;
+
+    if (store->log) {
+	fclose(store->log);
+	store->log = NULL;
+    }
+    if (store->keys)
+	dictRelease(store->keys);
+    if (store->strings)
+	dictRelease(store->strings);
+    store->keys = store->strings = NULL;
+    sdsfree(store->path);
+    sdsfree(store->lookup);
+    sdsfree(store->scratch);
+    free(store->argv);
+    store->path = store->lookup = store->scratch = NULL;
+    store->argv = NULL;
+}
+
+static void
+store_close_callback(uv_handle_t *handle)
+{
+    struct keyStore	*store = (struct keyStore *)handle->data;
+
+    if (--store->closing == 0)
+	free(store);
+}
+
+static void
+store_close(struct keyStore *store)
+{
+    store_release_all(store);
+    store->closing = 2;
+    uv_close((uv_handle_t *)&store->idle, store_close_callback);
+    uv_close((uv_handle_t *)&store->timer, store_close_callback);
+}
+
+static void
+store_idle_callback(uv_idle_t *handle)
+{
+    struct keyStore	*store = (struct keyStore *)handle->data;
+    storeReply		*rp, *next;
+
+    /* detach the current batch - callbacks may queue further requests */
+    rp = store->head;
+    store->head = NULL;
+    store->tail = &store->head;
+
+    store->delivering = 1;
+    for (; rp; rp = next) {
+	next = rp->next;
+	if (!store->freed)
+	    rp->callback(NULL, rp->reply, rp->arg);
+	store_reply_free(rp->reply);
+	free(rp);
+    }
+    store->delivering = 0;
+
+    if (store->freed) {
+	store_close(store);
+	return;
+    }
+    if (store->head == NULL)
+	uv_idle_stop(&store->idle);
+    if (store->log)
+	fflush(store->log);
+}
+
+static void
+store_sweep_callback(uv_timer_t *handle)
+{
+    struct keyStore	*store = (struct keyStore *)handle->data;
+    dictIterator	iterator;
+    dictEntry		*entry;
+    storeValue		*value;
+    __int64_t		now = store_now();
+
+    dictInitIterator(&iterator, store->keys);
+    while ((entry = dictNext(&iterator)) != NULL) {
+	value = (storeValue *)dictGetVal(entry);
+	if (value->expires && value->expires <= now)
+	    dictDelete(store->keys, dictGetKey(entry));
+    }
+}
+
+struct keyStore *
+keyStoreCreate(void *events, const char *path, sds *errmsg)
+{
+    struct keyStore	*store;
+    int			sts;
+
+    if ((store = calloc(1, sizeof(struct keyStore))) == NULL) {
+	infofmt(*errmsg, "out-of-memory allocating key store");
+	return NULL;
+    }
+    store->tail = &store->head;
+    store->keys = dictCreate(&storeKeysCallBacks);
+    store->strings = dictCreate(&storeStringsCallBacks);
+    store->lookup = sdsempty();
+    store->scratch = sdsempty();
+    if (!store->keys || !store->strings || !store->lookup || !store->scratch) {
+	infofmt(*errmsg, "out-of-memory allocating key store");
+	goto fail;
+    }
+
+    if (path && *path) {
+	store->path = sdsnew(path);
+	if ((sts = store_replay(store, errmsg)) < 0 ||
+	    (sts = store_compact(store, errmsg)) < 0)
+	    goto fail;
+	if ((store->log = fopen(path, "a")) == NULL) {
+	    sts = -oserror();
+	    infofmt(*errmsg, "cannot append to %s: %s", path, pmErrStr(sts));
+	    goto fail;
+	}
+    }
+
+    uv_idle_init((uv_loop_t *)events, &store->idle);
+    store->idle.data = store;
+    uv_timer_init((uv_loop_t *)events, &store->timer);
+    store->timer.data = store;
+    uv_timer_start(&store->timer, store_sweep_callback,
+			STORE_SWEEP_MSEC, STORE_SWEEP_MSEC);
+    uv_unref((uv_handle_t *)&store->timer);
+    return store;
+
+fail:
+    store_release_all(store);
+    free(store);
+    return NULL;
+}
+
+void
+keyStoreFree(struct keyStore *store)
+{
+    if (store == NULL)
+	return;
+    if (store->delivering)	/* finish once the callbacks return */
+	store->freed = 1;
+    else
+	store_close(store);
+}
+
+/*
+ * Execute a RESP-encoded request (possibly several pipelined commands)
+ * and queue the reply for delivery to the callback from the event loop.
+ */
+int
+keyStoreRequest(struct keyStore *store, const char *cmd, size_t length,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    storeReply		*rp;
+    respReply		*reply = NULL;
+    ssize_t		bytes;
+    int			argc;
+
+    if (store->freed)
+	return -ENOTCONN;
+    while (length > 0) {
+	if ((bytes = store_parse(store, cmd, length, &argc)) <= 0) {
+	    store_reply_free(reply);
+	    return bytes < 0 ? bytes : -EPROTO;
+	}
+	cmd += bytes;
+	length -= bytes;
+	if (argc == 0)
+	    continue;
+	store_reply_free(reply);	/* only the last reply is returned */
+	if ((reply = store_execute(store, argc, store->argv)) == NULL)
+	    return -ENOMEM;
+    }
+    if (reply == NULL)
+	return -EINVAL;
+
+    if ((rp = malloc(sizeof(storeReply))) == NULL) {
+	store_reply_free(reply);
+	return -ENOMEM;
+    }
+    rp->callback = callback;
+    rp->arg = arg;
+    rp->reply = reply;
+    rp->next = NULL;
+    *store->tail = rp;
+    store->tail = &rp->next;
+    uv_idle_start(&store->idle, store_idle_callback);
+    return 0;
+}
+
+unsigned long
+keyStoreKeys(struct keyStore *store)
+{
+    return store && store->keys ? dictSize(store->keys) : 0;
+}
+
+#else /* !HAVE_LIBUV */
+
+struct keyStore *
+keyStoreCreate(void *events, const char *path, sds *errmsg)
+{
+    infofmt(*errmsg, "embedded key store requires libuv event loop support");
+    return NULL;
+}
+
+void
+keyStoreFree(struct keyStore *store)
+{
+    (void)store;
+}
+
+int
+keyStoreRequest(struct keyStore *store, const char *cmd, size_t length,
+		keyClusterCallbackFn *callback, void *arg)
+{
+    return -ENOTSUP;
+}
+
+unsigned long
+keyStoreKeys(struct keyStore *store)
+{
+    return 0;
+}
+
+#endif /* HAVE_LIBUV */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ */
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include "sds.h"
+#include "keys.h"
+
+/*
+ * Embedded in-process key store - an alternative to an external key
+ * server for single host and edge deployments, or for testing.  Keys
+ * are held in memory and the subset of RESP commands issued by this
+ * library is executed directly on each keySlotsRequest; replies are
+ * delivered from the event loop, as for a server connection.
+ *
+ * Optionally the store is made persistent by logging write commands
+ * to a file, which is replayed and compacted when next opened.
+ */
+struct keyStore;
+
+extern struct keyStore *keyStoreCreate(void *, const char *, sds *);
+extern void keyStoreFree(struct keyStore *);
+extern int keyStoreRequest(struct keyStore *, const char *, size_t,
+		keyClusterCallbackFn *, void *);
+extern unsigned long keyStoreKeys(struct keyStore *);
+
+#endif	/* SERIES_STORE_H */
@@ -22,6 +22,8 @@
 #include "maps.h"
 #include "util.h"
 #include "sha1.h"
+#include "chunks.h"
+#include "rollup.h"
 
 const char *SDS_NOINIT = "SDS_NOINIT";	/* back-compat, exported global */
 
@@ -181,6 +183,24 @@ value_precision(char *buf, int maxlen, int usedlen)
 }
 #endif
 
+/*
+ * Replace label sets returned from libpcp with the interned copy of
+ * the first set (all callers here ask for exactly one), such that it
+ * is shared with other contexts and has a stable identity for cached
+ * label merging.  Interned sets are released via pmwebapi_labelsetfree.
+ */
+static int
+labelset_intern(pmLabelSet **sets, int sts)
+{
+    pmLabelSet	*lp = *sets;
+
+    if (sts <= 0 || lp == NULL)
+	return sts;
+    *sets = __pmInternLabelSet(lp);
+    pmFreeLabelSets(lp, sts);
+    return *sets ? sts : -ENOMEM;
+}
+
 static int
 default_labelset(context_t *c, pmLabelSet **sets)
 {
@@ -191,13 +211,34 @@ default_labelset(context_t *c, pmLabelSet **sets)
     pmsprintf(buf, sizeof(buf), "{\"hostname\":\"%s\"}", c->host);
     if ((sts = __pmAddLabels(&lp, buf, PM_LABEL_CONTEXT)) > 0) {
 	*sets = lp;
-	return 0;
+	return labelset_intern(sets, 1) < 0 ? -ENOMEM : 0;
     }
     if (lp)
 	free(lp); /* Coverity CID340558 */
     return sts;
 }
 
+/*
+ * Merge interned label sets into the buffer via the libpcp cache of
+ * merged sets - most metrics and instances share the same upper level
+ * sets, so this avoids repeating the same merge for each one of them.
+ */
+static int
+labelsets_merge(pmLabelSet **sets, int nsets, char *buffer, int length)
+{
+    pmLabelSet	*merged;
+    int		sts;
+
+    if ((sts = __pmMergeInternedLabelSets(sets, nsets, &merged)) < 0)
+	return sts;
+    if (sts >= length)
+	sts = -E2BIG;
+    else if (sts > 0)
+	memcpy(buffer, merged->json, sts + 1);
+    __pmReleaseLabelSet(merged);
+    return sts;
+}
+
 int
 metric_labelsets(metric_t *metric, char *buffer, int length,
 	int (*filter)(const pmLabel *, const char *, void *), void *arg)
@@ -220,6 +261,8 @@ metric_labelsets(metric_t *metric, char *buffer, int length,
     if (metric && metric->labelset)
 	sets[nsets++] = metric->labelset;
 
+    if (filter == NULL && nsets > 0)
+	return labelsets_merge(sets, nsets, buffer, length);
     return pmMergeLabelSets(sets, nsets, buffer, length, filter, arg);
 }
 
@@ -241,6 +284,8 @@ instance_labelsets(indom_t *indom, instance_t *inst, char *buffer, int length,
     if (inst && inst->labelset)
 	sets[nsets++] = inst->labelset;
 
+    if (filter == NULL && nsets > 0)
+	return labelsets_merge(sets, nsets, buffer, length);
     return pmMergeLabelSets(sets, nsets, buffer, length, filter, arg);
 }
 
@@ -265,7 +310,11 @@ pmwebapi_source_meta(context_t *c, char *buffer, int length)
 	return sts;
     }
     c->host = sdsnew(host);
-    sts = pmGetContextLabels(set);
+    if (*set) {
+	pmwebapi_labelsetfree(*set);
+	*set = NULL;
+    }
+    sts = labelset_intern(set, pmGetContextLabels(set));
     if (sts == PM_ERR_IPC)
 	c->setup = 0;
     if (sts <= 0 && default_labelset(c, set) < 0)
@@ -670,7 +719,7 @@ pmwebapi_release_context(context_t *cp)
 
     sdsfree(cp->labels);
     if (cp->labelset)
-	pmFreeLabelSets(cp->labelset, 1);
+	pmwebapi_labelsetfree(cp->labelset);
 
     if (cp->metrics)	/* use the same value pointers as cp->pmids */
 	dictRelease(cp->metrics);	/* but, one entry per name */
@@ -709,7 +758,7 @@ void
 pmwebapi_free_domain(struct domain *domain)
 {
     if (domain->labelset)
-	pmFreeLabelSets(domain->labelset, 1);
+	pmwebapi_labelsetfree(domain->labelset);
     memset(domain, 0, sizeof(*domain));
     free(domain);
 }
@@ -744,7 +793,8 @@ pmwebapi_add_domain_labels(struct context *context, struct domain *domain)
     int			sts;
 
     if (domain->labelset == NULL) {
-	sts = pmGetDomainLabels(domain->domain, &domain->labelset);
+	sts = labelset_intern(&domain->labelset,
+		pmGetDomainLabels(domain->domain, &domain->labelset));
 	if (sts == PM_ERR_IPC)
 	    context->setup = 0;
 	if (sts < 0) {
@@ -761,7 +811,7 @@ void
 pmwebapi_free_cluster(struct cluster *cluster)
 {
     if (cluster->labelset)
-	pmFreeLabelSets(cluster->labelset, 1);
+	pmwebapi_labelsetfree(cluster->labelset);
     memset(cluster, 0, sizeof(*cluster));
     free(cluster);
 }
@@ -800,7 +850,8 @@ pmwebapi_add_cluster_labels(struct context *context, struct cluster *cluster)
     int			sts;
 
     if (cluster->labelset == NULL) {
-	sts = pmGetClusterLabels(cluster->cluster, &cluster->labelset);
+	sts = labelset_intern(&cluster->labelset,
+		pmGetClusterLabels(cluster->cluster, &cluster->labelset));
 	if (sts == PM_ERR_IPC)
 	    context->setup = 0;
 	if (sts < 0) {
@@ -823,7 +874,7 @@ pmwebapi_free_indom(indom_t *indom)
     sdsfree(indom->labels);
 
     if (indom->labelset)
-	pmFreeLabelSets(indom->labelset, 1);
+	pmwebapi_labelsetfree(indom->labelset);
 
     if (indom->insts) {
 	dictIterator iter;
@@ -871,29 +922,21 @@ labelsetlen(pmLabelSet *lp)
     return sizeof(pmLabelSet) + lp->jsonlen + (lp->nlabels * sizeof(pmLabel));
 }
 
+/*
+ * Label sets held by libpcp_web structures are interned (shared and
+ * reference counted) - so "duplicating" takes a reference on the one
+ * copy of the set, and it must be freed via pmwebapi_labelsetfree.
+ */
 pmLabelSet *
 pmwebapi_labelsetdup(pmLabelSet *lp)
 {
-    pmLabelSet		*dup;
-    char		*json;
+    return __pmInternLabelSet(lp);
+}
 
-    if ((dup = calloc(1, sizeof(pmLabelSet))) == NULL)
-	return NULL;
-    *dup = *lp;
-    if (lp->nlabels <= 0)
-	return dup;
-    if ((json = strdup(lp->json)) == NULL) {
-	free(dup);
-	return NULL;
-    }
-    if ((dup->labels = calloc(lp->nlabels, sizeof(pmLabel))) == NULL) {
-	free(dup);
-	free(json);
-	return NULL;
-    }
-    memcpy(dup->labels, lp->labels, sizeof(pmLabel) * lp->nlabels);
-    dup->json = json;
-    return dup;
+void
+pmwebapi_labelsetfree(pmLabelSet *lp)
+{
+    __pmReleaseLabelSet(lp);
 }
 
 void
@@ -906,7 +949,8 @@ pmwebapi_add_instances_labels(struct context *context, struct indom *indom)
     int			i, inst, sts = 0, nsets = 0;
 
     if (indom->labelset == NULL) {
-	sts = pmGetInDomLabels(indom->indom, &indom->labelset);
+	sts = labelset_intern(&indom->labelset,
+		pmGetInDomLabels(indom->indom, &indom->labelset));
 	if (sts == PM_ERR_IPC)
 	    context->setup = 0;
 	if (sts < 0) {
@@ -940,7 +984,7 @@ pmwebapi_add_instances_labels(struct context *context, struct indom *indom)
 		continue;
 	    }
 	    if (instance->labelset)
-		pmFreeLabelSets(instance->labelset, 1);
+		pmwebapi_labelsetfree(instance->labelset);
 	    instance->labelset = labels;
 
 	    pmwebapi_instance_hash(indom, instance);
@@ -975,7 +1019,7 @@ pmwebapi_free_instance(instance_t *instance)
     sdsfree(instance->labels);
 
     if (instance->labelset)
-	pmFreeLabelSets(instance->labelset, 1);
+	pmwebapi_labelsetfree(instance->labelset);
 
     while (list) {
 	sdsfree(list->name);
@@ -1113,7 +1157,7 @@ pmwebapi_free_metric(metric_t *metric)
     sdsfree(metric->labels);
 
     if (metric->labelset)
-	pmFreeLabelSets(metric->labelset, 1);
+	pmwebapi_labelsetfree(metric->labelset);
 
     while (list) {
 	sdsfree(list->name);
@@ -1136,6 +1180,11 @@ pmwebapi_free_metric(metric_t *metric)
 	free(metric->u.vlist);
     }
 
+    if (metric->chunk)
+	seriesChunkFree(metric->chunk);
+    if (metric->rollups)
+	seriesRollupFree(metric->rollups);
+
     memset(metric, 0, sizeof(*metric));
     free(metric);
 }
@@ -1278,7 +1327,8 @@ pmwebapi_add_item_labels(struct context *context, struct metric *metric)
     int			sts;
 
     if (metric->labelset == NULL) {
-	sts = pmGetItemLabels(metric->desc.pmid, &metric->labelset);
+	sts = labelset_intern(&metric->labelset,
+		pmGetItemLabels(metric->desc.pmid, &metric->labelset));
 	if (sts == PM_ERR_IPC)
 	    context->setup = 0;
 	if (sts < 0) {
@@ -38,6 +38,7 @@ extern int instance_labelsets(struct indom *, struct instance *,
 		void *type);
 
 extern pmLabelSet *pmwebapi_labelsetdup(pmLabelSet *);
+extern void pmwebapi_labelsetfree(pmLabelSet *);
 
 extern const char *pmwebapi_indom_str(struct metric *, char *, int);
 extern const char *pmwebapi_pmid_str(struct metric *, char *, int);
@@ -1909,8 +1909,14 @@ webgroup_scrape(pmWebGroupSettings *settings, context_t *cp,
 			e = dictFind(indom->insts, &value->inst);
 			instance = e ? (struct instance *)dictGetVal(e) : NULL;
 		    }
-		    if (instance == NULL)
-			continue;
+		    if (instance == NULL) {
+			/* found an instance not in existing indom cache */
+			indom->updated = 0;	/* invalidate this cache */
+			if ((instance = pmwebapi_lookup_instance(indom, value->inst)))
+			    pmwebapi_add_instances_labels(cp, indom);
+			else
+			    continue;
+		    }
 		    v = webgroup_encode_value(v, type, &value->atom);
 		    series = pmwebapi_hash_sds(series, instance->name.hash);
 		    scrape.value.series = series;
@@ -28,6 +28,7 @@ GroupControl::GroupControl(bool restrictArchives) :
     my.timeState = StartState;
     my.buttonState = QedTimeButton::Timeless;
     my.pmtimeState = QmcTime::StoppedState;
+    my.fetchOwed = false;
     memset(&my.delta, 0, sizeof(struct timeval));
     memset(&my.position, 0, sizeof(struct timeval));
 }
@@ -264,6 +265,8 @@ GroupControl::setupWorldView(void)
 void
 GroupControl::adjustWorldView(QmcTime::Packet *packet, bool vcrMode)
 {
+    settleFetch();
+
     my.delta = packet->delta;
     my.position = packet->position;
     my.realDelta = pmtimevalToReal(&packet->delta);
@@ -527,6 +530,8 @@ GroupControl::step(QmcTime::Packet *packet)
 {
     double stepPosition = pmtimevalToReal(&packet->position);
 
+    settleFetch();
+
     console->post(PmChart::DebugProtocol,
 	"GroupControl::step: stepping to time %.2f, delta=%.2f, state=%s",
 	stepPosition, my.realDelta, timeState());
@@ -555,12 +560,42 @@ GroupControl::step(QmcTime::Packet *packet)
 	my.timeData.push_back(my.realPosition - torange(my.delta, last));
     }
 
-    fetch();
+    // Fetch without blocking the UI, the gadgets are updated once all
+    // of the new values have arrived (in fetched() below).
+    my.fetchOwed = true;
+    my.fetchActive = isActive(packet);
+    my.fetchState = packet->state;
+    my.fetchMode = packet->mode;
+    fetchAsync(this, "fetched");
+}
 
-    bool active = isActive(packet);
-    if (isActive(packet))
-	newButtonState(packet->state, packet->mode, pmchart->isTabRecording());
-    refreshGadgets(active);
+void
+GroupControl::fetched(int generation)
+{
+    if (fetchComplete(generation) && my.fetchOwed)
+	refreshFetched();
+}
+
+void
+GroupControl::refreshFetched()
+{
+    my.fetchOwed = false;
+    if (my.fetchActive)
+	newButtonState(my.fetchState, my.fetchMode, pmchart->isTabRecording());
+    refreshGadgets(my.fetchActive);
+}
+
+//
+// If the values for the last step() are still arriving, wait for them
+// and finish that step before time moves on again.
+//
+void
+GroupControl::settleFetch()
+{
+    if (my.fetchOwed) {
+	fetchWait();
+	refreshFetched();
+    }
 }
 
 void
@@ -67,6 +67,9 @@ public Q_SLOTS:
     void timeSelectionReactive(Gadget *, int);
     void timeSelectionInactive(Gadget *);
 
+private Q_SLOTS:
+    void fetched(int);
+
 private:
     typedef enum {
 	StartState,
@@ -78,6 +81,8 @@ private:
 
     char *timeState();
     void refreshGadgets(bool);
+    void refreshFetched();
+    void settleFetch();
     bool isActive(QmcTime::Packet *);
     void adjustWorldView(QmcTime::Packet *, bool);
     void adjustLiveWorldViewForward(QmcTime::Packet *);
@@ -102,6 +107,11 @@ private:
 	QmcTime::Source pmtimeSource;	// reliable archive/host test
 	QmcTime::State pmtimeState;
 	State timeState;
+
+	bool fetchOwed;			// step() awaiting its refreshGadgets
+	bool fetchActive;		// step() state for fetched() to use
+	QmcTime::State fetchState;
+	QmcTime::Mode fetchMode;
     } my;
 };
 
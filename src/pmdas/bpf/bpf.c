@@ -385,10 +385,19 @@ bpf_fetch(int numpmid, pmID pmidlist[], pmdaResult **resp, pmdaExt *pmda)
 {
     module* target;
     int cache_result;
+    int j;
 
     for(int i = 0; i < numpmid; i++) {
         unsigned int cluster_id = pmID_cluster(pmidlist[i]);
         unsigned int item = pmID_item(pmidlist[i]);
+
+        // refresh each module only once per fetch, as it may harvest whole maps
+        for (j = 0; j < i; j++)
+            if (pmID_cluster(pmidlist[j]) == cluster_id)
+                break;
+        if (j < i)
+            continue;
+
         cache_result = pmdaCacheLookup(clusters, cluster_id, NULL, (void**)&target);
         if (cache_result == PMDA_CACHE_ACTIVE) {
             target->refresh(item);
@@ -9,20 +9,26 @@ pmdaInstid biolatency_instances[NUM_LATENCY_SLOTS];
 
 struct biolatency_bpf *bpf_obj;
 int biolatency_fd = -1;
+map_snapshot biolatency_map = { .fd = -1 };
+hist_cache biolatency_hist;
 #define INDOM_COUNT 1
 #define BIOLATENCY_INDOM 0
 unsigned int indom_id_mapping[INDOM_COUNT];
 
-#define METRIC_COUNT 1
+#define METRIC_COUNT 2
 char* metric_names[METRIC_COUNT] = {
-	"disk.all.latency"
+	"disk.all.latency",
+    "disk.all.map_syscalls"
 };
 
 char* metric_text_oneline[METRIC_COUNT] = {
-    "Disk latency"
+    "Disk latency",
+    "bpf() calls made reading the histogram map"
 };
 char* metric_text_long[METRIC_COUNT] = {
-    "Disk latency histogram across all disks, for both reads and writes.\n"
+    "Disk latency histogram across all disks, for both reads and writes.\n",
+    "Number of bpf() system calls needed to read the latency histogram map\n"
+    "for the most recent fetch.\n"
 };
 
 unsigned int biolatency_metric_count()
@@ -72,6 +78,18 @@ void biolatency_register(unsigned int cluster_id, pmdaMetric *metrics, pmdaIndom
             }
         };
 
+    /* bpf.disk.all.map_syscalls */
+    metrics[1] = (struct pmdaMetric)
+        { /* m_user */ NULL,
+            { /* m_desc */
+                PMDA_PMID(cluster_id, 1),
+                PM_TYPE_U32,
+                PM_INDOM_NULL,
+                PM_SEM_INSTANT,
+                PMDA_PMUNITS(0, 0, 1, 0, 0, PM_COUNT_ONE)
+            }
+        };
+
     indoms[0] = (struct pmdaIndom)
         {
             indom_id_mapping[BIOLATENCY_INDOM],
@@ -110,6 +128,14 @@ int biolatency_init(dict *cfg, char *module_name)
         return biolatency_fd;
     }
 
+    ret = map_snapshot_init(&biolatency_map, biolatency_fd);
+    if (ret == 0)
+        ret = hist_cache_init(&biolatency_hist, NUM_LATENCY_SLOTS);
+    if (ret != 0) {
+        pmNotifyErr(LOG_ERR, "bpf map buffers: %s", strerror(-ret));
+        return ret;
+    }
+
     fill_instids_log2(NUM_LATENCY_SLOTS, biolatency_instances);
 
     return 0;
@@ -124,33 +150,36 @@ void biolatency_shutdown()
     if (bpf_obj) {
         biolatency_bpf__destroy(bpf_obj);
     }
+    map_snapshot_free(&biolatency_map);
+    hist_cache_free(&biolatency_hist);
 }
 
 void biolatency_refresh(unsigned int item)
 {
-    /* do nothing */
+    if (biolatency_fd == -1) {
+        // not initialised
+        return;
+    }
+
+    if (map_snapshot_refresh(&biolatency_map) >= 0) {
+        hist_cache_fill(&biolatency_hist, &biolatency_map);
+    }
 }
 
 int biolatency_fetch_to_atom(unsigned int item, unsigned int inst, pmAtomValue *atom)
 {
-    if (inst == PM_IN_NULL) {
-        return PM_ERR_INST;
-    }
-
     if (biolatency_fd == -1) {
         // not initialised
         return PMDA_FETCH_NOVALUES;
     }
 
-    unsigned long key = inst;
-    unsigned long value = 0;
-    int ret = bpf_map_lookup_elem(biolatency_fd, &key, &value);
-    if (ret == -1) {
-        return PMDA_FETCH_NOVALUES;
+    /* bpf.disk.all.map_syscalls */
+    if (item == 1) {
+        atom->ul = biolatency_map.syscalls;
+        return PMDA_FETCH_STATIC;
     }
 
-    atom->ull = value;
-    return PMDA_FETCH_STATIC;
+    return hist_cache_fetch(&biolatency_hist, inst, atom);
 }
 
 struct module bpf_module = {
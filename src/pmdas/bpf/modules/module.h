@@ -4,6 +4,9 @@
 #include <pcp/pmapi.h>
 #include <pcp/pmda.h>
 #include <math.h>
+#include <errno.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
 #include "dict.h"
 #include "sds.h"
 
@@ -79,8 +82,9 @@ typedef struct module {
     /**
      * Pre-fetch refresh call issued by PMCD.
      *
-     * This is a good time to refresh indom table, or load any metrics that are more
-     * efficiently fetched in bulk.
+     * Called once per fetch for a module with metrics in the request, with item
+     * being the first of those.  This is a good time to refresh indom table, or
+     * load any metrics that are more efficiently fetched in bulk.
      */
     refresh_fn_t refresh;
 
@@ -169,4 +173,296 @@ void fill_instids(unsigned int slot_count, pmdaInstid **slots) {
     }
 }
 
+/**
+ * Snapshot of all entries of a BPF map, harvested once per fetch.
+ *
+ * Entries are read up to MAP_BATCH_ENTRIES per bpf() call with
+ * BPF_MAP_LOOKUP_BATCH, into buffers reused from one fetch to the next.
+ * Kernels (or map types) without batch support fall back to iterating
+ * key by key.  Values of per-CPU maps are summed across CPUs, so these
+ * must consist solely of 64-bit counters.
+ *
+ * After map_snapshot_refresh() the entries are sorted by key, for lookup
+ * with map_snapshot_lookup(); syscalls holds the number of bpf() calls
+ * that harvest needed.
+ */
+#define MAP_BATCH_ENTRIES 256
+
+#ifndef ENOTSUPP
+#define ENOTSUPP 524	/* kernel internal, but returned for missing map ops */
+#endif
+
+typedef struct map_entry {
+    const void *key;
+    const void *value;
+    __u32 key_size;
+} map_entry;
+
+typedef struct map_snapshot {
+    int fd;
+    __u32 key_size;
+    __u32 value_size;		/* size of one value, after per-CPU summing */
+    __u32 cpu_stride;		/* size of each CPU's value, 0 if not per-CPU */
+    __u32 ncpus;
+    int nobatch;		/* batch lookups are not supported */
+    unsigned int syscalls;	/* bpf() calls made by the latest refresh */
+    __u32 count;
+    __u32 capacity;
+    char *keys;
+    char *values;
+    map_entry *entries;		/* sorted by key */
+    char *batch_keys;		/* one batch, as returned by the kernel */
+    char *batch_values;
+    char *token;		/* opaque batch position */
+} map_snapshot;
+
+int map_snapshot_init(map_snapshot *snap, int fd)
+{
+    struct bpf_map_info info;
+    __u32 len = sizeof(info);
+    size_t raw_size, token_size;
+    int ncpus;
+
+    memset(snap, 0, sizeof(*snap));
+    memset(&info, 0, sizeof(info));
+    if (bpf_obj_get_info_by_fd(fd, &info, &len) != 0)
+        return -errno;
+
+    snap->fd = fd;
+    snap->key_size = info.key_size;
+    snap->value_size = info.value_size;
+    snap->ncpus = 1;
+    raw_size = info.value_size;
+
+    switch (info.type) {
+        case BPF_MAP_TYPE_PERCPU_HASH:
+        case BPF_MAP_TYPE_PERCPU_ARRAY:
+        case BPF_MAP_TYPE_LRU_PERCPU_HASH:
+            if (info.value_size % sizeof(__u64) != 0)
+                return -EINVAL;
+            if ((ncpus = libbpf_num_possible_cpus()) < 0)
+                return ncpus;
+            snap->ncpus = ncpus;
+            snap->cpu_stride = info.value_size;
+            raw_size = (size_t)info.value_size * ncpus;
+            break;
+        default:
+            break;
+    }
+
+    token_size = info.key_size > sizeof(__u64) ? info.key_size : sizeof(__u64);
+    snap->batch_keys = calloc(MAP_BATCH_ENTRIES, info.key_size);
+    snap->batch_values = calloc(MAP_BATCH_ENTRIES, raw_size);
+    snap->token = calloc(1, token_size);
+    if (!snap->batch_keys || !snap->batch_values || !snap->token)
+        return -ENOMEM;
+    return 0;
+}
+
+void map_snapshot_free(map_snapshot *snap)
+{
+    free(snap->keys);
+    free(snap->values);
+    free(snap->entries);
+    free(snap->batch_keys);
+    free(snap->batch_values);
+    free(snap->token);
+    memset(snap, 0, sizeof(*snap));
+    snap->fd = -1;
+}
+
+static int map_snapshot_add(map_snapshot *snap, const char *key, const char *raw)
+{
+    __u32 i, cpu, capacity;
+    __u64 *sum;
+    void *p;
+
+    if (snap->count == snap->capacity) {
+        capacity = snap->capacity ? snap->capacity * 2 : MAP_BATCH_ENTRIES;
+        if ((p = realloc(snap->keys, (size_t)capacity * snap->key_size)) == NULL)
+            return -ENOMEM;
+        snap->keys = p;
+        if ((p = realloc(snap->values, (size_t)capacity * snap->value_size)) == NULL)
+            return -ENOMEM;
+        snap->values = p;
+        if ((p = realloc(snap->entries, (size_t)capacity * sizeof(map_entry))) == NULL)
+            return -ENOMEM;
+        snap->entries = p;
+        snap->capacity = capacity;
+    }
+
+    memcpy(snap->keys + (size_t)snap->count * snap->key_size, key, snap->key_size);
+    if (snap->cpu_stride == 0) {
+        memcpy(snap->values + (size_t)snap->count * snap->value_size, raw, snap->value_size);
+    } else {
+        sum = (__u64 *)(snap->values + (size_t)snap->count * snap->value_size);
+        memset(sum, 0, snap->value_size);
+        for (cpu = 0; cpu < snap->ncpus; cpu++, raw += snap->cpu_stride)
+            for (i = 0; i < snap->value_size / sizeof(__u64); i++)
+                sum[i] += ((const __u64 *)raw)[i];
+    }
+    snap->count++;
+    return 0;
+}
+
+/* Key by key, two bpf() calls per entry - for kernels without batching */
+static int map_snapshot_iterate(map_snapshot *snap)
+{
+    char *key = snap->batch_keys, *next = snap->batch_keys + snap->key_size;
+    void *prev = NULL;
+    int sts;
+
+    while (snap->syscalls++, bpf_map_get_next_key(snap->fd, prev, next) == 0) {
+        memcpy(key, next, snap->key_size);
+        prev = key;
+        snap->syscalls++;
+        if (bpf_map_lookup_elem(snap->fd, key, snap->batch_values) != 0)
+            continue;	/* deleted since */
+        if ((sts = map_snapshot_add(snap, key, snap->batch_values)) < 0)
+            return sts;
+    }
+    return errno == ENOENT ? 0 : -errno;
+}
+
+static int map_snapshot_batch(map_snapshot *snap)
+{
+    size_t raw_size = snap->cpu_stride ? (size_t)snap->cpu_stride * snap->ncpus : snap->value_size;
+    void *in = NULL;
+    __u32 i, n;
+    int sts, done;
+
+    do {
+        n = MAP_BATCH_ENTRIES;
+        sts = bpf_map_lookup_batch(snap->fd, in, snap->token,
+                                   snap->batch_keys, snap->batch_values, &n, NULL);
+        snap->syscalls++;
+        if (sts != 0 && errno != ENOENT)
+            return -errno;
+        done = (sts != 0);
+        for (i = 0; i < n; i++) {
+            if ((sts = map_snapshot_add(snap, snap->batch_keys + i * snap->key_size,
+                                        snap->batch_values + i * raw_size)) < 0)
+                return sts;
+        }
+        in = snap->token;
+    } while (!done);
+    return 0;
+}
+
+static int map_entry_compare(const void *a, const void *b)
+{
+    const map_entry *ea = a, *eb = b;
+
+    return memcmp(ea->key, eb->key, ea->key_size);
+}
+
+/**
+ * Harvest the current map contents, replacing the previous snapshot.
+ *
+ * Returns the number of entries, or a negative errno.
+ */
+int map_snapshot_refresh(map_snapshot *snap)
+{
+    __u32 i;
+    int sts = -EINVAL;
+
+    snap->count = 0;
+    snap->syscalls = 0;
+    if (snap->fd < 0)
+        return sts;
+
+    if (!snap->nobatch) {
+        sts = map_snapshot_batch(snap);
+        if (sts == -EINVAL || sts == -ENOTSUPP || sts == -EOPNOTSUPP) {
+            /* no batch ops for this kernel or map type */
+            snap->nobatch = 1;
+            snap->count = 0;
+        } else if (sts == -ENOSPC) {
+            /* a hash bucket larger than one batch - walk it instead */
+            snap->count = 0;
+        }
+    }
+    if (snap->nobatch || sts == -ENOSPC)
+        sts = map_snapshot_iterate(snap);
+    if (sts < 0)
+        return sts;
+
+    for (i = 0; i < snap->count; i++) {
+        snap->entries[i].key = snap->keys + (size_t)i * snap->key_size;
+        snap->entries[i].value = snap->values + (size_t)i * snap->value_size;
+        snap->entries[i].key_size = snap->key_size;
+    }
+    qsort(snap->entries, snap->count, sizeof(map_entry), map_entry_compare);
+    return snap->count;
+}
+
+/**
+ * Value for the given key in the latest snapshot, or NULL if not present.
+ */
+const void *map_snapshot_lookup(const map_snapshot *snap, const void *key)
+{
+    map_entry probe = { key, NULL, snap->key_size };
+    map_entry *entry;
+
+    entry = bsearch(&probe, snap->entries, snap->count, sizeof(map_entry), map_entry_compare);
+    return entry ? entry->value : NULL;
+}
+
+/**
+ * Histogram slots, as keyed by slot number in a map of 64-bit counts,
+ * cached as one value per instance from the latest map snapshot.
+ */
+typedef struct hist_cache {
+    unsigned int nslots;
+    __u64 *slots;
+    char *present;
+} hist_cache;
+
+int hist_cache_init(hist_cache *hist, unsigned int nslots)
+{
+    hist->nslots = nslots;
+    hist->slots = calloc(nslots, sizeof(__u64));
+    hist->present = calloc(nslots, sizeof(char));
+    return (hist->slots && hist->present) ? 0 : -ENOMEM;
+}
+
+void hist_cache_free(hist_cache *hist)
+{
+    free(hist->slots);
+    free(hist->present);
+    memset(hist, 0, sizeof(*hist));
+}
+
+void hist_cache_fill(hist_cache *hist, const map_snapshot *snap)
+{
+    __u64 slot;
+    __u32 i;
+
+    memset(hist->present, 0, hist->nslots);
+    for (i = 0; i < snap->count; i++) {
+        const map_entry *entry = &snap->entries[i];
+
+        if (snap->key_size == sizeof(__u32))
+            slot = *(const __u32 *)entry->key;
+        else if (snap->key_size == sizeof(__u64))
+            slot = *(const __u64 *)entry->key;
+        else
+            continue;
+        if (slot >= hist->nslots || snap->value_size != sizeof(__u64))
+            continue;
+        hist->slots[slot] = *(const __u64 *)entry->value;
+        hist->present[slot] = 1;
+    }
+}
+
+int hist_cache_fetch(const hist_cache *hist, unsigned int inst, pmAtomValue *atom)
+{
+    if (inst == PM_IN_NULL)
+        return PM_ERR_INST;
+    if (inst >= hist->nslots || !hist->present[inst])
+        return PMDA_FETCH_NOVALUES;
+    atom->ull = hist->slots[inst];
+    return PMDA_FETCH_STATIC;
+}
+
 #endif
@@ -25,6 +25,7 @@ static struct env {
 
 int tgid_map_fd;
 int nr_cpus;
+static map_snapshot tgid_map = { .fd = -1 };
 
 static pmdaInstid *netatop_instances;
 // /usr/src/kernels/.M.m-b-r.kn.x86_64/tools/lib/bpf/libbpf.c
@@ -34,9 +35,10 @@ static pmdaIndom *netatop_indoms;
 static unsigned int indom_id_mapping[INDOM_COUNT];
 
 
-#define METRIC_COUNT 8
+#define METRIC_COUNT 9
 enum metric_name { TCPSNDPACKS, TCPSNDBYTES, TCPRCVPACKS, TCPRCVBYTES, 
-		   UDPSNDPACKS, UDPSNDBYTES, UDPRCVPACKS, UDPRCVBYTES };
+		   UDPSNDPACKS, UDPSNDBYTES, UDPRCVPACKS, UDPRCVBYTES,
+		   MAPSYSCALLS };
 enum metric_indom { NETATOP_INDOM };
 
 
@@ -49,6 +51,7 @@ char* metric_names[METRIC_COUNT] = {
     [UDPSNDBYTES] = "proc.net.udp.send.bytes",
     [UDPRCVPACKS] = "proc.net.udp.recv.packets",
     [UDPRCVBYTES] = "proc.net.udp.recv.bytes",
+    [MAPSYSCALLS] = "proc.net.map_syscalls",
 };
 
 char* metric_text_oneline[METRIC_COUNT] = {
@@ -59,7 +62,8 @@ char* metric_text_oneline[METRIC_COUNT] = {
     [UDPSNDPACKS] = "udp packets sent",
     [UDPSNDBYTES] = "udp bytes sent",
     [UDPRCVPACKS] = "udp packets received",
-    [UDPRCVBYTES] = "udp bytes received"
+    [UDPRCVBYTES] = "udp bytes received",
+    [MAPSYSCALLS] = "bpf() calls made reading the per-process map"
 };
 
 char* metric_text_long[METRIC_COUNT] = {
@@ -70,7 +74,9 @@ char* metric_text_long[METRIC_COUNT] = {
     [UDPSNDPACKS] = "udp packets sent (tracepoint/sock/sock_send_length)",
     [UDPSNDBYTES] = "udp bytes sent (tracepoint/sock/sock_send_length)",
     [UDPRCVPACKS] = "udp packets received (tracepoint/sock/sock_recv_length)",
-    [UDPRCVBYTES] = "udp bytes received (tracepoint/sock/sock_recv_length)"
+    [UDPRCVBYTES] = "udp bytes received (tracepoint/sock/sock_recv_length)",
+    [MAPSYSCALLS] = "Number of bpf() system calls needed to read the per-process network\n"
+                    "statistics map for the most recent fetch.\n"
 };
 
 static unsigned int netatop_metric_count(void)
@@ -196,6 +202,17 @@ static void netatop_register(unsigned int cluster_id, pmdaMetric *metrics, pmdaI
             .units = PMDA_PMUNITS(1, 0, PM_SPACE_BYTE, 0, 0, 0),
         }
     };
+    /* proc.net.map_syscalls */
+    metrics[MAPSYSCALLS] = (struct pmdaMetric)
+    {
+        .m_desc = {
+            .pmid  = PMDA_PMID(cluster_id, 8),
+            .type  = PM_TYPE_U32,
+            .indom = PM_INDOM_NULL,
+            .sem   = PM_SEM_INSTANT,
+            .units = PMDA_PMUNITS(0, 0, 1, 0, 0, PM_COUNT_ONE),
+        }
+    };
 
     indoms[NETATOP_INDOM] = (struct pmdaIndom)
     {
@@ -291,6 +308,11 @@ int netatop_init(dict *cfg, char *module_name)
         pmNotifyErr(LOG_ERR, "failed to get map fd: %s", strerror(errno));
         return true;
     }
+    err = map_snapshot_init(&tgid_map, tgid_map_fd);
+    if (err) {
+        pmNotifyErr(LOG_ERR, "failed to setup map buffers: %s", strerror(-err));
+        return true;
+    }
     return err;
 }
 
@@ -298,114 +320,73 @@ int netatop_init(dict *cfg, char *module_name)
 static void netatop_shutdown()
 {
     free(netatop_instances);
+    map_snapshot_free(&tgid_map);
 
     netatop_bpf__destroy(obj);
 }
 
-/* Set instance ids to tids present in bpf map */
+/* Harvest the bpf map, and set instance ids to tids present in it */
 
 static void netatop_refresh(unsigned int item)
 {
-     unsigned long cur_key = 1;
-
-    if (item == 0) {
-	 int map_entry_n = 0;
-	 netatop_fill_instids(env.process_count, &netatop_instances);
-         for (int ret = bpf_map_get_next_key(tgid_map_fd, NULL, &cur_key);
-              ret == 0;
-              ret = bpf_map_get_next_key (tgid_map_fd, &cur_key, &cur_key)) {
-//	     if (kill(cur_key, 0) && errno == ESRCH) 
-//		  bpf_map_delete_elem(tgid_map_fd, &cur_key);
-	     netatop_add_instids (env.process_count, cur_key, &netatop_instances);
-	     map_entry_n += 1;
-	 }
-	 netatop_indoms[NETATOP_INDOM].it_numinst = map_entry_n;
+    int map_entry_n = 0;
+
+    if (map_snapshot_refresh(&tgid_map) < 0)
+        return;
+
+    netatop_fill_instids(env.process_count, &netatop_instances);
+    for (__u32 i = 0; i < tgid_map.count; i++) {
+        unsigned long long tid = *(const unsigned long long *)tgid_map.entries[i].key;
+
+        if (netatop_add_instids(env.process_count, tid, &netatop_instances))
+            map_entry_n += 1;
     }
+    netatop_indoms[NETATOP_INDOM].it_numinst = map_entry_n;
 }
 
-/* Get network metrics from bpf for a particular metric for a particular tid */
+/* Get network metrics from the harvested map for a particular tid */
 
 static int netatop_fetch_to_atom(unsigned int item, unsigned int inst, pmAtomValue *atom)
 {
-    nr_cpus = libbpf_num_possible_cpus();
-    struct taskcount *value = (struct taskcount*)calloc(nr_cpus, sizeof(struct taskcount));
-    unsigned long next_key = inst;
-
-    if (bpf_map_lookup_elem(tgid_map_fd, &next_key, value) == 0) {
-	struct taskcount data = {
-	    .tcpsndpacks = 0,
-	    .tcpsndbytes = 0,
-	    .tcprcvpacks = 0,
-	    .tcprcvbytes = 0,
-	    .udpsndpacks = 0,
-	    .udpsndbytes = 0,
-	    .udprcvpacks = 0,
-	    .udprcvbytes = 0,
-	};
-
-        for (int i = 0; i < nr_cpus; i++) {
-            data.tcpsndpacks += value[i].tcpsndpacks;
-            data.tcpsndbytes += value[i].tcpsndbytes;
-            data.tcprcvpacks += value[i].tcprcvpacks;
-            data.tcprcvbytes += value[i].tcprcvbytes;
-            data.udpsndpacks += value[i].udpsndpacks;
-            data.udpsndbytes += value[i].udpsndbytes;
-            data.udprcvpacks += value[i].udprcvpacks;
-            data.udprcvbytes += value[i].udprcvbytes;
-        } 
-	netatop_add_instids(env.process_count, next_key, &netatop_instances);
+    const struct taskcount *data;
+    unsigned long long key = inst;
+
+    /* proc.net.map_syscalls */
+    if (item == MAPSYSCALLS) {
+        atom->ul = tgid_map.syscalls;
+        return PMDA_FETCH_STATIC;
     }
 
-    unsigned long long netvalue = 0;
+    if ((data = map_snapshot_lookup(&tgid_map, &key)) == NULL)
+        return PMDA_FETCH_NOVALUES;
+
     switch (item) {
     case TCPSNDPACKS:
-        for (int i = 0; i < nr_cpus; i++) {
-            netvalue += value[i].tcpsndpacks;
-        } 
-        atom->ull = netvalue;
-	break;
+        atom->ull = data->tcpsndpacks;
+        break;
     case TCPSNDBYTES:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].tcpsndbytes;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->tcpsndbytes;
+        break;
     case TCPRCVPACKS:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].tcprcvpacks;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->tcprcvpacks;
+        break;
     case TCPRCVBYTES:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].tcprcvbytes;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->tcprcvbytes;
+        break;
     case UDPSNDPACKS:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].udpsndpacks;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->udpsndpacks;
+        break;
     case UDPSNDBYTES:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].udpsndbytes;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->udpsndbytes;
+        break;
     case UDPRCVPACKS:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].udprcvpacks;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->udprcvpacks;
+        break;
     case UDPRCVBYTES:
-	for (int i = 0; i < nr_cpus; i++) {
-	    netvalue += value[i].udprcvbytes;
-	}
-	atom->ull = netvalue;
-	break;
+        atom->ull = data->udprcvbytes;
+        break;
+    default:
+        return PM_ERR_PMID;
     }
 
     return PMDA_FETCH_STATIC;
@@ -9,25 +9,31 @@ pmdaInstid runqlat_instances[NUM_LATENCY_SLOTS];
 
 struct runqlat_bpf *bpf_obj;
 int runqlat_fd = -1;
+map_snapshot runqlat_map = { .fd = -1 };
+hist_cache runqlat_hist;
 #define INDOM_COUNT 1
 #define RUNQLAT_INDOM 0
 unsigned int indom_id_mapping[INDOM_COUNT];
 
-#define METRIC_COUNT 1
+#define METRIC_COUNT 2
 char* metric_names[METRIC_COUNT] = {
-    "runq.latency"
+    "runq.latency",
+    "runq.map_syscalls"
 };
 
 char* metric_text_oneline[METRIC_COUNT] = {
-    "Run queue latency (ns)"
+    "Run queue latency (ns)",
+    "bpf() calls made reading the histogram map"
 };
 char* metric_text_long[METRIC_COUNT] = {
-    "Run queue latency from task switches,\nie: how long each task sat in queue from entry to queue until executing.\n"
+    "Run queue latency from task switches,\nie: how long each task sat in queue from entry to queue until executing.\n",
+    "Number of bpf() system calls needed to read the latency histogram map\n"
+    "for the most recent fetch.\n"
 };
 
 unsigned int runqlat_metric_count()
 {
-    return 1;
+    return METRIC_COUNT;
 }
 
 char* runqlat_metric_name(unsigned int metric)
@@ -72,6 +78,18 @@ void runqlat_register(unsigned int cluster_id, pmdaMetric *metrics, pmdaIndom *i
             }
         };
 
+    /* bpf.runq.map_syscalls */
+    metrics[1] = (struct pmdaMetric)
+        { /* m_user */ NULL,
+            { /* m_desc */
+                PMDA_PMID(cluster_id, 1),
+                PM_TYPE_U32,
+                PM_INDOM_NULL,
+                PM_SEM_INSTANT,
+                PMDA_PMUNITS(0, 0, 1, 0, 0, PM_COUNT_ONE)
+            }
+        };
+
     indoms[0] = (struct pmdaIndom)
         {
             indom_id_mapping[RUNQLAT_INDOM],
@@ -110,6 +128,14 @@ int runqlat_init(dict *cfg, char *module_name)
         return runqlat_fd;
     }
 
+    ret = map_snapshot_init(&runqlat_map, runqlat_fd);
+    if (ret == 0)
+        ret = hist_cache_init(&runqlat_hist, NUM_LATENCY_SLOTS);
+    if (ret != 0) {
+        pmNotifyErr(LOG_ERR, "bpf map buffers: %s", strerror(-ret));
+        return ret;
+    }
+
     fill_instids_log2(NUM_LATENCY_SLOTS, runqlat_instances);
 
     return 0;
@@ -124,33 +150,36 @@ void runqlat_shutdown()
     if (bpf_obj) {
         runqlat_bpf__destroy(bpf_obj);
     }
+    map_snapshot_free(&runqlat_map);
+    hist_cache_free(&runqlat_hist);
 }
 
 void runqlat_refresh(unsigned int item)
 {
-    /* do nothing */
+    if (runqlat_fd == -1) {
+        // not initialised
+        return;
+    }
+
+    if (map_snapshot_refresh(&runqlat_map) >= 0) {
+        hist_cache_fill(&runqlat_hist, &runqlat_map);
+    }
 }
 
 int runqlat_fetch_to_atom(unsigned int item, unsigned int inst, pmAtomValue *atom)
 {
-    if (inst == PM_IN_NULL) {
-        return PM_ERR_INST;
-    }
-
     if (runqlat_fd == -1) {
         // not initialised
         return PMDA_FETCH_NOVALUES;
     }
 
-    unsigned long key = inst;
-    unsigned long value = 0;
-    int ret = bpf_map_lookup_elem(runqlat_fd, &key, &value);
-    if (ret == -1) {
-        return PMDA_FETCH_NOVALUES;
+    /* bpf.runq.map_syscalls */
+    if (item == 1) {
+        atom->ul = runqlat_map.syscalls;
+        return PMDA_FETCH_STATIC;
     }
 
-    atom->ull = value;
-    return PMDA_FETCH_STATIC;
+    return hist_cache_fetch(&runqlat_hist, inst, atom);
 }
 
 struct module bpf_module = {
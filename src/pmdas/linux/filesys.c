@@ -23,14 +23,15 @@ scan_filesys_options(const char *options, const char *option)
 {
     static char buffer[128];
     char *s;
+    char *saveptr;
 
     pmstrncpy(buffer, sizeof(buffer), options);
 
-    s = strtok(buffer, ",");
+    s = strtok_r(buffer, ",", &saveptr);
     while (s) {
 	if (strcmp(s, option) == 0)
 	    return s;
-        s = strtok(NULL, ",");
+        s = strtok_r(NULL, ",", &saveptr);
     }
     return NULL;
 }
@@ -180,6 +181,7 @@ refresh_filesys(pmInDom filesys_indom, pmInDom tmpfs_indom,
     pmInDom		indom;
     FILE		*fp;
     char		*path, *device, *type, *options;
+    char		*saveptr;
     char		*devname;
     char		link[MAXPATHLEN];
     ssize_t		len;
@@ -198,12 +200,12 @@ refresh_filesys(pmInDom filesys_indom, pmInDom tmpfs_indom,
 	return -oserror();
 
     while (fgets(buf, sizeof(buf), fp) != NULL) {
-	if ((device = strtok(buf, " ")) == 0)
+	if ((device = strtok_r(buf, " ", &saveptr)) == 0)
 	    continue;
 
-	path = strtok(NULL, " ");
-	type = strtok(NULL, " ");
-	options = strtok(NULL, " ");
+	path = strtok_r(NULL, " ", &saveptr);
+	type = strtok_r(NULL, " ", &saveptr);
+	options = strtok_r(NULL, " ", &saveptr);
 	if (strcmp(type, "proc") == 0 ||
 	    strcmp(type, "nfs") == 0 ||
 	    strcmp(type, "devfs") == 0 ||
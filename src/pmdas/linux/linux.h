@@ -119,6 +119,7 @@ enum {
 	CLUSTER_NUMA_HUGEPAGES,	/* 95 /sys/devices/system/node/nodeN/hugepages metrics */
 	CLUSTER_NFS4_SVR_CLIENTS,	/* 96 /proc/fs/nfsd/clients/<client>/info metrics */
 	CLUSTER_NFS4_SVR_OPENS,	/* 97 /proc/fs/nfsd/clients/<client>/states metrics */
+	CLUSTER_REFRESH,	/* 98 refresh coalescing control and statistics */
 
 	NUM_CLUSTERS		/* one more than highest numbered cluster */
 };
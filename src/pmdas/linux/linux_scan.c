@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+#include <fcntl.h>
+#include "linux.h"
+#include "linux_scan.h"
+
+int
+linux_scanfile(const char *path, linux_scanbuf_t *sb)
+{
+    char	name[MAXPATHLEN], *p;
+    size_t	size;
+    ssize_t	n;
+
+    /* in test mode we replace procfs files (keeping fd open thwarts that) */
+    if (sb->fd >= 0 && (linux_test_mode & LINUX_TEST_STATSPATH)) {
+	close(sb->fd);
+	sb->fd = -1;
+    }
+    if (sb->fd < 0) {
+	pmsprintf(name, sizeof(name), "%s%s", linux_statspath, path);
+	if ((sb->fd = open(name, O_RDONLY)) < 0)
+	    return -oserror();
+    }
+
+    sb->length = 0;
+    for (;;) {
+	if (sb->length + 1 >= sb->size) {
+	    size = sb->size ? sb->size * 2 : 4096;
+	    if ((p = (char *)realloc(sb->buf, size)) == NULL) {
+		n = -ENOMEM;
+		goto done;
+	    }
+	    sb->buf = p;
+	    sb->size = size;
+	}
+	n = pread(sb->fd, sb->buf + sb->length,
+			sb->size - sb->length - 1, sb->length);
+	if (n < 0) {
+	    n = -oserror();
+	    goto done;
+	}
+	if (n == 0)
+	    break;
+	sb->length += n;
+    }
+    sb->buf[sb->length] = '\0';
+    n = sb->length;
+
+done:
+    if (!sb->keepopen || n < 0) {
+	close(sb->fd);
+	sb->fd = -1;
+    }
+    return n;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+#ifndef LINUX_SCAN_H
+#define LINUX_SCAN_H
+
+/*
+ * Whole-file reads into a reusable buffer, and a minimal tokenizer for
+ * the hot /proc files (stat, interrupts, softirqs, meminfo, vmstat and
+ * net/dev).  On large machines these files run to megabytes per fetch
+ * and sscanf/strtoul per field dominate the refresh cost - the helpers
+ * below parse in place, without allocation or format interpretation.
+ */
+typedef struct {
+    char	*buf;		/* file contents, null-terminated */
+    size_t	length;		/* bytes in the last read */
+    size_t	size;		/* allocated buffer size */
+    int		fd;		/* descriptor, if kept open */
+    int		keepopen;	/* reuse fd across refreshes */
+} linux_scanbuf_t;
+
+#define LINUX_SCANBUF_INIT(keepopen)	{ NULL, 0, 0, -1, (keepopen) }
+
+/*
+ * Read the given file (relative to linux_statspath) into the buffer,
+ * growing it as needed.  Returns the length read or a negative errno.
+ * Descriptors are never kept open in QA mode, where files are replaced.
+ */
+extern int linux_scanfile(const char *, linux_scanbuf_t *);
+
+/*
+ * Null-terminate the line at p, returning the start of the next line
+ * (or NULL at end of buffer).
+ */
+static inline char *
+linux_scan_line(char *p)
+{
+    char	*end;
+
+    if ((end = strchr(p, '\n')) == NULL)
+	return NULL;
+    *end = '\0';
+    return end + 1;
+}
+
+static inline char *
+linux_scan_space(char *p)
+{
+    while (*p == ' ' || *p == '\t')
+	p++;
+    return p;
+}
+
+/*
+ * Parse an unsigned decimal value after any spaces or tabs (never
+ * crossing a line end), returning the first unparsed character or
+ * NULL if there were no digits.
+ */
+static inline char *
+linux_scan_ull(char *p, unsigned long long *value)
+{
+    unsigned long long	v = 0;
+    unsigned int	d;
+    char		*s;
+
+    s = p = linux_scan_space(p);
+    while ((d = (unsigned char)*p - '0') < 10) {
+	v = v * 10 + d;
+	p++;
+    }
+    if (p == s)
+	return NULL;
+    *value = v;
+    return p;
+}
+
+/*
+ * Write value as decimal digits at p, returning the end (not terminated).
+ */
+static inline char *
+linux_scan_putul(char *p, unsigned long value)
+{
+    char	digits[24], *d = digits;
+
+    do {
+	*d++ = '0' + (value % 10);
+	value /= 10;
+    } while (value);
+    while (d > digits)
+	*p++ = *--d;
+    return p;
+}
+
+#endif /* LINUX_SCAN_H */
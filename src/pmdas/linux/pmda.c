@@ -24,6 +24,7 @@
  */
 #include "linux.h"
 #undef LINUX /* defined in NSS/NSPR headers as something different, which we do not need. */
+#include "libpcp.h"
 #include "domain.h"
 
 #include <ctype.h>
@@ -33,6 +34,7 @@
 #include <sys/utsname.h>
 #include <pwd.h>
 #include <grp.h>
+#include <pthread.h>
 
 #include "filesys.h"
 #include "getinfo.h"
@@ -120,6 +122,11 @@ static int		rootfd = -1;	/* af_unix pmdaroot */
 static int		all_access;	/* =1 no access checks */
 static int		hz;
 
+static unsigned int	refresh_interval;	/* msec, zero: no coalescing */
+static __uint64_t	refresh_count;		/* cluster refreshes done */
+static __uint64_t	refresh_hits;		/* cluster refreshes shared */
+static struct timespec	refresh_stamp[NUM_REFRESHES];
+
 /* globals */
 int _pm_pageshift; /* for hinv.pagesize and for pages -> bytes */
 int _pm_ncpus; /* maximum number of processors configurable */
@@ -2788,6 +2795,21 @@ static pmdaMetric metrictab[] = {
     { PMDA_PMID(CLUSTER_KERNEL_UNAME, 7), PM_TYPE_STRING, PM_INDOM_NULL, PM_SEM_DISCRETE, 
     PMDA_PMUNITS(0,0,0,0,0,0) } },
 
+/* pmda.refresh.interval */
+  { &refresh_interval,
+    { PMDA_PMID(CLUSTER_REFRESH, 0), PM_TYPE_U32, PM_INDOM_NULL, PM_SEM_DISCRETE,
+    PMDA_PMUNITS(0,1,0,0,PM_TIME_MSEC,0) } },
+
+/* pmda.refresh.count */
+  { &refresh_count,
+    { PMDA_PMID(CLUSTER_REFRESH, 1), PM_TYPE_U64, PM_INDOM_NULL, PM_SEM_COUNTER,
+    PMDA_PMUNITS(0,0,1,0,0,PM_COUNT_ONE) } },
+
+/* pmda.refresh.hits */
+  { &refresh_hits,
+    { PMDA_PMID(CLUSTER_REFRESH, 2), PM_TYPE_U64, PM_INDOM_NULL, PM_SEM_COUNTER,
+    PMDA_PMUNITS(0,0,1,0,0,PM_COUNT_ONE) } },
+
 /*
  * network snmp cluster
  */
@@ -7686,6 +7708,444 @@ linux_ctx_container(int ctx)
     return NULL;
 }
 
+/*
+ * Clusters whose refresh routines read their own files into their own
+ * structures are refreshed as jobs, spread across a small pool of threads
+ * (kept from one fetch to the next) whenever a fetch needs several of
+ * them.  Meanwhile the calling
+ * thread refreshes the remaining clusters (those switching namespaces or
+ * checking per-client access), then joins in with the jobs.  The indom
+ * cache routines are not thread-safe, so only one job at a time may use
+ * them (and none while the calling thread is busy with its own clusters);
+ * a job may also name an earlier job which must complete before it runs.
+ * Any parser that can run alongside another must tokenise with strtok_r(3)
+ * as the strtok(3) position is shared by every thread in the process.
+ * Container contexts are always refreshed serially, as setns(2) cannot
+ * switch mount namespaces in a multi-threaded process.
+ */
+enum {
+    JOB_STAT,
+    JOB_CPUINFO,
+    JOB_MEMINFO,
+    JOB_NUMA_MEMINFO,
+    JOB_LOADAVG,
+    JOB_NET_NFS,
+    JOB_INTERRUPTS,
+    JOB_SOFTIRQS,
+    JOB_SWAPDEV,
+    JOB_SCSI,
+    JOB_SEM_LIMITS,
+    JOB_MSG_LIMITS,
+    JOB_SHM_INFO,
+    JOB_SEM_INFO,
+    JOB_MSG_INFO,
+    JOB_SHM_LIMITS,
+    JOB_UPTIME,
+    JOB_UTMP,
+    JOB_VFS,
+    JOB_LOCKS,
+    JOB_SYS_KERNEL,
+    JOB_VMSTAT,
+    JOB_SYSFS_KERNEL,
+    JOB_NET_SOFTNET,
+    JOB_SHM_STAT,
+    JOB_MSG_STAT,
+    JOB_SEM_STAT,
+    JOB_BUDDYINFO,
+    JOB_ZONEINFO,
+    JOB_KSM_INFO,
+    JOB_TAPEDEV,
+    JOB_PRESSURE,
+    JOB_FCHOST,
+    JOB_HUGEPAGES,
+    JOB_NUMA_HUGEPAGES,
+    JOB_NFS4_SVR_CLIENTS,
+    JOB_NFS4_SVR_OPENS,
+
+    NUM_JOBS
+};
+
+typedef struct {
+    int		clusters[4];	/* need_refresh[] entries, -1 terminated */
+    int		after;		/* job to complete beforehand, or -1 */
+    int		caches;		/* job uses the indom caches */
+} refresh_job_t;
+
+static const refresh_job_t refresh_jobs[NUM_JOBS] = {
+    [JOB_STAT] = { { CLUSTER_STAT, -1 }, -1, 1 },
+    [JOB_CPUINFO] = { { CLUSTER_CPUINFO, -1 }, JOB_STAT, 1 },
+    [JOB_MEMINFO] = { { CLUSTER_MEMINFO, -1 }, -1, 0 },
+    [JOB_NUMA_MEMINFO] = { { CLUSTER_NUMA_MEMINFO, -1 }, JOB_STAT, 1 },
+    [JOB_LOADAVG] = { { CLUSTER_LOADAVG, -1 }, -1, 0 },
+    [JOB_NET_NFS] = { { CLUSTER_NET_NFS, -1 }, -1, 0 },
+    [JOB_INTERRUPTS] = { { CLUSTER_INTERRUPTS, -1 }, -1, 1 },
+    [JOB_SOFTIRQS] = { { CLUSTER_SOFTIRQS, CLUSTER_SOFTIRQS_TOTAL, -1 }, -1, 1 },
+    [JOB_SWAPDEV] = { { CLUSTER_SWAPDEV, -1 }, -1, 1 },
+    [JOB_SCSI] = { { CLUSTER_SCSI, -1 }, -1, 1 },
+    [JOB_SEM_LIMITS] = { { CLUSTER_SEM_LIMITS, -1 }, -1, 0 },
+    [JOB_MSG_LIMITS] = { { CLUSTER_MSG_LIMITS, -1 }, -1, 0 },
+    [JOB_SHM_INFO] = { { CLUSTER_SHM_INFO, -1 }, -1, 0 },
+    [JOB_SEM_INFO] = { { CLUSTER_SEM_INFO, -1 }, -1, 0 },
+    [JOB_MSG_INFO] = { { CLUSTER_MSG_INFO, -1 }, -1, 0 },
+    [JOB_SHM_LIMITS] = { { CLUSTER_SHM_LIMITS, -1 }, -1, 0 },
+    [JOB_UPTIME] = { { CLUSTER_UPTIME, -1 }, -1, 0 },
+    [JOB_UTMP] = { { CLUSTER_UTMP, -1 }, -1, 0 },
+    [JOB_VFS] = { { CLUSTER_VFS, -1 }, -1, 0 },
+    [JOB_LOCKS] = { { CLUSTER_LOCKS, -1 }, -1, 0 },
+    [JOB_SYS_KERNEL] = { { CLUSTER_SYS_KERNEL, -1 }, -1, 0 },
+    [JOB_VMSTAT] = { { CLUSTER_VMSTAT, -1 }, -1, 0 },
+    [JOB_SYSFS_KERNEL] = { { CLUSTER_SYSFS_KERNEL, -1 }, JOB_STAT, 1 },
+    [JOB_NET_SOFTNET] = { { CLUSTER_NET_SOFTNET, -1 }, JOB_STAT, 1 },
+    [JOB_SHM_STAT] = { { CLUSTER_SHM_STAT, -1 }, -1, 1 },
+    [JOB_MSG_STAT] = { { CLUSTER_MSG_STAT, -1 }, -1, 1 },
+    [JOB_SEM_STAT] = { { CLUSTER_SEM_STAT, -1 }, -1, 1 },
+    [JOB_BUDDYINFO] = { { CLUSTER_BUDDYINFO, -1 }, -1, 0 },
+    [JOB_ZONEINFO] = { { CLUSTER_ZONEINFO, CLUSTER_ZONEINFO_PROTECTION, -1 }, -1, 1 },
+    [JOB_KSM_INFO] = { { CLUSTER_KSM_INFO, -1 }, -1, 0 },
+    [JOB_TAPEDEV] = { { CLUSTER_TAPEDEV, -1 }, -1, 1 },
+    [JOB_PRESSURE] = { { CLUSTER_PRESSURE_CPU, CLUSTER_PRESSURE_MEM,
+			 CLUSTER_PRESSURE_IO, CLUSTER_PRESSURE_IRQ }, -1, 0 },
+    [JOB_FCHOST] = { { CLUSTER_FCHOST, -1 }, -1, 1 },
+    [JOB_HUGEPAGES] = { { CLUSTER_HUGEPAGES, -1 }, -1, 1 },
+    [JOB_NUMA_HUGEPAGES] = { { CLUSTER_NUMA_HUGEPAGES, -1 }, -1, 1 },
+    [JOB_NFS4_SVR_CLIENTS] = { { CLUSTER_NFS4_SVR_CLIENTS, -1 }, -1, 1 },
+    [JOB_NFS4_SVR_OPENS] = { { CLUSTER_NFS4_SVR_OPENS, -1 }, -1, 1 },
+};
+
+enum { JOB_IDLE, JOB_QUEUED, JOB_RUNNING, JOB_DONE };
+
+static int		refresh_threads = -1;	/* less than two: no threads */
+static pthread_mutex_t	refresh_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	refresh_cond = PTHREAD_COND_INITIALIZER;
+static __pmWorkPool	*refresh_pool;
+static int		refresh_nworkers;	/* threads used this fetch */
+static int		refresh_state[NUM_JOBS];
+static int		refresh_caches_busy;	/* indom caches in use */
+static int		*refresh_need;		/* need_refresh of this fetch */
+
+static void
+refresh_job(int job, int *need_refresh)
+{
+    switch (job) {
+    case JOB_STAT:
+	refresh_proc_stat(&proc_stat);
+	break;
+    case JOB_CPUINFO:
+	refresh_proc_cpuinfo();
+	break;
+    case JOB_MEMINFO:
+	refresh_proc_meminfo(&proc_meminfo);
+	break;
+    case JOB_NUMA_MEMINFO:
+	refresh_numa_meminfo();
+	break;
+    case JOB_LOADAVG:
+	refresh_proc_loadavg(&proc_loadavg);
+	break;
+    case JOB_NET_NFS:
+	refresh_proc_net_rpc(&proc_net_rpc);
+	refresh_proc_fs_nfsd(&proc_fs_nfsd);
+	break;
+    case JOB_INTERRUPTS:
+	refresh_proc_interrupts();
+	break;
+    case JOB_SOFTIRQS:
+	refresh_proc_softirqs();
+	break;
+    case JOB_SWAPDEV:
+	refresh_swapdev(INDOM(SWAPDEV_INDOM));
+	break;
+    case JOB_SCSI:
+	refresh_proc_scsi(INDOM(SCSI_INDOM));
+	break;
+    case JOB_SEM_LIMITS:
+	refresh_sem_limits(&sem_limits);
+	break;
+    case JOB_MSG_LIMITS:
+	refresh_msg_limits(&msg_limits);
+	break;
+    case JOB_SHM_INFO:
+	refresh_shm_info(&shm_info);
+	break;
+    case JOB_SEM_INFO:
+	refresh_sem_info(&sem_info);
+	break;
+    case JOB_MSG_INFO:
+	refresh_msg_info(&msg_info);
+	break;
+    case JOB_SHM_LIMITS:
+	refresh_shm_limits(&shm_limits);
+	break;
+    case JOB_UPTIME:
+	refresh_proc_uptime(&proc_uptime);
+	break;
+    case JOB_UTMP:
+	refresh_login_info(&login_info);
+	break;
+    case JOB_VFS:
+	refresh_proc_sys_fs(&proc_sys_fs);
+	break;
+    case JOB_LOCKS:
+	refresh_proc_locks(&proc_locks);
+	break;
+    case JOB_SYS_KERNEL:
+	refresh_proc_sys_kernel(&proc_sys_kernel);
+	break;
+    case JOB_VMSTAT:
+	refresh_proc_vmstat(&_pm_proc_vmstat);
+	break;
+    case JOB_SYSFS_KERNEL:
+	refresh_sysfs_kernel(&sysfs_kernel, need_refresh);
+	break;
+    case JOB_NET_SOFTNET:
+	refresh_proc_net_softnet(&proc_net_softnet);
+	break;
+    case JOB_SHM_STAT:
+	refresh_shm_stat(INDOM(IPC_STAT_INDOM));
+	break;
+    case JOB_MSG_STAT:
+	refresh_msg_queue(INDOM(IPC_MSG_INDOM));
+	break;
+    case JOB_SEM_STAT:
+	refresh_sem_array(INDOM(IPC_SEM_INDOM));
+	break;
+    case JOB_BUDDYINFO:
+	refresh_proc_buddyinfo(&proc_buddyinfo);
+	break;
+    case JOB_ZONEINFO:
+	refresh_proc_zoneinfo(INDOM(ZONEINFO_INDOM),
+			      INDOM(ZONEINFO_PROTECTION_INDOM));
+	break;
+    case JOB_KSM_INFO:
+	refresh_ksm_info(&ksm_info);
+	break;
+    case JOB_TAPEDEV:
+	refresh_sysfs_tapestats(INDOM(TAPEDEV_INDOM));
+	break;
+    case JOB_PRESSURE:	/* one job, as these share a format buffer */
+	if (need_refresh[CLUSTER_PRESSURE_CPU])
+	    refresh_proc_pressure_cpu(&proc_pressure);
+	if (need_refresh[CLUSTER_PRESSURE_MEM])
+	    refresh_proc_pressure_mem(&proc_pressure);
+	if (need_refresh[CLUSTER_PRESSURE_IO])
+	    refresh_proc_pressure_io(&proc_pressure);
+	if (need_refresh[CLUSTER_PRESSURE_IRQ])
+	    refresh_proc_pressure_irq(&proc_pressure);
+	break;
+    case JOB_FCHOST:
+	refresh_sysfs_fchosts(INDOM(FCHOST_INDOM));
+	break;
+    case JOB_HUGEPAGES:
+	refresh_sysfs_hugepages(INDOM(HUGEPAGES_INDOM));
+	break;
+    case JOB_NUMA_HUGEPAGES:
+	refresh_sysfs_numa_hugepages(INDOM(NUMA_HUGEPAGES_INDOM));
+	break;
+    case JOB_NFS4_SVR_CLIENTS:
+	refresh_nfs4_svr_client(INDOM(NFS4_SVR_CLIENT_INDOM));
+	break;
+    case JOB_NFS4_SVR_OPENS:
+	refresh_nfs4_svr_client_opens(INDOM(NFS4_SVR_CLIENT_OPENS_INDOM));
+	break;
+    }
+}
+
+/*
+ * Pick the next queued job that can run now, waiting for a job it must
+ * follow or for the indom caches when necessary.  Returns -1 once none
+ * remain queued.  Called with refresh_lock held.
+ */
+static int
+refresh_job_next(void)
+{
+    int		job, after, queued;
+
+    for (;;) {
+	for (job = queued = 0; job < NUM_JOBS; job++) {
+	    if (refresh_state[job] != JOB_QUEUED)
+		continue;
+	    queued++;
+	    after = refresh_jobs[job].after;
+	    if (after >= 0 && (refresh_state[after] == JOB_QUEUED ||
+			       refresh_state[after] == JOB_RUNNING))
+		continue;
+	    if (refresh_jobs[job].caches && refresh_caches_busy)
+		continue;
+	    if (refresh_jobs[job].caches)
+		refresh_caches_busy = 1;
+	    refresh_state[job] = JOB_RUNNING;
+	    return job;
+	}
+	if (queued == 0)
+	    return -1;
+	pthread_cond_wait(&refresh_cond, &refresh_lock);
+    }
+}
+
+static void *
+refresh_worker(void *arg)
+{
+    int		job;
+
+    (void)arg;
+    pthread_mutex_lock(&refresh_lock);
+    while ((job = refresh_job_next()) >= 0) {
+	pthread_mutex_unlock(&refresh_lock);
+	refresh_job(job, refresh_need);
+	pthread_mutex_lock(&refresh_lock);
+	if (refresh_jobs[job].caches)
+	    refresh_caches_busy = 0;
+	refresh_state[job] = JOB_DONE;
+	pthread_cond_broadcast(&refresh_cond);
+    }
+    pthread_mutex_unlock(&refresh_lock);
+    return NULL;
+}
+
+static void
+refresh_task(void *arg, int i)
+{
+    (void)i;
+    refresh_worker(arg);
+}
+
+/*
+ * Queue the jobs needed by this fetch, and set the pool threads working
+ * on them if there are several; the indom caches are held for the caller
+ * until linux_refresh_jobs_finish().
+ */
+static void
+linux_refresh_jobs_start(int *need_refresh, linux_container_t *cp)
+{
+    int		i, job, njobs = 0, nthreads = refresh_threads;
+
+    for (job = 0; job < NUM_JOBS; job++) {
+	refresh_state[job] = JOB_IDLE;
+	for (i = 0; i < 4 && refresh_jobs[job].clusters[i] >= 0; i++) {
+	    if (need_refresh[refresh_jobs[job].clusters[i]]) {
+		refresh_state[job] = JOB_QUEUED;
+		njobs++;
+		break;
+	    }
+	}
+    }
+    refresh_need = need_refresh;
+    refresh_caches_busy = 1;
+    refresh_nworkers = 0;
+
+    if (nthreads < 2 || njobs < 2 || cp != NULL)
+	return;
+    if (nthreads > njobs)
+	nthreads = njobs;
+    if (refresh_pool == NULL && (refresh_pool = __pmWorkPoolCreate()) == NULL)
+	return;
+    refresh_nworkers = __pmWorkPoolStart(refresh_pool, nthreads, refresh_task, NULL);
+}
+
+/*
+ * Release the indom caches to the workers, then run any jobs remaining
+ * (all of them, without workers) in this thread and wait for completion.
+ */
+static void
+linux_refresh_jobs_finish(void)
+{
+    pthread_mutex_lock(&refresh_lock);
+    refresh_caches_busy = 0;
+    pthread_cond_broadcast(&refresh_cond);
+    pthread_mutex_unlock(&refresh_lock);
+
+    refresh_worker(NULL);
+    if (refresh_nworkers)
+	__pmWorkPoolWait(refresh_pool);
+
+    if (pmDebugOptions.libpmda && refresh_nworkers)
+	fprintf(stderr, "%s: %d threads\n", "linux_refresh", refresh_nworkers);
+    refresh_nworkers = 0;
+}
+
+/*
+ * Entries of need_refresh[] passed to the same refresh routine, which
+ * are refreshed or coalesced together - refresh_proc_partitions would
+ * mark every disk indom inactive if the wwid or zram flag was kept but
+ * the diskstats flag dropped, for example.  Each job forms a group too.
+ */
+static const int refresh_routines[][16] = {
+    { CLUSTER_PARTITIONS, CLUSTER_WWID, CLUSTER_ZRAM_DEVICES,
+      REFRESH_PROC_DISKSTATS, REFRESH_PROC_PARTITIONS, -1 },
+    { CLUSTER_FILESYS, CLUSTER_TMPFS, -1 },
+    { CLUSTER_NET_DEV, CLUSTER_NET_ADDR,
+      REFRESH_NET_MTU, REFRESH_NET_TYPE, REFRESH_NET_SPEED,
+      REFRESH_NET_DUPLEX, REFRESH_NET_LINKUP, REFRESH_NET_RUNNING,
+      REFRESH_NET_WIRELESS, REFRESH_NET_VIRTUAL,
+      REFRESH_NETADDR_INET, REFRESH_NETADDR_IPV6, REFRESH_NETADDR_HW, -1 },
+    { CLUSTER_SYSFS_KERNEL, REFRESH_SYSFS_KERNEL_UEVENTSEQ,
+      REFRESH_SYSFS_KERNEL_EXTFRAG, REFRESH_SYSFS_MODULE_ZSWAP,
+      REFRESH_SYSFS_KERNEL_VMMEMCTL, REFRESH_SYSFS_KERNEL_HVBALLOON, -1 },
+};
+
+static int		refresh_group[NUM_REFRESHES];	/* first of group */
+
+static void
+linux_refresh_groups(void)
+{
+    const int		*group;
+    int			i, j;
+
+    for (i = 0; i < NUM_REFRESHES; i++)
+	refresh_group[i] = i;
+    for (i = 0; i < NUM_JOBS; i++) {
+	group = refresh_jobs[i].clusters;
+	for (j = 1; group[j] >= 0; j++)
+	    refresh_group[group[j]] = group[0];
+    }
+    for (i = 0; i < sizeof(refresh_routines)/sizeof(refresh_routines[0]); i++) {
+	group = refresh_routines[i];
+	for (j = 1; group[j] >= 0; j++)
+	    refresh_group[group[j]] = group[0];
+    }
+}
+
+/*
+ * Coalesce refreshes from concurrent clients: a group of clusters all
+ * refreshed less than refresh_interval milliseconds ago is not read
+ * again.  Container contexts always refresh, and invalidate the host
+ * values they replace; as do clusters whose values depend on per-client
+ * access rights.
+ */
+static void
+linux_refresh_coalesce(int *need_refresh, linux_container_t *cp)
+{
+    struct timespec	now;
+    int			i, stale[NUM_REFRESHES] = {0};
+
+    if (refresh_interval)
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for (i = 0; i < NUM_REFRESHES; i++) {
+	if (!need_refresh[i])
+	    continue;
+	if (!refresh_interval || cp || i == CLUSTER_SLAB || i == CLUSTER_TTY ||
+	    !refresh_stamp[i].tv_sec ||
+	    pmtimespecSub(&now, &refresh_stamp[i]) * 1000.0 >= refresh_interval)
+	    stale[refresh_group[i]] = 1;
+    }
+
+    for (i = 0; i < NUM_REFRESHES; i++) {
+	if (!need_refresh[i])
+	    continue;
+	if (!stale[refresh_group[i]]) {
+	    need_refresh[i] = 0;
+	    refresh_hits++;
+	    continue;
+	}
+	if (!refresh_interval || cp || i == CLUSTER_SLAB || i == CLUSTER_TTY)
+	    memset(&refresh_stamp[i], 0, sizeof(struct timespec));
+	else
+	    refresh_stamp[i] = now;
+	refresh_count++;
+    }
+}
+
 static int
 linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
 {
@@ -7699,6 +8159,9 @@ linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
     if (cp && (sts = container_lookup(rootfd, cp)) < 0)
 	return sts;
 
+    linux_refresh_coalesce(need_refresh, cp);
+    linux_refresh_jobs_start(need_refresh, cp);
+
     if (need_refresh[CLUSTER_PARTITIONS] ||
 	need_refresh[CLUSTER_WWID] ||
 	need_refresh[CLUSTER_ZRAM_DEVICES] ||
@@ -7713,26 +8176,6 @@ linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
 	    sts = lsts;
     }
 
-    if (need_refresh[CLUSTER_STAT])
-	refresh_proc_stat(&proc_stat);
-
-    if (need_refresh[CLUSTER_CPUINFO])
-	refresh_proc_cpuinfo();
-
-    if (need_refresh[CLUSTER_MEMINFO])
-	refresh_proc_meminfo(&proc_meminfo);
-
-    if (need_refresh[CLUSTER_NUMA_MEMINFO])
-	refresh_numa_meminfo();
-
-    if (need_refresh[CLUSTER_LOADAVG])
-	refresh_proc_loadavg(&proc_loadavg);
-
-    if (need_refresh[CLUSTER_NET_NFS]) {
-	refresh_proc_net_rpc(&proc_net_rpc);
-	refresh_proc_fs_nfsd(&proc_fs_nfsd);
-    }
-
     /*
      * Network interface metrics and namespaces are complicated by a
      * need to be in the right namespace at the right time (for /sys
@@ -7901,19 +8344,6 @@ linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
 	container_nsleave(cp, LINUX_NAMESPACE_UTS);
     }
 
-    if (need_refresh[CLUSTER_INTERRUPTS])
-	refresh_proc_interrupts();
-
-    if (need_refresh[CLUSTER_SOFTIRQS] ||
-	need_refresh[CLUSTER_SOFTIRQS_TOTAL])
-	refresh_proc_softirqs();
-
-    if (need_refresh[CLUSTER_SWAPDEV])
-	refresh_swapdev(INDOM(SWAPDEV_INDOM));
-
-    if (need_refresh[CLUSTER_SCSI])
-	refresh_proc_scsi(INDOM(SCSI_INDOM));
-
     if (need_refresh[CLUSTER_SLAB]) {
 	if (all_access ||
 	    (laccess != NULL && laccess->uid == 0 && laccess->uid_flag)) {
@@ -7924,71 +8354,6 @@ linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
 	}
     }
 
-    if (need_refresh[CLUSTER_SEM_LIMITS])
-	refresh_sem_limits(&sem_limits);
-
-    if (need_refresh[CLUSTER_MSG_LIMITS])
-        refresh_msg_limits(&msg_limits);
-
-    if (need_refresh[CLUSTER_SHM_INFO])
-        refresh_shm_info(&shm_info);
-
-    if (need_refresh[CLUSTER_SEM_INFO])
-        refresh_sem_info(&sem_info);
-
-    if (need_refresh[CLUSTER_MSG_INFO])
-        refresh_msg_info(&msg_info);
-
-    if (need_refresh[CLUSTER_SHM_LIMITS])
-        refresh_shm_limits(&shm_limits);
-
-    if (need_refresh[CLUSTER_UPTIME])
-        refresh_proc_uptime(&proc_uptime);
-
-    if (need_refresh[CLUSTER_UTMP])
-        refresh_login_info(&login_info);
-
-    if (need_refresh[CLUSTER_VFS])
-    	refresh_proc_sys_fs(&proc_sys_fs);
-
-    if (need_refresh[CLUSTER_LOCKS])
-    	refresh_proc_locks(&proc_locks);
-
-    if (need_refresh[CLUSTER_SYS_KERNEL])
-    	refresh_proc_sys_kernel(&proc_sys_kernel);
-
-    if (need_refresh[CLUSTER_VMSTAT])
-    	refresh_proc_vmstat(&_pm_proc_vmstat);
-
-    if (need_refresh[CLUSTER_SYSFS_KERNEL])
-	refresh_sysfs_kernel(&sysfs_kernel, need_refresh);
-
-    if (need_refresh[CLUSTER_NET_SOFTNET])
-	refresh_proc_net_softnet(&proc_net_softnet);
-
-    if (need_refresh[CLUSTER_SHM_STAT])
-	refresh_shm_stat(INDOM(IPC_STAT_INDOM));
-
-    if (need_refresh[CLUSTER_MSG_STAT])
-	refresh_msg_queue(INDOM(IPC_MSG_INDOM));
-
-    if (need_refresh[CLUSTER_SEM_STAT])
-	refresh_sem_array(INDOM(IPC_SEM_INDOM));
-
-    if (need_refresh[CLUSTER_BUDDYINFO])
-	refresh_proc_buddyinfo(&proc_buddyinfo);
-
-    if (need_refresh[CLUSTER_ZONEINFO] ||
-        need_refresh[CLUSTER_ZONEINFO_PROTECTION])
-	refresh_proc_zoneinfo(INDOM(ZONEINFO_INDOM),
-			      INDOM(ZONEINFO_PROTECTION_INDOM));
-
-    if (need_refresh[CLUSTER_KSM_INFO])
-	refresh_ksm_info(&ksm_info);
-
-    if (need_refresh[CLUSTER_TAPEDEV])
-	refresh_sysfs_tapestats(INDOM(TAPEDEV_INDOM));
-
     if (need_refresh[CLUSTER_TTY]) {
 	if (all_access ||
 	    (laccess != NULL && laccess->uid == 0 && laccess->uid_flag)) {
@@ -7999,30 +8364,9 @@ linux_refresh(pmdaExt *pmda, int *need_refresh, int context)
 	}
     }
 
-    if (need_refresh[CLUSTER_PRESSURE_CPU])
-	refresh_proc_pressure_cpu(&proc_pressure);
-    if (need_refresh[CLUSTER_PRESSURE_MEM])
-	refresh_proc_pressure_mem(&proc_pressure);
-    if (need_refresh[CLUSTER_PRESSURE_IO])
-	refresh_proc_pressure_io(&proc_pressure);
-    if (need_refresh[CLUSTER_PRESSURE_IRQ])
-	refresh_proc_pressure_irq(&proc_pressure);
-
-    if (need_refresh[CLUSTER_FCHOST])
-	refresh_sysfs_fchosts(INDOM(FCHOST_INDOM));
-
-    if (need_refresh[CLUSTER_HUGEPAGES])
-	refresh_sysfs_hugepages(INDOM(HUGEPAGES_INDOM));
-    if (need_refresh[CLUSTER_NUMA_HUGEPAGES])
-	refresh_sysfs_numa_hugepages(INDOM(NUMA_HUGEPAGES_INDOM));
-
-    if (need_refresh[CLUSTER_NFS4_SVR_CLIENTS])
-        refresh_nfs4_svr_client(INDOM(NFS4_SVR_CLIENT_INDOM));
-    if (need_refresh[CLUSTER_NFS4_SVR_OPENS])
-        refresh_nfs4_svr_client_opens(INDOM(NFS4_SVR_CLIENT_OPENS_INDOM));
-
 done:
     container_close(cp, ns_fds);
+    linux_refresh_jobs_finish();
     return sts;
 }
 
@@ -10633,6 +10977,9 @@ linux_fetch(int numpmid, pmID pmidlist[], pmdaResult **resp, pmdaExt *pmda)
 	    }
 	    break;
 
+	case CLUSTER_REFRESH:	/* no refresh needed */
+	    break;
+
 	default:
 	    need_refresh[cluster]++;
 	    break;
@@ -10644,6 +10991,34 @@ linux_fetch(int numpmid, pmID pmidlist[], pmdaResult **resp, pmdaExt *pmda)
     return pmdaFetch(numpmid, pmidlist, resp, pmda);
 }
 
+static int
+linux_store(pmdaResult *result, pmdaExt *pmda)
+{
+    linux_access_t	*laccess = access_ctx(pmda->e_context);
+    pmValueSet		*vsp;
+    pmAtomValue		av;
+    int			i, sts = 0;
+
+    for (i = 0; i < result->numpmid && sts == 0; i++) {
+	vsp = result->vset[i];
+	if (pmID_cluster(vsp->pmid) != CLUSTER_REFRESH ||
+	    pmID_item(vsp->pmid) != 0)	/* pmda.refresh.interval */
+	    sts = PM_ERR_PERMISSION;
+	else if (!all_access &&
+		 (laccess == NULL || laccess->uid != 0 || !laccess->uid_flag))
+	    sts = PM_ERR_PERMISSION;
+	else if (vsp->numval != 1)
+	    sts = PM_ERR_INST;
+	else if ((sts = pmExtractValue(vsp->valfmt, &vsp->vlist[0],
+				PM_TYPE_U32, &av, PM_TYPE_U32)) >= 0) {
+	    refresh_interval = av.ul;
+	    memset(refresh_stamp, 0, sizeof(refresh_stamp));
+	    sts = 0;
+	}
+    }
+    return sts;
+}
+
 static void
 linux_grow_ctxtab(int ctx)
 {
@@ -11043,6 +11418,17 @@ linux_init(pmdaInterface *dp)
     }
     if ((envpath = getenv("LINUX_ACCESS")) != NULL)
 	all_access = atoi(envpath);
+    if ((envpath = getenv("LINUX_REFRESH_INTERVAL")) != NULL)
+	refresh_interval = atoi(envpath);
+    if ((envpath = getenv("LINUX_REFRESH_THREADS")) != NULL)
+	refresh_threads = atoi(envpath);
+    else if (!_isDSO && refresh_threads < 0) {
+	/* default to one refresh thread per CPU, up to a limit */
+	refresh_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (refresh_threads > 4)
+	    refresh_threads = 4;
+    }
+    linux_refresh_groups();
 
     if (_isDSO) {
 	char helppath[MAXPATHLEN];
@@ -11059,6 +11445,7 @@ linux_init(pmdaInterface *dp)
 
     dp->version.seven.instance = linux_instance;
     dp->version.seven.fetch = linux_fetch;
+    dp->version.seven.store = linux_store;
     dp->version.seven.attribute = linux_attribute;
     dp->version.seven.label = linux_label;
     pmdaSetLabelCallBack(dp, linux_labelCallBack);
@@ -11169,13 +11556,14 @@ pmLongOptions	longopts[] = {
     { "no-access-checks", 0, 'A', 0, "no access checks will be performed (insecure, beware!)" },
     PMDAOPT_DOMAIN,
     PMDAOPT_LOGFILE,
+    { "refresh-threads", 1, 't', "N", "threads refreshing independent clusters (default: one per CPU)" },
     PMDAOPT_USERNAME,
     PMOPT_HELP,
     PMDA_OPTIONS_END
 };
 
 pmdaOptions	opts = {
-    .short_options = "AD:d:l:U:?",
+    .short_options = "AD:d:l:t:U:?",
     .long_options = longopts,
 };
 
@@ -11202,6 +11590,9 @@ main(int argc, char **argv)
 	case 'A':
 	    all_access = 1;
 	    break;
+	case 't':
+	    refresh_threads = atoi(opts.optarg);
+	    break;
 	}
     }
 
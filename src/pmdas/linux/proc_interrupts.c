@@ -15,11 +15,12 @@
 #include "linux.h"
 #include "filesys.h"
 #include "proc_interrupts.h"
+#include "linux_scan.h"
 #include <sys/stat.h>
 #include <ctype.h>
 
-static char *iobuf;			/* buffer sized based on CPU count */
-static unsigned int iobufsz;
+static linux_scanbuf_t interrupts = LINUX_SCANBUF_INIT(1);
+static linux_scanbuf_t softirqs = LINUX_SCANBUF_INIT(1);
 
 static online_cpu_t *online_cpumap;	/* maps input columns to CPU info */
 unsigned int irq_err_count;
@@ -34,15 +35,9 @@ setup_buffers(void)
     static int setup;
 
     if (!setup) {
-	if ((iobufsz = (_pm_ncpus * 64)) < BUFSIZ)
-	    iobufsz = BUFSIZ;
-	if ((iobuf = malloc(iobufsz)) == NULL)
-	    return;
 	online_cpumap = calloc(_pm_ncpus, sizeof(online_cpu_t));
-	if (!online_cpumap) {
-	    free(iobuf);
+	if (!online_cpumap)
 	    return;
-	}
 	setup = 1;
     }
 }
@@ -116,34 +111,48 @@ extract_interrupt_name(char *buffer, char **suffix)
     while (isspace((int)*s))		/* find start of name */
 	s++;
     for (end = s; *end && !isspace((int)*end); end++);	/* find end */
+    *suffix = *end ? end + 1 : end;	/* mark values start */
     prev = end - 1;
     if (*prev == '_' || *prev == ':')	/* overwrite final non-name char */
 	end--;				/* and then move end of name */
     *end = '\0';			/* mark end of name */
-    *suffix = end + 1;			/* mark values start */
     return s;
 }
 
 static int
 extract_interrupt_errors(char *buffer)
 {
-    return (sscanf(buffer, "ERR: %u", &irq_err_count) == 1 ||
-	    sscanf(buffer, "Err: %u", &irq_err_count) == 1  ||
-	    sscanf(buffer, "BAD: %u", &irq_err_count) == 1);
+    unsigned long long value;
+
+    if (strncmp(buffer, "ERR:", 4) != 0 &&
+	strncmp(buffer, "Err:", 4) != 0 &&
+	strncmp(buffer, "BAD:", 4) != 0)
+	return 0;
+    if (linux_scan_ull(buffer + 4, &value) == NULL)
+	return 0;
+    irq_err_count = value;
+    return 1;
 }
 
 static int
 extract_interrupt_misses(char *buffer)
 {
-    return sscanf(buffer, "MIS: %u", &irq_mis_count) == 1;
+    unsigned long long value;
+
+    if (strncmp(buffer, "MIS:", 4) != 0 ||
+	linux_scan_ull(buffer + 4, &value) == NULL)
+	return 0;
+    irq_mis_count = value;
+    return 1;
 }
 
 static int
 extract_interrupt_values(char *name, char *buffer, pmInDom intr, pmInDom cpuintr, int ncolumns)
 {
-    unsigned long i, cpuid, value;
+    unsigned long i, cpuid;
+    unsigned long long value;
     char *s = buffer, *end = NULL;
-    char cpubuf[64];
+    char cpubuf[64], *cpuname;
     interrupt_cpu_t *cpuip;
     interrupt_t *ip = NULL;
     int sts, changed = 0;
@@ -155,16 +164,22 @@ extract_interrupt_values(char *name, char *buffer, pmInDom intr, pmInDom cpuintr
 	changed = 1;
     }
 
+    /* instance names are "<name>::cpu<N>", build the common prefix once */
+    cpuname = cpubuf + pmsprintf(cpubuf, sizeof(cpubuf) - 24, "%s::cpu", name);
+
     ip->total = 0;
     for (i = 0; i < ncolumns; i++) {
-	value = strtoul(s, &end, 10);
-	if (!isspace(*end))
+	if ((end = linux_scan_ull(s, &value)) == NULL) {
+	    value = 0;
+	    end = s;
+	}
+	if (*end != '\0' && !isspace((int)*end))
 	    continue;
 	s = end;
 	cpuip = NULL;
 	cpuid = column_to_cpuid(i);
 	online_cpumap[cpuid].intr_count += value;
-	pmsprintf(cpubuf, sizeof cpubuf, "%s::cpu%lu", name, cpuid);
+	*linux_scan_putul(cpuname, cpuid) = '\0';
 	sts = pmdaCacheLookupName(cpuintr, cpubuf, NULL, (void **)&cpuip);
 	if (sts < 0 || cpuip == NULL) {
 	    if ((cpuip = calloc(1, sizeof(interrupt_cpu_t))) == NULL)
@@ -189,9 +204,8 @@ int
 refresh_proc_interrupts(void)
 {
     static int setup;
-    FILE *fp;
-    char *name, *values;
-    int i, save, ncolumns;
+    char *line, *next, *name, *values;
+    int i, sts, save, ncolumns;
     pmInDom intr_indom = INDOM(INTERRUPT_INDOM);
     pmInDom cpu_intr_indom = INDOM(INTERRUPT_CPU_INDOM);
 
@@ -207,28 +221,28 @@ refresh_proc_interrupts(void)
     for (i = 0; i < _pm_ncpus; i++)
 	online_cpumap[i].intr_count = 0;
 
-    if ((fp = linux_statsfile("/proc/interrupts", iobuf, iobufsz)) == NULL)
-	return -oserror();
+    if ((sts = linux_scanfile("/proc/interrupts", &interrupts)) < 0)
+	return sts;
 
     /* first parse header, which maps online CPU number to column number */
-    if (fgets(iobuf, iobufsz, fp)) {
-	ncolumns = map_online_cpus(iobuf);
-    } else {
-	fclose(fp);
+    line = interrupts.buf;
+    if ((next = linux_scan_line(line)) == NULL)
 	return -EINVAL;		/* unrecognised file format */
-    }
+    ncolumns = map_online_cpus(line);
 
     save = 0;
-    while (fgets(iobuf, iobufsz, fp) != NULL) {
+    for (line = next; line != NULL; line = next) {
+	next = linux_scan_line(line);
+	if (*line == '\0')
+	    continue;
 	/* extract interrupt line (or other) and values from each row */
-	if (extract_interrupt_errors(iobuf))
+	if (extract_interrupt_errors(line))
 	    continue;
-	if (extract_interrupt_misses(iobuf))
+	if (extract_interrupt_misses(line))
 	    continue;
-	name = extract_interrupt_name(iobuf, &values);
+	name = extract_interrupt_name(line, &values);
 	save |= extract_interrupt_values(name, values, intr_indom, cpu_intr_indom, ncolumns);
     }
-    fclose(fp);
 
     if (save) {
 	pmdaCacheOp(cpu_intr_indom, PMDA_CACHE_SAVE);
@@ -240,9 +254,10 @@ refresh_proc_interrupts(void)
 static int
 extract_softirq_values(char *name, char *buffer, pmInDom sirq, pmInDom cpusirq, int ncolumns)
 {
-    unsigned long i, cpuid, value;
+    unsigned long i, cpuid;
+    unsigned long long value;
     char *s = buffer, *end = NULL;
-    char cpubuf[64];
+    char cpubuf[64], *cpuname;
     interrupt_cpu_t *cpuip;
     interrupt_t *ip = NULL;
     int sts, changed = 0;
@@ -254,16 +269,22 @@ extract_softirq_values(char *name, char *buffer, pmInDom sirq, pmInDom cpusirq,
 	changed = 1;
     }
 
+    /* instance names are "<name>::cpu<N>", build the common prefix once */
+    cpuname = cpubuf + pmsprintf(cpubuf, sizeof(cpubuf) - 24, "%s::cpu", name);
+
     ip->total = 0;
     for (i = 0; i < ncolumns; i++) {
-	value = strtoul(s, &end, 10);
-	if (!isspace(*end))
+	if ((end = linux_scan_ull(s, &value)) == NULL) {
+	    value = 0;
+	    end = s;
+	}
+	if (*end != '\0' && !isspace((int)*end))
 	    continue;
 	s = end;
 	cpuip = NULL;
 	cpuid = column_to_cpuid(i);
 	online_cpumap[cpuid].sirq_count += value;
-	pmsprintf(cpubuf, sizeof cpubuf, "%s::cpu%lu", name, cpuid);
+	*linux_scan_putul(cpuname, cpuid) = '\0';
 	sts = pmdaCacheLookupName(cpusirq, cpubuf, NULL, (void **)&cpuip);
 	if (sts < 0 || cpuip == NULL) {
 	    if ((cpuip = calloc(1, sizeof(interrupt_cpu_t))) == NULL)
@@ -288,9 +309,8 @@ int
 refresh_proc_softirqs(void)
 {
     static int setup;
-    FILE *fp;
-    char *name, *values;
-    int i = 0, save, ncolumns;
+    char *line, *next, *name, *values;
+    int i = 0, sts, save, ncolumns;
     pmInDom sirq_indom = INDOM(SOFTIRQ_INDOM);
     pmInDom cpu_sirq_indom = INDOM(SOFTIRQ_CPU_INDOM);
 
@@ -306,24 +326,24 @@ refresh_proc_softirqs(void)
     for (i = 0; i < _pm_ncpus; i++)
 	online_cpumap[i].sirq_count = 0;
 
-    if ((fp = linux_statsfile("/proc/softirqs", iobuf, iobufsz)) == NULL)
-	return -oserror();
+    if ((sts = linux_scanfile("/proc/softirqs", &softirqs)) < 0)
+	return sts;
 
     /* first parse header, which maps online CPU number to column number */
-    if (fgets(iobuf, iobufsz, fp)) {
-	ncolumns = map_online_cpus(iobuf);
-    } else {
-	fclose(fp);
+    line = softirqs.buf;
+    if ((next = linux_scan_line(line)) == NULL)
 	return -EINVAL;		/* unrecognised file format */
-    }
+    ncolumns = map_online_cpus(line);
 
     save = 0;
-    while (fgets(iobuf, iobufsz, fp) != NULL) {
+    for (line = next; line != NULL; line = next) {
+	next = linux_scan_line(line);
+	if (*line == '\0')
+	    continue;
 	/* extract values from all subsequent softirqs file lines */
-	name = extract_interrupt_name(iobuf, &values);
+	name = extract_interrupt_name(line, &values);
 	save |= extract_softirq_values(name, values, sirq_indom, cpu_sirq_indom, ncolumns);
     }
-    fclose(fp);
 
     if (save) {
 	pmdaCacheOp(cpu_sirq_indom, PMDA_CACHE_SAVE);
@@ -18,10 +18,11 @@
 #include <sys/stat.h>
 #include "linux.h"
 #include "proc_meminfo.h"
+#include "linux_scan.h"
 
 static proc_meminfo_t moff;
 
-static struct {
+static struct meminfo_field {
     char	*field;
     int64_t	*offset;
 } meminfo_fields[] = {
@@ -98,13 +99,45 @@ static struct {
 #define MOFFSET(ii, pp) (int64_t *)((char *)pp + \
     (__psint_t)meminfo_fields[ii].offset - (__psint_t)&moff)
 
+#define NUM_MEMINFO_FIELDS (sizeof(meminfo_fields)/sizeof(meminfo_fields[0]) - 1)
+
+static int
+meminfo_compare(const void *a, const void *b)
+{
+    const struct meminfo_field	*fa = (const struct meminfo_field *)a;
+    const struct meminfo_field	*fb = (const struct meminfo_field *)b;
+
+    return strcmp(fa->field, fb->field);
+}
+
+/*
+ * Sort the table (once, excluding the sentinel) so that each line
+ * of the file can be matched with a binary search.
+ */
+static struct meminfo_field *
+meminfo_lookup(char *name)
+{
+    struct meminfo_field	key = { .field = name };
+    static int			sorted;
+
+    if (!sorted) {
+	qsort(meminfo_fields, NUM_MEMINFO_FIELDS,
+		sizeof(meminfo_fields[0]), meminfo_compare);
+	sorted = 1;
+    }
+    return bsearch(&key, meminfo_fields, NUM_MEMINFO_FIELDS,
+		sizeof(meminfo_fields[0]), meminfo_compare);
+}
+
 int
 refresh_proc_meminfo(proc_meminfo_t *proc_meminfo)
 {
+    static linux_scanbuf_t sb = LINUX_SCANBUF_INIT(1);
+    struct meminfo_field	*field;
     char	buf[1024];
-    char	*bufp;
+    char	*bufp, *line, *next;
     int64_t	*p;
-    int		i;
+    int		i, sts;
     FILE	*fp;
 
     for (i = 0; meminfo_fields[i].field != NULL; i++) {
@@ -112,28 +145,25 @@ refresh_proc_meminfo(proc_meminfo_t *proc_meminfo)
 	*p = -1; /* marked as "no value available" */
     }
 
-    if ((fp = linux_statsfile("/proc/meminfo", buf, sizeof(buf))) == NULL)
-	return -oserror();
+    if ((sts = linux_scanfile("/proc/meminfo", &sb)) < 0)
+	return sts;
 
-    while (fgets(buf, sizeof(buf), fp) != NULL) {
-	if ((bufp = strchr(buf, ':')) == NULL)
+    for (line = sb.buf; line != NULL; line = next) {
+	next = linux_scan_line(line);
+	if ((bufp = strchr(line, ':')) == NULL)
 	    continue;
 	*bufp = '\0';
-	for (i=0; meminfo_fields[i].field != NULL; i++) {
-	    if (strcmp(buf, meminfo_fields[i].field) != 0)
-		continue;
-	    p = MOFFSET(i, proc_meminfo);
-	    for (bufp++; *bufp; bufp++) {
-	    	if (isdigit((int)*bufp)) {
-		    sscanf(bufp, "%llu", (unsigned long long *)p);
-		    break;
-		}
+	if ((field = meminfo_lookup(line)) == NULL)
+	    continue;
+	p = MOFFSET(field - meminfo_fields, proc_meminfo);
+	for (bufp++; *bufp; bufp++) {
+	    if (isdigit((int)*bufp)) {
+		linux_scan_ull(bufp, (unsigned long long *)p);
+		break;
 	    }
 	}
     }
 
-    fclose(fp);
-
     /*
      * MemAvailable is only in 3.x or later kernels but we can calculate it
      * using other values, similar to upstream kernel commit 34e431b0ae.
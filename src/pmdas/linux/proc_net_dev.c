@@ -21,6 +21,7 @@
 #include <sys/ioctl.h>
 #include "namespaces.h"
 #include "proc_net_dev.h"
+#include "linux_scan.h"
 
 static int
 refresh_inet_socket(linux_container_t *container)
@@ -367,9 +368,8 @@ refresh_proc_net_dev(pmInDom indom, linux_container_t *container)
 {
     static int		setup;		/* first pass through */
     static uint32_t	cache_err;	/* throttle messages */
-    char		buf[1024];
-    FILE		*fp;
-    char		*p, *v;
+    static linux_scanbuf_t sb = LINUX_SCANBUF_INIT(0); /* container netns */
+    char		*p, *v, *line, *next;
     int			j, sts;
     net_interface_t	*netip;
 
@@ -384,7 +384,7 @@ refresh_proc_net_dev(pmInDom indom, linux_container_t *container)
 
     pmdaCacheOp(indom, PMDA_CACHE_INACTIVE);
 
-    if ((fp = linux_statsfile("/proc/net/dev", buf, sizeof(buf))) == NULL)
+    if (linux_scanfile("/proc/net/dev", &sb) < 0)
 	return;
 
     /*
@@ -394,11 +394,12 @@ Inter-|   Receive                                                |  Transmit
   eth0:       0  337614    0    0    0     0          0         0        0  267537    0    0    0 27346      62          0
      */
 
-    while (fgets(buf, sizeof(buf), fp) != NULL) {
-	if ((p = v = strchr(buf, ':')) == NULL)
+    for (line = sb.buf; line != NULL; line = next) {
+	next = linux_scan_line(line);
+	if ((p = v = strchr(line, ':')) == NULL)
 	    continue;
 	*p = '\0';
-	for (p=buf; *p && isspace((int)*p); p++) {;}
+	for (p=line; *p && isspace((int)*p); p++) {;}
 
 	sts = pmdaCacheLookupName(indom, p, NULL, (void **)&netip);
 	if (sts == PM_ERR_INST || (sts >= 0 && netip == NULL)) {
@@ -424,16 +425,13 @@ Inter-|   Receive                                                |  Transmit
 	}
 
 	memset(&netip->ioc, 0, sizeof(netip->ioc));
-	for (p=v, j=0; j < PROC_DEV_COUNTERS_PER_LINE; j++) {
-	    for (; !isdigit((int)*p); p++) {;}
-	    sscanf(p, "%llu", (long long unsigned int *)&netip->counters[j]);
-	    for (; !isspace((int)*p); p++) {;}
+	for (p=v+1, j=0; j < PROC_DEV_COUNTERS_PER_LINE; j++) {
+	    if ((p = linux_scan_ull(p, (unsigned long long *)&netip->counters[j])) == NULL)
+		break;
 	}
     }
 
     /* success */
-    fclose(fp);
-
     if (!container)
 	pmdaCacheOp(indom, PMDA_CACHE_SAVE);
 }
@@ -533,11 +533,12 @@ get_fields(netstat_fields_t *fields, char *header, char *buffer)
 {
     int i, j, count;
     char *p, *indices[NETSTAT_MAX_COLUMNS];
+    char *saveptr;
 
     /* first get pointers to each of the column headings */
-    strtok(header, " ");
+    strtok_r(header, " ", &saveptr);
     for (i = 0; i < NETSTAT_MAX_COLUMNS; i++) {
-	if ((p = strtok(NULL, " \n")) == NULL)
+	if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
 	    break;
 	indices[i] = p;
     }
@@ -545,7 +546,7 @@ get_fields(netstat_fields_t *fields, char *header, char *buffer)
     while (p != NULL) {
 	if (onetrip == 1)
 	    pmNotifyErr(LOG_WARNING, "proc_net_netstat: %s extra field \"%s\" (increase NETSTAT_MAX_COLUMNS)\n", header, p);
-	p = strtok(NULL, " \n");
+	p = strtok_r(NULL, " \n", &saveptr);
     }
 
     /*
@@ -556,9 +557,9 @@ get_fields(netstat_fields_t *fields, char *header, char *buffer)
      * passed in "fields" table which typically matches the
      * kernel - but may be out-of-order for older kernels).
      */
-    strtok(buffer, " ");
+    strtok_r(buffer, " ", &saveptr);
     for (i = j = 0; j <= count; j++) {
-        if ((p = strtok(NULL, " \n")) == NULL)
+        if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
             break;
 	if (fields[i].field == NULL)
 	    /* wrap search in fields table */
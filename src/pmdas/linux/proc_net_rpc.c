@@ -23,6 +23,7 @@ refresh_proc_net_rpc(proc_net_rpc_t *proc_net_rpc)
     char buf[4096];
     FILE *fp;
     char *p;
+    char *saveptr;
     int i;
 
     memset(proc_net_rpc, 0, sizeof(proc_net_rpc_t));
@@ -50,30 +51,30 @@ refresh_proc_net_rpc(proc_net_rpc_t *proc_net_rpc)
 		    &proc_net_rpc->client.rpcauthrefresh);
 	    else
 	    if (strncmp(buf, "proc2", 5) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 		for (i=0; p && i < NR_RPC_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->client.reqcounts[i] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
 	    else
 	    if (strncmp(buf, "proc3", 5) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 		for (i=0; p && i < NR_RPC3_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->client.reqcounts3[i] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
 	    else
 	    if (strncmp(buf, "proc4", 5) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 		for (i=0; p && i < NR_RPC4_CLI_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->client.reqcounts4[i] = strtoul(p, (char **)NULL, 10);
 		}
@@ -150,41 +151,41 @@ refresh_proc_net_rpc(proc_net_rpc_t *proc_net_rpc)
                     &proc_net_rpc->server.rpcbadclnt);
 	    else
 	    if (strncmp(buf, "proc2", 5) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 		for (i=0; p && i < NR_RPC_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->server.reqcounts[i] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
 	    else
 	    if (strncmp(buf, "proc3", 5) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 		for (i=0; p && i < NR_RPC3_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->server.reqcounts3[i] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
 	    else
 	    if (strncmp(buf, "proc4ops", 8) == 0) {
-		if ((p = strtok(buf, " ")) != NULL)
-		    p = strtok(NULL, " ");
+		if ((p = strtok_r(buf, " ", &saveptr)) != NULL)
+		    p = strtok_r(NULL, " ", &saveptr);
 
 		/* Inst 0 is a NULL count (below) - not from the kernel! */
 		for (i=1; p && i <= NR_RPC4_SVR_COUNTERS; i++) {
-		    if ((p = strtok(NULL, " ")) == NULL)
+		    if ((p = strtok_r(NULL, " ", &saveptr)) == NULL)
 			break;
 		    proc_net_rpc->server.reqcounts4[i] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
 	    else
 	    if (strncmp(buf, "proc4", 5) == 0) {
-		if ((strtok(buf, " ")) != NULL &&
-		    (strtok(NULL, " ")) != NULL &&
-		    (p = strtok(NULL, " ")) != NULL) { /* 3rd token is NULL count */
+		if ((strtok_r(buf, " ", &saveptr)) != NULL &&
+		    (strtok_r(NULL, " ", &saveptr)) != NULL &&
+		    (p = strtok_r(NULL, " ", &saveptr)) != NULL) { /* 3rd token is NULL count */
 		    proc_net_rpc->server.reqcounts4[0] = strtoul(p, (char **)NULL, 10);
 		}
 	    }
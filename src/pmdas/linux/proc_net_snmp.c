@@ -240,11 +240,12 @@ get_fields(snmp_fields_t *fields, char *header, char *buffer)
 {
     int i, j, count;
     char *p, *indices[SNMP_MAX_COLUMNS];
+    char *saveptr;
 
     /* first get pointers to each of the column headings */
-    strtok(header, " ");
+    strtok_r(header, " ", &saveptr);
     for (i = 0; i < SNMP_MAX_COLUMNS; i++) {
-	if ((p = strtok(NULL, " \n")) == NULL)
+	if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
 	    break;
 	indices[i] = p;
     }
@@ -252,7 +253,7 @@ get_fields(snmp_fields_t *fields, char *header, char *buffer)
     while (p != NULL) {
 	if (onetrip == 1)
 	    pmNotifyErr(LOG_WARNING, "proc_net_snmp: %s extra field \"%s\" (increase SNMP_MAX_COLUMNS)\n", header, p);
-	p = strtok(NULL, " \n");
+	p = strtok_r(NULL, " \n", &saveptr);
     }
 
     /*
@@ -263,9 +264,9 @@ get_fields(snmp_fields_t *fields, char *header, char *buffer)
      * passed in "fields" table which typically matches the
      * kernel - but may be out-of-order for older kernels).
      */
-    strtok(buffer, " ");
+    strtok_r(buffer, " ", &saveptr);
     for (i = j = 0; j <= count; j++) {
-        if ((p = strtok(NULL, " \n")) == NULL)
+        if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
             break;
 	if (fields[i].field == NULL)
 	    /* wrap search in fields table */
@@ -305,18 +306,19 @@ get_ordinal_fields(snmp_fields_t *fields, char *header, char *buffer,
     int i, j, count;
     unsigned int inst;
     char *p, *indices[SNMP_MAX_COLUMNS];
+    char *saveptr;
 
-    strtok(header, " ");
+    strtok_r(header, " ", &saveptr);
     for (i = 0; i < SNMP_MAX_COLUMNS; i++) {
-	if ((p = strtok(NULL, " \n")) == NULL)
+	if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
 	    break;
 	indices[i] = p;
     }
     count = i;
 
-    strtok(buffer, " ");
+    strtok_r(buffer, " ", &saveptr);
     for (j = 0; j < count; j++) {
-        if ((p = strtok(NULL, " \n")) == NULL)
+        if ((p = strtok_r(NULL, " \n", &saveptr)) == NULL)
             break;
         for (i = 0; fields[i].field; i++) {
             if (sscanf(indices[j], fields[i].field, &inst) != 1)
@@ -1078,6 +1078,7 @@ get_disk_ctlr(char *name)
     char		path[MAXPATHLEN];
     char		link[MAXPATHLEN];
     char		*ctlr;
+    char		*saveptr;
 
     pmsprintf(path, sizeof(path), "%s/sys/block/%s", linux_statspath, name);
     if ((size = readlink(path, link, sizeof(link)-1)) < 0) {
@@ -1095,7 +1096,7 @@ get_disk_ctlr(char *name)
      *                     ^^^^^^^ controlller id as per lspci
      *                                 ^^^ disk name as per indom
      */
-    part = strtok(link, "/");
+    part = strtok_r(link, "/", &saveptr);
     want = 0;
     while (part != NULL) {
 	if (strcmp(part, "pci0000:00") == 0) {
@@ -1120,7 +1121,7 @@ get_disk_ctlr(char *name)
 		return NULL;
 	    }
 	}
-	part = strtok(NULL, "/");
+	part = strtok_r(NULL, "/", &saveptr);
     }
 
     if (pmDebugOptions.appl1)
@@ -1141,6 +1142,7 @@ get_disk_model(char *name)
     char		link[MAXPATHLEN];
     char		duplink[MAXPATHLEN];
     char		*model;
+    char		*saveptr;
 
     pmsprintf(path, sizeof(path), "%s/sys/block/%s", linux_statspath, name);
     if ((size = readlink(path, link, sizeof(link)-1)) < 0) {
@@ -1155,7 +1157,7 @@ get_disk_model(char *name)
     link[size] = '\0';
     strcpy(duplink, link);
     model = NULL;
-    part = strtok(link, "/");
+    part = strtok_r(link, "/", &saveptr);
     while (part != NULL) {
 	if (strcmp(part, "block") == 0) {
 	    /*
@@ -1192,7 +1194,7 @@ get_disk_model(char *name)
 		return NULL;
 	    }
 	}
-	part = strtok(NULL, "/");
+	part = strtok_r(NULL, "/", &saveptr);
     }
 
     if (pmDebugOptions.appl1)
@@ -17,6 +17,7 @@
  */
 #include "linux.h"
 #include "proc_stat.h"
+#include "linux_scan.h"
 #include <sys/stat.h>
 #include <dirent.h>
 #include <ctype.h>
@@ -160,6 +161,46 @@ find_line_format(const char *fmt, int fmtlen, char **bufindex, int nbufindex, in
     return -1;
 }
 
+/*
+ * Parse CPU time fields, which are in kernel (not cpuacct_t) order;
+ * fields missing on older kernels (see below) are left untouched.
+ */
+static void
+scan_cpu_fields(char *p, cpuacct_t *acct)
+{
+    unsigned long long	*fields[] = {
+	&acct->user, &acct->nice, &acct->sys, &acct->idle, &acct->wait,
+	&acct->irq, &acct->sirq, &acct->steal, &acct->guest, &acct->guest_nice,
+    };
+    int			i;
+
+    for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+	if ((p = linux_scan_ull(p, fields[i])) == NULL)
+	    break;
+}
+
+/*
+ * Instance identifiers map directly to CPU identifiers (see above),
+ * so this is usually a direct lookup; fallback to the instance name.
+ */
+static int
+find_cpu(pmInDom cpus, unsigned long long cpuid, char **name, percpu_t **cpu)
+{
+    char	cpuname[32];
+    int		inst, sts;
+
+    *cpu = NULL;
+    if (cpuid <= INT_MAX &&
+	pmdaCacheLookup(cpus, (int)cpuid, name, (void **)cpu) > 0 &&
+	*cpu != NULL && (*cpu)->cpuid == cpuid)
+	return 0;
+    *cpu = NULL;
+    pmsprintf(cpuname, sizeof(cpuname), "cpu%llu", cpuid);
+    if ((sts = pmdaCacheLookupName(cpus, cpuname, &inst, (void **)cpu)) < 0)
+	return sts;
+    return pmdaCacheLookup(cpus, inst, name, NULL);
+}
+
 #define WAITIO_SLOP 100
 
 /*
@@ -175,14 +216,12 @@ refresh_proc_stat(proc_stat_t *proc_stat)
     pernode_t	*np;
     percpu_t	*cp;
     pmInDom	cpus, nodes;
-    char	buf[MAXPATHLEN], *name, *sp, **bp;
-    char	cpuname[32];
-    int		n = 0, i, size;
+    char	*name, *p, *statbuf, **bp;
+    int		n, i, size;
     static unsigned long long	prev_wait;
+    unsigned long long	cpuid;
 
-    static int fd = -1; /* kept open until exit(), unless testing */
-    static char *statbuf;
-    static int maxstatbuf;
+    static linux_scanbuf_t sb = LINUX_SCANBUF_INIT(1); /* fd kept open */
     static char **bufindex;
     static int nbufindex;
     static int maxbufindex;
@@ -201,36 +240,9 @@ refresh_proc_stat(proc_stat_t *proc_stat)
 	memset(&np->stat, 0, sizeof(np->stat));
     }
 
-    /* in test mode we replace procfs files (keeping fd open thwarts that) */
-    if (fd >= 0 && (linux_test_mode & LINUX_TEST_STATSPATH)) {
-	close(fd);
-	fd = -1;
-    }
-
-    if (fd >= 0) {
-	if (lseek(fd, 0, SEEK_SET) < 0)
-	    return -oserror();
-    } else {
-	pmsprintf(buf, sizeof(buf), "%s/proc/stat", linux_statspath);
-	if ((fd = open(buf, O_RDONLY)) < 0)
-	    return -oserror();
-    }
-
-    for (;;) {
-	while (n >= maxstatbuf) {
-	    size = maxstatbuf + 512;
-	    if ((sp = (char *)realloc(statbuf, size)) == NULL)
-		return -ENOMEM;
-	    statbuf = sp;
-	    maxstatbuf = size;
-	}
-	size = (statbuf + maxstatbuf) - (statbuf + n);
-	if ((i = read(fd, statbuf + n, size)) > 0)
-	    n += i;
-	else
-	    break;
-    }
-    statbuf[n] = '\0';
+    if ((n = linux_scanfile("/proc/stat", &sb)) < 0)
+	return n;
+    statbuf = sb.buf;
 
     if (bufindex == NULL) {
 	size = 16 * sizeof(char *);
@@ -241,27 +253,19 @@ refresh_proc_stat(proc_stat_t *proc_stat)
 
     nbufindex = 0;
     bufindex[nbufindex] = statbuf;
-    for (i = 0; i < n; i++) {
-	if (statbuf[i] == '\n' || statbuf[i] == '\0') {
-	    statbuf[i] = '\0';
-	    if (nbufindex + 1 >= maxbufindex) {
-		size = (maxbufindex + 4) * sizeof(char *);
-		if ((bp = (char **)realloc(bufindex, size)) == NULL)
-		    return -ENOMEM;
-		bufindex = bp;
-	    	maxbufindex += 4;
-	    }
-	    bufindex[++nbufindex] = statbuf + i + 1;
+    for (p = statbuf; (p = linux_scan_line(p)) != NULL; ) {
+	if (nbufindex + 1 >= maxbufindex) {
+	    size = (maxbufindex * 2) * sizeof(char *);
+	    if ((bp = (char **)realloc(bufindex, size)) == NULL)
+		return -ENOMEM;
+	    bufindex = bp;
+	    maxbufindex *= 2;
 	}
+	bufindex[++nbufindex] = p;
     }
 
-#define ALLCPU_FMT "cpu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
-    n = sscanf((const char *)bufindex[0], ALLCPU_FMT,
-	&proc_stat->all.user, &proc_stat->all.nice,
-	&proc_stat->all.sys, &proc_stat->all.idle,
-	&proc_stat->all.wait, &proc_stat->all.irq,
-	&proc_stat->all.sirq, &proc_stat->all.steal,
-	&proc_stat->all.guest, &proc_stat->all.guest_nice);
+    if (strncmp(bufindex[0], "cpu ", 4) == 0)
+	scan_cpu_fields(bufindex[0] + 4, &proc_stat->all);
     if (proc_stat->all.prev_wait > 0 &&
 	    proc_stat->all.wait < proc_stat->all.prev_wait &&
 	    proc_stat->all.wait > proc_stat->all.prev_wait - WAITIO_SLOP) {
@@ -280,7 +284,6 @@ refresh_proc_stat(proc_stat_t *proc_stat)
     else
 	proc_stat->all.prev_wait = proc_stat->all.wait;
 
-#define PERCPU_FMT "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
     /*
      * per-CPU stats
      * e.g. cpu0 95379 4 20053 6502503
@@ -300,23 +303,18 @@ refresh_proc_stat(proc_stat_t *proc_stat)
     else {
 	for (n = 0; n < nbufindex; n++) {
 	    if (strncmp("cpu", bufindex[n], 3) != 0 ||
-		!isdigit((int)bufindex[n][3]))
+		!isdigit((int)bufindex[n][3]) ||
+		(p = linux_scan_ull(&bufindex[n][3], &cpuid)) == NULL)
 		continue;
 	    cp = NULL;
 	    np = NULL;
-	    i = atoi(&bufindex[n][3]);	/* extract CPU identifier */
-	    pmsprintf(cpuname, sizeof(cpuname), "cpu%u", i); /* instance name */
-	    if (pmdaCacheLookupName(cpus, cpuname, &i, (void **)&cp) < 0 || !cp)
+	    if (find_cpu(cpus, cpuid, &name, &cp) < 0 || !cp)
 		continue;
 	    /* need to NOT zero out the prev_wait field, as it is used below */
 	    prev_wait = cp->stat.prev_wait;
 	    memset(&cp->stat, 0, sizeof(cp->stat));
 	    cp->stat.prev_wait = prev_wait;
-	    sscanf(bufindex[n], PERCPU_FMT, &i,
-		    &cp->stat.user, &cp->stat.nice, &cp->stat.sys,
-		    &cp->stat.idle, &cp->stat.wait, &cp->stat.irq,
-		    &cp->stat.sirq, &cp->stat.steal, &cp->stat.guest,
-		    &cp->stat.guest_nice);
+	    scan_cpu_fields(p, &cp->stat);
 	    /* see comment above re kernel waitio */
 	    if (cp->stat.prev_wait > 0 &&
 		    cp->stat.wait < cp->stat.prev_wait &&
@@ -326,7 +324,7 @@ refresh_proc_stat(proc_stat_t *proc_stat)
 	    else
 		cp->stat.prev_wait = cp->stat.wait;
 
-	    pmdaCacheStore(cpus, PMDA_CACHE_ADD, cpuname, (void *)cp);
+	    pmdaCacheStore(cpus, PMDA_CACHE_ADD, name, (void *)cp);
 
 	    /* update per-node aggregate CPU utilisation stats as well */
 	    if (pmdaCacheLookup(nodes, cp->node->instid, NULL, (void **)&np) < 0 || !np)
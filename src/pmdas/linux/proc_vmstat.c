@@ -18,8 +18,9 @@
 #include <ctype.h>
 #include "linux.h"
 #include "proc_vmstat.h"
+#include "linux_scan.h"
 
-static struct {
+static struct vmstat_field {
     const char	*field;
     __uint64_t	*offset; 
 } vmstat_fields[] = {
@@ -399,6 +400,36 @@ static struct {
 #define VMSTAT_OFFSET(ii, pp) (int64_t *)((char *)pp + \
     (__psint_t)vmstat_fields[ii].offset - (__psint_t)&_pm_proc_vmstat)
 
+#define NUM_VMSTAT_FIELDS (sizeof(vmstat_fields)/sizeof(vmstat_fields[0]) - 1)
+
+static int
+vmstat_compare(const void *a, const void *b)
+{
+    const struct vmstat_field	*fa = (const struct vmstat_field *)a;
+    const struct vmstat_field	*fb = (const struct vmstat_field *)b;
+
+    return strcmp(fa->field, fb->field);
+}
+
+/*
+ * Source order above is for maintenance only, so sort the table once
+ * (excluding the sentinel) for a binary search of each line's name.
+ */
+static struct vmstat_field *
+vmstat_lookup(const char *name)
+{
+    struct vmstat_field	key = { .field = name };
+    static int		sorted;
+
+    if (!sorted) {
+	qsort(vmstat_fields, NUM_VMSTAT_FIELDS,
+		sizeof(vmstat_fields[0]), vmstat_compare);
+	sorted = 1;
+    }
+    return bsearch(&key, vmstat_fields, NUM_VMSTAT_FIELDS,
+		sizeof(vmstat_fields[0]), vmstat_compare);
+}
+
 void
 proc_vmstat_init(void)
 {
@@ -421,11 +452,11 @@ proc_vmstat_init(void)
 int
 refresh_proc_vmstat(proc_vmstat_t *proc_vmstat)
 {
-    char	buf[1024];
-    char	*bufp;
+    static linux_scanbuf_t sb = LINUX_SCANBUF_INIT(1);
+    struct vmstat_field	*field;
+    char	*bufp, *line, *next;
     int64_t	*p;
-    int		i;
-    FILE	*fp;
+    int		i, sts;
 
     for (i = 0; vmstat_fields[i].field != NULL; i++) {
 	p = VMSTAT_OFFSET(i, proc_vmstat);
@@ -437,38 +468,36 @@ refresh_proc_vmstat(proc_vmstat_t *proc_vmstat)
     proc_vmstat->pgsteal_total = 0;
     proc_vmstat->pgdemote_total = 0;
 
-    if ((fp = linux_statsfile("/proc/vmstat", buf, sizeof(buf))) == NULL)
-    	return -oserror();
+    if ((sts = linux_scanfile("/proc/vmstat", &sb)) < 0)
+    	return sts;
 
     _pm_have_proc_vmstat = 1;
 
-    while (fgets(buf, sizeof(buf), fp) != NULL) {
-	if ((bufp = strchr(buf, ' ')) == NULL)
+    for (line = sb.buf; line != NULL; line = next) {
+	next = linux_scan_line(line);
+	if ((bufp = strchr(line, ' ')) == NULL)
 	    continue;
 	*bufp = '\0';
-	for (i = 0; vmstat_fields[i].field != NULL; i++) {
-	    if (strcmp(buf, vmstat_fields[i].field) != 0)
-		continue;
-	    p = VMSTAT_OFFSET(i, proc_vmstat);
-	    for (bufp++; *bufp; bufp++) {
-	    	if (isdigit((int)*bufp)) {
-		    sscanf(bufp, "%llu", (unsigned long long *)p);
-		    break;
-		}
+	if ((field = vmstat_lookup(line)) == NULL)
+	    continue;
+	p = VMSTAT_OFFSET(field - vmstat_fields, proc_vmstat);
+	for (bufp++; *bufp; bufp++) {
+	    if (isdigit((int)*bufp)) {
+		linux_scan_ull(bufp, (unsigned long long *)p);
+		break;
 	    }
-	    if (*bufp == '\0')
-		continue;
-	    else if (strncmp(buf, "pgsteal_", 8) == 0)
-		proc_vmstat->pgsteal_total += *p;
-	    else if (strncmp(buf, "pgscan_kswapd", 13) == 0)
-		proc_vmstat->pgscan_kswapd_total += *p;
-	    else if (strncmp(buf, "pgscan_direct", 13) == 0)
-		proc_vmstat->pgscan_direct_total += *p;
-	    else if (strncmp(buf, "pgdemote_", 9) == 0)
-		proc_vmstat->pgdemote_total += *p;
 	}
+	if (*bufp == '\0')
+	    continue;
+	else if (strncmp(line, "pgsteal_", 8) == 0)
+	    proc_vmstat->pgsteal_total += *p;
+	else if (strncmp(line, "pgscan_kswapd", 13) == 0)
+	    proc_vmstat->pgscan_kswapd_total += *p;
+	else if (strncmp(line, "pgscan_direct", 13) == 0)
+	    proc_vmstat->pgscan_direct_total += *p;
+	else if (strncmp(line, "pgdemote_", 9) == 0)
+	    proc_vmstat->pgdemote_total += *p;
     }
-    fclose(fp);
 
     if (proc_vmstat->nr_slab == -1)	/* split apart in 2.6.18 */
 	proc_vmstat->nr_slab = proc_vmstat->nr_slab_reclaimable +
@@ -27,6 +27,7 @@ refresh_swapdev(pmInDom swapdev_indom)
     char *size;
     char *used;
     char *priority;
+    char *saveptr;
     int sts;
 
     pmdaCacheOp(swapdev_indom, PMDA_CACHE_INACTIVE);
@@ -37,12 +38,12 @@ refresh_swapdev(pmInDom swapdev_indom)
     while (fgets(buf, sizeof(buf), fp) != NULL) {
 	if (buf[0] != '/')
 	    continue;
-	if ((path = strtok(buf, " \t")) == 0)
+	if ((path = strtok_r(buf, " \t", &saveptr)) == 0)
 	    continue;
-	if ((/*type: */ strtok(NULL, " \t")) == NULL ||
-	    (size = strtok(NULL, " \t")) == NULL ||
-	    (used = strtok(NULL, " \t")) == NULL ||
-	    (priority = strtok(NULL, " \t")) == NULL)
+	if ((/*type: */ strtok_r(NULL, " \t", &saveptr)) == NULL ||
+	    (size = strtok_r(NULL, " \t", &saveptr)) == NULL ||
+	    (used = strtok_r(NULL, " \t", &saveptr)) == NULL ||
+	    (priority = strtok_r(NULL, " \t", &saveptr)) == NULL)
 	    continue;
 	sts = pmdaCacheLookupName(swapdev_indom, path, NULL, (void **)&swap);
 	if (sts == PMDA_CACHE_ACTIVE)	/* repeated line in /proc/swaps? */
@@ -1520,11 +1520,21 @@ proc_refresh(pmdaExt *pmda, int *need_refresh)
 	need_refresh[CLUSTER_PID_FD] ||
 	need_refresh[CLUSTER_PID_FDINFO] ||
 	need_refresh[CLUSTER_PROC_RUNQ]) {
+	unsigned int	harvest = 0;
+
+	if (need_refresh[CLUSTER_PID_STAT])
+	    harvest |= PROC_PID_FLAG_STAT;
+	if (need_refresh[CLUSTER_PID_STATM])
+	    harvest |= PROC_PID_FLAG_STATM;
+	if (need_refresh[CLUSTER_PID_IO] && have_access)
+	    harvest |= PROC_PID_FLAG_IO;
+	if (need_refresh[CLUSTER_PID_SCHEDSTAT])
+	    harvest |= PROC_PID_FLAG_SCHEDSTAT;
 	refresh_proc_pid(&proc_pid,
 		need_refresh[CLUSTER_PROC_RUNQ]? &proc_runq : NULL,
 		proc_ctx_threads(pmda->e_context, threads),
 		proc_ctx_cgroups(pmda->e_context, cgroups),
-		container ? cgroup : NULL, cgrouplen);
+		container ? cgroup : NULL, cgrouplen, harvest);
 
     }
     if (need_refresh[CLUSTER_HOTPROC_PID_STAT] ||
@@ -4032,6 +4042,16 @@ proc_init(pmdaInterface *dp)
 	threads = atoi(envpath);
     if ((envpath = getenv("PROC_ACCESS")) != NULL)
 	all_access = atoi(envpath);
+    if ((envpath = getenv("PROC_HARVEST_THREADS")) != NULL)
+	proc_harvest_threads = atoi(envpath);
+    else if (!_isDSO && proc_harvest_threads < 0) {
+	/* default to one harvesting thread per CPU, up to a limit */
+	proc_harvest_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (proc_harvest_threads > 8)
+	    proc_harvest_threads = 8;
+    }
+    if ((envpath = getenv("PROC_HARVEST_MINPIDS")) != NULL)
+	proc_harvest_minpids = atoi(envpath);
 
     if (_isDSO) {
 	char helppath[MAXPATHLEN];
@@ -4128,13 +4148,14 @@ pmLongOptions	longopts[] = {
     PMDAOPT_LOGFILE,
     { "with-threads", 0, 'L', 0, "include threads in the all-processes instance domain" },
     { "from-cgroup", 1, 'r', "NAME", "restrict monitoring to processes in the named cgroup" },
+    { "harvest-threads", 1, 't', "N", "threads reading large process lists (default: one per CPU)" },
     PMDAOPT_USERNAME,
     PMOPT_HELP,
     PMDA_OPTIONS_END
 };
 
 pmdaOptions	opts = {
-    .short_options = "AD:d:l:Lr:U:?",
+    .short_options = "AD:d:l:Lr:t:U:?",
     .long_options = longopts,
 };
 
@@ -4163,6 +4184,9 @@ main(int argc, char **argv)
 	case 'r':
 	    cgroups = opts.optarg;
 	    break;
+	case 't':
+	    proc_harvest_threads = atoi(opts.optarg);
+	    break;
 	}
     }
 
@@ -26,6 +26,7 @@
 #include <sys/stat.h>
 #include <sys/syslog.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <pwd.h>
 #include <grp.h>
 #include "proc_pid.h"
@@ -37,11 +38,16 @@ static size_t	procbuflen;
 static char	*procbuf;
 
 static proc_pid_list_t procpids; /* previous pids list that the proc pmda uses */
-static void refresh_proc_pidlist(proc_pid_t *, proc_pid_list_t *, proc_runq_t *);
-static int refresh_proc_pid_stat(proc_pid_entry_t *);
+static void refresh_proc_pidlist(proc_pid_t *, proc_pid_list_t *, proc_runq_t *, unsigned int);
+static int proc_dirfd_open(int);
+static void proc_dirfd_close(proc_pid_entry_t *);
+static int proc_openat(const char *, proc_pid_entry_t *, int);
+static void harvest_proc_pidlist(proc_pid_t *, int, unsigned int);
+static int refresh_proc_pid_stat(proc_pid_entry_t *, size_t *, char **);
+static int refresh_proc_pid_statm(proc_pid_entry_t *, size_t *, char **);
 static int refresh_proc_pid_status(proc_pid_entry_t *);
-static int refresh_proc_pid_io(proc_pid_entry_t *);
-static int refresh_proc_pid_schedstat(proc_pid_entry_t *);
+static int refresh_proc_pid_io(proc_pid_entry_t *, size_t *, char **);
+static int refresh_proc_pid_schedstat(proc_pid_entry_t *, size_t *, char **);
 
 /* Hotproc variables */
 
@@ -456,7 +462,8 @@ hotproc_eval_procs(void)
 
     /* Whats running right now */
     refresh_global_pidlist(0, &hotpids);
-    refresh_proc_pidlist(hotproc_poss_pid, &hotpids, NULL);
+    refresh_proc_pidlist(hotproc_poss_pid, &hotpids, NULL,
+		PROC_PID_FLAG_STAT | PROC_PID_FLAG_IO | PROC_PID_FLAG_SCHEDSTAT);
 
     pmtimevalNow(&timestamp);
 
@@ -472,10 +479,10 @@ hotproc_eval_procs(void)
 	}
 
 	/* Collect all the stat/status/statm info */
-	refresh_proc_pid_stat(entry);
+	refresh_proc_pid_stat(entry, &procbuflen, &procbuf);
 	refresh_proc_pid_status(entry);
-	refresh_proc_pid_io(entry);
-	refresh_proc_pid_schedstat(entry);
+	refresh_proc_pid_io(entry, &procbuflen, &procbuf);
+	refresh_proc_pid_schedstat(entry, &procbuflen, &procbuf);
 
         /* Note: /proc/pid/schedstat and /proc/pid/io not on all platforms */
 	if (!(entry->success & PROC_PID_FLAG_STAT) ||
@@ -716,6 +723,116 @@ disable_hotproc(void)
     conf_gen = 0;
 }
 
+/*
+ * Bulk harvesting of the stat, statm, io and schedstat clusters.  With
+ * many thousands of processes, reading these files one at a time from
+ * the fetch callback dominates the cost of a fetch; so when the pid list
+ * is large the entries are instead spread across a number of threads,
+ * each reading through its own buffer and setting the SUCCESS flags of
+ * the entries it covers, such that the fetch callback later finds all
+ * values already in place.  Clusters that update shared state (such as
+ * the strings cache) continue to be read on demand, and any file that
+ * could not be read is retried then too so the error is reported.  The
+ * threads persist in a pool from one refresh to the next.
+ */
+#define HARVEST_FLAGS	(PROC_PID_FLAG_STAT | PROC_PID_FLAG_STATM | \
+			 PROC_PID_FLAG_IO | PROC_PID_FLAG_SCHEDSTAT)
+
+int		proc_harvest_threads = -1;	/* less than two disables harvesting */
+int		proc_harvest_minpids = 1024;	/* smallest pid list worth threads */
+
+typedef struct {
+    unsigned int	flags;		/* PROC_PID_FLAG_* clusters to read */
+    int			start;		/* first entry covered by this thread */
+    int			stride;		/* step between entries covered */
+    int			count;
+    proc_pid_entry_t	**entries;
+    size_t		buflen;		/* read buffer kept across refreshes */
+    char		*buf;
+} harvest_t;
+
+static void
+harvest_entries(harvest_t *hp)
+{
+    proc_pid_entry_t	*ep;
+    int			i;
+
+    for (i = hp->start; i < hp->count; i += hp->stride) {
+	ep = hp->entries[i];
+	if (hp->flags & PROC_PID_FLAG_STAT)
+	    refresh_proc_pid_stat(ep, &hp->buflen, &hp->buf);
+	if (hp->flags & PROC_PID_FLAG_STATM)
+	    refresh_proc_pid_statm(ep, &hp->buflen, &hp->buf);
+	if (hp->flags & PROC_PID_FLAG_IO)
+	    refresh_proc_pid_io(ep, &hp->buflen, &hp->buf);
+	if (hp->flags & PROC_PID_FLAG_SCHEDSTAT)
+	    refresh_proc_pid_schedstat(ep, &hp->buflen, &hp->buf);
+    }
+}
+
+/* pool task i covers the share after the calling thread's own */
+static void
+harvest_task(void *arg, int i)
+{
+    harvest_entries((harvest_t *)arg + i + 1);
+}
+
+static void
+harvest_proc_pidlist(proc_pid_t *proc_pid, int count, unsigned int flags)
+{
+    static proc_pid_entry_t	**entries;
+    static harvest_t		*workers;
+    static __pmWorkPool		*pool;
+    static int			maxentries, maxworkers;
+    __pmHashNode		*node;
+    void			*tmp;
+    int				i, n, started, nthreads = proc_harvest_threads;
+
+    if ((flags &= HARVEST_FLAGS) == 0 || nthreads < 2 ||
+	count < proc_harvest_minpids)
+	return;
+    if (pool == NULL && (pool = __pmWorkPoolCreate()) == NULL)
+	return;
+
+    if (count > maxentries) {
+	if ((tmp = realloc(entries, count * sizeof(*entries))) == NULL)
+	    return;
+	entries = (proc_pid_entry_t **)tmp;
+	maxentries = count;
+    }
+    if (nthreads > maxworkers) {
+	if ((tmp = realloc(workers, nthreads * sizeof(*workers))) == NULL)
+	    return;
+	workers = (harvest_t *)tmp;
+	memset(&workers[maxworkers], 0,
+		(nthreads - maxworkers) * sizeof(*workers));
+	maxworkers = nthreads;
+    }
+
+    for (n = i = 0; i < proc_pid->pidhash.hsize; i++) {
+	for (node = proc_pid->pidhash.hash[i]; node; node = node->next)
+	    entries[n++] = (proc_pid_entry_t *)node->data;
+    }
+    for (i = 0; i < nthreads; i++) {
+	workers[i].flags = flags;
+	workers[i].start = i;
+	workers[i].stride = nthreads;
+	workers[i].count = n;
+	workers[i].entries = entries;
+    }
+
+    /* the calling thread covers the first share, and any not started */
+    started = 1 + __pmWorkPoolStart(pool, nthreads - 1, harvest_task, workers);
+    harvest_entries(&workers[0]);
+    for (i = started; i < nthreads; i++)
+	harvest_entries(&workers[i]);
+    __pmWorkPoolWait(pool);
+
+    if (pmDebugOptions.appl1)
+	fprintf(stderr, "%s: %d pids, flags=0x%x, %d threads\n",
+		"harvest_proc_pidlist", n, flags, started);
+}
+
 static void
 refresh_proc_indom_entry(proc_pid_entry_t *ep, pmdaIndom *indomp, int idx)
 {
@@ -839,7 +956,8 @@ sanitise_cmdline(char *buf, int len)
 }
 
 static void
-refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *runq)
+refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids,
+		proc_runq_t *runq, unsigned int harvest)
 {
     int			i, fd, numinst, idx = 0;
     char		*p, buf[MAXPATHLEN];
@@ -872,9 +990,9 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 	    memset(ep, 0, sizeof(proc_pid_entry_t));
 
 	    ep->id = pids->pids[i];
+	    ep->dirfd = proc_dirfd_open(ep->id);
 
-	    pmsprintf(buf, sizeof(buf), "%s/proc/%d/cmdline", proc_statspath, pids->pids[i]);
-	    if ((fd = open(buf, O_RDONLY)) >= 0) {
+	    if ((fd = proc_openat("cmdline", ep, O_RDONLY)) >= 0) {
 		int numlen = pmsprintf(buf, sizeof(buf), "%06d ", pids->pids[i]);
 		if ((k = read(fd, buf+numlen, sizeof(buf)-numlen)) > 0) {
 		    if (k >= (int)(sizeof(buf) - numlen))
@@ -884,8 +1002,9 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 		close(fd);
 	    }
 	    else if (pmDebugOptions.appl1 && pmDebugOptions.desperate) {
-		fprintf(stderr, "%s: open(\"%s\", O_RDONLY) failed: %s\n",
-			"refresh_proc_pidlist", buf, pmErrStr(-oserror()));
+		fprintf(stderr, "%s: open(\"%s/proc/%d/cmdline\", O_RDONLY) failed: %s\n",
+			"refresh_proc_pidlist", proc_statspath, ep->id,
+			pmErrStr(-oserror()));
 	    }
 	    if (k == 0) {
 		/*
@@ -893,8 +1012,7 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 		 * returns an empty string so we have to get it
 		 * from /proc/<pid>/status or /proc/<pid>/stat
 		 */
-		pmsprintf(buf, sizeof(buf), "%s/proc/%d/status", proc_statspath, pids->pids[i]);
-		if ((fd = open(buf, O_RDONLY)) >= 0) {
+		if ((fd = proc_openat("status", ep, O_RDONLY)) >= 0) {
 		    /* We engage in a bit of a hanky-panky here:
 		     * the string should look like "123456 (name)",
 		     * we get it from /proc/XX/status as "Name:   name\n...",
@@ -921,8 +1039,9 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 		    close(fd);
 		}
 		else if (pmDebugOptions.appl1 && pmDebugOptions.desperate) {
-		    fprintf(stderr, "%s: open(\"%s\", O_RDONLY) failed: %s\n",
-			    "refresh_proc_pidlist", buf, pmErrStr(-oserror()));
+		    fprintf(stderr, "%s: open(\"%s/proc/%d/status\", O_RDONLY) failed: %s\n",
+			    "refresh_proc_pidlist", proc_statspath, ep->id,
+			    pmErrStr(-oserror()));
 		}
 	    }
 
@@ -995,6 +1114,7 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 		    free(ep->wchan_buf);
 		if (ep->environ_buf != NULL)
 		    free(ep->environ_buf);
+		proc_dirfd_close(ep);
 	    	if (prev == NULL)
 		    proc_pid->pidhash.hash[i] = node->next;
 		else
@@ -1008,8 +1128,13 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
     }
 
     /* Reset accounting of the runqueue metrics, initially all zeroes */
-    if (runq)
+    if (runq) {
 	memset(runq, 0, sizeof(proc_runq_t));
+	harvest |= PROC_PID_FLAG_STAT;
+    }
+
+    /* Read the requested clusters in bulk, if the pid list is large */
+    harvest_proc_pidlist(proc_pid, numinst, harvest);
 
     /*
      * At this point, the hash table contains only valid pids.  Finally:
@@ -1019,7 +1144,8 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
      * - if runq metrics are being gathered, sample stat files now for all
      *   active processes and accumulate the values - and do this in a way
      *   that sets the FETCHED flag for these files such that they're only
-     *   read once for each sample (fetch).
+     *   read once for each sample (fetch) - if they were harvested above,
+     *   the SUCCESS flag is already set and they are not read again.
      */
     indomp->it_numinst = numinst;
     indomp->it_set = (pmdaInstid *)realloc(indomp->it_set, numinst * sizeof(pmdaInstid));
@@ -1027,7 +1153,7 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 	for (node=proc_pid->pidhash.hash[i]; node != NULL; node=node->next) {
 	    ep = (proc_pid_entry_t *)node->data;
 	    if (runq) {
-		refresh_proc_pid_stat(ep);
+		refresh_proc_pid_stat(ep, &procbuflen, &procbuf);
 		refresh_proc_runq(ep, runq);
 	    }
 	    refresh_proc_indom_entry(ep, indomp, idx++);
@@ -1038,7 +1164,7 @@ refresh_proc_pidlist(proc_pid_t *proc_pid, proc_pid_list_t *pids, proc_runq_t *r
 int
 refresh_proc_pid(proc_pid_t *proc_pid, proc_runq_t *proc_runq,
 		 int want_threads, const char *cgroups,
-		 const char *container, int namelen)
+		 const char *container, int namelen, unsigned int harvest)
 {
     char		path[MAXPATHLEN];
     int			sts, want_cgroups;
@@ -1064,7 +1190,7 @@ refresh_proc_pid(proc_pid_t *proc_pid, proc_runq_t *proc_runq,
 		"refresh_proc_pid", procpids.count, procpids.threads,
 		container ? "container" : "cgroups", filter ? filter : "");
 
-    refresh_proc_pidlist(proc_pid, &procpids, proc_runq);
+    refresh_proc_pidlist(proc_pid, &procpids, proc_runq, harvest);
     return 0;
 }
 
@@ -1079,11 +1205,83 @@ refresh_hotproc_pid(proc_pid_t *proc_pid, int threads, const char *cgroups)
     if ((sts = refresh_hotproc_pidlist(&hotpids)) < 0)
 	return sts;
 
-    refresh_proc_pidlist(proc_pid, &hotpids, NULL);
+    refresh_proc_pidlist(proc_pid, &hotpids, NULL, 0);
     return 0;
 }
 
 
+/*
+ * Each entry holds its /proc/<pid> directory open while the process
+ * lives, so that the files of every cluster are opened with a single
+ * relative lookup (openat) rather than resolving the full path anew.
+ * The number of directories held is bounded by half the open file
+ * limit; beyond that, entries simply fall back to absolute paths.
+ */
+static int	dirfd_budget = -1;	/* directories we may still hold open */
+
+static int
+proc_dirfd_open(int id)
+{
+    struct rlimit	limit;
+    char		buf[128];
+    int			fd;
+
+    if (dirfd_budget < 0) {
+	if (getrlimit(RLIMIT_NOFILE, &limit) < 0)
+	    dirfd_budget = 0;
+	else if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > INT_MAX)
+	    dirfd_budget = INT_MAX / 2;
+	else
+	    dirfd_budget = limit.rlim_cur / 2;
+    }
+    if (dirfd_budget == 0)
+	return -1;
+    pmsprintf(buf, sizeof(buf), "%s/proc/%d", proc_statspath, id);
+    if ((fd = open(buf, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) >= 0)
+	dirfd_budget--;
+    else if (oserror() == EMFILE || oserror() == ENFILE)
+	dirfd_budget = 0;
+    return fd;
+}
+
+static void
+proc_dirfd_close(proc_pid_entry_t *ep)
+{
+    if (ep->dirfd >= 0) {
+	close(ep->dirfd);
+	ep->dirfd = -1;
+	dirfd_budget++;
+    }
+}
+
+/*
+ * Open a file below the /proc/<pid> directory of an entry, relative
+ * to its directory descriptor if one is held.  Should the pid have
+ * been recycled since that directory was opened, the relative open
+ * fails yet the absolute path succeeds - switch to the new directory
+ * in that case.
+ */
+static int
+proc_openat(const char *base, proc_pid_entry_t *ep, int flags)
+{
+    int			fd, dirfd;
+    char		buf[128];
+
+    if (ep->dirfd >= 0) {
+	if ((fd = openat(ep->dirfd, base, flags)) >= 0 || oserror() != ENOENT)
+	    return fd;
+    }
+    pmsprintf(buf, sizeof(buf), "%s/proc/%d/%s", proc_statspath, ep->id, base);
+    if ((fd = open(buf, flags)) >= 0 && ep->dirfd >= 0) {
+	pmsprintf(buf, sizeof(buf), "%s/proc/%d", proc_statspath, ep->id);
+	if ((dirfd = open(buf, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) >= 0) {
+	    dup2(dirfd, ep->dirfd);
+	    close(dirfd);
+	}
+    }
+    return fd;
+}
+
 /*
  * Open a proc file, taking into account that we may want thread info
  * rather than process information.
@@ -1094,63 +1292,60 @@ refresh_hotproc_pid(proc_pid_t *proc_pid, int threads, const char *cgroups)
  * task group has all (peer) tasks in that group, even for "children".
  */
 static int
-proc_open(const char *base, proc_pid_entry_t *ep)
+proc_open_flags(const char *base, proc_pid_entry_t *ep, int flags)
 {
     int			fd;
     char		buf[128];
 
     if (procpids.threads) {
-	pmsprintf(buf, sizeof(buf), "%s/proc/%d/task/%d/%s",
-			proc_statspath, ep->id, ep->id, base);
-	fd = open(buf, O_RDONLY);
+	pmsprintf(buf, sizeof(buf), "task/%d/%s", ep->id, base);
+	fd = proc_openat(buf, ep, flags);
 	if (fd < 0) {
 	    if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-		fprintf(stderr, "%s: open(\"%s\", O_RDONLY) failed: %s\n",
-				"proc_open", buf, pmErrStr(-oserror()));
+		fprintf(stderr, "%s: open(\"%s/proc/%d/%s\", O_RDONLY) failed: %s\n",
+				"proc_open", proc_statspath, ep->id, buf,
+				pmErrStr(-oserror()));
 	    /* fallback to /proc path if task path open fails */
 	} else {
 	    if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-		fprintf(stderr, "%s: thread: %s -> fd=%d\n",
-				"proc_open", buf, fd);
+		fprintf(stderr, "%s: thread: %s/proc/%d/%s -> fd=%d\n",
+				"proc_open", proc_statspath, ep->id, buf, fd);
 	    return fd;
 	}
     }
-    pmsprintf(buf, sizeof(buf), "%s/proc/%d/%s", proc_statspath, ep->id, base);
-    fd = open(buf, O_RDONLY);
+    fd = proc_openat(base, ep, flags);
     if (fd < 0) {
 	if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-	    fprintf(stderr, "%s: open(\"%s\", O_RDONLY) failed: %s\n",
-			    "proc_open", buf, pmErrStr(-oserror()));
+	    fprintf(stderr, "%s: open(\"%s/proc/%d/%s\", O_RDONLY) failed: %s\n",
+			    "proc_open", proc_statspath, ep->id, base,
+			    pmErrStr(-oserror()));
     }
     if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-	fprintf(stderr, "%s: %s -> fd=%d\n", "proc_open", buf, fd);
+	fprintf(stderr, "%s: %s/proc/%d/%s -> fd=%d\n",
+			"proc_open", proc_statspath, ep->id, base, fd);
     return fd;
 }
 
+static int
+proc_open(const char *base, proc_pid_entry_t *ep)
+{
+    return proc_open_flags(base, ep, O_RDONLY);
+}
+
 static DIR *
 proc_opendir(const char *base, proc_pid_entry_t *ep)
 {
     DIR			*dir;
-    char		buf[128];
+    int			fd;
 
-    if (procpids.threads) {
-	pmsprintf(buf, sizeof(buf), "%s/proc/%d/task/%d/%s", proc_statspath, ep->id, ep->id, base);
-	if ((dir = opendir(buf)) != NULL) {
-	    return dir;
-	}
-	else {
-	    if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-		fprintf(stderr, "%s: opendir(\"%s\") failed: %s\n",
-				"proc_opendir", buf, pmErrStr(-oserror()));
-	}
-	/* fallback to /proc path if task path opendir fails */
-    }
-    pmsprintf(buf, sizeof(buf), "%s/proc/%d/%s", proc_statspath, ep->id, base);
-    dir = opendir(buf);
-    if (dir == NULL) {
+    if ((fd = proc_open_flags(base, ep, O_RDONLY | O_DIRECTORY)) < 0)
+	return NULL;
+    if ((dir = fdopendir(fd)) == NULL) {
 	if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-	    fprintf(stderr, "%s: opendir(\"%s\") failed: %s\n",
-			    "proc_opendir", buf, pmErrStr(-oserror()));
+	    fprintf(stderr, "%s: fdopendir(\"%s/proc/%d/%s\") failed: %s\n",
+			    "proc_opendir", proc_statspath, ep->id, base,
+			    pmErrStr(-oserror()));
+	close(fd);
     }
     return dir;
 }
@@ -1159,15 +1354,20 @@ static int
 proc_readlink(const char *base, proc_pid_entry_t *ep, size_t *lenp, char **bufp)
 {
     char		buf[1024];
-    int			sts;
+    int			sts = -1;
 
     if (*lenp < MAXPATHLEN) {
 	if ((*bufp = (char *)realloc(*bufp, MAXPATHLEN)) == NULL)
 	    return -ENOMEM;
 	*lenp = MAXPATHLEN;
     }
-    pmsprintf(buf, sizeof(buf), "%s/proc/%d/%s", proc_statspath, ep->id, base);
-    if ((sts = readlink(buf, *bufp, *lenp)) <= 0) {
+    if (ep->dirfd >= 0)
+	sts = readlinkat(ep->dirfd, base, *bufp, *lenp);
+    if (sts <= 0) {
+	pmsprintf(buf, sizeof(buf), "%s/proc/%d/%s", proc_statspath, ep->id, base);
+	sts = readlink(buf, *bufp, *lenp);
+    }
+    if (sts <= 0) {
 	if (sts < 0)	/* expected for kernel threads */
 	    sts = 0;
 	if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
@@ -1196,40 +1396,42 @@ maperr(void)
     return sts;
 }
 
+/*
+ * Read a proc file directly into a buffer that is retained by the caller
+ * and grown as needed across calls.  *lenp is the usable buffer size (an
+ * extra byte is always allocated for the trailing null), and the number
+ * of bytes read is returned on success.
+ */
 static int
 read_proc_entry(int fd, size_t *lenp, char **bufp)
 {
-    size_t		len = 0;
-    char		*p = *bufp, buf[1024];
-    int			n, sts = 0;
+    size_t		len = 0, size;
+    ssize_t		n;
+    char		*p;
 
-    for (len=0;;) {
-	if ((n = read(fd, buf, sizeof(buf))) <= 0)
+    for (;;) {
+	if (len >= *lenp) {
+	    size = *lenp ? *lenp * 2 : 4096 - 1;
+	    if ((p = (char *)realloc(*bufp, size + 1)) == NULL)
+		return -ENOMEM;
+	    *bufp = p;
+	    *lenp = size;
+	}
+	if ((n = read(fd, *bufp + len, *lenp - len)) <= 0)
 	    break;
 	len += n;
-	if (*lenp < len) {
-	    *lenp = len;
-	    *bufp = (char *)realloc(*bufp, len+1);
-	    p = *bufp + len - n;
-	}
-	memcpy(p, buf, n);
-	p += n;
     }
 
-    if (len > 0)
-    	*p = '\0';
-    else {
-	/* invalid read */
-	if (n < 0)
-	    sts = maperr();
-	else if (n == 0) {
-	    sts = PM_ERR_VALUE;
-	    if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
-		fprintf(stderr, "%s: fd=%d: no data\n", "read_proc_entry", fd);
-	}
+    if (len > 0) {
+	(*bufp)[len] = '\0';
+	return len;
     }
-
-    return sts;
+    /* invalid read */
+    if (n < 0)
+	return maperr();
+    if (pmDebugOptions.appl1 && pmDebugOptions.desperate)
+	fprintf(stderr, "%s: fd=%d: no data\n", "read_proc_entry", fd);
+    return PM_ERR_VALUE;
 }
 
 static void
@@ -1298,7 +1500,7 @@ parse_proc_stat(proc_pid_entry_t *ep, size_t buflen, char *buf)
 }
 
 static int
-refresh_proc_pid_stat(proc_pid_entry_t *ep)
+refresh_proc_pid_stat(proc_pid_entry_t *ep, size_t *lenp, char **bufp)
 {
     int			fd, sts;
 
@@ -1306,8 +1508,8 @@ refresh_proc_pid_stat(proc_pid_entry_t *ep)
 	return 0;
     if ((fd = proc_open("stat", ep)) < 0)
 	return maperr();
-    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) >= 0) {
-	parse_proc_stat(ep, procbuflen, procbuf);
+    if ((sts = read_proc_entry(fd, lenp, bufp)) >= 0) {
+	parse_proc_stat(ep, sts, *bufp);
 	ep->success |= PROC_PID_FLAG_STAT;
     }
     close(fd);
@@ -1326,7 +1528,7 @@ fetch_proc_pid_stat(int id, proc_pid_t *proc_pid, int *sts)
     if (!ep)
 	return NULL;
     if (!(ep->fetched & PROC_PID_FLAG_STAT)) {
-	*sts = refresh_proc_pid_stat(ep);
+	*sts = refresh_proc_pid_stat(ep, &procbuflen, &procbuf);
 	ep->fetched |= PROC_PID_FLAG_STAT;
     }
     return (*sts < 0) ? NULL : ep;
@@ -1379,15 +1581,14 @@ refresh_proc_pid_environ(proc_pid_entry_t *ep)
     if ((fd = proc_open("environ", ep)) >= 0) {
 	sts = read_proc_entry(fd, &ep->environ_buflen, &ep->environ_buf);
 	close(fd);
-	if (sts == 0) {
+	if (sts > 0) {
 	    /* replace nulls with spaces */
-	    if (ep->environ_buf) {
-		for (p=ep->environ_buf; p < ep->environ_buf + ep->environ_buflen; p++) {
-		    if (*p == '\0')
-			*p = ' ';
-		}
-		ep->environ_buf[ep->environ_buflen-1] = '\0';
+	    for (p=ep->environ_buf; p < ep->environ_buf + sts; p++) {
+		if (*p == '\0')
+		    *p = ' ';
 	    }
+	    ep->environ_buf[sts-1] = '\0';
+	    sts = 0;
 	} else {
 	    /* probably EOF on first read */
 	    ep->environ_buflen = 0;
@@ -1637,7 +1838,7 @@ refresh_proc_pid_status(proc_pid_entry_t *ep)
 	return 0;
     if ((fd = proc_open("status", ep)) < 0)
 	return maperr();
-    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) == 0) {
+    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) >= 0) {
 	parse_proc_status(ep, procbuflen, procbuf);
 	ep->success |= PROC_PID_FLAG_STATUS;
     }
@@ -1679,7 +1880,7 @@ parse_proc_statm(proc_pid_entry_t *ep, size_t buflen, char *buf)
 }
 
 static int
-refresh_proc_pid_statm(proc_pid_entry_t *ep)
+refresh_proc_pid_statm(proc_pid_entry_t *ep, size_t *lenp, char **bufp)
 {
     int			fd, sts;
 
@@ -1687,8 +1888,8 @@ refresh_proc_pid_statm(proc_pid_entry_t *ep)
 	return 0;
     if ((fd = proc_open("statm", ep)) < 0)
 	return maperr();
-    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) == 0) {
-	parse_proc_statm(ep, procbuflen, procbuf);
+    if ((sts = read_proc_entry(fd, lenp, bufp)) >= 0) {
+	parse_proc_statm(ep, sts, *bufp);
 	ep->success |= PROC_PID_FLAG_STATM;
     }
     close(fd);
@@ -1708,7 +1909,7 @@ fetch_proc_pid_statm(int id, proc_pid_t *proc_pid, int *sts)
     	return NULL;
 
     if (!(ep->fetched & PROC_PID_FLAG_STATM)) {
-	*sts = refresh_proc_pid_statm(ep);
+	*sts = refresh_proc_pid_statm(ep, &procbuflen, &procbuf);
 	ep->fetched |= PROC_PID_FLAG_STATM;
     }
     return (*sts < 0) ? NULL : ep;
@@ -1728,17 +1929,11 @@ refresh_proc_pid_maps(proc_pid_entry_t *ep)
     sts = read_proc_entry(fd, &ep->maps_buflen, &ep->maps_buf);
     close(fd);
 
-    /* If there are no maps, make maps_buf a zero length string. */
-    if (ep->maps_buflen == 0) {
-	ep->maps_buflen = 1;
-	ep->maps_buf = (char *)malloc(1);
-    }
+    /* If there are no maps, maps_buf is a zero length string. */
     if (ep->maps_buf) {
-	ep->maps_buf[ep->maps_buflen - 1] = '\0';
+	ep->maps_buf[sts > 0 ? sts - 1 : 0] = '\0';
 	ep->success |= PROC_PID_FLAG_MAPS;
 	sts = 0; /* clear PM_ERR_VALUE */
-    } else {
-	ep->maps_buflen = 0;
     }
     return sts;
 }
@@ -1775,7 +1970,7 @@ parse_proc_schedstat(proc_pid_entry_t *ep, size_t buflen, char *buf)
 }
 
 static int
-refresh_proc_pid_schedstat(proc_pid_entry_t *ep)
+refresh_proc_pid_schedstat(proc_pid_entry_t *ep, size_t *lenp, char **bufp)
 {
     int			fd, sts;
 
@@ -1783,8 +1978,8 @@ refresh_proc_pid_schedstat(proc_pid_entry_t *ep)
 	return 0;
     if ((fd = proc_open("schedstat", ep)) < 0)
 	return maperr();
-    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) >= 0) {
-	parse_proc_schedstat(ep, procbuflen, procbuf);
+    if ((sts = read_proc_entry(fd, lenp, bufp)) >= 0) {
+	parse_proc_schedstat(ep, sts, *bufp);
 	ep->success |= PROC_PID_FLAG_SCHEDSTAT;
     }
     close(fd);
@@ -1804,7 +1999,7 @@ fetch_proc_pid_schedstat(int id, proc_pid_t *proc_pid, int *sts)
 	return NULL;
 
     if (!(ep->fetched & PROC_PID_FLAG_SCHEDSTAT)) {
-	*sts = refresh_proc_pid_schedstat(ep);
+	*sts = refresh_proc_pid_schedstat(ep, &procbuflen, &procbuf);
 	ep->fetched |= PROC_PID_FLAG_SCHEDSTAT;
     }
     return (*sts < 0) ? NULL : ep;
@@ -1885,7 +2080,7 @@ parse_proc_io(proc_pid_entry_t *ep, size_t buflen, char *buf)
 }
 
 static int
-refresh_proc_pid_io(proc_pid_entry_t *ep)
+refresh_proc_pid_io(proc_pid_entry_t *ep, size_t *lenp, char **bufp)
 {
     int			fd, sts;
 
@@ -1893,8 +2088,8 @@ refresh_proc_pid_io(proc_pid_entry_t *ep)
 	return 0;
     if ((fd = proc_open("io", ep)) < 0)
 	return maperr();
-    if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) >= 0) {
-	parse_proc_io(ep, procbuflen, procbuf);
+    if ((sts = read_proc_entry(fd, lenp, bufp)) >= 0) {
+	parse_proc_io(ep, sts, *bufp);
 	ep->success |= PROC_PID_FLAG_IO;
     }
     close(fd);
@@ -1920,7 +2115,7 @@ fetch_proc_pid_io(int id, proc_pid_t *proc_pid, int *sts)
 	return NULL;
 
     if (!(ep->fetched & PROC_PID_FLAG_IO)) {
-	*sts = refresh_proc_pid_io(ep);
+	*sts = refresh_proc_pid_io(ep, &procbuflen, &procbuf);
 	ep->fetched |= PROC_PID_FLAG_IO;
     }
     return (*sts < 0) ? NULL : ep;
@@ -2765,7 +2960,7 @@ parse_proc_numa_maps(proc_pid_entry_t *ep, size_t buflen, char *buf)
     /*
      * Ensure the proc buffer is NUL-terminated so the string routines below
      * cannot read past the end.  read_proc_entry() allocates len+1 bytes and
-     * uses buflen (len) for the bytes-read value passed here.
+     * returns the bytes-read value (buflen) passed here.
      */
     buf[buflen] = '\0';
     end = buf + buflen;
@@ -2869,7 +3064,7 @@ refresh_proc_pid_numa_maps(proc_pid_entry_t *ep)
     ep->numa_maps.stack_id = -1;
     ep->numa_maps.private_id = -1;
     if ((sts = read_proc_entry(fd, &procbuflen, &procbuf)) >= 0) {
-	sts = parse_proc_numa_maps(ep, procbuflen, procbuf);
+	sts = parse_proc_numa_maps(ep, sts, procbuf);
 	if (sts >= 0)
 	    ep->success |= PROC_PID_FLAG_NUMA_MAPS;
     }
@@ -262,7 +262,7 @@ enum {
 
 typedef struct {
     int			id;	/* pid, hash key and internal instance id */
-    int			pad;
+    int			dirfd;	/* open /proc/<pid> directory, or -1 */
     unsigned int	fetched;   /* PROC_PID_FLAG_* values (sample attempt) */
     unsigned int	success;   /* PROC_PID_FLAG_* values (sample success) */
     char		*name;	/* full command line and args prefixed by PID */
@@ -351,7 +351,7 @@ typedef struct {
 extern proc_pid_entry_t *proc_pid_entry_lookup(int, proc_pid_t *);
 
 /* refresh the proc indom, reset all "fetched" flags */
-extern int refresh_proc_pid(proc_pid_t *, proc_runq_t *, int, const char *, const char *, int);
+extern int refresh_proc_pid(proc_pid_t *, proc_runq_t *, int, const char *, const char *, int, unsigned int);
 
 /* refresh the hotproc indom, checking against the current configuration */
 extern int refresh_hotproc_pid(proc_pid_t *, int, const char *);
@@ -428,4 +428,8 @@ extern proc_pid_entry_t *fetch_proc_pid_fdinfo(int, proc_pid_t *, int *);
 /* fetch delayacct data via netlink (libnl) for pid */
 extern proc_pid_entry_t *fetch_proc_pid_delayacct(int, proc_pid_t *, int *);
 
+/* number of threads used to harvest clusters across large pid lists */
+extern int proc_harvest_threads;
+extern int proc_harvest_minpids;
+
 #endif /* _PROC_PID_H */
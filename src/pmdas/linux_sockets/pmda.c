@@ -283,6 +283,7 @@ sockets_init(pmdaInterface *dp)
     pmdaInit(dp, indomtable, nindoms, metrictable, nmetrics);
 
     /* load the cache (if any) and run an initial refresh */
+    pmdaCacheOp(sockets_indom(SOCKETS_INDOM), PMDA_CACHE_BINARY);
     pmdaCacheOp(sockets_indom(SOCKETS_INDOM), PMDA_CACHE_LOAD);
     ss_refresh(sockets_indom(SOCKETS_INDOM));
 }
@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/*
+ * Native NETLINK_SOCK_DIAG collection of the inet (TCP and UDP, IPv4
+ * and IPv6) sockets that "ss -noemitauO" would otherwise report - the
+ * binary inet_diag messages and attributes are decoded directly into
+ * the per-socket ss_stats_t in the instance domain cache.
+ *
+ * Only filters that reduce to a set of socket states (e.g. "state all",
+ * "state established", "exclude listening") can be passed to the kernel
+ * this way; anything else is left for the ss command to evaluate.
+ */
+
+#include <pcp/pmapi.h>
+#include <pcp/pmda.h>
+#include <pcp/libpcp.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include "ss_stats.h"
+
+/* kernel TCP states, as used in inet_diag_msg and inet_diag_req_v2 */
+enum {
+    SS_UNKNOWN,
+    SS_ESTABLISHED,
+    SS_SYN_SENT,
+    SS_SYN_RECV,
+    SS_FIN_WAIT1,
+    SS_FIN_WAIT2,
+    SS_TIME_WAIT,
+    SS_CLOSE,
+    SS_CLOSE_WAIT,
+    SS_LAST_ACK,
+    SS_LISTEN,
+    SS_CLOSING,
+    SS_NEW_SYN_RECV,
+    SS_MAX
+};
+
+#define SS_ALL		((1 << SS_MAX) - 1)
+#define SS_CONN		(SS_ALL & ~((1 << SS_LISTEN) | (1 << SS_CLOSE) | \
+			(1 << SS_TIME_WAIT) | (1 << SS_SYN_RECV)))
+
+/*
+ * struct tcp_info as sent in INET_DIAG_INFO - the glibc <netinet/tcp.h>
+ * version (which pmapi.h pulls in, and which conflicts with including
+ * <linux/tcp.h>) stops well short of the fields ss reports.  The kernel
+ * only ever appends to this structure.
+ */
+struct ss_tcp_info {
+    __u8	tcpi_state;
+    __u8	tcpi_ca_state;
+    __u8	tcpi_retransmits;
+    __u8	tcpi_probes;
+    __u8	tcpi_backoff;
+    __u8	tcpi_options;
+    __u8	tcpi_snd_wscale : 4, tcpi_rcv_wscale : 4;
+    __u8	tcpi_delivery_rate_app_limited:1, tcpi_fastopen_client_fail:2;
+
+    __u32	tcpi_rto;
+    __u32	tcpi_ato;
+    __u32	tcpi_snd_mss;
+    __u32	tcpi_rcv_mss;
+
+    __u32	tcpi_unacked;
+    __u32	tcpi_sacked;
+    __u32	tcpi_lost;
+    __u32	tcpi_retrans;
+    __u32	tcpi_fackets;
+
+    __u32	tcpi_last_data_sent;
+    __u32	tcpi_last_ack_sent;
+    __u32	tcpi_last_data_recv;
+    __u32	tcpi_last_ack_recv;
+
+    __u32	tcpi_pmtu;
+    __u32	tcpi_rcv_ssthresh;
+    __u32	tcpi_rtt;
+    __u32	tcpi_rttvar;
+    __u32	tcpi_snd_ssthresh;
+    __u32	tcpi_snd_cwnd;
+    __u32	tcpi_advmss;
+    __u32	tcpi_reordering;
+
+    __u32	tcpi_rcv_rtt;
+    __u32	tcpi_rcv_space;
+
+    __u32	tcpi_total_retrans;
+
+    __u64	tcpi_pacing_rate;
+    __u64	tcpi_max_pacing_rate;
+    __u64	tcpi_bytes_acked;
+    __u64	tcpi_bytes_received;
+    __u32	tcpi_segs_out;
+    __u32	tcpi_segs_in;
+
+    __u32	tcpi_notsent_bytes;
+    __u32	tcpi_min_rtt;
+    __u32	tcpi_data_segs_in;
+    __u32	tcpi_data_segs_out;
+
+    __u64	tcpi_delivery_rate;
+
+    __u64	tcpi_busy_time;
+    __u64	tcpi_rwnd_limited;
+    __u64	tcpi_sndbuf_limited;
+
+    __u32	tcpi_delivered;
+    __u32	tcpi_delivered_ce;
+
+    __u64	tcpi_bytes_sent;
+    __u64	tcpi_bytes_retrans;
+    __u32	tcpi_dsack_dups;
+    __u32	tcpi_reord_seen;
+};
+
+/* state names as reported by ss(8) */
+static const char *ss_state_names[SS_MAX] = {
+    "UNKNOWN", "ESTAB", "SYN-SENT", "SYN-RECV", "FIN-WAIT-1", "FIN-WAIT-2",
+    "TIME-WAIT", "UNCONN", "CLOSE-WAIT", "LAST-ACK", "LISTEN", "CLOSING",
+    "SYN-RECV",
+};
+
+/* state and state class names accepted in ss(8) filters */
+static const struct {
+    const char	*name;
+    int		states;
+} ss_state_filters[] = {
+    { "all",		SS_ALL },
+    { "connected",	SS_CONN },
+    { "synchronized",	SS_CONN & ~(1 << SS_SYN_SENT) },
+    { "bucket",		(1 << SS_SYN_RECV) | (1 << SS_TIME_WAIT) },
+    { "big",		SS_ALL & ~((1 << SS_SYN_RECV) | (1 << SS_TIME_WAIT)) },
+    { "established",	1 << SS_ESTABLISHED },
+    { "syn-sent",	1 << SS_SYN_SENT },
+    { "syn-recv",	1 << SS_SYN_RECV },
+    { "fin-wait-1",	1 << SS_FIN_WAIT1 },
+    { "fin-wait-2",	1 << SS_FIN_WAIT2 },
+    { "time-wait",	1 << SS_TIME_WAIT },
+    { "closed",		1 << SS_CLOSE },
+    { "close-wait",	1 << SS_CLOSE_WAIT },
+    { "last-ack",	1 << SS_LAST_ACK },
+    { "listening",	1 << SS_LISTEN },
+    { "listen",		1 << SS_LISTEN },
+    { "closing",	1 << SS_CLOSING },
+};
+
+/* timer names as reported by ss(8) */
+static const char *ss_timer_names[] = {
+    "off", "on", "keepalive", "timewait", "persist", "unknown"
+};
+
+static int	nl_fd = -1;		/* sock_diag netlink socket */
+static int	nl_disabled;		/* netlink unavailable, always use ss */
+static char	*nl_filter;		/* ss_filter last translated */
+static int	nl_states;		/* kernel state mask for nl_filter */
+static char	nl_buf[64 * 1024];	/* reused for every dump */
+
+/*
+ * Translate the ss filter to a kernel socket state mask, if it only
+ * consists of "state" and "exclude" clauses.  Returns 0 if the filter
+ * needs the ss command to evaluate it.
+ */
+static int
+ss_filter_states(const char *filter)
+{
+    char	*s, *tok, *saveptr;
+    int		states = 0;
+    int		exclude = 0;
+    int		expect = 0;	/* 1 after "state", 2 after "exclude" */
+    int		i;
+
+    if ((s = strdup(filter)) == NULL)
+	return 0;
+    for (tok = strtok_r(s, " \t", &saveptr); tok != NULL;
+	 tok = strtok_r(NULL, " \t", &saveptr)) {
+	if (expect == 0) {
+	    if (strcmp(tok, "state") == 0)
+		expect = 1;
+	    else if (strcmp(tok, "exclude") == 0 || strcmp(tok, "excl") == 0)
+		expect = 2;
+	    else
+		break;
+	    continue;
+	}
+	for (i = 0; i < sizeof(ss_state_filters) / sizeof(ss_state_filters[0]); i++) {
+	    if (strcmp(tok, ss_state_filters[i].name) == 0)
+		break;
+	}
+	if (i == sizeof(ss_state_filters) / sizeof(ss_state_filters[0]))
+	    break;
+	if (expect == 1)
+	    states |= ss_state_filters[i].states;
+	else
+	    exclude |= ss_state_filters[i].states;
+	expect = 0;
+    }
+    free(s);
+    if (tok != NULL || expect != 0)
+	return 0;	/* more than ss_filter_states() can express */
+
+    /* ss -a: with no state clauses, all states are reported */
+    if (states == 0)
+	states = SS_ALL;
+    states &= ~exclude;
+    if (states & (1 << SS_SYN_RECV))
+	states |= (1 << SS_NEW_SYN_RECV);
+    return states;
+}
+
+/*
+ * Returns 1 if the netlink interface can be used for the current
+ * filter (opening the netlink socket on first use), else 0.
+ */
+int
+ss_netlink_open(void)
+{
+    if (nl_disabled || getenv("PCPQA_PMDA_SOCKETS") != NULL)
+	return 0;
+
+    if (ss_filter == NULL) {
+	/* pmstore to network.persocket.filter frees this if changing */
+	if ((ss_filter = strdup("")) == NULL)
+	    return 0;
+    }
+    if (nl_filter == NULL || strcmp(nl_filter, ss_filter) != 0) {
+	if (nl_filter)
+	    free(nl_filter);
+	if ((nl_filter = strdup(ss_filter)) == NULL)
+	    return 0;
+	nl_states = ss_filter_states(ss_filter);
+	if (pmDebugOptions.appl0)
+	    fprintf(stderr, "ss_netlink_open: filter \"%s\" -> states 0x%x\n",
+		    ss_filter, nl_states);
+    }
+    if (nl_states == 0)
+	return 0;
+
+    if (nl_fd < 0) {
+	nl_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (nl_fd < 0) {
+	    if (pmDebugOptions.appl0)
+		fprintf(stderr, "ss_netlink_open: socket: %s\n",
+			pmErrStr(-oserror()));
+	    nl_disabled = 1;
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+/*
+ * Format an address and port the way "ss -n" does
+ */
+static void
+ss_addr(char *buf, int buflen, int family, const __be32 *addr,
+	__be16 port, unsigned int ifindex, int v6only)
+{
+    char	host[INET6_ADDRSTRLEN];
+    char	ifname[IF_NAMESIZE + 1];
+    char	service[8];
+    int		n;
+
+    if (family == AF_INET) {
+	inet_ntop(AF_INET, addr, host, sizeof(host));
+	n = pmsprintf(buf, buflen, "%s", host);
+    }
+    else if (!v6only && IN6_IS_ADDR_UNSPECIFIED((const struct in6_addr *)addr))
+	n = pmsprintf(buf, buflen, "*");
+    else {
+	inet_ntop(AF_INET6, addr, host, sizeof(host));
+	n = pmsprintf(buf, buflen, "[%s]", host);
+    }
+    if (ifindex && if_indextoname(ifindex, ifname) != NULL)
+	n += pmsprintf(buf + n, buflen - n, "%%%s", ifname);
+    if (port)
+	pmsprintf(service, sizeof(service), "%u", ntohs(port));
+    else
+	strcpy(service, "*");
+    pmsprintf(buf + n, buflen - n, ":%s", service);
+}
+
+/*
+ * Format a timer expiry the way ss does, e.g. 3min57sec or 200ms
+ */
+static void
+ss_timer_expire(char *buf, int buflen, unsigned int timeout)
+{
+    int		minutes, secs, msecs;
+    int		n = 0;
+
+    secs = timeout / 1000;
+    minutes = secs / 60;
+    secs = secs % 60;
+    msecs = timeout % 1000;
+    buf[0] = '\0';
+    if (minutes) {
+	msecs = 0;
+	n += pmsprintf(buf, buflen, "%dmin", minutes);
+	if (minutes > 9)
+	    secs = 0;
+    }
+    if (secs) {
+	if (secs > 9)
+	    msecs = 0;
+	n += pmsprintf(buf + n, buflen - n, "%d%s", secs, msecs ? "." : "sec");
+    }
+    if (msecs)
+	pmsprintf(buf + n, buflen - n, "%03dms", msecs);
+}
+
+static void
+ss_decode_skmem(ss_stats_t *ss, const __u32 *skmem, int len)
+{
+    __u32	mem[SK_MEMINFO_VARS] = { 0 };
+
+    memcpy(mem, skmem, len < sizeof(mem) ? len : sizeof(mem));
+    ss->skmem_rmem_alloc = mem[SK_MEMINFO_RMEM_ALLOC];
+    ss->skmem_rcv_buf = mem[SK_MEMINFO_RCVBUF];
+    ss->skmem_wmem_alloc = mem[SK_MEMINFO_WMEM_ALLOC];
+    ss->skmem_snd_buf = mem[SK_MEMINFO_SNDBUF];
+    ss->skmem_fwd_alloc = mem[SK_MEMINFO_FWD_ALLOC];
+    ss->skmem_wmem_queued = mem[SK_MEMINFO_WMEM_QUEUED];
+    ss->skmem_ropt_mem = mem[SK_MEMINFO_OPTMEM];
+    ss->skmem_back_log = mem[SK_MEMINFO_BACKLOG];
+    ss->skmem_sock_drop = mem[SK_MEMINFO_DROPS];
+    pmsprintf(ss->skmem_str, sizeof(ss->skmem_str),
+		"r%u,rb%u,t%u,tb%u,f%u,w%u,o%u,bl%u,d%u",
+		ss->skmem_rmem_alloc, ss->skmem_rcv_buf,
+		ss->skmem_wmem_alloc, ss->skmem_snd_buf,
+		ss->skmem_fwd_alloc, ss->skmem_wmem_queued,
+		ss->skmem_ropt_mem, ss->skmem_back_log,
+		ss->skmem_sock_drop);
+}
+
+/*
+ * Decode struct tcp_info - older kernels send a shorter structure,
+ * in which case the missing (trailing) fields remain zero
+ */
+static void
+ss_decode_tcp_info(ss_stats_t *ss, const void *data, int len)
+{
+    struct ss_tcp_info	info;
+
+    memset(&info, 0, sizeof(info));
+    memcpy(&info, data, len < sizeof(info) ? len : sizeof(info));
+
+    ss->ts = (info.tcpi_options & TCPI_OPT_TIMESTAMPS) != 0;
+    ss->sack = (info.tcpi_options & TCPI_OPT_SACK) != 0;
+    if (info.tcpi_options & TCPI_OPT_WSCALE) {
+	ss->wscale_snd = info.tcpi_snd_wscale;
+	ss->wscale_rcv = info.tcpi_rcv_wscale;
+	pmsprintf(ss->wscale_str, sizeof(ss->wscale_str), "%d,%d",
+		    ss->wscale_snd, ss->wscale_rcv);
+    }
+    if (info.tcpi_rto && info.tcpi_rto != 3000000)
+	ss->rto = (double)info.tcpi_rto / 1000;
+    ss->backoff = info.tcpi_backoff;
+    ss->round_trip_rtt = (double)info.tcpi_rtt / 1000;
+    ss->round_trip_rttvar = (double)info.tcpi_rttvar / 1000;
+    if (info.tcpi_rtt)
+	pmsprintf(ss->round_trip_str, sizeof(ss->round_trip_str), "%g/%g",
+		    ss->round_trip_rtt, ss->round_trip_rttvar);
+    ss->ato = (double)info.tcpi_ato / 1000;
+    ss->mss = info.tcpi_snd_mss;
+    ss->pmtu = info.tcpi_pmtu;
+    ss->rcvmss = info.tcpi_rcv_mss;
+    ss->advmss = info.tcpi_advmss;
+    ss->cwnd = info.tcpi_snd_cwnd;
+    if (info.tcpi_snd_ssthresh < 0xFFFF)
+	ss->ssthresh = info.tcpi_snd_ssthresh;
+    ss->bytes_sent = info.tcpi_bytes_sent;
+    ss->bytes_retrans = info.tcpi_bytes_retrans;
+    ss->bytes_acked = info.tcpi_bytes_acked;
+    ss->bytes_received = info.tcpi_bytes_received;
+    ss->segs_out = info.tcpi_segs_out;
+    ss->segs_in = info.tcpi_segs_in;
+    ss->data_segs_out = info.tcpi_data_segs_out;
+    ss->data_segs_in = info.tcpi_data_segs_in;
+    if (info.tcpi_rtt && info.tcpi_snd_cwnd && info.tcpi_snd_mss)
+	ss->send = (double)info.tcpi_snd_cwnd * (double)info.tcpi_snd_mss *
+		    8000000.0 / (double)info.tcpi_rtt;
+    ss->lastsnd = info.tcpi_last_data_sent;
+    ss->lastrcv = info.tcpi_last_data_recv;
+    ss->lastack = info.tcpi_last_ack_recv;
+    if (info.tcpi_pacing_rate && info.tcpi_pacing_rate != ~0ULL)
+	ss->pacing_rate = (double)info.tcpi_pacing_rate * 8;
+    ss->delivery_rate = (double)info.tcpi_delivery_rate * 8;
+    ss->delivered = info.tcpi_delivered;
+    ss->app_limited = info.tcpi_delivery_rate_app_limited;
+    ss->reord_seen = info.tcpi_reord_seen;
+    ss->busy = info.tcpi_busy_time / 1000;
+    ss->unacked = info.tcpi_unacked;
+    ss->rwnd_limited = info.tcpi_rwnd_limited / 1000;
+    if (info.tcpi_retrans || info.tcpi_total_retrans)
+	pmsprintf(ss->retrans_str, sizeof(ss->retrans_str), "%u/%u",
+		    info.tcpi_retrans, info.tcpi_total_retrans);
+    ss->dsack_dups = info.tcpi_dsack_dups;
+    ss->rcv_rtt = (double)info.tcpi_rcv_rtt / 1000;
+    ss->rcv_space = info.tcpi_rcv_space;
+    ss->lost = info.tcpi_lost;
+    ss->rcv_ssthresh = info.tcpi_rcv_ssthresh;
+    ss->minrtt = (double)info.tcpi_min_rtt / 1000;
+    ss->notsent = info.tcpi_notsent_bytes;
+}
+
+/*
+ * Decode one inet_diag_msg into the cache entry for its socket
+ */
+static int
+ss_netlink_store(int indom, const char *netid, struct nlmsghdr *nlh)
+{
+    struct inet_diag_msg	*r = NLMSG_DATA(nlh);
+    struct rtattr		*attr;
+    struct rtattr		*tb[INET_DIAG_MAX + 1] = { NULL };
+    ss_stats_t			*ss;
+    char			src[SZ_ADDR_PORT];
+    char			dst[SZ_ADDR_PORT];
+    char			instname[2*SZ_ADDR_PORT+2];	/* src<->addr */
+    int				len, v6only = 0, inst, state;
+
+    len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*r));
+    if (len < 0)
+	return PM_ERR_IPC;
+    for (attr = (struct rtattr *)(r + 1); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+	if (attr->rta_type <= INET_DIAG_MAX)
+	    tb[attr->rta_type] = attr;
+    }
+
+    if (r->idiag_family == AF_INET6 && tb[INET_DIAG_SKV6ONLY] != NULL)
+	v6only = *(__u8 *)RTA_DATA(tb[INET_DIAG_SKV6ONLY]);
+    ss_addr(src, sizeof(src), r->idiag_family, r->id.idiag_src,
+		r->id.idiag_sport, r->id.idiag_if, v6only);
+    ss_addr(dst, sizeof(dst), r->idiag_family, r->id.idiag_dst,
+		r->id.idiag_dport, 0, v6only);
+    ss_instname(netid, v6only, src, dst, instname, sizeof(instname));
+
+    ss = NULL;
+    if (pmdaCacheLookupName(indom, instname, &inst, (void **)&ss) < 0 || ss == NULL) {
+	/* new entry */
+	if ((ss = (ss_stats_t *)malloc(sizeof(ss_stats_t))) == NULL)
+	    return -ENOMEM;
+    }
+    memset(ss, 0, sizeof(*ss));
+
+    pmstrncpy(ss->netid, sizeof(ss->netid), netid);
+    state = r->idiag_state < SS_MAX ? r->idiag_state : SS_UNKNOWN;
+    pmstrncpy(ss->state, sizeof(ss->state), ss_state_names[state]);
+    ss->recvq = r->idiag_rqueue;
+    ss->sendq = r->idiag_wqueue;
+    pmstrncpy(ss->src, sizeof(ss->src), src);
+    pmstrncpy(ss->dst, sizeof(ss->dst), dst);
+    ss->inode = r->idiag_inode;
+    ss->uid = r->idiag_uid;
+    ss->sk = ((__uint64_t)r->id.idiag_cookie[1] << 32) | r->id.idiag_cookie[0];
+    ss->v6only = v6only;
+
+    if (r->idiag_timer) {
+	int	timer = r->idiag_timer < 5 ? r->idiag_timer : 5;
+
+	pmstrncpy(ss->timer_name, sizeof(ss->timer_name), ss_timer_names[timer]);
+	ss_timer_expire(ss->timer_expire_str, sizeof(ss->timer_expire_str),
+			r->idiag_expires);
+	ss->timer_retrans = r->idiag_retrans;
+	pmsprintf(ss->timer_str, sizeof(ss->timer_str), "%s,%s,%d",
+		    ss->timer_name, ss->timer_expire_str, ss->timer_retrans);
+    }
+
+    if ((attr = tb[INET_DIAG_SKMEMINFO]) != NULL)
+	ss_decode_skmem(ss, RTA_DATA(attr), RTA_PAYLOAD(attr));
+    if ((attr = tb[INET_DIAG_INFO]) != NULL && strcmp(netid, "tcp") == 0)
+	ss_decode_tcp_info(ss, RTA_DATA(attr), RTA_PAYLOAD(attr));
+    if ((attr = tb[INET_DIAG_CONG]) != NULL)
+	ss->cubic = strncmp(RTA_DATA(attr), "cubic", RTA_PAYLOAD(attr)) == 0;
+
+    ss->instid = pmdaCacheStore(indom, PMDA_CACHE_ADD, instname, (void *)ss);
+    return 0;
+}
+
+/*
+ * Dump all sockets of one family and protocol into the cache
+ */
+static int
+ss_netlink_dump(int indom, int family, int protocol, const char *netid)
+{
+    struct {
+	struct nlmsghdr		nlh;
+	struct inet_diag_req_v2	req;
+    } request;
+    struct sockaddr_nl	nladdr = { .nl_family = AF_NETLINK };
+    struct nlmsghdr	*nlh;
+    ssize_t		bytes;
+    int			sts;
+
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq = protocol << 8 | family;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = protocol;
+    request.req.idiag_states = nl_states;
+    request.req.idiag_ext = (1 << (INET_DIAG_INFO - 1)) |
+			    (1 << (INET_DIAG_CONG - 1)) |
+			    (1 << (INET_DIAG_SKMEMINFO - 1));
+
+    if (sendto(nl_fd, &request, sizeof(request), 0,
+		(struct sockaddr *)&nladdr, sizeof(nladdr)) < 0)
+	return -oserror();
+
+    for (;;) {
+	if ((bytes = recv(nl_fd, nl_buf, sizeof(nl_buf), 0)) < 0) {
+	    if (oserror() == EINTR)
+		continue;
+	    return -oserror();
+	}
+	if (bytes == 0)
+	    return PM_ERR_IPC;
+	for (nlh = (struct nlmsghdr *)nl_buf; NLMSG_OK(nlh, bytes);
+	     nlh = NLMSG_NEXT(nlh, bytes)) {
+	    if (nlh->nlmsg_seq != request.nlh.nlmsg_seq)
+		continue;
+	    if (nlh->nlmsg_type == NLMSG_DONE)
+		return 0;
+	    if (nlh->nlmsg_type == NLMSG_ERROR) {
+		struct nlmsgerr	*err = NLMSG_DATA(nlh);
+
+		/* no kernel support for this protocol (e.g. udp_diag) */
+		if (err->error == -ENOENT)
+		    return 0;
+		return err->error ? err->error : PM_ERR_IPC;
+	    }
+	    if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY)
+		continue;
+	    if ((sts = ss_netlink_store(indom, netid, nlh)) < 0)
+		return sts;
+	}
+    }
+}
+
+int
+ss_netlink_refresh(int indom)
+{
+    int		sts;
+
+    if ((sts = ss_netlink_dump(indom, AF_INET, IPPROTO_TCP, "tcp")) < 0 ||
+	(sts = ss_netlink_dump(indom, AF_INET6, IPPROTO_TCP, "tcp")) < 0 ||
+	(sts = ss_netlink_dump(indom, AF_INET, IPPROTO_UDP, "udp")) < 0 ||
+	(sts = ss_netlink_dump(indom, AF_INET6, IPPROTO_UDP, "udp")) < 0) {
+	if (pmDebugOptions.appl0)
+	    fprintf(stderr, "ss_netlink_refresh: %s\n", pmErrStr(sts));
+	/* drop the socket, a partially read dump cannot be resumed */
+	close(nl_fd);
+	nl_fd = -1;
+    }
+    return sts;
+}
@@ -22,8 +22,9 @@ static ss_stats_t ss_p;
 /* boolean value with no separate value, default 0 */
 #define PM_TYPE_BOOL (PM_TYPE_UNKNOWN-1)
 
-/* helper macros to extract field address and size */
-#define SSFIELD(str,type,f) {(str), (sizeof(str)-1), type, (&(f)), (sizeof(f))}
+/* helper macros to extract field address, size and integer base */
+#define SSFIELD(str,type,f) {(str), (sizeof(str)-1), type, (&(f)), (sizeof(f)), 10}
+#define SSHEXFIELD(str,type,f) {(str), (sizeof(str)-1), type, (&(f)), (sizeof(f)), 16}
 #define SSNULLFIELD(str) {(str), (sizeof(str)-1), PM_TYPE_UNKNOWN, NULL}
 
 static struct {
@@ -32,12 +33,13 @@ static struct {
     int type;
     void *addr;
     int size;
+    int base;
     int found;
 } parse_table[] = {
     SSFIELD("timer:", PM_TYPE_STRING, ss_p.timer_str),
     SSFIELD("uid:", PM_TYPE_U32, ss_p.uid),
     SSFIELD("ino:", PM_TYPE_64, ss_p.inode),
-    SSFIELD("sk:", PM_TYPE_U64, ss_p.sk),
+    SSHEXFIELD("sk:", PM_TYPE_U64, ss_p.sk), /* cookie in hex, e.g. sk:976e */
     SSFIELD("cgroup:", PM_TYPE_STRING, ss_p.cgroup),
     SSFIELD("v6only:", PM_TYPE_32, ss_p.v6only),
     SSNULLFIELD("--- "),
@@ -295,19 +297,19 @@ ss_parse(char *line, int has_state_field, ss_stats_t *ss)
                         break;
                     case PM_TYPE_32:
                         p += parse_table[i].len;
-                        *(__int32_t *)(parse_table[i].addr) = strtol(p, NULL, 10);
+                        *(__int32_t *)(parse_table[i].addr) = strtol(p, NULL, parse_table[i].base);
                         break;
                     case PM_TYPE_U32:
                         p += parse_table[i].len;
-                        *(__uint32_t *)(parse_table[i].addr) = strtoul(p, NULL, 10);
+                        *(__uint32_t *)(parse_table[i].addr) = strtoul(p, NULL, parse_table[i].base);
                         break;
                     case PM_TYPE_64:
                         p += parse_table[i].len;
-                        *(__int64_t *)(parse_table[i].addr) = strtoll(p, NULL, 10);
+                        *(__int64_t *)(parse_table[i].addr) = strtoll(p, NULL, parse_table[i].base);
                         break;
                     case PM_TYPE_U64:
                         p += parse_table[i].len;
-                        *(__uint64_t *)(parse_table[i].addr) = strtoull(p, NULL, 10);
+                        *(__uint64_t *)(parse_table[i].addr) = strtoull(p, NULL, parse_table[i].base);
                         break;
                     case PM_TYPE_FLOAT:
                         p += parse_table[i].len;
@@ -16,11 +16,15 @@
 
 #include "ss_stats.h"
 
-static char *
-ss_instname(ss_stats_t *ss, char *buf, int buflen)
+/*
+ * Socket instance name, the same whether from ss output or netlink
+ */
+char *
+ss_instname(const char *netid, int v6only, const char *src, const char *dst,
+		char *buf, int buflen)
 {
     /* af/src:port<->dst:port */
-    pmsprintf(buf, buflen, "%s%s%s<->%s", ss->netid, ss->v6only ? "6/" : "/", ss->src, ss->dst);
+    pmsprintf(buf, buflen, "%s%s%s<->%s", netid, v6only ? "6/" : "/", src, dst);
 
     return buf;
 }
@@ -32,10 +36,9 @@ ss_free(void *p)
     free(ss);
 }
 
-int
-ss_refresh(int indom)
+static int
+ss_stream_refresh(int indom, FILE *fp)
 {
-    FILE *fp;
     int sts = 0;
     ss_stats_t *ss, parsed_ss;
     int inst;
@@ -43,12 +46,6 @@ ss_refresh(int indom)
     char instname[2*SZ_ADDR_PORT+2];	/* src<->addr */
     char line[4096] = {0};
 
-    if ((fp = ss_open_stream()) == NULL)
-    	return -errno;
-
-    /* invalidate all cache entries */
-    pmdaCacheOp(indom, PMDA_CACHE_INACTIVE);
-    
     has_state_field = 0;
     memset(&parsed_ss, 0, sizeof(parsed_ss));
     while (fgets(line, sizeof(line), fp) != NULL) {
@@ -61,23 +58,44 @@ ss_refresh(int indom)
 	}
 		
 	ss_parse(line, has_state_field, &parsed_ss);
-	ss_instname(&parsed_ss, instname, sizeof(instname));
+	ss_instname(parsed_ss.netid, parsed_ss.v6only, parsed_ss.src,
+			parsed_ss.dst, instname, sizeof(instname));
 	ss = NULL;
 	sts = pmdaCacheLookupName(indom, instname, &inst, (void **)&ss);
 	if (sts < 0 || ss == NULL) {
 	    /* new entry */
 	    if (ss == NULL)
 		ss = (ss_stats_t *)malloc(sizeof(ss_stats_t));
-	    if (ss == NULL) {
-		ss_close_stream(fp);
+	    if (ss == NULL)
 	    	return -ENOMEM;
-	    }
 	    sts = 0;
 	}
 	*ss = parsed_ss;
 	ss->instid = pmdaCacheStore(indom, PMDA_CACHE_ADD, instname, (void **)ss);
     }
-    ss_close_stream(fp);
+    return sts;
+}
+
+int
+ss_refresh(int indom)
+{
+    FILE *fp;
+    int sts;
+
+    if (ss_netlink_open()) {
+	/* invalidate all cache entries */
+	pmdaCacheOp(indom, PMDA_CACHE_INACTIVE);
+	sts = ss_netlink_refresh(indom);
+    }
+    else {
+	if ((fp = ss_open_stream()) == NULL)
+	    return -errno;
+
+	/* invalidate all cache entries */
+	pmdaCacheOp(indom, PMDA_CACHE_INACTIVE);
+	sts = ss_stream_refresh(indom, fp);
+	ss_close_stream(fp);
+    }
 
     /* purge inactive/closed sockets after 10min, and free private data */
     pmdaCachePurgeCallback(indom, 600, ss_free);
@@ -88,7 +88,10 @@ typedef struct ss_stats {
 } ss_stats_t;
 
 extern int ss_refresh(int);
+extern char *ss_instname(const char *, int, const char *, const char *, char *, int);
 extern int ss_parse(char *, int, ss_stats_t *);
 extern FILE *ss_open_stream(void);
 extern void ss_close_stream(FILE *);
+extern int ss_netlink_open(void);
+extern int ss_netlink_refresh(int);
 extern char *ss_filter; /* current string value of network.persocket.filter */
@@ -59,6 +59,13 @@ static pmdaOptions opts = {
     .long_options = longopts,
 };
 
+typedef struct {
+    unsigned int	item;		/* metric item identifier */
+    int			metric;		/* index into metrics1/2 */
+    mmv_disk_value_t	*first;		/* first value for this metric */
+    __pmHashCtl		insts;		/* internal instance -> value */
+} item_t;
+
 typedef struct {
     char		*name;		/* strdup client name */
     void		*addr;		/* mmap */
@@ -72,6 +79,8 @@ typedef struct {
     int			mcnt2;		/* number of v2 metrics */
     int			icnt;		/* number of instance domains */
     int			lcnt;		/* number of labels */
+    item_t		*items;		/* sorted by item, then metric */
+    int			nitems;		/* number of items entries */
     int			version;	/* v1/v2/v3 version number */
     int			cluster;	/* cluster identifier */
     pid_t		pid;		/* process identifier */
@@ -589,6 +598,168 @@ create_indom(pmdaExt *pmda, stats_t *s, __uint64_t offset, __uint32_t count,
     return 0;
 }
 
+static void
+free_items(stats_t *s)
+{
+    int			i;
+
+    for (i = 0; i < s->nitems; i++)
+	__pmHashFree(&s->items[i].insts);
+    free(s->items);
+    s->items = NULL;
+    s->nitems = 0;
+}
+
+static int
+compare_items(const void *a, const void *b)
+{
+    const item_t	*ia = (const item_t *)a;
+    const item_t	*ib = (const item_t *)b;
+
+    if (ia->item != ib->item)
+	return ia->item < ib->item ? -1 : 1;
+    return ia->metric - ib->metric;
+}
+
+/*
+ * Build the per-item value index for a mapped file, so that fetch
+ * can find the value for an (item, instance) pair directly rather
+ * than scanning every metric and then every value in the file.
+ * Item identifiers can be sparse, so rather than a table spanning the
+ * item range there is one entry per metric, sorted by item and found
+ * by binary search; metrics sharing an item keep their file order.
+ * The layout of the values section cannot change without a change
+ * in the generation number, which in turn triggers a remap.
+ */
+static void
+index_items(agent_t *ap, stats_t *s)
+{
+    mmv_disk_metric_t	*m1 = s->metrics1;
+    mmv_disk_metric2_t	*m2 = s->metrics2;
+    mmv_disk_value_t	*v = s->values;
+    __int64_t		offset, base, msize;
+    __uint32_t		indom, internal;
+    item_t		*ip;
+    int			i, item, mcnt, *entry;
+
+    if (s->version == MMV_VERSION1) {
+	mcnt = s->mcnt1;
+	msize = sizeof(mmv_disk_metric_t);
+	base = (char *)m1 - (char *)s->addr;
+    } else {
+	mcnt = s->mcnt2;
+	msize = sizeof(mmv_disk_metric2_t);
+	base = (char *)m2 - (char *)s->addr;
+    }
+    if (mcnt == 0)
+	return;
+
+    if ((s->items = calloc(mcnt, sizeof(item_t))) == NULL ||
+	(entry = malloc(mcnt * sizeof(int))) == NULL) {
+	pmNotifyErr(LOG_ERR, "%s: %s: index items out of memory: %s",
+			ap->prefix, s->name, osstrerror());
+	free(s->items);
+	s->items = NULL;
+	return;
+    }
+    for (i = 0; i < mcnt; i++) {
+	item = (s->version == MMV_VERSION1) ? m1[i].item : m2[i].item;
+	if (pmID_item(item) != item)
+	    continue;
+	ip = &s->items[s->nitems++];
+	ip->item = item;
+	ip->metric = i;
+	__pmHashInit(&ip->insts);
+    }
+    qsort(s->items, s->nitems, sizeof(item_t), compare_items);
+
+    /* metric index -> index entry, for placing each value */
+    for (i = 0; i < mcnt; i++)
+	entry[i] = -1;
+    for (i = 0; i < s->nitems; i++)
+	entry[s->items[i].metric] = i;
+
+    for (i = 0; i < s->vcnt; i++) {
+	offset = v[i].metric - base;
+	if (offset < 0 || offset >= mcnt * msize || offset % msize != 0)
+	    continue;
+	offset /= msize;
+	if (entry[offset] < 0)
+	    continue;
+	ip = &s->items[entry[offset]];
+	if (ip->first == NULL)
+	    ip->first = &v[i];
+	indom = (s->version == MMV_VERSION1) ?
+			m1[offset].indom : m2[offset].indom;
+	if (indom == PM_INDOM_NULL || indom == 0)
+	    continue;
+
+	if (s->version == MMV_VERSION1) {
+	    if (s->len < v[i].instance + sizeof(mmv_disk_instance_t))
+		continue;
+	    internal = ((mmv_disk_instance_t *)
+			((char *)s->addr + v[i].instance))->internal;
+	} else {
+	    if (s->len < v[i].instance + sizeof(mmv_disk_instance2_t))
+		continue;
+	    internal = ((mmv_disk_instance2_t *)
+			((char *)s->addr + v[i].instance))->internal;
+	}
+	/* first value for a given instance wins, duplicates are ignored */
+	if (__pmHashSearch(internal, &ip->insts) == NULL)
+	    __pmHashAdd(internal, &v[i], &ip->insts);
+    }
+    free(entry);
+}
+
+/* first index entry for an item - the metric describing it */
+static item_t *
+find_item(stats_t *s, unsigned int item)
+{
+    int			lo = 0, hi = s->nitems, mid;
+
+    while (lo < hi) {
+	mid = lo + (hi - lo) / 2;
+	if (s->items[mid].item < item)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    if (lo < s->nitems && s->items[lo].item == item)
+	return &s->items[lo];
+    return NULL;
+}
+
+/*
+ * Find the value of an item for an instance.  Where metrics share an
+ * item (the namespace keeps the first, see verify_metric_item) values
+ * come from the first of those holding one for the instance.
+ */
+static item_t *
+find_value(stats_t *s, item_t *ip, unsigned int inst, mmv_disk_value_t **value)
+{
+    item_t		*last = &s->items[s->nitems];
+    __pmHashNode	*hp;
+    __uint32_t		indom;
+    unsigned int	item = ip->item;
+
+    for (; ip < last && ip->item == item; ip++) {
+	if (ip->first == NULL)
+	    continue;
+	indom = (s->version == MMV_VERSION1) ?
+		s->metrics1[ip->metric].indom : s->metrics2[ip->metric].indom;
+	if (indom == PM_INDOM_NULL || indom == 0 || inst == PM_IN_NULL) {
+	    *value = ip->first;
+	    return ip;
+	}
+	if ((hp = __pmHashSearch(inst, &ip->insts)) != NULL) {
+	    *value = (mmv_disk_value_t *)hp->data;
+	    return ip;
+	}
+    }
+    return NULL;
+}
+
 static void
 map_stats(pmdaExt *pmda)
 {
@@ -636,6 +807,7 @@ map_stats(pmdaExt *pmda)
 
     if (ap->slist != NULL) {
 	for (i = 0; i < ap->scnt; i++) {
+	    free_items(&ap->slist[i]);
 	    free(ap->slist[i].name);
 	    __pmMemoryUnmap(ap->slist[i].addr, ap->slist[i].len);
 	}
@@ -891,6 +1063,7 @@ map_stats(pmdaExt *pmda)
 		break;
 	    }
 	}
+	index_items(ap, s);
     }
 
     pmdaTreeRebuildHash(ap->pmns, ap->mtot); /* for reverse (pmid->name) lookups */
@@ -927,42 +1100,20 @@ mmv_lookup_item1(int item, unsigned int inst,
 	stats_t *s, mmv_disk_value_t **value,
 	__uint64_t *shorttext, __uint64_t *helptext)
 {
-    mmv_disk_metric_t	*m1 = s->metrics1;
-    mmv_disk_value_t	*v = s->values;
-    int			mi, vi, sts = PM_ERR_PMID;
-
-    for (mi = 0; mi < s->mcnt1; mi++) {
-	if (m1[mi].item != item)
-	    continue;
+    mmv_disk_metric_t	*m1;
+    item_t		*ip;
 
-	if (value == NULL) {
-	    if (shorttext)
-		*shorttext = m1[mi].shorttext;
-	    if (helptext)
-		*helptext = m1[mi].helptext;
-	    return m1[mi].type;
-	}
-
-	sts = PM_ERR_INST;
-	for (vi = 0; vi < s->vcnt; vi++) {
-	    mmv_disk_metric_t *mt = (mmv_disk_metric_t *)
-			((char *)s->addr + v[vi].metric);
-	    mmv_disk_instance_t *is = (mmv_disk_instance_t *)
-			((char *)s->addr + v[vi].instance);
-
-	    if ((mt == &m1[mi]) &&
-		(mt->indom == PM_INDOM_NULL || mt->indom == 0 ||
-		inst == PM_IN_NULL || is->internal == inst)) {
-		if (shorttext)
-		    *shorttext = m1[mi].shorttext;
-		if (helptext)
-		    *helptext = m1[mi].helptext;
-		*value = &v[vi];
-		return m1[mi].type;
-	    }
-	}
-    }
-    return sts;
+    if (item < 0 || (ip = find_item(s, item)) == NULL)
+	return PM_ERR_PMID;
+    if (value != NULL && (ip = find_value(s, ip, inst, value)) == NULL)
+	return PM_ERR_INST;
+    m1 = &s->metrics1[ip->metric];
+
+    if (shorttext)
+	*shorttext = m1->shorttext;
+    if (helptext)
+	*helptext = m1->helptext;
+    return m1->type;
 }
 
 static int
@@ -970,42 +1121,20 @@ mmv_lookup_item2(int item, unsigned int inst,
 	stats_t *s, mmv_disk_value_t **value,
 	__uint64_t *shorttext, __uint64_t *helptext)
 {
-    mmv_disk_metric2_t	*m2 = s->metrics2;
-    mmv_disk_value_t	*v = s->values;
-    int			mi, vi, sts = PM_ERR_PMID;
-
-    for (mi = 0; mi < s->mcnt2; mi++) {
-	if (m2[mi].item != item)
-	    continue;
+    mmv_disk_metric2_t	*m2;
+    item_t		*ip;
 
-	if (value == NULL) {
-	    if (shorttext)
-		*shorttext = m2[mi].shorttext;
-	    if (helptext)
-		*helptext = m2[mi].helptext;
-	    return m2[mi].type;
-	}
-
-	sts = PM_ERR_INST;
-	for (vi = 0; vi < s->vcnt; vi++) {
-	    mmv_disk_metric2_t *mt = (mmv_disk_metric2_t *)
-			((char *)s->addr + v[vi].metric);
-	    mmv_disk_instance2_t *is = (mmv_disk_instance2_t *)
-			((char *)s->addr + v[vi].instance);
-
-	    if ((mt == &m2[mi]) &&
-		(mt->indom == PM_INDOM_NULL || mt->indom == 0 ||
-		inst == PM_IN_NULL || is->internal == inst)) {
-		if (shorttext)
-		    *shorttext = m2[mi].shorttext;
-		if (helptext)
-		    *helptext = m2[mi].helptext;
-		*value = &v[vi];
-		return m2[mi].type;
-	    }
-	}
-    }
-    return sts;
+    if (item < 0 || (ip = find_item(s, item)) == NULL)
+	return PM_ERR_PMID;
+    if (value != NULL && (ip = find_value(s, ip, inst, value)) == NULL)
+	return PM_ERR_INST;
+    m2 = &s->metrics2[ip->metric];
+
+    if (shorttext)
+	*shorttext = m2->shorttext;
+    if (helptext)
+	*helptext = m2->helptext;
+    return m2->type;
 }
 
 static int
@@ -1140,6 +1269,66 @@ mmv_fetchCallBack(pmdaMetric *mdesc, unsigned int inst, pmAtomValue *atom)
     return PMDA_FETCH_NOVALUES;
 }
 
+/*
+ * batch callback provided to pmdaFetch - resolves the mapping and item
+ * once, then fills numeric values for all requested instances; control,
+ * elapsed and string metrics are passed back to mmv_fetchCallBack
+ */
+static int
+mmv_fetchBatchCallBack(pmdaMetric *mdesc, int numinst,
+	const unsigned int *instlist, pmAtomValue *values, int *status)
+{
+    mmv_disk_value_t	*v;
+    agent_t		*ap = (agent_t *)mdesc->m_user;
+    stats_t		*s = NULL;	/* pander to gcc */
+    item_t		*ip;
+    pmID		pmid = mdesc->m_desc.pmid;
+    int			i, sts, sentinel;
+
+    if (pmID_cluster(pmid) == 0 || ap->scnt == 0)
+	return PM_ERR_PMID;
+    if ((sts = mmv_lookup_stat_metric(ap, pmid, PM_IN_NULL, &s,
+					NULL, NULL, NULL)) < 0)
+	return sts;
+
+    switch (sts) {
+	case MMV_TYPE_I32:
+	case MMV_TYPE_U32:
+	case MMV_TYPE_I64:
+	case MMV_TYPE_U64:
+	case MMV_TYPE_FLOAT:
+	case MMV_TYPE_DOUBLE:
+	    break;
+	default:
+	    return PM_ERR_PMID;
+    }
+
+    ip = find_item(s, pmID_item(pmid));
+    sentinel = ((mmv_disk_header_t *)s->addr)->flags & MMV_FLAG_SENTINEL;
+
+    for (i = 0; i < numinst; i++) {
+	if (find_value(s, ip, instlist[i], &v) == NULL) {
+	    status[i] = PM_ERR_INST;
+	    continue;
+	}
+	memcpy(&values[i], &v->value, sizeof(pmAtomValue));
+	status[i] = PMDA_FETCH_STATIC;
+	if (!sentinel)
+	    continue;
+	if (sts == MMV_TYPE_FLOAT) {
+	    if (isnan(values[i].f))
+		status[i] = PMDA_FETCH_NOVALUES;
+	}
+	else if (sts == MMV_TYPE_DOUBLE) {
+	    if (isnan(values[i].d))
+		status[i] = PMDA_FETCH_NOVALUES;
+	}
+	else if (memcmp(&values[i], &aNaN, sizeof(pmAtomValue)) == 0)
+	    status[i] = PMDA_FETCH_NOVALUES;
+    }
+    return 0;
+}
+
 static void
 mmv_reload_maybe(pmdaExt *pmda)
 {
@@ -1572,6 +1761,7 @@ init_pmda(pmdaInterface *dp, agent_t *ap)
 	dp->version.seven.children = mmv_children;
 	dp->version.seven.label = mmv_label;
 	pmdaSetFetchCallBack(dp, mmv_fetchCallBack);
+	pmdaSetFetchBatchCallBack(dp, mmv_fetchBatchCallBack);
 	pmdaSetLabelCallBack(dp, mmv_labelCallBack);
 
 	pmdaSetData(dp, (void *)ap);
@@ -35,6 +35,14 @@
 #define TIME_ENABLED 1
 #define TIME_RUNNING 2
 
+/* layout of a PERF_FORMAT_GROUP read, before the per-member values */
+#define GROUP_NR 0
+#define GROUP_TIME_ENABLED 1
+#define GROUP_TIME_RUNNING 2
+#define GROUP_VALUES 3
+
+static int groupsize;
+
 const char *perf_strerror(int err)
 {
     const char *ret = "Unknown error";
@@ -83,6 +91,20 @@ static void free_event(event_t *del)
     free(del->name);
 }
 
+static void free_eventgroups(eventgroup_t *group)
+{
+    eventgroup_t *tmp;
+
+    /* the leader fd belongs to (and is closed with) the first member */
+    while(group) {
+        tmp = group->next;
+        free(group->members);
+        free(group->buffer);
+        free(group);
+        group = tmp;
+    }
+}
+
 static void free_perfdata(perfdata_t *del)
 {
     int i;
@@ -90,6 +112,7 @@ static void free_perfdata(perfdata_t *del)
     if(0 == del ) {
         return;
     }
+    free_eventgroups(del->groups);
     for ( i = 0; i < del->nevents; ++i )
     {
         free_event(&del->events[i]);
@@ -133,6 +156,132 @@ static void free_event_list(event_list_t *event_list)
     }
 }
 
+void perf_event_groupsize(int size)
+{
+    groupsize = size;
+}
+
+/*
+ * Largest group an event with these attributes may join.  Hardware
+ * groups are scheduled onto the PMU as a unit and a group larger than
+ * the available counters never counts at all, so those are only formed
+ * on request.  Software events have no such constraint.
+ */
+static int perf_group_limit(const perf_event_attr_t *hw)
+{
+    if(groupsize > 0)
+        return groupsize;
+    return (hw->type == PERF_TYPE_SOFTWARE) ? INT_MAX : 1;
+}
+
+/* Make space for one more member, before its counter is opened */
+static int perf_group_reserve(eventgroup_t *group)
+{
+    eventcpuinfo_t **members;
+    uint64_t *buffer;
+    int n = group->nmembers + 1;
+
+    members = realloc(group->members, n * sizeof(*members));
+    if(NULL == members)
+        return -E_PERFEVENT_REALLOC;
+    group->members = members;
+
+    buffer = realloc(group->buffer, (GROUP_VALUES + n) * sizeof(*buffer));
+    if(NULL == buffer)
+        return -E_PERFEVENT_REALLOC;
+    group->buffer = buffer;
+
+    return 0;
+}
+
+/*
+ * Open the counter for an event on one cpu, returning its fd.  Where
+ * grouping applies the counter joins (or leads) a group with the other
+ * counters on the same cpu and PMU; should the kernel refuse that, the
+ * counter is opened on its own and read individually as before.
+ */
+static int perf_event_open_cpu(perfdata_t *inst, eventcpuinfo_t *info)
+{
+    eventgroup_t *group;
+    int limit = perf_group_limit(&info->hw);
+    int fd;
+
+    info->group = NULL;
+    if(limit <= 1)
+        return perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+
+    for(group = inst->groups; group; group = group->next)
+    {
+        if(group->cpu == info->cpu && group->type == info->hw.type &&
+           group->nmembers < limit)
+            break;
+    }
+
+    if(group)
+    {
+        if(perf_group_reserve(group) == 0)
+        {
+            fd = perf_event_open(&info->hw, -1, info->cpu, group->fd, 0);
+            if(fd != -1)
+            {
+                group->members[group->nmembers++] = info;
+                info->group = group;
+                return fd;
+            }
+        }
+    }
+    else if((group = calloc(1, sizeof(*group))) != NULL)
+    {
+        if(perf_group_reserve(group) == 0)
+        {
+            info->hw.read_format |= PERF_FORMAT_GROUP;
+            fd = perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+            info->hw.read_format &= ~PERF_FORMAT_GROUP;
+            if(fd != -1)
+            {
+                group->fd = fd;
+                group->cpu = info->cpu;
+                group->type = info->hw.type;
+                group->members[group->nmembers++] = info;
+                group->next = inst->groups;
+                inst->groups = group;
+                info->group = group;
+                return fd;
+            }
+        }
+        free_eventgroups(group);
+    }
+
+    return perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+}
+
+/*
+ * Read all counters of a group with one read() of the leader, storing
+ * each into its member in the same form an individual read would have.
+ */
+static void perf_group_read(eventgroup_t *group)
+{
+    size_t size = (GROUP_VALUES + group->nmembers) * sizeof(uint64_t);
+    eventcpuinfo_t *info;
+    int i;
+
+    if(read(group->fd, group->buffer, size) != (ssize_t)size ||
+       group->buffer[GROUP_NR] != (uint64_t)group->nmembers)
+    {
+        group->status = -1;
+        return;
+    }
+
+    for(i = 0; i < group->nmembers; ++i)
+    {
+        info = group->members[i];
+        info->values[RAW_VALUE] = group->buffer[GROUP_VALUES + i];
+        info->values[TIME_ENABLED] = group->buffer[GROUP_TIME_ENABLED];
+        info->values[TIME_RUNNING] = group->buffer[GROUP_TIME_RUNNING];
+    }
+    group->status = 0;
+}
+
 /* Right now, only capable of parsing event and umask */
 static int parse_and_get_config(char *config_str, uint64_t *config)
 {
@@ -619,7 +768,7 @@ static int perf_setup_event(perfdata_t *inst, const char *eventname,
             info->hw.exclude_hv = 1;
             info->hw.exclude_guest = 1;
             info->hw.disabled = 1;
-            info->fd = perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+            info->fd = perf_event_open_cpu(inst, info);
 
             if (info->fd == -1) {
                 fprintf(stderr, "perf_event_open failed on cpu%d for \"%s\": %s\n",
@@ -652,7 +801,7 @@ static int perf_setup_event(perfdata_t *inst, const char *eventname,
 
             info->hw.disabled = 1;
             info->hw.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-            info->fd = perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+            info->fd = perf_event_open_cpu(inst, info);
             if(info->fd == -1)
             {
                 fprintf(stderr, "perf_event_open failed on cpu%d for \"%s\": %s\n", 
@@ -784,7 +933,7 @@ static int perf_setup_dynamic_events(perfdata_t *inst,
                 info->hw.disabled = 1;
                 info->hw.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
 
-                info->fd = perf_event_open(&info->hw, -1, info->cpu, -1, 0);
+                info->fd = perf_event_open_cpu(inst, info);
                 if(info->fd == -1) {
                     fprintf(stderr, "perf_event_open failed on cpu%d for \"%s\": %s\n",
                             info->cpu, curr->name, strerror(errno) );
@@ -1124,6 +1273,7 @@ int perf_get(perfhandle_t *inst, perf_counter **counters, int *size,
              perf_derived_counter **derived_counters, int *derived_size)
 {
     int cpuidx, idx, events_read;
+    eventgroup_t *group;
 
     if(NULL == inst)
     {
@@ -1146,6 +1296,10 @@ int perf_get(perfhandle_t *inst, perf_counter **counters, int *size,
         ncounters = pdata->nevents;
     }
 
+    /* one read per group fills in the values of all its members */
+    for(group = pdata->groups; group; group = group->next)
+        perf_group_read(group);
+
     events_read = 0;
     for(idx = 0; idx < pdata->nevents; ++idx)
     {
@@ -1171,7 +1325,10 @@ int perf_get(perfhandle_t *inst, perf_counter **counters, int *size,
             int ret;
 
             if( info->type == EVENT_TYPE_PERF ) {
-                ret = read(info->fd, info->values, sizeof(info->values));
+                if (info->group)
+                    ret = info->group->status == 0 ? sizeof(info->values) : -1;
+                else
+                    ret = read(info->fd, info->values, sizeof(info->values));
                 if (ret != sizeof(info->values)) {
                     if (ret == -1)
                         fprintf(stderr, "cannot read event %s on cpu %d:%d\n", event->name, info->cpu, ret);
@@ -57,6 +57,22 @@ typedef struct perf_derived_counter_t_
     perf_counter_list *counter_list;
 } perf_derived_counter;
 
+/*
+ * Counters on the same cpu and PMU can be opened as a group, so that a
+ * single read of the group leader (PERF_FORMAT_GROUP) returns the values
+ * of every member, rather than one read per counter.
+ */
+typedef struct eventgroup_t_ {
+    int fd; /* group leader, opened with PERF_FORMAT_GROUP */
+    int cpu;
+    uint32_t type; /* perf_event_attr type common to all members */
+    int nmembers;
+    struct eventcpuinfo_t_ **members; /* leader first, in kernel sibling order */
+    uint64_t *buffer; /* nr, time_enabled, time_running, value[nr] */
+    int status; /* result of the most recent group read */
+    struct eventgroup_t_ *next;
+} eventgroup_t;
+
 typedef struct eventcpuinfo_t_ {
     uint64_t values[3];
     uint64_t previous[3];
@@ -67,6 +83,7 @@ typedef struct eventcpuinfo_t_ {
     char *fstr; /* fstr from library, must be freed */
     rapl_data_t rapldata;
     int cpu;
+    eventgroup_t *group; /* group read together with, or NULL */
 } eventcpuinfo_t;
 
 typedef struct event_t_ {
@@ -101,6 +118,9 @@ typedef struct perfdata_t_
     int nderivedevents;
     derived_event_t *derived_events;
 
+    /* counter groups, each read with a single read() per fetch */
+    eventgroup_t *groups;
+
     /* information about the architecture (number of cpus, numa nodes etc) */
     archinfo_t *archinfo;
 
@@ -118,6 +138,10 @@ void perf_counter_destroy(perf_counter *data, int size, perf_derived_counter *de
 
 void perf_event_destroy(perfhandle_t *inst);
 
+/* Maximum counters per group, applied to all PMUs.  The default (0)
+ * groups software events only, one group per cpu. */
+void perf_event_groupsize(int size);
+
 #define PERF_COUNTER_ENABLE 0
 #define PERF_COUNTER_DISABLE 1
 int perf_counter_enable(perfhandle_t *inst, int enable);
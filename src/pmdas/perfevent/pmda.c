@@ -752,6 +752,7 @@ static void usage(void)
           "  -C           maintain compatibility to (possibly) nonconforming metric names\n"
 	  "  -D debug     set debug options, see pmdbg(1)\n"
           "  -d domain    use domain (numeric) for metrics domain of PMDA\n"
+          "  -G size      read counters in groups of up to size per cpu and PMU\n"
           "  -l logfile   write log into logfile rather than using default log name\n"
           "  -U username  user account to run under (default \"pcp\")\n"
           "\nExactly one of the following options may appear:\n"
@@ -781,13 +782,16 @@ int main(int argc, char **argv)
     pmdaDaemon(&dispatch, PMDA_INTERFACE_7, pmGetProgname(), PERFEVENT,
                "perfevent.log", mypath);
 
-    while ((c = pmdaGetOpt(argc, argv, "CD:d:i:l:pu:U:6:?", &dispatch, &err)) != EOF)
+    while ((c = pmdaGetOpt(argc, argv, "CD:d:G:i:l:pu:U:6:?", &dispatch, &err)) != EOF)
     {
         switch(c)
         {
         case 'C':
             compat_names = 1;
             break;
+        case 'G':
+            perf_event_groupsize(atoi(optarg));
+            break;
         case 'U':
             username = optarg;
             break;
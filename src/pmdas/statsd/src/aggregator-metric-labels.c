@@ -28,7 +28,7 @@
  * @arg container - Metrics struct acting as metrics wrapper
  * @arg item - Parent item
  * 
- * Synchronized by 
+ * Synchronized by mutex on metric's metrics_shard
  */
 static void
 create_labels_dict(
@@ -36,7 +36,7 @@ create_labels_dict(
     struct pmda_metrics_container* container,
     struct metric* item
 ) {
-    pthread_mutex_lock(&container->mutex);
+    pthread_mutex_lock(&item->shard->mutex);
     /**
      * Callbacks for metrics hashtable
      */
@@ -49,7 +49,7 @@ create_labels_dict(
     };
     labels* children = dictCreate(&metric_label_dict_callbacks);
     item->children = children;
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&item->shard->mutex);
 }
 
 
@@ -60,7 +60,7 @@ create_labels_dict(
  * @arg item - Metric serving as root
  * @arg datagram - Datagram to be processed
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 int
 process_labeled_datagram(
@@ -116,7 +116,7 @@ process_labeled_datagram(
  * @arg out - Placeholder label
  * @return 1 when any found, 0 when not
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 int
 find_label_by_name(
@@ -125,17 +125,17 @@ find_label_by_name(
     char* key,
     struct metric_label** out
 ) {
-    pthread_mutex_lock(&container->mutex);
+    pthread_mutex_lock(&item->shard->mutex);
     dictEntry* result = dictFind(item->children, key);
     if (result == NULL) {
-        pthread_mutex_unlock(&container->mutex);
+        pthread_mutex_unlock(&item->shard->mutex);
         return 0;
     }
     if (out != NULL) {
         struct metric_label* label = (struct metric_label*)dictGetVal(result);
         *out = label;
     }
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&item->shard->mutex);
     return 1;
 }
 
@@ -240,15 +240,15 @@ create_label(
  * @arg key - Label key
  * @arg label - Label to be saved
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 void
 add_label(struct pmda_metrics_container* container, struct metric* item, char* key, struct metric_label* label) {
-    pthread_mutex_lock(&container->mutex);
+    pthread_mutex_lock(&item->shard->mutex);
     dictAdd(item->children, key, label);
-    container->generation += 1;
+    increment_metrics_generation(container);
     item->meta->pcp_instance_change_requested = 1;
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&item->shard->mutex);
 }
 
 /**
@@ -51,19 +51,104 @@ init_pmda_metrics(struct agent_config* config) {
         (struct pmda_metrics_container*) malloc(sizeof(struct pmda_metrics_container));
     ALLOC_CHECK(container, "Unable to create PMDA metrics container.");
     pthread_mutex_init(&container->mutex, NULL);
-    metrics* m = dictCreate(&metric_dict_callbacks);
-    container->metrics = m;
+    container->shard_count = config->aggregator_shards;
+    container->shards =
+        (struct metrics_shard*) malloc(sizeof(struct metrics_shard) * container->shard_count);
+    ALLOC_CHECK(container->shards, "Unable to create PMDA metrics shards.");
+    size_t i;
+    for (i = 0; i < container->shard_count; i++) {
+        pthread_mutex_init(&container->shards[i].mutex, NULL);
+        container->shards[i].metrics = dictCreate(&metric_dict_callbacks);
+    }
     container->generation = 0;
     return container;
 }
 
+/**
+ * Frees pmda_metrics_container structure along with all recorded metrics
+ * @arg container - Metrics container
+ */
+void
+free_pmda_metrics(struct pmda_metrics_container* container) {
+    size_t i;
+    for (i = 0; i < container->shard_count; i++) {
+        dictRelease(container->shards[i].metrics);
+        pthread_mutex_destroy(&container->shards[i].mutex);
+    }
+    free(container->shards);
+    pthread_mutex_destroy(&container->mutex);
+    free(container);
+}
+
+/**
+ * Maps metric name to index of shard that owns it
+ * - uses FNV-1a rather than the dict hash, so that keys within one shard still spread over its buckets
+ * - hashes no more than the hashtable key keeps (see create_metric_dict_key), so that
+ *   a long metric name and its truncated key always map to the same shard
+ * @arg name - Metric name or its hashtable key
+ * @arg shard_count - Number of shards
+ * @return shard index
+ */
+size_t
+get_metric_shard_index(const char* name, size_t shard_count) {
+    uint32_t hash = 2166136261U;
+    const char* end = name + METRIC_DICT_KEY_SIZE - 1;
+    if (shard_count <= 1) {
+        return 0;
+    }
+    while (*name && name < end) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619U;
+    }
+    return hash % shard_count;
+}
+
+/**
+ * Gets shard that owns metric of given name
+ * @arg container - Metrics container
+ * @arg name - Metric name or its hashtable key
+ * @return shard
+ */
+struct metrics_shard*
+get_metric_shard(struct pmda_metrics_container* container, const char* name) {
+    return &container->shards[get_metric_shard_index(name, container->shard_count)];
+}
+
+/**
+ * Increments metrics generation, signaling PMDA that its namespace needs to be remapped
+ * @arg container - Metrics container
+ *
+ * Synchronized by mutex on pmda_metrics_container
+ */
+void
+increment_metrics_generation(struct pmda_metrics_container* container) {
+    pthread_mutex_lock(&container->mutex);
+    container->generation += 1;
+    pthread_mutex_unlock(&container->mutex);
+}
+
+/**
+ * Gets current metrics generation
+ * @arg container - Metrics container
+ * @return generation
+ *
+ * Synchronized by mutex on pmda_metrics_container
+ */
+size_t
+get_metrics_generation(struct pmda_metrics_container* container) {
+    pthread_mutex_lock(&container->mutex);
+    size_t generation = container->generation;
+    pthread_mutex_unlock(&container->mutex);
+    return generation;
+}
+
 /**
  * Creates STATSD metric hashtable key for use in hashtable related functions (find_metric_by_name, check_metric_name_available)
  * @return new key
  */
 char*
 create_metric_dict_key(char* key) {
-    size_t maximum_key_size = 2048;
+    size_t maximum_key_size = METRIC_DICT_KEY_SIZE;
     char buffer[maximum_key_size]; // maximum key size
     int key_size = pmsprintf(
         buffer,
@@ -200,15 +285,12 @@ print_metric_meta(FILE* f, struct metric_metadata* meta) {
  * @arg config - Config containing information about where to output
  * @arg container - Metrics struct acting as metrics wrapper
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on each metrics_shard in turn
  */
 void
 write_metrics_to_file(struct agent_config* config, struct pmda_metrics_container* container) {
     VERBOSE_LOG(0, "Writing metrics to file...");
-    pthread_mutex_lock(&container->mutex);
-    metrics* m = container->metrics;
     if (strlen(config->debug_output_filename) == 0) {
-        pthread_mutex_unlock(&container->mutex);
         return; 
     }
     int sep = pmPathSeparator();
@@ -222,36 +304,40 @@ write_metrics_to_file(struct agent_config* config, struct pmda_metrics_container
     FILE* f;
     f = fopen(debug_output, "a+");
     if (f == NULL) {
-        pthread_mutex_unlock(&container->mutex);
         VERBOSE_LOG(0, "Unable to open file for output.");
         return;
     }
-    dictIterator iterator;
-    dictInitIterator(&iterator, m);
-    dictEntry* current;
     long int count = 0;
-    while ((current = dictNext(&iterator)) != NULL) {
-        struct metric* item = (struct metric*)dictGetVal(current);
-        switch (item->type) {
-            case METRIC_TYPE_COUNTER:
-                print_counter_metric(config, f, item);
-                break;
-            case METRIC_TYPE_GAUGE:
-                print_gauge_metric(config, f, item);
-                break;
-            case METRIC_TYPE_DURATION:
-                print_duration_metric(config, f, item);
-                break;
-            case METRIC_TYPE_NONE:
-                // not actually a metric error case
-                break;
+    size_t i;
+    for (i = 0; i < container->shard_count; i++) {
+        struct metrics_shard* shard = &container->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        dictIterator iterator;
+        dictInitIterator(&iterator, shard->metrics);
+        dictEntry* current;
+        while ((current = dictNext(&iterator)) != NULL) {
+            struct metric* item = (struct metric*)dictGetVal(current);
+            switch (item->type) {
+                case METRIC_TYPE_COUNTER:
+                    print_counter_metric(config, f, item);
+                    break;
+                case METRIC_TYPE_GAUGE:
+                    print_gauge_metric(config, f, item);
+                    break;
+                case METRIC_TYPE_DURATION:
+                    print_duration_metric(config, f, item);
+                    break;
+                case METRIC_TYPE_NONE:
+                    // not actually a metric error case
+                    break;
+            }
+            count++;
         }
-        count++;
+        pthread_mutex_unlock(&shard->mutex);
     }
     fprintf(f, "----------------\n");
     fprintf(f, "Total number of records: %lu \n", count);
     fclose(f);    
-    pthread_mutex_unlock(&container->mutex);
     VERBOSE_LOG(0, "Wrote metrics to debug file.");
 }
 
@@ -262,22 +348,22 @@ write_metrics_to_file(struct agent_config* config, struct pmda_metrics_container
  * @arg out - Placeholder metric
  * @return 1 when any found, 0 when not
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metrics_shard owning the key
  */
 int
 find_metric_by_name(struct pmda_metrics_container* container, char* key, struct metric** out) {
-    pthread_mutex_lock(&container->mutex);
-    metrics* m = container->metrics;
-    dictEntry* result = dictFind(m, key);
+    struct metrics_shard* shard = get_metric_shard(container, key);
+    pthread_mutex_lock(&shard->mutex);
+    dictEntry* result = dictFind(shard->metrics, key);
     if (result == NULL) {
-        pthread_mutex_unlock(&container->mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return 0;
     }
     if (out != NULL) {
         struct metric* item = (struct metric*)dictGetVal(result);
         *out = item;
     }
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return 1;
 }
 
@@ -300,6 +386,7 @@ create_metric(struct agent_config* config, struct statsd_datagram* datagram, str
     (*out)->meta = create_metric_meta(datagram);
     (*out)->children = NULL;
     (*out)->committed = 0;
+    (*out)->shard = NULL;
     (*out)->config = config;
     int status = 0; 
     (*out)->value = NULL;
@@ -335,14 +422,16 @@ create_metric(struct agent_config* config, struct statsd_datagram* datagram, str
  * @arg container - Metrics container 
  * @arg item - Metric to be saved
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metrics_shard owning the key
  */
 void
 add_metric(struct pmda_metrics_container* container, char* key, struct metric* item) {
-    pthread_mutex_lock(&container->mutex);
-    dictAdd(container->metrics, key, item);
-    container->generation += 1;
-    pthread_mutex_unlock(&container->mutex);
+    struct metrics_shard* shard = get_metric_shard(container, key);
+    pthread_mutex_lock(&shard->mutex);
+    item->shard = shard;
+    dictAdd(shard->metrics, key, item);
+    increment_metrics_generation(container);
+    pthread_mutex_unlock(&shard->mutex);
 }
 
 /**
@@ -350,14 +439,15 @@ add_metric(struct pmda_metrics_container* container, char* key, struct metric* i
  * @arg container - Metrics container
  * @arg key - Metric's hashtable key
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metrics_shard owning the key
  */
 void
 remove_metric(struct pmda_metrics_container* container, char* key) {
-    pthread_mutex_lock(&container->mutex);
-    dictDelete(container->metrics, key);
-    container->generation += 1;
-    pthread_mutex_unlock(&container->mutex);
+    struct metrics_shard* shard = get_metric_shard(container, key);
+    pthread_mutex_lock(&shard->mutex);
+    dictDelete(shard->metrics, key);
+    increment_metrics_generation(container);
+    pthread_mutex_unlock(&shard->mutex);
 }
 
 /**
@@ -369,7 +459,7 @@ remove_metric(struct pmda_metrics_container* container, char* key) {
  * @arg value - Dest value
  * @return 1 on success, 0 when update itself fails, -1 when metric with same name but different type is already recorded
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metrics_shard owning the key
  */
 int
 update_metric_value(
@@ -379,7 +469,8 @@ update_metric_value(
     struct statsd_datagram* datagram,
     void** value
 ) {
-    pthread_mutex_lock(&container->mutex);
+    struct metrics_shard* shard = get_metric_shard(container, datagram->name);
+    pthread_mutex_lock(&shard->mutex);
     int status = 0;
     if (datagram->type != type) {
         status = -1;
@@ -411,7 +502,7 @@ update_metric_value(
                 break;
         }
     }
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return status;
 }
 
@@ -508,11 +599,12 @@ free_metric_metadata(struct metric_metadata* meta) {
  * @arg container - Metrics container
  * @arg item - Metric to be updated
  * 
- * Synchronized by mutex on pmda_metrics_container struct
+ * Synchronized by mutex on metric's metrics_shard
  */
 void
 mark_metric_as_committed(struct pmda_metrics_container* container, struct metric* item) {
-    pthread_mutex_lock(&container->mutex);
+    (void)container;
+    pthread_mutex_lock(&item->shard->mutex);
     item->committed = 1;
-    pthread_mutex_unlock(&container->mutex);
+    pthread_mutex_unlock(&item->shard->mutex);
 }
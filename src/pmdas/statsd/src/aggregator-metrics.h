@@ -16,6 +16,7 @@
 #define AGGREGATOR_METRICS_
 
 #include <stddef.h>
+#include <pthread.h>
 #include <pcp/dict.h>
 #include <chan/chan.h>
 
@@ -26,6 +27,9 @@
 typedef dict metrics;
 typedef dict labels;
 
+/* Size of metric hashtable key buffer, longer names are truncated to fit */
+#define METRIC_DICT_KEY_SIZE 2048
+
 typedef enum DURATION_INSTANCE {
     DURATION_MIN,
     DURATION_MAX,
@@ -70,6 +74,7 @@ typedef struct metric_label {
 typedef struct metric {
     char* name;
     int committed;
+    struct metrics_shard* shard; // shard owning this metric, set when added
     struct metric_metadata* meta;
     labels* children;
     enum METRIC_TYPE type;
@@ -92,10 +97,21 @@ typedef struct duration_values_meta {
     double std_deviation;
 } duration_values_meta;
 
-typedef struct pmda_metrics_container {
+/**
+ * Subset of recorded metrics, selected by hash of metric name.
+ * Each shard is updated by exactly one aggregator thread and guarded by its own mutex,
+ * so that aggregation of different shards and PMDA fetches proceed independently.
+ */
+typedef struct metrics_shard {
     metrics* metrics;
-    size_t generation;
     pthread_mutex_t mutex;
+} metrics_shard;
+
+typedef struct pmda_metrics_container {
+    struct metrics_shard* shards;
+    size_t shard_count;
+    size_t generation;
+    pthread_mutex_t mutex; // guards generation only, may be taken while holding a shard mutex
 } pmda_metrics_container;
 
 /**
@@ -104,6 +120,51 @@ typedef struct pmda_metrics_container {
 extern struct pmda_metrics_container*
 init_pmda_metrics(struct agent_config* config);
 
+/**
+ * Frees pmda_metrics_container structure along with all recorded metrics
+ * @arg container - Metrics container
+ */
+extern void
+free_pmda_metrics(struct pmda_metrics_container* container);
+
+/**
+ * Maps metric name to index of shard that owns it
+ * - only the part of the name kept in its hashtable key is hashed
+ * @arg name - Metric name or its hashtable key
+ * @arg shard_count - Number of shards
+ * @return shard index
+ */
+extern size_t
+get_metric_shard_index(const char* name, size_t shard_count);
+
+/**
+ * Gets shard that owns metric of given name
+ * @arg container - Metrics container
+ * @arg name - Metric name (same as its hashtable key)
+ * @return shard
+ */
+extern struct metrics_shard*
+get_metric_shard(struct pmda_metrics_container* container, const char* name);
+
+/**
+ * Increments metrics generation, signaling PMDA that its namespace needs to be remapped
+ * @arg container - Metrics container
+ *
+ * Synchronized by mutex on pmda_metrics_container
+ */
+extern void
+increment_metrics_generation(struct pmda_metrics_container* container);
+
+/**
+ * Gets current metrics generation
+ * @arg container - Metrics container
+ * @return generation
+ *
+ * Synchronized by mutex on pmda_metrics_container
+ */
+extern size_t
+get_metrics_generation(struct pmda_metrics_container* container);
+
 /**
  * Creates STATSD metric hashtable key for use in hashtable related functions (find_metric_by_name, check_metric_name_available)
  * @return new key
@@ -134,7 +195,7 @@ free_metric(struct agent_config* config, struct metric* item);
  * @arg config - Config containing information about where to output
  * @arg container - Metrics struct acting as metrics wrapper
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on each metrics_shard in turn
  */
 extern void
 write_metrics_to_file(struct agent_config* config, struct pmda_metrics_container* container);
@@ -146,7 +207,7 @@ write_metrics_to_file(struct agent_config* config, struct pmda_metrics_container
  * @arg out - Placeholder metric
  * @return 1 when any found, 0 when not
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 extern int
 find_metric_by_name(struct pmda_metrics_container* container, char* key, struct metric** out);
@@ -166,7 +227,7 @@ create_metric(struct agent_config* config, struct statsd_datagram* datagram, str
  * @arg container - Metrics container 
  * @arg item - Metric to be saved
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 extern void
 add_metric(struct pmda_metrics_container* container, char* key, struct metric* item);
@@ -176,7 +237,7 @@ add_metric(struct pmda_metrics_container* container, char* key, struct metric* i
  * @arg container - Metrics container
  * @arg key - Metric's hashtable key
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 extern void
 remove_metric(struct pmda_metrics_container* container, char* key);
@@ -190,7 +251,7 @@ remove_metric(struct pmda_metrics_container* container, char* key);
  * @arg value - Dest value
  * @return 1 on success, 0 when update itself fails, -1 when metric with same name but different type is already recorded
  * 
- * Synchronized by mutex on pmda_metrics_container
+ * Synchronized by mutex on metric's metrics_shard
  */
 extern int
 update_metric_value(
@@ -240,7 +301,7 @@ print_metric_meta(FILE* f, struct metric_metadata* meta);
  * @arg container - Metrics container
  * @arg item - Metric to be updated
  * 
- * Synchronized by mutex on pmda_metrics_container struct
+ * Synchronized by mutex on metric's metrics_shard
  */
 extern void
 mark_metric_as_committed(struct pmda_metrics_container* container, struct metric* item);
@@ -31,17 +31,19 @@
 #include "aggregator-stats.h"
 
 /**
- * Mutex guarding aggregator proccesing, so there are no race conditions if we request debug output.
+ * Lock guarding aggregator proccesing, so there are no race conditions if we request debug output.
+ * - aggregator threads of all shards hold it for reading, debug output for writing
  */
-static pthread_mutex_t g_aggregator_processing_lock;
+static pthread_rwlock_t g_aggregator_processing_lock = PTHREAD_RWLOCK_INITIALIZER;
 
 /**
  * This is shared with a function thats called from signal handler, should debug data be requested
+ * - any shard's arguments will do, they differ only in channel
  */
 static struct aggregator_args* g_aggregator_args = NULL;
 
 /**
- * Thread startpoint - passes down given datagram to aggregator to record value it contains (should be used for a single new thread)
+ * Thread startpoint - passes down given datagram to aggregator to record value it contains (should be used for a single new thread per shard)
  * @arg args - aggregator_args
  */
 void*
@@ -73,7 +75,7 @@ aggregator_exec(void* args) {
             free_parser_to_aggregator_message(message);
             continue;
         }
-        pthread_mutex_lock(&g_aggregator_processing_lock);
+        pthread_rwlock_rdlock(&g_aggregator_processing_lock);
         process_stat(config, stats_container, STAT_RECEIVED, NULL);
         if (message->type == PARSER_RESULT_PARSED) {
             clock_gettime(CLOCK_MONOTONIC, &t0);
@@ -93,7 +95,7 @@ aggregator_exec(void* args) {
             process_stat(config, stats_container, STAT_TIME_SPENT_PARSING, &message->time);
         }
         free_parser_to_aggregator_message(message);
-        pthread_mutex_unlock(&g_aggregator_processing_lock);
+        pthread_rwlock_unlock(&g_aggregator_processing_lock);
     }
     VERBOSE_LOG(2, "Aggregator thread exiting.");
     pthread_exit(NULL);
@@ -105,10 +107,10 @@ aggregator_exec(void* args) {
 void
 aggregator_debug_output() {
     if (g_aggregator_args != NULL) {
-        pthread_mutex_lock(&g_aggregator_processing_lock);
+        pthread_rwlock_wrlock(&g_aggregator_processing_lock);
         write_metrics_to_file(g_aggregator_args->config, g_aggregator_args->metrics_container);
         write_stats_to_file(g_aggregator_args->config, g_aggregator_args->stats_container);
-        pthread_mutex_unlock(&g_aggregator_processing_lock);
+        pthread_rwlock_unlock(&g_aggregator_processing_lock);
     }
 }
 
@@ -32,7 +32,7 @@ typedef struct aggregator_args
 } aggregator_args;
 
 /**
- * Thread startpoint - passes down given datagram to aggregator to record value it contains (should be used for a single new thread)
+ * Thread startpoint - passes down given datagram to aggregator to record value it contains (should be used for a single new thread per shard)
  * @arg args - aggregator_args
  */
 extern void*
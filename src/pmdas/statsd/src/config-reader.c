@@ -28,6 +28,8 @@ static void
 set_default_config(struct agent_config* config) {
     config->max_udp_packet_size = 1472;
     config->max_unprocessed_packets = 2048;
+    config->parser_threads = 1;
+    config->aggregator_shards = 1;
     config->verbose = 0;
     config->debug_output_filename = (char*) malloc(sizeof(char) * 6);
     ALLOC_CHECK(config->debug_output_filename, "Unable to allocate memory for debug output filename");
@@ -67,6 +69,16 @@ ini_line_handler(void* user, const char* section, const char* name, const char*
         if (param < UINT32_MAX) {
             dest->max_unprocessed_packets = (unsigned int) param;
         }
+    } else if (MATCH("parser_threads")) {
+        long unsigned int param = strtoul(value, NULL, 10);
+        if (param > 0 && param <= MAX_PARSER_THREADS) {
+            dest->parser_threads = (unsigned int) param;
+        }
+    } else if (MATCH("aggregator_shards")) {
+        long unsigned int param = strtoul(value, NULL, 10);
+        if (param > 0 && param <= MAX_AGGREGATOR_SHARDS) {
+            dest->aggregator_shards = (unsigned int) param;
+        }
     } else if (MATCH("port")) {
         long unsigned int param = strtoul(value, NULL, 10);
         if (param < UINT32_MAX) {
@@ -140,11 +152,13 @@ read_agent_config_cmd(pmdaInterface* dispatch, struct agent_config* dest, int ar
         { "parser-type", 1, 'r', "PARSER-TYPE", "Parser type to use (ragel = 1, basic = 0)" },
         { "duration-aggregation-type", 1, 'a', "DURATION-AGGREGATION-TYPE", "Aggregation type for duration metric to use (hdr_histogram = 1, basic histogram = 0)" },
         { "max-unprocessed-packets-size:", 1, 'z', "MAX-UNPROCESSED-PACKETS-SIZE", "Maximum count of unprocessed packets." },
+        { "parser-threads", 1, 'T', "PARSER-THREADS", "Number of parser threads" },
+        { "aggregator-shards", 1, 'S', "AGGREGATOR-SHARDS", "Number of aggregator threads, each owning a shard of metrics" },
         PMDA_OPTIONS_END
     };
 
     static pmdaOptions opts = {
-        .short_options = "D:d:l:U:v:so:Z:P:r:a:z:?",
+        .short_options = "D:d:l:U:v:so:Z:P:r:a:z:T:S:?",
         .long_options = longopts,
     };
     while(1) {
@@ -220,6 +234,26 @@ read_agent_config_cmd(pmdaInterface* dispatch, struct agent_config* dest, int ar
                 }
                 break;
             }
+            case 'T':
+            {
+                long unsigned int param = strtoul(opts.optarg, NULL, 10);
+                if (param > 0 && param <= MAX_PARSER_THREADS) {
+                    dest->parser_threads = (unsigned int) param;
+                } else {
+                    pmNotifyErr(LOG_INFO, "parser_threads option value is out of bounds.");
+                }
+                break;
+            }
+            case 'S':
+            {
+                long unsigned int param = strtoul(opts.optarg, NULL, 10);
+                if (param > 0 && param <= MAX_AGGREGATOR_SHARDS) {
+                    dest->aggregator_shards = (unsigned int) param;
+                } else {
+                    pmNotifyErr(LOG_INFO, "aggregator_shards option value is out of bounds.");
+                }
+                break;
+            }
         }
     }
     if (opts.errors) {
@@ -246,6 +280,8 @@ print_agent_config(struct agent_config* config) {
     pmNotifyErr(LOG_INFO, "parser_type: %s \n", config->parser_type == PARSER_TYPE_BASIC ? "BASIC" : "RAGEL");
     pmNotifyErr(LOG_INFO, "maximum of unprocessed packets: %d \n", config->max_unprocessed_packets);
     pmNotifyErr(LOG_INFO, "maximum udp packet size: %ld \n", config->max_udp_packet_size);
+    pmNotifyErr(LOG_INFO, "parser threads: %d \n", config->parser_threads);
+    pmNotifyErr(LOG_INFO, "aggregator shards: %d \n", config->aggregator_shards);
     pmNotifyErr(LOG_INFO, "duration_aggregation_type: %s\n", 
         config->duration_aggregation_type == DURATION_AGGREGATION_TYPE_HDR_HISTOGRAM ? "HDR_HISTOGRAM" : "BASIC");
     pmNotifyErr(LOG_INFO, "</settings>\n");
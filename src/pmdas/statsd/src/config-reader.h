@@ -21,6 +21,9 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#define MAX_PARSER_THREADS 64
+#define MAX_AGGREGATOR_SHARDS 64
+
 typedef enum PARSER_TYPE {
     PARSER_TYPE_BASIC = 0,
     PARSER_TYPE_RAGEL = 1
@@ -38,6 +41,8 @@ typedef struct agent_config {
     unsigned int verbose;
     unsigned int show_version;
     unsigned int max_unprocessed_packets;
+    unsigned int parser_threads;
+    unsigned int aggregator_shards;
     unsigned int port;
     char* debug_output_filename;
     char* username;
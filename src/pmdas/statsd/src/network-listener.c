@@ -22,6 +22,7 @@
 #include <chan/chan.h>
 #include <pthread.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <signal.h>
 
 #include "network-listener.h"
@@ -30,6 +31,53 @@
 #include "utils.h"
 #include "config-reader.h"
 
+/**
+ * Receives up to NETWORK_LISTENER_BATCH_SIZE datagrams from socket into given buffers
+ * - uses single recvmmsg call where available, otherwise reads one datagram
+ * @arg fd - Socket
+ * @arg batch - Datagrams to receive into, each with buffer of at least max_udp_packet_size + 1
+ * @arg lengths - Placeholder for received length of each datagram
+ * @arg max_udp_packet_size - Maximum datagram size
+ * @return number of datagrams received, 0 when none was ready, -1 on error
+ */
+static int
+receive_datagrams(
+    int fd,
+    struct unprocessed_statsd_datagram** batch,
+    size_t* lengths,
+    int max_udp_packet_size
+) {
+#ifdef MSG_WAITFORONE
+    struct mmsghdr messages[NETWORK_LISTENER_BATCH_SIZE];
+    struct iovec iovecs[NETWORK_LISTENER_BATCH_SIZE];
+    int i;
+    memset(messages, 0, sizeof(messages));
+    for (i = 0; i < NETWORK_LISTENER_BATCH_SIZE; i++) {
+        iovecs[i].iov_base = batch[i]->value;
+        iovecs[i].iov_len = max_udp_packet_size;
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int count = recvmmsg(fd, messages, NETWORK_LISTENER_BATCH_SIZE, MSG_WAITFORONE, NULL);
+    if (count == -1) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    for (i = 0; i < count; i++) {
+        lengths[i] = messages[i].msg_len;
+    }
+    return count;
+#else
+    struct sockaddr_storage src_addr;
+    socklen_t src_addr_len = sizeof(src_addr);
+    ssize_t count = recvfrom(fd, batch[0]->value, max_udp_packet_size, 0, (struct sockaddr*)&src_addr, &src_addr_len);
+    if (count == -1) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    lengths[0] = count;
+    return 1;
+#endif
+}
+
 /**
  * Thread entrypoint - listens on address and port specified in config 
  * for UDP/TCP containing StatsD payload and then sends it over to parser thread for parsing
@@ -41,6 +89,7 @@ network_listener_exec(void* args) {
     static char* end_message = "PMDASTATSD_EXIT"; 
     struct agent_config* config = ((struct network_listener_args*)args)->config;
     chan_t* network_listener_to_parser = ((struct network_listener_args*)args)->network_listener_to_parser;
+    struct datagram_pool* pool = ((struct network_listener_args*)args)->pool;
     const char* hostname = 0;
     struct addrinfo hints;
     fd_set readfds;
@@ -69,39 +118,41 @@ network_listener_exec(void* args) {
     struct timeval tv;
     freeaddrinfo(res);
     int max_udp_packet_size = config->max_udp_packet_size;
-    char *buffer = (char *) malloc(max_udp_packet_size * sizeof(char));
-    struct sockaddr_storage src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    // datagrams to receive into, slots handed over to parsers are refilled from pool
+    struct unprocessed_statsd_datagram* batch[NETWORK_LISTENER_BATCH_SIZE];
+    size_t lengths[NETWORK_LISTENER_BATCH_SIZE];
+    int i;
+    for (i = 0; i < NETWORK_LISTENER_BATCH_SIZE; i++) {
+        batch[i] = acquire_datagram(pool);
+    }
     int rv;
-    while(1) {
+    int exit_requested = 0;
+    while(!exit_requested) {
         FD_ZERO(&readfds);
         FD_SET(fd, &readfds);
         tv.tv_sec = 1;
         tv.tv_usec = 0;
         rv = select(fd + 1, &readfds, NULL, NULL, &tv);
         if (rv == 1) {
-            ssize_t count = recvfrom(fd, buffer, max_udp_packet_size, 0, (struct sockaddr*)&src_addr, &src_addr_len);
+            int count = receive_datagrams(fd, batch, lengths, max_udp_packet_size);
             if (count == -1) {
                 DIE("%s", strerror(errno));
-            } 
-            // since we checked for -1
-            else if ((signed int)count == max_udp_packet_size) { 
-                VERBOSE_LOG(2, "Datagram too large for buffer: truncated and skipped");
-            } else {
-                struct unprocessed_statsd_datagram* datagram = (struct unprocessed_statsd_datagram*) malloc(sizeof(struct unprocessed_statsd_datagram));
-                ALLOC_CHECK(datagram, "Unable to assign memory for struct representing unprocessed datagrams.");
-                datagram->value = (char*) malloc(sizeof(char) * (count + 1));
-                ALLOC_CHECK(datagram->value, "Unable to assign memory for datagram value.");
-                memcpy(datagram->value, buffer, count);
-                datagram->value[count] = '\0';
+            }
+            for (i = 0; i < count; i++) {
+                struct unprocessed_statsd_datagram* datagram = batch[i];
+                if (lengths[i] == (size_t)max_udp_packet_size) {
+                    VERBOSE_LOG(2, "Datagram too large for buffer: truncated and skipped");
+                    continue;
+                }
+                datagram->value[lengths[i]] = '\0';
                 if (strcmp(end_message, datagram->value) == 0) {
-                    free_unprocessed_datagram(datagram);
                     kill(getpid(), SIGINT);
+                    exit_requested = 1;
                     break;
                 }
                 chan_send(network_listener_to_parser, datagram);
+                batch[i] = acquire_datagram(pool);
             }
-            memset(buffer, 0, max_udp_packet_size);
             rv = 0;
         } else {
             int exit_flag = check_exit_flag();
@@ -111,13 +162,17 @@ network_listener_exec(void* args) {
         }
     }
     VERBOSE_LOG(2, "Network listener thread exiting.");
-    struct unprocessed_statsd_datagram* datagram = (struct unprocessed_statsd_datagram*) malloc(sizeof(struct unprocessed_statsd_datagram));
-    ALLOC_CHECK(datagram, "Unable to assign memory for struct representing unprocessed datagrams.");
+    for (i = 0; i < NETWORK_LISTENER_BATCH_SIZE; i++) {
+        release_datagram(pool, batch[i]);
+    }
+    // every parser thread stops on its own end message
     size_t length = strlen(end_message) + 1;
-    datagram->value = (char*) malloc(sizeof(char) * length);
-    memcpy(datagram->value, end_message, length);
-    chan_send(network_listener_to_parser, datagram);
-    free(buffer);
+    unsigned int parser;
+    for (parser = 0; parser < config->parser_threads; parser++) {
+        struct unprocessed_statsd_datagram* datagram = acquire_datagram(pool);
+        memcpy(datagram->value, end_message, length);
+        chan_send(network_listener_to_parser, datagram);
+    }
     pthread_exit(NULL);
 }
 
@@ -135,18 +190,88 @@ free_unprocessed_datagram(struct unprocessed_statsd_datagram* datagram) {
     }
 }
 
+/**
+ * Creates pool of datagram buffers
+ * @arg config - Application config
+ * @arg count - Number of datagrams in pool
+ * @return datagram_pool
+ */
+struct datagram_pool*
+create_datagram_pool(struct agent_config* config, size_t count) {
+    struct datagram_pool* pool = (struct datagram_pool*) malloc(sizeof(struct datagram_pool));
+    ALLOC_CHECK(pool, "Unable to assign memory for datagram pool.");
+    pool->count = count;
+    pool->free_datagrams = chan_init(count);
+    if (pool->free_datagrams == NULL) {
+        DIE("Unable to create channel for datagram pool.");
+    }
+    pool->datagrams =
+        (struct unprocessed_statsd_datagram*) malloc(sizeof(struct unprocessed_statsd_datagram) * count);
+    ALLOC_CHECK(pool->datagrams, "Unable to assign memory for pooled datagrams.");
+    size_t i;
+    for (i = 0; i < count; i++) {
+        pool->datagrams[i].value = (char*) malloc(sizeof(char) * (config->max_udp_packet_size + 1));
+        ALLOC_CHECK(pool->datagrams[i].value, "Unable to assign memory for datagram value.");
+        chan_send(pool->free_datagrams, &pool->datagrams[i]);
+    }
+    return pool;
+}
+
+/**
+ * Takes datagram from pool, waits for one to be released if pool is empty
+ * @arg pool - Datagram pool
+ * @return datagram or NULL when pool is closed
+ */
+struct unprocessed_statsd_datagram*
+acquire_datagram(struct datagram_pool* pool) {
+    struct unprocessed_statsd_datagram* datagram = NULL;
+    if (chan_recv(pool->free_datagrams, (void*)&datagram) == -1) {
+        return NULL;
+    }
+    return datagram;
+}
+
+/**
+ * Returns datagram back to pool
+ * @arg pool - Datagram pool
+ * @arg datagram - Datagram taken from the same pool
+ */
+void
+release_datagram(struct datagram_pool* pool, struct unprocessed_statsd_datagram* datagram) {
+    if (datagram != NULL) {
+        chan_send(pool->free_datagrams, datagram);
+    }
+}
+
+/**
+ * Frees pool along with all its datagrams, none may be in use anymore
+ * @arg pool - Datagram pool
+ */
+void
+free_datagram_pool(struct datagram_pool* pool) {
+    size_t i;
+    chan_close(pool->free_datagrams);
+    chan_dispose(pool->free_datagrams);
+    for (i = 0; i < pool->count; i++) {
+        free(pool->datagrams[i].value);
+    }
+    free(pool->datagrams);
+    free(pool);
+}
+
 /**
  * Creates arguments for network listener thread
  * @arg config - Application config
- * @arg unprocessed_channel - Network listener -> Parser
- * @arg stats_sink - Channel for sending stats about PMDA itself
+ * @arg network_listener_to_parser - Network listener -> Parser
+ * @arg pool - Datagram pool
  * @return network_listener_args
  */
 struct network_listener_args*
-create_listener_args(struct agent_config* config, chan_t* network_listener_to_parser) {
+create_listener_args(struct agent_config* config, chan_t* network_listener_to_parser, struct datagram_pool* pool) {
     struct network_listener_args* listener_args = (struct network_listener_args*) malloc(sizeof(struct network_listener_args));
     ALLOC_CHECK(listener_args, "Unable to assign memory for listener arguments.");
     listener_args->config = config;
     listener_args->network_listener_to_parser = network_listener_to_parser;
+    listener_args->pool = pool;
     return listener_args;
 }
@@ -20,15 +20,32 @@
 
 #include "config-reader.h"
 
+/**
+ * Maximum number of datagrams read from socket in one receive call
+ */
+#define NETWORK_LISTENER_BATCH_SIZE 32
+
 typedef struct unprocessed_statsd_datagram
 {
     char* value;
 } unprocessed_statsd_datagram;
 
+/**
+ * Preallocated datagram buffers, recycled between network listener and parsers
+ * - free datagrams wait in free_datagrams channel, each has buffer of max_udp_packet_size + 1
+ */
+typedef struct datagram_pool
+{
+    chan_t* free_datagrams;
+    struct unprocessed_statsd_datagram* datagrams;
+    size_t count;
+} datagram_pool;
+
 typedef struct network_listener_args
 {
     struct agent_config* config;
     chan_t* network_listener_to_parser;
+    struct datagram_pool* pool;
 } network_listener_args;
 
 /**
@@ -46,13 +63,46 @@ network_listener_exec(void* args);
 extern void
 free_unprocessed_datagram(struct unprocessed_statsd_datagram* datagram);
 
+/**
+ * Creates pool of datagram buffers
+ * @arg config - Application config
+ * @arg count - Number of datagrams in pool
+ * @return datagram_pool
+ */
+extern struct datagram_pool*
+create_datagram_pool(struct agent_config* config, size_t count);
+
+/**
+ * Takes datagram from pool, waits for one to be released if pool is empty
+ * @arg pool - Datagram pool
+ * @return datagram or NULL when pool is closed
+ */
+extern struct unprocessed_statsd_datagram*
+acquire_datagram(struct datagram_pool* pool);
+
+/**
+ * Returns datagram back to pool
+ * @arg pool - Datagram pool
+ * @arg datagram - Datagram taken from the same pool
+ */
+extern void
+release_datagram(struct datagram_pool* pool, struct unprocessed_statsd_datagram* datagram);
+
+/**
+ * Frees pool along with all its datagrams, none may be in use anymore
+ * @arg pool - Datagram pool
+ */
+extern void
+free_datagram_pool(struct datagram_pool* pool);
+
 /**
  * Creates arguments for network listener thread
  * @arg config - Application config
  * @arg network_listener_to_parser - Network listener -> Parser
+ * @arg pool - Datagram pool
  * @return network_listener_args
  */
 extern struct network_listener_args*
-create_listener_args(struct agent_config* config, chan_t* network_listener_to_parser);
+create_listener_args(struct agent_config* config, chan_t* network_listener_to_parser, struct datagram_pool* pool);
 
 #endif
@@ -23,6 +23,7 @@
 #include "network-listener.h"
 #include "parsers.h"
 #include "aggregators.h"
+#include "aggregator-metrics.h"
 #include "parser-basic.h"
 #include "parser-ragel.h"
 #include "utils.h"
@@ -38,7 +39,9 @@ parser_exec(void* args) {
     static char* network_end_message = "PMDASTATSD_EXIT";
     struct agent_config* config = ((struct parser_args*)args)->config;
     chan_t* network_listener_to_parser = ((struct parser_args*)args)->network_listener_to_parser;
-    chan_t* parser_to_aggregator = ((struct parser_args*)args)->parser_to_aggregator;
+    struct datagram_pool* pool = ((struct parser_args*)args)->pool;
+    chan_t** parser_to_aggregator = ((struct parser_args*)args)->parser_to_aggregator;
+    size_t aggregator_count = ((struct parser_args*)args)->aggregator_count;
     datagram_parse_callback parse_datagram;
     if ((int)config->parser_type == (int)PARSER_TYPE_BASIC) {
         parse_datagram = &basic_parser_parse;
@@ -47,6 +50,7 @@ parser_exec(void* args) {
     }
     struct unprocessed_statsd_datagram* datagram;
     char delim[] = "\n";
+    char* saveptr;
     struct timespec t0, t1;
     unsigned long time_spent_parsing;
     int should_exit;
@@ -59,16 +63,16 @@ parser_exec(void* args) {
         }
         if (strcmp(datagram->value, network_end_message) == 0) {
             VERBOSE_LOG(2, "Got network end message.");
-            free_unprocessed_datagram(datagram);
+            release_datagram(pool, datagram);
             break;
         }
         if (should_exit) {
             VERBOSE_LOG(2, "Freeing datagrams after exit.");
-            free_unprocessed_datagram(datagram);
+            release_datagram(pool, datagram);
             continue;
         }
         struct statsd_datagram* parsed;
-        char* tok = strtok(datagram->value, delim);
+        char* tok = strtok_r(datagram->value, delim, &saveptr);
         while (tok != NULL) {
             clock_gettime(CLOCK_MONOTONIC, &t0);
             int success = parse_datagram(tok, &parsed);
@@ -81,24 +85,32 @@ parser_exec(void* args) {
             if (success) {
                 message->data = parsed;
                 message->type = PARSER_RESULT_PARSED;
-                chan_send(parser_to_aggregator, message);
+                // metric is always aggregated by the shard that owns its name
+                chan_send(parser_to_aggregator[get_metric_shard_index(parsed->name, aggregator_count)], message);
             } else {
                 message->data = NULL;
                 message->type = PARSER_RESULT_DROPPED;
-                chan_send(parser_to_aggregator, message);
+                chan_send(parser_to_aggregator[0], message);
             }
-            tok = strtok(NULL, delim);
+            tok = strtok_r(NULL, delim, &saveptr);
         }
-        free_unprocessed_datagram(datagram);
+        release_datagram(pool, datagram);
     }
     VERBOSE_LOG(2, "Parser exiting.");
-    struct parser_to_aggregator_message* message =
-        (struct parser_to_aggregator_message*) malloc(sizeof(struct parser_to_aggregator_message));
-    ALLOC_CHECK(message, "Unable to assign memory for parser to aggregator message.");
-    message->type = PARSER_RESULT_END;
-    message->time = 0;
-    message->data = NULL;
-    chan_send(parser_to_aggregator, message);
+    // aggregators may only stop once no parser can send them anything anymore
+    unsigned int exited = __sync_add_and_fetch(((struct parser_args*)args)->parsers_exited, 1);
+    if (exited == config->parser_threads) {
+        size_t i;
+        for (i = 0; i < aggregator_count; i++) {
+            struct parser_to_aggregator_message* message =
+                (struct parser_to_aggregator_message*) malloc(sizeof(struct parser_to_aggregator_message));
+            ALLOC_CHECK(message, "Unable to assign memory for parser to aggregator message.");
+            message->type = PARSER_RESULT_END;
+            message->time = 0;
+            message->data = NULL;
+            chan_send(parser_to_aggregator[i], message);
+        }
+    }
     pthread_exit(NULL);
 }
 
@@ -106,16 +118,29 @@ parser_exec(void* args) {
  * Creates arguments for parser thread
  * @arg config - Application config
  * @arg network_listener_to_parser - Network listener -> Parser
- * @arg parser_to_aggregator - Parser -> Aggregator
+ * @arg pool - Datagram pool, to which processed datagrams are released
+ * @arg parser_to_aggregator - Parser -> Aggregator, one for each aggregator shard
+ * @arg aggregator_count - Number of aggregator shards
+ * @arg parsers_exited - Counter of exited parser threads, shared by all of them
  * @return parser_args
  */
 struct parser_args*
-create_parser_args(struct agent_config* config, chan_t* network_listener_to_parser, chan_t* parser_to_aggregator) {
+create_parser_args(
+    struct agent_config* config,
+    chan_t* network_listener_to_parser,
+    struct datagram_pool* pool,
+    chan_t** parser_to_aggregator,
+    size_t aggregator_count,
+    unsigned int* parsers_exited
+) {
     struct parser_args* args = (struct parser_args*) malloc(sizeof(struct parser_args));
     ALLOC_CHECK(args, "Unable to assign memory for parser arguments.");
     args->config = config;
     args->network_listener_to_parser = network_listener_to_parser;
+    args->pool = pool;
     args->parser_to_aggregator = parser_to_aggregator;
+    args->aggregator_count = aggregator_count;
+    args->parsers_exited = parsers_exited;
     return args;
 }
 
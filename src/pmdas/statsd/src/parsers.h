@@ -24,7 +24,10 @@ typedef struct parser_args
 {
     struct agent_config* config;
     chan_t* network_listener_to_parser;
-    chan_t* parser_to_aggregator;
+    struct datagram_pool* pool;
+    chan_t** parser_to_aggregator; // one channel per aggregator shard
+    size_t aggregator_count;
+    unsigned int* parsers_exited; // shared by all parser threads, last one to exit ends aggregators
 } parser_args;
 
 typedef enum METRIC_TYPE { 
@@ -76,11 +79,21 @@ parser_exec(void* args);
  * Creates arguments for parser thread
  * @arg config - Application config
  * @arg network_listener_to_parser - Network listener -> Parser
- * @arg parser_to_aggregator - Parser -> Aggregator
+ * @arg pool - Datagram pool, to which processed datagrams are released
+ * @arg parser_to_aggregator - Parser -> Aggregator, one for each aggregator shard
+ * @arg aggregator_count - Number of aggregator shards
+ * @arg parsers_exited - Counter of exited parser threads, shared by all of them
  * @return parser_args
  */
 extern struct parser_args*
-create_parser_args(struct agent_config* config, chan_t* network_listener_to_parser, chan_t* parser_to_aggregator);
+create_parser_args(
+    struct agent_config* config,
+    chan_t* network_listener_to_parser,
+    struct datagram_pool* pool,
+    chan_t** parser_to_aggregator,
+    size_t aggregator_count,
+    unsigned int* parsers_exited
+);
 
 /**
  * 
@@ -422,18 +422,22 @@ statsd_map_stats(pmdaExt* pmda) {
     reset_stat(data->config, data->stats_storage, STAT_TRACKED_METRIC);
     insert_hardcoded_metrics(pmda);
     struct pmda_metrics_container* container = data->metrics_storage;
-    pthread_mutex_lock(&container->mutex);
-    metrics* m = container->metrics;
-    dictIterator iterator;
-    dictInitIterator(&iterator, m);
-    dictEntry* current;
-    while ((current = dictNext(&iterator)) != NULL) {
-        struct metric* item = (struct metric*)dictGetVal(current);
-        char* key = (char*)dictGetKey(current);
-        map_metric(key, item, pmda);
+    // read generation first, anything added while walking the shards triggers another reload
+    data->generation = get_metrics_generation(container);
+    size_t i;
+    for (i = 0; i < container->shard_count; i++) {
+        struct metrics_shard* shard = &container->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        dictIterator iterator;
+        dictInitIterator(&iterator, shard->metrics);
+        dictEntry* current;
+        while ((current = dictNext(&iterator)) != NULL) {
+            struct metric* item = (struct metric*)dictGetVal(current);
+            char* key = (char*)dictGetKey(current);
+            map_metric(key, item, pmda);
+        }
+        pthread_mutex_unlock(&shard->mutex);
     }
-    data->generation = data->metrics_storage->generation;
-    pthread_mutex_unlock(&container->mutex);
 
     pmdaTreeRebuildHash(data->pcp_pmns, data->pcp_metric_count);
 }
@@ -446,9 +450,7 @@ statsd_map_stats(pmdaExt* pmda) {
 static void
 statsd_possible_reload(pmdaExt* pmda) {    
     struct pmda_data_extension* data = (struct pmda_data_extension*) pmdaExtGetData(pmda);
-    pthread_mutex_lock(&data->metrics_storage->mutex);
-    int need_reload = data->metrics_storage->generation != data->generation ? 1 : 0;
-    pthread_mutex_unlock(&data->metrics_storage->mutex);
+    int need_reload = get_metrics_generation(data->metrics_storage) != data->generation ? 1 : 0;
     if (need_reload) {
         VERBOSE_LOG(1, "statsd: %s: reloading", pmGetProgname());
         statsd_map_stats(pmda);
@@ -793,9 +795,9 @@ statsd_label_callback(pmInDom in_dom, unsigned int inst, pmLabelSet** lp) {
     if (!found) {
         return 0;
     }
-    pthread_mutex_lock(&data->metrics_storage->mutex);
+    pthread_mutex_lock(&item->shard->mutex);
     pmdaAddLabels(lp, "%s", label->labels);
-    pthread_mutex_unlock(&data->metrics_storage->mutex);
+    pthread_mutex_unlock(&item->shard->mutex);
     return label->pair_count;
 }
 
@@ -936,7 +938,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
     enum DURATION_INSTANCE duration_stat;
     // metrics without any labels
     if (is_default_domain) {
-        pthread_mutex_lock(&data->metrics_storage->mutex);
+        pthread_mutex_lock(&result->shard->mutex);
         if (result->type == METRIC_TYPE_DURATION) {
             duration_stat = map_to_duration_instance(instance);
             (*atom)->d = get_duration_instance(config, result->value, duration_stat);
@@ -944,7 +946,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
             (*atom)->d = *(double*)result->value;
         }
         status = PMDA_FETCH_STATIC;
-        pthread_mutex_unlock(&data->metrics_storage->mutex);
+        pthread_mutex_unlock(&result->shard->mutex);
     } 
     // metrics with labels
     else {
@@ -953,7 +955,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
                                     ((result->type == METRIC_TYPE_DURATION && instance < 9) || instance == 0);
         // check if request was for root value
         if (request_for_root_value) {
-            pthread_mutex_lock(&data->metrics_storage->mutex);
+            pthread_mutex_lock(&result->shard->mutex);
             if (result->type == METRIC_TYPE_DURATION) {
                 duration_stat = map_to_duration_instance(instance);
                 (*atom)->d = get_duration_instance(config, result->value, duration_stat);
@@ -961,7 +963,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
                 (*atom)->d = *(double*)result->value;
             }
             status = PMDA_FETCH_STATIC;
-            pthread_mutex_unlock(&data->metrics_storage->mutex);
+            pthread_mutex_unlock(&result->shard->mutex);
         } else {
         // else return some labeled value
             int instance_label_offset;
@@ -980,7 +982,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
                 &label
             );
             if (found) {
-                pthread_mutex_lock(&data->metrics_storage->mutex);
+                pthread_mutex_lock(&result->shard->mutex);
                 if (result->type == METRIC_TYPE_DURATION) {
                     duration_stat = map_to_duration_instance(instance);
                     (*atom)->d = get_duration_instance(config, label->value, duration_stat);
@@ -988,7 +990,7 @@ statsd_resolve_dynamic_metric_fetch(pmdaMetric* mdesc, unsigned int instance, pm
                     (*atom)->d = *(double*)label->value;
                 }
                 status = PMDA_FETCH_STATIC;
-                pthread_mutex_unlock(&data->metrics_storage->mutex);
+                pthread_mutex_unlock(&result->shard->mutex);
             }
         }
     }
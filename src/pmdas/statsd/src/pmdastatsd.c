@@ -154,9 +154,7 @@ free_shared_data(struct agent_config* config, struct pmda_data_extension* data)
     // frees config
     free(config->debug_output_filename);
     // remove metrics dictionary and related
-    dictRelease(data->metrics_storage->metrics);
-    pthread_mutex_destroy(&data->metrics_storage->mutex);
-    free(data->metrics_storage);
+    free_pmda_metrics(data->metrics_storage);
     // remove stats dictionary and related
     free(data->stats_storage->stats->metrics_recorded);
     free(data->stats_storage->stats);
@@ -249,13 +247,15 @@ main_PDU_loop(pmdaInterface* dispatch) {
 
 static int _isDSO = 1; /* for local contexts */
 static pthread_t network_listener;
-static pthread_t aggregator;
-static pthread_t parser;
+static pthread_t aggregators[MAX_AGGREGATOR_SHARDS];
+static pthread_t parsers[MAX_PARSER_THREADS];
+static unsigned int parsers_exited;
+static struct datagram_pool* datagrams;
 static chan_t* network_listener_to_parser;
-static chan_t* parser_to_aggregator;
+static chan_t* parser_to_aggregator[MAX_AGGREGATOR_SHARDS];
 static struct network_listener_args* listener_thread_args;
-static struct aggregator_args* aggregator_thread_args;
-static struct parser_args* parser_thread_args;
+static struct aggregator_args* aggregator_thread_args[MAX_AGGREGATOR_SHARDS];
+static struct parser_args* parser_thread_args[MAX_PARSER_THREADS];
 static struct agent_config config;
 static struct pmda_data_extension data = { 0 };
 char help_file_path[MAXPATHLEN];
@@ -268,6 +268,7 @@ statsd_init(pmdaInterface *dispatch)
     struct pmda_metrics_container* metricsp;
     struct pmda_stats_container* statsp;
     int pthread_errno, sep = pmPathSeparator();
+    unsigned int i;
 
     if (_isDSO) {
         pmsprintf(
@@ -288,26 +289,49 @@ statsd_init(pmdaInterface *dispatch)
     statsp = init_pmda_stats(&config);
     init_data_ext(&data, &config, metricsp, statsp);
 
+    // enough datagrams for full parser queue, listener's receive batch and one being parsed by each parser
+    datagrams = create_datagram_pool(
+        &config,
+        config.max_unprocessed_packets + NETWORK_LISTENER_BATCH_SIZE + config.parser_threads
+    );
     network_listener_to_parser = chan_init(config.max_unprocessed_packets);
     if (network_listener_to_parser == NULL) {
 	    DIE("Unable to create channel network listener -> parser.");
     }
-    parser_to_aggregator = chan_init(config.max_unprocessed_packets);
-    if (parser_to_aggregator == NULL) {
-	    DIE("Unable to create channel parser -> aggregator.");
+    for (i = 0; i < config.aggregator_shards; i++) {
+        parser_to_aggregator[i] = chan_init(config.max_unprocessed_packets);
+        if (parser_to_aggregator[i] == NULL) {
+            DIE("Unable to create channel parser -> aggregator.");
+        }
     }
 
-    listener_thread_args = create_listener_args(&config, network_listener_to_parser);
-    parser_thread_args = create_parser_args(&config, network_listener_to_parser, parser_to_aggregator);
-    aggregator_thread_args = create_aggregator_args(&config, parser_to_aggregator, metricsp, statsp);
+    listener_thread_args = create_listener_args(&config, network_listener_to_parser, datagrams);
+    parsers_exited = 0;
+    for (i = 0; i < config.parser_threads; i++) {
+        parser_thread_args[i] = create_parser_args(
+            &config,
+            network_listener_to_parser,
+            datagrams,
+            parser_to_aggregator,
+            config.aggregator_shards,
+            &parsers_exited
+        );
+    }
+    for (i = 0; i < config.aggregator_shards; i++) {
+        aggregator_thread_args[i] = create_aggregator_args(&config, parser_to_aggregator[i], metricsp, statsp);
+    }
 
     pthread_errno = 0; 
     pthread_errno = pthread_create(&network_listener, NULL, network_listener_exec, listener_thread_args);
     PTHREAD_CHECK(pthread_errno);
-    pthread_errno = pthread_create(&parser, NULL, parser_exec, parser_thread_args);
-    PTHREAD_CHECK(pthread_errno);
-    pthread_errno = pthread_create(&aggregator, NULL, aggregator_exec, aggregator_thread_args);
-    PTHREAD_CHECK(pthread_errno);
+    for (i = 0; i < config.parser_threads; i++) {
+        pthread_errno = pthread_create(&parsers[i], NULL, parser_exec, parser_thread_args[i]);
+        PTHREAD_CHECK(pthread_errno);
+    }
+    for (i = 0; i < config.aggregator_shards; i++) {
+        pthread_errno = pthread_create(&aggregators[i], NULL, aggregator_exec, aggregator_thread_args[i]);
+        PTHREAD_CHECK(pthread_errno);
+    }
 
     if (dispatch->status != 0) {
         pthread_exit(NULL);
@@ -337,31 +361,43 @@ statsd_init(pmdaInterface *dispatch)
 
 static void
 statsd_done(void) {    
+    unsigned int i;
     if (pthread_join(network_listener, NULL) != 0) {
         DIE("Error joining network network listener thread.");
     } else {
         VERBOSE_LOG(2, "Network listener thread joined.");
     }
-    if (pthread_join(parser, NULL) != 0) {
-        DIE("Error joining datagram parser thread.");
-    } else {
-        VERBOSE_LOG(2, "Parser thread joined.");
+    for (i = 0; i < config.parser_threads; i++) {
+        if (pthread_join(parsers[i], NULL) != 0) {
+            DIE("Error joining datagram parser thread.");
+        } else {
+            VERBOSE_LOG(2, "Parser thread joined.");
+        }
     }
-    if (pthread_join(aggregator, NULL) != 0) {    
-        DIE("Error joining datagram aggregator thread.");
-    } else {
-        VERBOSE_LOG(2, "Aggregator thread joined.");
+    for (i = 0; i < config.aggregator_shards; i++) {
+        if (pthread_join(aggregators[i], NULL) != 0) {    
+            DIE("Error joining datagram aggregator thread.");
+        } else {
+            VERBOSE_LOG(2, "Aggregator thread joined.");
+        }
     }
 
     free_shared_data(&config, &data);
     free(listener_thread_args);
-    free(parser_thread_args);
-    free(aggregator_thread_args);
+    for (i = 0; i < config.parser_threads; i++) {
+        free(parser_thread_args[i]);
+    }
+    for (i = 0; i < config.aggregator_shards; i++) {
+        free(aggregator_thread_args[i]);
+    }
     
     chan_close(network_listener_to_parser);
-    chan_close(parser_to_aggregator);
     chan_dispose(network_listener_to_parser);
-    chan_dispose(parser_to_aggregator);
+    for (i = 0; i < config.aggregator_shards; i++) {
+        chan_close(parser_to_aggregator[i]);
+        chan_dispose(parser_to_aggregator[i]);
+    }
+    free_datagram_pool(datagrams);
 }
 
 int
@@ -1004,6 +1004,144 @@ mark_all(Host *hdown)
     }
 }
 
+#ifdef PM_MULTI_THREAD
+/*
+ * Concurrent fetching ... with many live hosts in a Task, doing the
+ * fetches one after another makes each cycle take the sum of all the
+ * round trip times.  Instead the pmFetch calls are handed out to a
+ * pool of threads, so the cycle is only as long as the slowest host.
+ * Current context is per-thread in libpcp, so each thread may
+ * pmUseContext() independently.  Only the fetches happen in the
+ * threads, all the state changes (host down, etc) are done back in
+ * the main thread once all the fetches have completed.
+ *
+ * The pool threads (a libpcp __pmWorkPool) live for the life of pmie,
+ * idle between cycles; the pool grows as needed to one thread per live
+ * host fetch (less the one done by the main thread) up to
+ * MAX_FETCH_THREADS, and each thread claims fetches until none remain.
+ */
+#define MAX_FETCH_THREADS	64
+
+typedef struct {
+    pthread_mutex_t	lock;		/* guards next */
+    Fetch		**fetches;	/* fetches to be done */
+    int			*status;	/* pmFetch return values */
+    int			nfetch;
+    int			next;		/* next fetch to be claimed */
+} fetchbatch_t;
+
+static fetchbatch_t	batch = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+static __pmWorkPool	*pool;
+
+/* claim and do fetches until none are left */
+static void
+fetchClaim(void)
+{
+    Fetch	*f;
+    int		i;
+
+    pthread_mutex_lock(&batch.lock);
+    while (batch.next < batch.nfetch) {
+	i = batch.next++;
+	f = batch.fetches[i];
+	pthread_mutex_unlock(&batch.lock);
+	if ((batch.status[i] = pmUseContext(f->handle)) >= 0)
+	    batch.status[i] = pmFetch(f->npmids, f->pmids, &f->result);
+	pthread_mutex_lock(&batch.lock);
+    }
+    pthread_mutex_unlock(&batch.lock);
+}
+
+static void
+fetchTask(void *arg, int i)
+{
+    (void)arg;
+    (void)i;
+    fetchClaim();
+}
+
+/*
+ * Fetch from all the given Fetches concurrently, the pmFetch status
+ * for fetches[i] is returned in status[i].
+ */
+static void
+fetchConcurrent(Fetch **fetches, int *status, int nfetch)
+{
+    int		want = nfetch - 1;	/* main thread does one */
+
+    if (want > MAX_FETCH_THREADS)
+	want = MAX_FETCH_THREADS;
+
+    batch.fetches = fetches;
+    batch.status = status;
+    batch.nfetch = nfetch;
+    batch.next = 0;
+    if (pool == NULL)
+	pool = __pmWorkPoolCreate();
+    if (pool != NULL)
+	__pmWorkPoolStart(pool, want, fetchTask, NULL);
+
+    /* main thread also works, which covers threads not started too */
+    fetchClaim();
+    if (pool != NULL)
+	__pmWorkPoolWait(pool);
+}
+#endif
+
+/*
+ * Deal with the outcome of pmFetch for Fetch f, return 0 to continue
+ * or -1 if pmie is to stop.
+ */
+static int
+fetchDone(Fetch *f, int sts)
+{
+    Host	*h = f->host;
+
+    if (sts < 0) {
+	if (archives) {
+	    if (sts == PM_ERR_LOGREC) {
+		fprintf(stderr, "%s: pmFetch failed: %s\n", pmGetProgname(),
+			pmErrStr(sts));
+		exit(1);
+	    }
+	}
+	else {
+	    pmNotifyErr(LOG_ERR, "pmFetch from %s failed: %s\n",
+		    symName(f->host->name), pmErrStr(sts));
+	    host_state_changed(symName(f->host->conn), STATE_LOSTCONN);
+	    h->down = 1;
+	    mark_all(h);
+	}
+	f->result = NULL;
+    }
+    else if (sts & PMCD_HOSTNAME_CHANGE) {
+	/*
+	 * Hostname changed for pmcd and we were launched from
+	 * the control-driven scripts (pmie_check, pmie_daily),
+	 * then we need to exit.
+	 *
+	 * We rely on the systemd autorestart, systemd timer,
+	 * cron or the user to restart this pmie at which
+	 * time one or more of the following will happen:
+	 * - the correct pmcd hostname will be used internally,
+	 *   e.g. for %h in print actions
+	 * - for a pmie launched from the standard
+	 *   /etc/pcp/pmie control files, LOCALHOSTNAME will get
+	 *   correctly re-translated into a different pathname
+	 *   (usually the directory for the log file)
+	 */
+	const char	*host_name = pmGetContextHostName(f->handle);
+	pmNotifyErr(LOG_INFO, "PMCD hostname changed from %s to %s during pmFetch", symName(f->host->name), host_name);
+	if (runfromcontrol) {
+	    run_done = 1;
+	    return -1;
+	}
+    }
+    return 0;
+}
+
 /* execute fetches for given Task */
 void
 taskFetch(Task *t)
@@ -1016,6 +1154,12 @@ taskFetch(Task *t)
     pmValueSet	**v;
     int		i;
     int		sts;
+#ifdef PM_MULTI_THREAD
+    static Fetch	**fetches;
+    static int		*status;
+    static int		maxfetch;
+    int			nfetch = 0;
+#endif
 
     /* do all fetches, quick as you can */
     h = t->hosts;
@@ -1023,56 +1167,53 @@ taskFetch(Task *t)
 	f = h->fetches;
 	while (f) {
 	    if (f->result) pmFreeResult(f->result);
+	    f->result = NULL;
+#ifdef PM_MULTI_THREAD
+	    if (! h->down && ! archives) {
+		/* live hosts are fetched concurrently below */
+		if (nfetch == maxfetch) {
+		    maxfetch = maxfetch ? maxfetch * 2 : 16;
+		    fetches = (Fetch **) ralloc(fetches, maxfetch * sizeof(Fetch *));
+		    status = (int *) ralloc(status, maxfetch * sizeof(int));
+		}
+		fetches[nfetch++] = f;
+		f = f->next;
+		continue;
+	    }
+#endif
 	    if (! h->down) {
 		pmUseContext(f->handle);
-		if ((sts = pmFetch(f->npmids, f->pmids, &f->result)) < 0) {
-		    if (archives) {
-			if (sts == PM_ERR_LOGREC) {
-			    fprintf(stderr, "%s: pmFetch failed: %s\n", pmGetProgname(),
-				    pmErrStr(sts));
-			    exit(1);
-			}
-		    }
-		    else {
-			pmNotifyErr(LOG_ERR, "pmFetch from %s failed: %s\n",
-				symName(f->host->name), pmErrStr(sts));
-			host_state_changed(symName(f->host->conn), STATE_LOSTCONN);
-			h->down = 1;
-			mark_all(h);
-		    }
-		    f->result = NULL;
-		}
-		else if (sts & PMCD_HOSTNAME_CHANGE) {
-		    /*
-		     * Hostname changed for pmcd and we were launched from
-		     * the control-driven scripts (pmie_check, pmie_daily),
-		     * then we need to exit.
-		     *
-		     * We rely on the systemd autorestart, systemd timer,
-		     * cron or the user to restart this pmie at which
-		     * time one or more of the following will happen:
-		     * - the correct pmcd hostname will be used internally,
-		     *   e.g. for %h in print actions
-		     * - for a pmie launched from the standard
-		     *   /etc/pcp/pmie control files, LOCALHOSTNAME will get
-		     *   correctly re-translated into a different pathname
-		     *   (usually the directory for the log file)
-		     */
-		    const char	*host_name = pmGetContextHostName(f->handle);
-		    pmNotifyErr(LOG_INFO, "PMCD hostname changed from %s to %s during pmFetch", symName(f->host->name), host_name);
-		    if (runfromcontrol) {
-			run_done = 1;
-			return;
-		    }
-		}
+		sts = pmFetch(f->npmids, f->pmids, &f->result);
+		if (fetchDone(f, sts) < 0)
+		    return;
 	    }
-	    else
-		f->result = NULL;
 	    f = f->next;
 	}
 	h = h->next;
     }
 
+#ifdef PM_MULTI_THREAD
+    if (nfetch == 1) {
+	pmUseContext(fetches[0]->handle);
+	status[0] = pmFetch(fetches[0]->npmids, fetches[0]->pmids, &fetches[0]->result);
+    }
+    else if (nfetch > 1)
+	fetchConcurrent(fetches, status, nfetch);
+
+    /* handle outcomes in Task order, as if fetched one at a time */
+    for (i = 0; i < nfetch; i++) {
+	f = fetches[i];
+	if (f->host->down) {
+	    /* earlier fetch for the same host failed */
+	    if (f->result) pmFreeResult(f->result);
+	    f->result = NULL;
+	    continue;
+	}
+	if (fetchDone(f, status[i]) < 0)
+	    return;
+    }
+#endif
+
     /* sort and distribute pmValueSets to requesting Metrics */
     h = t->hosts;
     while (h) {
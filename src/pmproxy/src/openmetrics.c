@@ -11,6 +11,7 @@
  * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
  * License for more details.
  */
+#include <uv.h>
 #include "openmetrics.h"
 #include "libpcp.h"
 #include "util.h"
@@ -57,23 +58,20 @@ labeladd(void *arg, const struct dictEntry *entry)
 	sdscatfmt(labels->buffer, ",%S=%S", dictGetKey(entry), dictGetVal(entry));
 }
 
+/* label names, created before any worker thread can merge labels */
+static sds		instname, instid;
+
 /* convert an array of PCP labelsets into Open Metrics form */
-void
-open_metrics_labels(pmWebLabelSet *labels)
+static void
+open_metrics_merge(pmWebLabelSet *labels)
 {
     pmLabelSet		*labelset;
     pmLabel		*label;
     dict		*labeldict;
     const char		*offset;
-    static sds		instname, instid;
     sds			key, value;
     int			i, j, length;
 
-    if (instname == NULL)
-	instname = sdsnewlen("instname", 8);
-    if (instid == NULL)
-	instid = sdsnewlen("instid", 6);
-
     labeldict = dictCreate(&sdsOwnDictCallBacks);
 
     /* walk labelset in order adding labels to a temporary dictionary */
@@ -130,6 +128,166 @@ open_metrics_labels(pmWebLabelSet *labels)
     dictRelease(labeldict);
 }
 
+/*
+ * Cache of Open Metrics label strings, keyed on the addresses of the
+ * (interned, see __pmInternLabelSet) label sets being merged and the
+ * instance - a scrape merges the same few sets for every value, with
+ * only the instance level changing.  Each entry holds a reference on
+ * its label sets, so their addresses cannot be reused while cached;
+ * entries unused since the previous sweep are dropped once the cache
+ * reaches twice the size it was after that sweep.  Scrapes run on the
+ * worker threads, so the cache is guarded by labelcache_lock.
+ */
+#define MAXLABELSETS	(sizeof(((pmWebLabelSet *)0)->sets) / sizeof(pmLabelSet *))
+#define MINLABELCACHE	1024
+
+typedef struct labelcache {
+    unsigned int	key;
+    unsigned int	used;
+    int			nsets;
+    pmLabelSet		*sets[MAXLABELSETS];
+    unsigned int	instid;
+    sds			instname;
+    sds			labels;		/* Open Metrics form */
+    unsigned long long	serial;		/* identifies these labels */
+} labelcache_t;
+
+static __pmHashCtl	labelcache;
+static unsigned int	labelcache_limit = MINLABELCACHE;
+static unsigned long long labelcache_serial;
+static uv_mutex_t	labelcache_lock;
+
+static unsigned int
+labelcache_key(pmWebLabelSet *labels)
+{
+    const unsigned char	*bp = (const unsigned char *)labels->sets;
+    unsigned int	i, h = 2166136261U;	/* FNV-1a */
+
+    for (i = 0; i < labels->nsets * sizeof(pmLabelSet *); i++)
+	h = (h ^ bp[i]) * 16777619U;
+    return (h ^ labels->instid) * 16777619U;
+}
+
+static void
+labelcache_free(labelcache_t *lcp)
+{
+    int			i;
+
+    for (i = 0; i < lcp->nsets; i++)
+	if (lcp->sets[i] != NULL)
+	    __pmReleaseLabelSet(lcp->sets[i]);
+    sdsfree(lcp->instname);
+    sdsfree(lcp->labels);
+    free(lcp);
+}
+
+static __pmHashWalkState
+labelcache_sweep(const __pmHashNode *hp, void *arg)
+{
+    labelcache_t	*lcp = (labelcache_t *)hp->data;
+
+    (void)arg;
+    if (lcp->used) {
+	lcp->used = 0;
+	return PM_HASH_WALK_NEXT;
+    }
+    labelcache_free(lcp);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+static labelcache_t *
+labelcache_lookup(pmWebLabelSet *labels, unsigned int key)
+{
+    labelcache_t	*lcp;
+    __pmHashNode	*hp;
+
+    for (hp = __pmHashSearch(key, &labelcache); hp; hp = hp->next) {
+	if (hp->key != key)
+	    continue;
+	lcp = (labelcache_t *)hp->data;
+	if (lcp->nsets == labels->nsets && lcp->instid == labels->instid &&
+	    memcmp(lcp->sets, labels->sets,
+		    labels->nsets * sizeof(pmLabelSet *)) == 0 &&
+	    ((lcp->instname == NULL && labels->instname == NULL) ||
+	     (lcp->instname && labels->instname &&
+	      sdscmp(lcp->instname, labels->instname) == 0)))
+	    return lcp;
+    }
+    return NULL;
+}
+
+/* called with labelcache_lock held, returns the new entry serial */
+static unsigned long long
+labelcache_add(pmWebLabelSet *labels, unsigned int key)
+{
+    labelcache_t	*lcp;
+    int			i;
+
+    if (labels->nsets > MAXLABELSETS)
+	return 0;
+    if ((lcp = labelcache_lookup(labels, key)) != NULL)	/* another thread */
+	return lcp->serial;
+    if ((lcp = (labelcache_t *)calloc(1, sizeof(*lcp))) == NULL)
+	return 0;
+    lcp->key = key;
+    lcp->used = 1;
+    lcp->instid = labels->instid;
+    for (i = 0; i < labels->nsets; i++) {
+	lcp->nsets = i + 1;
+	/* takes a reference, and checks the set is interned */
+	lcp->sets[i] = __pmInternLabelSet(labels->sets[i]);
+	if (lcp->sets[i] != labels->sets[i]) {
+	    labelcache_free(lcp);
+	    return 0;
+	}
+    }
+    if (labels->instname)
+	lcp->instname = sdsdup(labels->instname);
+    lcp->labels = sdsdup(labels->buffer);
+
+    if (labelcache.nodes >= labelcache_limit) {
+	__pmHashWalkCB(labelcache_sweep, NULL, &labelcache);
+	labelcache_limit = labelcache.nodes * 2;
+	if (labelcache_limit < MINLABELCACHE)
+	    labelcache_limit = MINLABELCACHE;
+    }
+    if (__pmHashAdd(key, lcp, &labelcache) < 0) {
+	labelcache_free(lcp);
+	return 0;
+    }
+    return lcp->serial = ++labelcache_serial;
+}
+
+/*
+ * Produce Open Metrics labels for a labelset array, via the cache.
+ * Returns a serial number identifying these labels for as long as
+ * they remain cached (serials are never reused), or zero if uncached.
+ */
+unsigned long long
+open_metrics_labels(pmWebLabelSet *labels)
+{
+    labelcache_t	*lcp;
+    unsigned long long	serial;
+    unsigned int	key = labelcache_key(labels);
+
+    uv_mutex_lock(&labelcache_lock);
+    if ((lcp = labelcache_lookup(labels, key)) != NULL) {
+	lcp->used = 1;
+	labels->buffer = sdscpylen(labels->buffer, lcp->labels, sdslen(lcp->labels));
+	serial = lcp->serial;
+	uv_mutex_unlock(&labelcache_lock);
+	return serial;
+    }
+    uv_mutex_unlock(&labelcache_lock);
+
+    open_metrics_merge(labels);
+
+    uv_mutex_lock(&labelcache_lock);
+    serial = labelcache_add(labels, key);
+    uv_mutex_unlock(&labelcache_lock);
+    return serial;
+}
+
 /* convert PCP metric name to Open Metrics form */
 sds
 open_metrics_name(sds metric, int compat)
@@ -153,3 +311,337 @@ open_metrics_semantics(sds sem)
 	return sdsnew("gauge");
     return sdsnew("counter");
 }
+
+/*
+ * Cached exposition text for each metric family of each context: the
+ * HELP/TYPE header block and, per set of labels (identified by label
+ * cache serial), the "name{labels}" prefix of each value line.  Only
+ * the values themselves are then formatted during a scrape.
+ *
+ * The header is revalidated against the metric metadata each time the
+ * family is started, so metadata changes rebuild it; label and instance
+ * changes produce new label serials, and lines for serials not used
+ * since the previous sweep are dropped when a family's line cache
+ * reaches twice the size it was after that sweep.  Families are swept
+ * likewise, but never while held by a scrape in progress.
+ */
+#define MINFAMILYCACHE	1024
+#define MINLINECACHE	16
+
+struct open_metrics_family {
+    unsigned int	key;
+    unsigned int	used;
+    unsigned int	refcount;	/* scrapes currently using this */
+    unsigned int	compat;
+    sds			context;
+    sds			metric;		/* PCP metric name */
+    pmID		pmid;
+    pmInDom		indom;
+    sds			type;		/* metadata the header was built from */
+    sds			sem;
+    sds			units;
+    sds			oneline;
+    sds			name;		/* Open Metrics metric name */
+    sds			header;
+    __pmHashCtl		lines;
+    unsigned int	linelimit;
+};
+
+typedef struct {
+    unsigned long long	serial;		/* labels serial */
+    unsigned int	used;
+    sds			prefix;		/* name{labels} */
+} open_metrics_line;
+
+static __pmHashCtl	familycache;
+static unsigned int	familycache_limit = MINFAMILYCACHE;
+static uv_mutex_t	familycache_lock;
+
+static unsigned int
+family_key(sds context, sds metric, int compat)
+{
+    unsigned int	h = 2166136261U;	/* FNV-1a */
+    const char		*p;
+
+    for (p = context; p && *p; p++)
+	h = (h ^ (unsigned char)*p) * 16777619U;
+    h = (h ^ '/') * 16777619U;
+    for (p = metric; *p; p++)
+	h = (h ^ (unsigned char)*p) * 16777619U;
+    return (h ^ compat) * 16777619U;
+}
+
+static int
+same_sds(sds a, sds b)
+{
+    if (a == NULL || b == NULL)
+	return a == b;
+    return sdscmp(a, b) == 0;
+}
+
+static __pmHashWalkState
+line_free(const __pmHashNode *hp, void *arg)
+{
+    open_metrics_line	*lp = (open_metrics_line *)hp->data;
+
+    (void)arg;
+    sdsfree(lp->prefix);
+    free(lp);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+static __pmHashWalkState
+line_sweep(const __pmHashNode *hp, void *arg)
+{
+    open_metrics_line	*lp = (open_metrics_line *)hp->data;
+
+    if (lp->used) {
+	lp->used = 0;
+	return PM_HASH_WALK_NEXT;
+    }
+    return line_free(hp, arg);
+}
+
+static void
+family_lines_clear(open_metrics_family *fp)
+{
+    __pmHashWalkCB(line_free, NULL, &fp->lines);
+    __pmHashClear(&fp->lines);
+    fp->linelimit = MINLINECACHE;
+}
+
+static void
+family_free(open_metrics_family *fp)
+{
+    family_lines_clear(fp);
+    sdsfree(fp->context);
+    sdsfree(fp->metric);
+    sdsfree(fp->type);
+    sdsfree(fp->sem);
+    sdsfree(fp->units);
+    sdsfree(fp->oneline);
+    sdsfree(fp->name);
+    sdsfree(fp->header);
+    free(fp);
+}
+
+static __pmHashWalkState
+family_sweep(const __pmHashNode *hp, void *arg)
+{
+    open_metrics_family	*fp = (open_metrics_family *)hp->data;
+
+    (void)arg;
+    if (fp->used || fp->refcount) {
+	fp->used = 0;
+	return PM_HASH_WALK_NEXT;
+    }
+    family_free(fp);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+static int
+family_valid(open_metrics_family *fp, pmWebMetric *metric)
+{
+    return fp->pmid == metric->pmid && fp->indom == metric->indom &&
+	   same_sds(fp->type, metric->type) && same_sds(fp->sem, metric->sem) &&
+	   same_sds(fp->units, metric->units) &&
+	   same_sds(fp->oneline, metric->oneline);
+}
+
+/* (re)build the header block from the current metric metadata */
+static void
+family_header(open_metrics_family *fp, pmWebMetric *metric)
+{
+    char		pmidstr[20], indomstr[20];
+    sds			semantics;
+
+    fp->pmid = metric->pmid;
+    fp->indom = metric->indom;
+    fp->type = sdscpylen(fp->type ? fp->type : sdsempty(),
+			metric->type, sdslen(metric->type));
+    fp->sem = sdscpylen(fp->sem ? fp->sem : sdsempty(),
+			metric->sem, sdslen(metric->sem));
+    fp->units = sdscpylen(fp->units ? fp->units : sdsempty(),
+			metric->units, sdslen(metric->units));
+    sdsfree(fp->oneline);
+    fp->oneline = metric->oneline ? sdsdup(metric->oneline) : NULL;
+
+    if (fp->header == NULL)
+	fp->header = sdsempty();
+    else
+	sdsclear(fp->header);
+
+    if (fp->compat == 0) {	/* include pmid, indom and type */
+	pmIDStr_r(metric->pmid, pmidstr, sizeof(pmidstr));
+	pmInDomStr_r(metric->indom, indomstr, sizeof(indomstr));
+	fp->header = sdscatfmt(fp->header, "# PCP5 %S %s %S %s %S %S\n",
+			metric->name, pmidstr, metric->type,
+			indomstr, metric->sem, metric->units);
+    } else {
+	fp->header = sdscatfmt(fp->header, "# PCP %S %S %S\n",
+			metric->name, metric->sem, metric->units);
+    }
+    if (metric->oneline)
+	fp->header = sdscatfmt(fp->header, "# HELP %S %S\n",
+			fp->name, metric->oneline);
+    semantics = open_metrics_semantics(metric->sem);
+    fp->header = sdscatfmt(fp->header, "# TYPE %S %S\n", fp->name, semantics);
+    sdsfree(semantics);
+}
+
+/*
+ * Start a metric family: append its header block to the result and
+ * pass back the family, held for the caller until the matching call to
+ * open_metrics_family_done.  The family is NULL, and nothing appended,
+ * only if out of memory.
+ */
+sds
+open_metrics_family_start(sds result, sds context, pmWebMetric *metric,
+		int compat, open_metrics_family **family)
+{
+    open_metrics_family	*fp;
+    __pmHashNode	*hp;
+    unsigned int	key = family_key(context, metric->name, compat);
+
+    uv_mutex_lock(&familycache_lock);
+    for (hp = __pmHashSearch(key, &familycache); hp; hp = hp->next) {
+	if (hp->key != key)
+	    continue;
+	fp = (open_metrics_family *)hp->data;
+	if (fp->compat == compat && same_sds(fp->context, context) &&
+	    sdscmp(fp->metric, metric->name) == 0)
+	    break;
+    }
+    if (hp != NULL) {
+	if (!family_valid(fp, metric))
+	    family_header(fp, metric);
+    } else if ((fp = calloc(1, sizeof(*fp))) != NULL) {
+	fp->key = key;
+	fp->compat = compat;
+	fp->context = context ? sdsdup(context) : NULL;
+	fp->metric = sdsdup(metric->name);
+	fp->name = open_metrics_name(metric->name, compat);
+	fp->linelimit = MINLINECACHE;
+	family_header(fp, metric);
+	if (familycache.nodes >= familycache_limit) {
+	    __pmHashWalkCB(family_sweep, NULL, &familycache);
+	    familycache_limit = familycache.nodes * 2;
+	    if (familycache_limit < MINFAMILYCACHE)
+		familycache_limit = MINFAMILYCACHE;
+	}
+	if (__pmHashAdd(key, fp, &familycache) < 0) {
+	    family_free(fp);
+	    fp = NULL;
+	}
+    }
+    if (fp != NULL) {
+	fp->used = 1;
+	fp->refcount++;
+	result = sdscatsds(result, fp->header);
+    }
+    uv_mutex_unlock(&familycache_lock);
+
+    *family = fp;
+    return result;
+}
+
+void
+open_metrics_family_done(open_metrics_family *fp)
+{
+    if (fp == NULL)
+	return;
+    uv_mutex_lock(&familycache_lock);
+    fp->refcount--;
+    uv_mutex_unlock(&familycache_lock);
+}
+
+/*
+ * Append the "name{labels}" prefix of a value line for this family,
+ * from the line cache where the labels have a (non-zero) serial.
+ */
+sds
+open_metrics_family_line(sds result, open_metrics_family *fp,
+		unsigned long long serial, sds labels)
+{
+    open_metrics_line	*lp;
+    __pmHashNode	*hp;
+    unsigned int	key = (unsigned int)(serial ^ (serial >> 32));
+
+    uv_mutex_lock(&familycache_lock);
+    if (serial != 0) {
+	for (hp = __pmHashSearch(key, &fp->lines); hp; hp = hp->next) {
+	    lp = (open_metrics_line *)hp->data;
+	    if (hp->key == key && lp->serial == serial) {
+		lp->used = 1;
+		result = sdscatsds(result, lp->prefix);
+		uv_mutex_unlock(&familycache_lock);
+		return result;
+	    }
+	}
+    }
+
+    if (serial == 0 || (lp = calloc(1, sizeof(*lp))) == NULL) {
+	result = labels ? sdscatfmt(result, "%S{%S}", fp->name, labels) :
+			  sdscatsds(result, fp->name);
+	uv_mutex_unlock(&familycache_lock);
+	return result;
+    }
+    lp->serial = serial;
+    lp->used = 1;
+    lp->prefix = labels ? sdscatfmt(sdsempty(), "%S{%S}", fp->name, labels) :
+			  sdsdup(fp->name);
+    result = sdscatsds(result, lp->prefix);
+
+    if (fp->lines.nodes >= fp->linelimit) {
+	__pmHashWalkCB(line_sweep, NULL, &fp->lines);
+	fp->linelimit = fp->lines.nodes * 2;
+	if (fp->linelimit < MINLINECACHE)
+	    fp->linelimit = MINLINECACHE;
+    }
+    if (__pmHashAdd(key, lp, &fp->lines) < 0) {
+	sdsfree(lp->prefix);
+	free(lp);
+    }
+    uv_mutex_unlock(&familycache_lock);
+    return result;
+}
+
+static __pmHashWalkState
+labelcache_clear(const __pmHashNode *hp, void *arg)
+{
+    (void)arg;
+    labelcache_free((labelcache_t *)hp->data);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+static __pmHashWalkState
+familycache_clear(const __pmHashNode *hp, void *arg)
+{
+    (void)arg;
+    family_free((open_metrics_family *)hp->data);
+    return PM_HASH_WALK_DELETE_NEXT;
+}
+
+void
+open_metrics_setup(void)
+{
+    instname = sdsnewlen("instname", 8);
+    instid = sdsnewlen("instid", 6);
+    uv_mutex_init(&labelcache_lock);
+    uv_mutex_init(&familycache_lock);
+}
+
+void
+open_metrics_close(void)
+{
+    __pmHashWalkCB(familycache_clear, NULL, &familycache);
+    __pmHashClear(&familycache);
+    uv_mutex_destroy(&familycache_lock);
+    __pmHashWalkCB(labelcache_clear, NULL, &labelcache);
+    __pmHashClear(&labelcache);
+    uv_mutex_destroy(&labelcache_lock);
+    sdsfree(instname);
+    instname = NULL;
+    sdsfree(instid);
+    instid = NULL;
+}
@@ -24,6 +24,18 @@ extern sds open_metrics_name(sds, int);
 extern sds open_metrics_semantics(sds);
 
 /* convert an array of PCP labelsets into Open Metrics form */
-extern void open_metrics_labels(pmWebLabelSet *);
+extern unsigned long long open_metrics_labels(pmWebLabelSet *);
+
+/* cached exposition text for a metric family */
+typedef struct open_metrics_family open_metrics_family;
+extern sds open_metrics_family_start(sds, sds, pmWebMetric *, int,
+		open_metrics_family **);
+extern sds open_metrics_family_line(sds, open_metrics_family *,
+		unsigned long long, sds);
+extern void open_metrics_family_done(open_metrics_family *);
+
+/* setup and teardown of the Open Metrics label and exposition caches */
+extern void open_metrics_setup(void);
+extern void open_metrics_close(void);
 
 #endif	/* OPEN_METRICS_H */
@@ -57,6 +57,8 @@ typedef struct pmWebGroupBaton {
     sds			name;		/* metric currently being processed */
     pmID		pmid;		/* metric currently being processed */
     pmInDom		indom;		/* indom currently being processed */
+    open_metrics_family	*family; /* cached Open Metrics exposition */
+    unsigned long long	labelid; /* Open Metrics labels serial */
 } pmWebGroupBaton;
 
 static pmWebRestCommand commands[] = {
@@ -134,6 +136,7 @@ pmwebapi_data_release(struct client *client)
 	fprintf(stderr, "%s: baton " PRINTF_P_PFX "%p for client " PRINTF_P_PFX "%p\n", "pmwebapi_data_release",
 			baton, client);
 
+    open_metrics_family_done(baton->family);
     sdsfree(baton->name);
     sdsfree(baton->buffer);
     sdsfree(baton->suffix);
@@ -483,66 +486,57 @@ pmwebapi_scrape_openmetrics(pmWebGroupBaton *baton, pmWebScrape *scrape)
     pmWebInstance	*instance = &scrape->instance;
     pmWebMetric		*metric = &scrape->metric;
     pmWebValue		*value = &scrape->value;
+    unsigned long long	labelid = baton->labelid;
     long long		milliseconds;
-    char		pmidstr[20], indomstr[20];
-    sds			name = NULL, semantics = NULL, labels = NULL;
+    sds			labels = NULL;
     sds			s, result;
 
     result = http_get_buffer(baton->client);
-    name = open_metrics_name(metric->name, baton->compat);
+    baton->labelid = 0;
 
     if (baton->name == NULL)
 	baton->name = sdsempty();
 
+    /*
+     * Header and "name{labels}" text comes from the per-context family
+     * cache (built once, revalidated against metadata changes), so only
+     * the values themselves are formatted here.
+     */
     s = baton->name;
-    if (metric->pmid != baton->pmid || sdscmp(metric->name, s) != 0) {
+    if (metric->pmid != baton->pmid || sdscmp(metric->name, s) != 0 ||
+	baton->family == NULL) {
 	sdsclear(s);	/* new metric */
 	baton->name = sdscpylen(s, metric->name, sdslen(metric->name));
 	baton->pmid = metric->pmid;
-    } else {    
-	goto value;	/* metric header already done */
-    }
-
-    if (baton->compat == 0) {	/* include pmid, indom and type */
-	pmIDStr_r(metric->pmid, pmidstr, sizeof(pmidstr));
-	pmInDomStr_r(metric->indom, indomstr, sizeof(indomstr));
-	result = sdscatfmt(result, "# PCP5 %S %s %S %s %S %S\n",
-			metric->name, pmidstr, metric->type,
-			indomstr, metric->sem, metric->units);
-    } else {
-	result = sdscatfmt(result, "# PCP %S %S %S\n",
-			metric->name, metric->sem, metric->units);
+	open_metrics_family_done(baton->family);
+	result = open_metrics_family_start(result, baton->context, metric,
+			baton->compat, &baton->family);
+	if (baton->family == NULL) {
+	    http_set_buffer(baton->client, result, HTTP_FLAG_TEXT);
+	    return -ENOMEM;
+	}
     }
 
-    if (metric->oneline)
-	result = sdscatfmt(result, "# HELP %S %S\n", name, metric->oneline);
-    semantics = open_metrics_semantics(metric->sem);
-    result = sdscatfmt(result, "# TYPE %S %S\n", name, semantics);
-
-value:
     if (metric->indom != PM_INDOM_NULL)
 	labels = instance->labels;
     if (labels == NULL)
 	labels = metric->labels;
-    if (labels)
-	result = sdscatfmt(result, "%S{%S}", name, labels);
-    else /* no labels */
-	result = sdscatsds(result, name);
+    if (labels == NULL)
+	labelid = 0;
+    result = open_metrics_family_line(result, baton->family, labelid, labels);
 
     /* append the value */
-    result = sdscatfmt(result, " %S", value->value);
+    result = sdscatlen(result, " ", 1);
+    result = sdscatsds(result, value->value);
 
     if (baton->times) {
 	/* append the timestamp string */
 	milliseconds = (scrape->seconds * 1000) + (scrape->nanoseconds / 1000);
 	result = sdscatfmt(result, " %I\n", milliseconds);
     } else {
-	result = sdscatfmt(result, "\n");
+	result = sdscatlen(result, "\n", 1);
     }
 
-    sdsfree(semantics);
-    sdsfree(name);
-
     http_set_buffer(baton->client, result, HTTP_FLAG_TEXT);
     http_transfer(baton->client);
     return 0;
@@ -833,7 +827,7 @@ on_pmwebapi_scrape_labels(sds context, pmWebLabelSet *labelset, void *arg)
     if ((baton->client->u.http.flags & HTTP_FLAG_REQ_JSON))
 	open_telemetry_labels(labelset, &baton->labels, &baton->buffer);
     else
-	open_metrics_labels(labelset);
+	baton->labelid = open_metrics_labels(labelset);
 }
 
 static int
@@ -1279,6 +1273,7 @@ pmwebapi_servlet_setup(struct proxy *proxy)
     PMAPI_INDOM = sdsnew("indom");
     PMAPI_TYPE = sdsnew("type");
 
+    open_metrics_setup();
     pmWebGroupSetup(&pmwebapi_settings.module);
     pmWebGroupSetEventLoop(&pmwebapi_settings.module, proxy->events);
     pmWebGroupSetConfiguration(&pmwebapi_settings.module, proxy->config);
@@ -1290,6 +1285,7 @@ pmwebapi_servlet_close(struct proxy *proxy)
 {
     pmWebGroupClose(&pmwebapi_settings.module);
     proxymetrics_close(proxy, METRICS_WEBGROUP);
+    open_metrics_close();
 
     sdsfree(PARAM_NAMES);
     sdsfree(PARAM_NAME);
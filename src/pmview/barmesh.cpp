@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+#include <math.h>
+#include <Inventor/SbBox.h>
+#include <Inventor/SoPath.h>
+#include <Inventor/SoPickedPoint.h>
+#include <Inventor/details/SoFaceDetail.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoDrawStyle.h>
+#include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Inventor/nodes/SoPickStyle.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTransform.h>
+#include <Inventor/nodes/SoVertexProperty.h>
+#include "main.h"
+#include "barmesh.h"
+
+const int BarMesh::theCylSides = 16;
+
+BarMesh::~BarMesh()
+{
+    _root->unref();
+    _markStyle->unref();
+    _markPick->unref();
+    _markCube->unref();
+}
+
+//
+// Both shapes are n-sided prisms; the cube has flat sides and the
+// cylinder per-vertex normals so that its sides are smooth shaded.
+// Vertices [0,n) are the base and [n,2n) the top, the normals are
+// the n sides followed by the top and base.
+//
+BarMesh::BarMesh(ViewObj::Shape shape, int numBlocks, char id)
+: _root(new SoSeparator),
+  _faces(new SoIndexedFaceSet),
+  _props(new SoVertexProperty),
+  _markStyle(new SoDrawStyle),
+  _markPick(new SoPickStyle),
+  _markCube(new SoCube),
+  _marks(numBlocks, NULL),
+  _id(id),
+  _numBlocks(numBlocks),
+  _numDrawn(0),
+  _numVerts(0),
+  _shape(),
+  _coordIndex(),
+  _normIndex(),
+  _numFaces(0),
+  _coords(NULL),
+  _colors(NULL)
+{
+    int		sides = (shape == ViewObj::cylinder) ? theCylSides : 4;
+    float	radius = (shape == ViewObj::cylinder) ? 0.5 : M_SQRT1_2;
+    float	offset = (shape == ViewObj::cylinder) ? 0.0 : M_PI / 4.0;
+    bool	smooth = (shape == ViewObj::cylinder);
+    float	angle;
+    int		i, j, v;
+
+    _root->ref();
+    _root->addChild(_faces);
+    _faces->vertexProperty.setValue(_props);
+
+    // Markers are only there to be highlighted, the faces are drawn
+    // and picked
+    _markStyle->ref();
+    _markStyle->style = SoDrawStyle::INVISIBLE;
+    _markPick->ref();
+    _markPick->style = SoPickStyle::UNPICKABLE;
+    _markCube->ref();
+    _markCube->width = 1.0;
+    _markCube->height = 1.0;
+    _markCube->depth = 1.0;
+
+    _numVerts = sides * 2;
+    _numFaces = sides + 2;
+    _shape.resize(_numVerts);
+    for (i = 0; i < sides; i++) {
+	angle = offset + (2.0 * M_PI * i) / sides;
+	_shape[i].setValue(radius * cosf(angle), 0.0, radius * sinf(angle));
+	_shape[i + sides].setValue(radius * cosf(angle), 1.0,
+				   radius * sinf(angle));
+    }
+
+    _props->normal.setNum(sides + 2);
+    for (i = 0; i < sides; i++) {
+	angle = offset + (2.0 * M_PI * i) / sides;
+	if (!smooth)
+	    angle += M_PI / sides;
+	_props->normal.set1Value(i, cosf(angle), 0.0, sinf(angle));
+    }
+    _props->normal.set1Value(sides, 0.0, 1.0, 0.0);
+    _props->normal.set1Value(sides + 1, 0.0, -1.0, 0.0);
+
+    // Sides, counter-clockwise when seen from outside
+    for (i = 0; i < sides; i++) {
+	j = (i + 1) % sides;
+	_coordIndex << i << i + sides << j + sides << j << SO_END_FACE_INDEX;
+	if (smooth)
+	    _normIndex << i << i << j << j << SO_END_FACE_INDEX;
+	else
+	    _normIndex << i << i << i << i << SO_END_FACE_INDEX;
+    }
+    // Top and base
+    for (i = sides - 1; i >= 0; i--) {
+	_coordIndex << i + sides;
+	_normIndex << sides;
+    }
+    _coordIndex << SO_END_FACE_INDEX;
+    _normIndex << SO_END_FACE_INDEX;
+    for (i = 0; i < sides; i++) {
+	_coordIndex << i;
+	_normIndex << sides + 1;
+    }
+    _coordIndex << SO_END_FACE_INDEX;
+    _normIndex << SO_END_FACE_INDEX;
+
+    _props->normalBinding = SoVertexProperty::PER_VERTEX_INDEXED;
+    _props->materialBinding = SoVertexProperty::PER_FACE_INDEXED;
+
+    _props->vertex.setNum(_numVerts * _numBlocks);
+    _props->orderedRGBA.setNum(_numBlocks);
+    startEditing();
+    for (v = 0; v < _numBlocks; v++) {
+	setGeometry(v, SbVec3f(0.0, 0.0, 0.0), SbVec3f(1.0, 1.0, 1.0));
+	_colors[v] = 0xffffffff;
+    }
+    finishEditing();
+
+    setNumDrawn(_numBlocks);
+}
+
+//
+// The face indices of every block are those of the first offset by
+// its vertices, and each face of a block takes the block's color
+//
+void
+BarMesh::setNumDrawn(int n)
+{
+    int		numCoords = _coordIndex.size();
+    int32_t	*coords;
+    int32_t	*norms;
+    int32_t	*mats;
+    int		i, v;
+
+    if (n == _numDrawn)
+	return;
+    _numDrawn = n;
+
+    _faces->coordIndex.setNum(numCoords * n);
+    _faces->normalIndex.setNum(numCoords * n);
+    _faces->materialIndex.setNum(_numFaces * n);
+    coords = _faces->coordIndex.startEditing();
+    norms = _faces->normalIndex.startEditing();
+    mats = _faces->materialIndex.startEditing();
+    for (v = 0; v < n; v++) {
+	for (i = 0; i < numCoords; i++) {
+	    if (_coordIndex[i] == SO_END_FACE_INDEX)
+		*coords++ = SO_END_FACE_INDEX;
+	    else
+		*coords++ = _coordIndex[i] + v * _numVerts;
+	    *norms++ = _normIndex[i];
+	}
+	for (i = 0; i < _numFaces; i++)
+	    *mats++ = v;
+    }
+    _faces->coordIndex.finishEditing();
+    _faces->normalIndex.finishEditing();
+    _faces->materialIndex.finishEditing();
+}
+
+int
+BarMesh::pickBlock(const SoPickedPoint *pick) const
+{
+    const SoDetail	*detail;
+    int			v;
+
+    if (pick == NULL || pick->getPath()->getTail() != _faces)
+	return -1;
+    detail = pick->getDetail();
+    if (detail == NULL || !detail->isOfType(SoFaceDetail::getClassTypeId()))
+	return -1;
+    v = ((const SoFaceDetail *)detail)->getFaceIndex() / _numFaces;
+    return (v < _numBlocks) ? v : -1;
+}
+
+SoPath *
+BarMesh::pickPath(const SoPickedPoint *pick)
+{
+    SoPath	*path = pick->getPath();
+    int		v = pickBlock(pick);
+
+    if (v < 0)
+	return path;
+
+    // Up to and including our root, the parent of the faces
+    path = path->copy(0, path->getLength() - 1);
+    path->append(marker(v));
+    return path;
+}
+
+SoSeparator *
+BarMesh::marker(int v)
+{
+    SoSeparator	*sep = _marks[v];
+    char	buf[32];
+
+    if (sep == NULL) {
+	sep = _marks[v] = new SoSeparator;
+	pmsprintf(buf, sizeof(buf), "%c%d", _id, v);
+	sep->setName((SbName)buf);
+	sep->addChild(_markStyle);
+	sep->addChild(_markPick);
+	sep->addChild(new SoTransform);
+	sep->addChild(_markCube);
+	_root->addChild(sep);
+	setMarker(v);
+    }
+    return sep;
+}
+
+void
+BarMesh::prune(int v)
+{
+    if (_marks[v] != NULL) {
+	_root->removeChild(_marks[v]);
+	_marks[v] = NULL;
+    }
+}
+
+//
+// A marker is the unit cube scaled and moved to the bounds of the
+// block's vertices
+//
+void
+BarMesh::setMarker(int v)
+{
+    const SbVec3f	*coords;
+    SoTransform		*transform;
+    SbBox3f		box;
+    float		x, y, z;
+    int			i;
+
+    if (_coords != NULL)
+	coords = _coords + v * _numVerts;
+    else
+	coords = _props->vertex.getValues(v * _numVerts);
+    for (i = 0; i < _numVerts; i++)
+	box.extendBy(coords[i]);
+    box.getSize(x, y, z);
+    transform = (SoTransform *)_marks[v]->getChild(2);
+    transform->translation.setValue(box.getCenter());
+    transform->scaleFactor.setValue(x, y, z);
+}
+
+void
+BarMesh::startEditing()
+{
+    _coords = _props->vertex.startEditing();
+    _colors = _props->orderedRGBA.startEditing();
+}
+
+void
+BarMesh::finishEditing()
+{
+    _props->vertex.finishEditing();
+    _props->orderedRGBA.finishEditing();
+    _coords = NULL;
+    _colors = NULL;
+}
+
+void
+BarMesh::setGeometry(int v, const SbVec3f &tran, const SbVec3f &scale)
+{
+    bool	editing = (_coords != NULL);
+    SbVec3f	*coords;
+    int		i;
+
+    if (!editing)
+	startEditing();
+    coords = _coords + v * _numVerts;
+    for (i = 0; i < _numVerts; i++) {
+	const SbVec3f &unit = _shape[i];
+	coords[i].setValue(tran[0] + unit[0] * scale[0],
+			   tran[1] + unit[1] * scale[1],
+			   tran[2] + unit[2] * scale[2]);
+    }
+    if (_marks[v] != NULL)
+	setMarker(v);
+    if (!editing)
+	finishEditing();
+}
+
+void
+BarMesh::setColor(int v, const SbColor &color)
+{
+    if (_colors != NULL)
+	_colors[v] = color.getPackedValue();
+    else
+	_props->orderedRGBA.set1Value(v, color.getPackedValue());
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Red Hat.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+#ifndef _BARMESH_H_
+#define _BARMESH_H_
+
+#include <Inventor/SbColor.h>
+#include <Inventor/SbLinear.h>
+#include <QVector>
+#include "viewobj.h"
+
+class SoCube;
+class SoDrawStyle;
+class SoIndexedFaceSet;
+class SoPath;
+class SoPickStyle;
+class SoPickedPoint;
+class SoSeparator;
+class SoVertexProperty;
+
+//
+// The geometry and colors of all the blocks of a bar or stack
+// modulated object, drawn by a single indexed face set with a
+// color per face.  A refresh is an in-place update of one set of
+// vertex and color arrays rather than field changes on several
+// nodes per block.
+//
+// Blocks are identified from the face picked.  As SoSelection and
+// the box highlight action work on paths, a block that is picked
+// gets an invisible, unpickable marker node covering it, named by
+// the object id and block number, and the pick path is redirected
+// to that marker.  Markers of blocks no longer selected are removed
+// by prune().
+//
+// Block geometry is the unit cube or cylinder (base at the origin,
+// unit height) scaled and then translated, as for the shapes built
+// by ViewObj::object().
+//
+
+class BarMesh
+{
+private:
+
+    static const int	theCylSides;
+
+    SoSeparator		*_root;
+    SoIndexedFaceSet	*_faces;
+    SoVertexProperty	*_props;
+    SoDrawStyle		*_markStyle;
+    SoPickStyle		*_markPick;
+    SoCube		*_markCube;
+    QVector<SoSeparator *> _marks;	// marker of each block, if any
+    char		_id;
+    int			_numBlocks;
+    int			_numDrawn;
+    int			_numVerts;	// vertices per block
+    QVector<SbVec3f>	_shape;		// unit shape vertices
+    QVector<int32_t>	_coordIndex;	// faces of one block
+    QVector<int32_t>	_normIndex;
+    int			_numFaces;
+    SbVec3f		*_coords;	// only while editing
+    uint32_t		*_colors;
+
+public:
+
+    ~BarMesh();
+
+    BarMesh(ViewObj::Shape shape, int numBlocks, char id);
+
+    int numBlocks() const
+	{ return _numBlocks; }
+
+    // The faces of all blocks, and any markers
+    SoSeparator *root() const
+	{ return _root; }
+
+    // Draw only the first n blocks
+    void setNumDrawn(int n);
+
+    // Block of a picked face, or -1
+    int pickBlock(const SoPickedPoint *pick) const;
+
+    // Path to the marker of a picked block, else the picked path
+    SoPath *pickPath(const SoPickedPoint *pick);
+
+    // Marker of a block, added if there is not one already
+    SoSeparator *marker(int v);
+
+    // Remove the marker of a block not selected
+    void prune(int v);
+
+    // Bracket a batch of block changes, e.g. a whole refresh
+    void startEditing();
+    void finishEditing();
+
+    void setGeometry(int v, const SbVec3f &tran, const SbVec3f &scale);
+    void setColor(int v, const SbColor &color);
+    void setColor(int v, const float *rgb)
+	{ setColor(v, SbColor(rgb)); }
+
+private:
+
+    BarMesh();
+    BarMesh(const BarMesh &);
+    const BarMesh &operator=(const BarMesh &);
+    // Never defined
+
+    void setMarker(int v);
+};
+
+#endif /* _BARMESH_H_ */
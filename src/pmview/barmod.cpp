@@ -13,9 +13,6 @@
  * for more details.
  */
 #include <Inventor/SoPath.h>
-#include <Inventor/nodes/SoBaseColor.h>
-#include <Inventor/nodes/SoTranslation.h>
-#include <Inventor/nodes/SoScale.h>
 #include <Inventor/nodes/SoSeparator.h>
 #include <Inventor/nodes/SoSelection.h>
 #include "barmod.h"
@@ -30,16 +27,18 @@ const char BarMod::theBarId = 'b';
 
 BarMod::~BarMod()
 {
+    delete _mesh;
 }
 
 BarMod::BarMod(MetricList *metrics, 
-	       SoNode *obj, 
+	       ViewObj::Shape shape,
 	       BarMod::Direction dir,
 	       BarMod::Grouping group,
 	       float xScale, float __yScale, float zScale,
 	       float xSpace, float zSpace)
 : Modulate(metrics),
   _blocks(),
+  _mesh(NULL),
   _dir(dir),
   _mod(BarMod::yScale),
   _group(group),
@@ -52,12 +51,12 @@ BarMod::BarMod(MetricList *metrics,
   _yScale(__yScale),
   _zScale(zScale)
 {
-    generate(obj, xSpace, zSpace);
+    generate(shape, xSpace, zSpace);
 }
 
 BarMod::BarMod(MetricList *metrics, 
 	       const ColorScale &colScale,
-	       SoNode *obj, 
+	       ViewObj::Shape shape,
 	       BarMod::Direction dir,
 	       BarMod::Modulation mod,
 	       BarMod::Grouping group,
@@ -65,6 +64,7 @@ BarMod::BarMod(MetricList *metrics,
 	       float xSpace, float zSpace)
 : Modulate(metrics),
   _blocks(),
+  _mesh(NULL),
   _dir(dir),
   _mod(mod),
   _group(group),
@@ -77,17 +77,16 @@ BarMod::BarMod(MetricList *metrics,
   _yScale(__yScale),
   _zScale(zScale)
 {
-    generate(obj, xSpace, zSpace);
+    generate(shape, xSpace, zSpace);
 }
 
 void
-BarMod::generate(SoNode *obj, float xSpace, float zSpace)
+BarMod::generate(ViewObj::Shape shape, float xSpace, float zSpace)
 {
     int	numMetrics = _metrics->numMetrics();
     int	numValues = _metrics->numValues();
     int	maxInst = 0;
-    char	buf[32];
-    int		m, i, v;
+    int		m;
 
     if (pmDebugOptions.appl2)
 	cerr << "BarMod::generate() called" << Qt::endl;
@@ -109,29 +108,11 @@ BarMod::generate(SoNode *obj, float xSpace, float zSpace)
 	    _rows = maxInst;
 	}
 
+	// All bars are drawn by one face set, picked bars are
+	// identified by their named markers in the mesh
 	_blocks.resize(numValues);
-
-	for (m = 0, v = 0; m < _metrics->numMetrics(); m++) {
-	    const QmcMetric &metric = _metrics->metric(m);
-	    for (i = 0; i < metric.numValues(); i++, v++) {
-		BarBlock &block = _blocks[v];
-		pmsprintf(buf, sizeof(buf), "%c%d", theBarId, v);
-		block._sep = new SoSeparator;
-		block._sep->setName((SbName)buf);
-		_root->addChild(block._sep);
-
-		block._tran = new SoTranslation;
-		block._sep->addChild(block._tran);
-
-		block._color = new SoBaseColor;
-		block._sep->addChild(block._color);
-
-		block._scale = new SoScale;
-		block._sep->addChild(block._scale);
-
-		block._sep->addChild(obj);
-	    }
-	}
+	_mesh = new BarMesh(shape, numValues, theBarId);
+	_root->addChild(_mesh->root());
 
 	regenerate(_xScale, _zScale, xSpace, zSpace);
 	_infoValue = numValues;
@@ -160,6 +141,8 @@ BarMod::refresh(bool fetchFlag)
     if (status() < 0)
 	return;
 
+    _mesh->startEditing();
+
     for (m = 0, v = 0; m < _metrics->numMetrics(); m++) {
 	QmcMetric &metric = _metrics->metric(m);
 
@@ -170,17 +153,18 @@ BarMod::refresh(bool fetchFlag)
 
 	    BarBlock &block = _blocks[v];
 
+	    if (block._selected == false)
+		_mesh->prune(v);
+
 	    if (metric.error(i) < 0) {
 
 		if (pmDebugOptions.appl3)
 		    cerr << "BarMod::refresh() " << &metric << " metric[" << i << "] error=" << metric.error(i) << Qt::endl;
 
 		if (block._state != Modulate::error) {
-		    block._color->rgb.setValue(_errorColor.getValue());
+		    _mesh->setColor(v, _errorColor);
 		    if (_mod != color)
-			block._scale->scaleFactor.setValue(_xScale, 
-							   theMinScale,
-							   _zScale);
+			setScale(v, theMinScale);
 		    block._state = Modulate::error;
 		}
 	    }
@@ -195,11 +179,9 @@ BarMod::refresh(bool fetchFlag)
                 
 		if (value > theNormError) {
 		    if (block._state != Modulate::saturated) {
-			block._color->rgb.setValue(Modulate::_saturatedColor);
+			_mesh->setColor(v, Modulate::_saturatedColor);
 			if (_mod != color)
-			    block._scale->scaleFactor.setValue(_xScale, 
-							       _yScale, 
-							       _zScale);
+			    setScale(v, _yScale);
 			block._state = Modulate::saturated;
 		    }
 		}
@@ -207,24 +189,30 @@ BarMod::refresh(bool fetchFlag)
 		    if (block._state != Modulate::normal) {
 			block._state = Modulate::normal;
 			if (_mod == yScale)
-			    block._color->rgb.setValue(_metrics->color(m).getValue());
+			    _mesh->setColor(v, _metrics->color(m));
 		    }
 		    else if (_mod != yScale)
-			block._color->rgb.setValue(_colScale.step(unscaled).color().getValue());
+			_mesh->setColor(v, _colScale.step(unscaled).color());
 		    if (_mod != color) {
 			if (value < Modulate::theMinScale)
 			    value = Modulate::theMinScale;
 			else if (value > 1.0)
 			    value = 1.0;
-			block._scale->scaleFactor.setValue(_xScale,
-							   _yScale * value,
-							   _zScale);
+			setScale(v, _yScale * value);
 		    }
 
 		}
 	    }
 	}
     }
+
+    _mesh->finishEditing();
+}
+
+void
+BarMod::setScale(int v, float yScale)
+{
+    _mesh->setGeometry(v, _blocks[v]._tran, SbVec3f(_xScale, yScale, _zScale));
 }
 
 void
@@ -243,7 +231,7 @@ BarMod::selectAll()
     for (i = 0; i < _blocks.size(); i++) {
 	if (_blocks[i]._selected == false) {
 	    _selectCount++;
-	    theModList->selectSingle(_blocks[i]._sep);
+	    theModList->selectSingle(_mesh->marker(i));
 	    _blocks[i]._selected = true;
 	}
     }
@@ -417,14 +405,31 @@ void BarMod::launch(Launch &launch, bool all) const
     }
 }
 
+SoPath *
+BarMod::pickPath(const SoPickedPoint *pick)
+{
+    return _mesh->pickPath(pick);
+}
+
 void 
-BarMod::selectInfo(SoPath *path)
+BarMod::selectInfo(const SoPickedPoint *pick)
 {
-    findBlock(path, _infoMetric, _infoInst, _infoValue);
+    _infoValue = _mesh->pickBlock(pick);
+    if (_infoValue < 0) {
+	_infoValue = _blocks.size();
+	_infoMetric = _infoInst = 0;
+    }
+    else
+	findMetric(_infoValue, _infoMetric, _infoInst);
+
+    if (pmDebugOptions.appl2)
+	cerr << "BarMod::selectInfo: metric = " << _infoMetric
+	     << ", inst = " << _infoInst << ", value = " << _infoValue
+	     << Qt::endl;
 }
 
 void
-BarMod::removeInfo(SoPath *)
+BarMod::removeInfo(const SoPickedPoint *)
 {
     _infoValue = _blocks.size();
     _infoMetric = _infoInst = 0;
@@ -475,7 +480,7 @@ BarMod::findBlock(SoPath *path, int &metric, int &inst,
 {
     SoNode	*node;
     char	*str;
-    int		m, i, v;
+    int		i;
     char	c;
 
     for (i = path->getLength() - 1; i >= 0; --i) {
@@ -496,22 +501,8 @@ BarMod::findBlock(SoPath *path, int &metric, int &inst,
 	    metric = 0;
 	    inst = 0;
 	}
-	else {
-	    m = 0;
-	    v = value;
-	    while (m < _metrics->numMetrics()) {
-		i = _metrics->metric(m).numValues();
-		if (v < i) {
-		    metric = m;
-		    inst = v;
-		    break;
-		}
-		else {
-		    v -= i;
-		    m++;
-		}
-	    }
-	}
+	else
+	    findMetric(value, metric, inst);
     }
     else {
 	value = _blocks.size();
@@ -525,6 +516,28 @@ BarMod::findBlock(SoPath *path, int &metric, int &inst,
     return;
 }
 
+void
+BarMod::findMetric(int value, int &metric, int &inst)
+{
+    int		m = 0;
+    int		v = value;
+    int		i;
+
+    metric = inst = 0;
+    while (m < _metrics->numMetrics()) {
+	i = _metrics->metric(m).numValues();
+	if (v < i) {
+	    metric = m;
+	    inst = v;
+	    break;
+	}
+	else {
+	    v -= i;
+	    m++;
+	}
+    }
+}
+
 void
 BarMod::regenerate(float xScale, float zScale, float xSpace, float zSpace)
 {
@@ -544,26 +557,28 @@ BarMod::regenerate(float xScale, float zScale, float xSpace, float zSpace)
     _width = (unsigned int)((_cols * (_xScale + xSpace)) - xSpace);
     _depth = (unsigned int)((_rows * (_zScale + zSpace)) - zSpace);
 
+    _mesh->startEditing();
     for (m = 0, v = 0; m < _metrics->numMetrics(); m++) {
 	const QmcMetric &metric = _metrics->metric(m);
 	for (i = 0; i < metric.numValues(); i++, v++) {
 	    BarBlock &block = _blocks[v];
 
 	    if (_dir == instPerCol)
-		block._tran->translation.setValue(i * (_xScale+xSpace) + halfX,
-						  0,
-						  m * (_zScale+zSpace) + halfZ);
+		block._tran.setValue(i * (_xScale+xSpace) + halfX,
+				     0,
+				     m * (_zScale+zSpace) + halfZ);
 	    else
-		block._tran->translation.setValue(m * (_xScale+xSpace) + halfX,
-						  0,
-						  i * (_zScale+zSpace) + halfZ);
+		block._tran.setValue(m * (_xScale+xSpace) + halfX,
+				     0,
+				     i * (_zScale+zSpace) + halfZ);
 
-	    block._color->rgb.setValue(_errorColor.getValue());
-	    block._scale->scaleFactor.setValue(_xScale, _yScale, _zScale);
+	    _mesh->setColor(v, _errorColor);
+	    setScale(v, _yScale);
 	    block._state = Modulate::start;
 	    block._selected = false;
 	}
     }
+    _mesh->finishEditing();
 }
 
 const char *
@@ -17,19 +17,13 @@
 
 #include "colorscale.h"
 #include "modulate.h"
+#include "barmesh.h"
 #include <QVector>
 
-class SoBaseColor;
-class SoScale;
-class SoNode;
-class SoTranslation;
 class Launch;
 
 struct BarBlock {
-    SoSeparator		*_sep;
-    SoBaseColor		*_color;
-    SoScale		*_scale;
-    SoTranslation	*_tran;
+    SbVec3f		_tran;
     Modulate::State	_state;
     bool		_selected;
 };
@@ -49,6 +43,7 @@ private:
     static const char theBarId;
 
     BarBlockList	_blocks;
+    BarMesh		*_mesh;
     Direction		_dir;
     Modulation		_mod;
     Grouping		_group;
@@ -70,7 +65,7 @@ public:
     virtual ~BarMod();
 
     BarMod(MetricList *list,
-	   SoNode *obj,
+	   ViewObj::Shape shape,
 	   BarMod::Direction dir,
 	   BarMod::Grouping group,
 	   float xScale, float __yScale, float zScale,
@@ -78,7 +73,7 @@ public:
 
     BarMod(MetricList *list,
 	   const ColorScale &colScale,
-	   SoNode *obj,
+	   ViewObj::Shape shape,
 	   BarMod::Direction dir,
 	   BarMod::Modulation mod,
 	   BarMod::Grouping group,
@@ -104,8 +99,10 @@ public:
     virtual int select(SoPath *);
     virtual int remove(SoPath *);
 
-    virtual void selectInfo(SoPath *);
-    virtual void removeInfo(SoPath *);
+    virtual SoPath *pickPath(const SoPickedPoint *pick);
+
+    virtual void selectInfo(const SoPickedPoint *pick);
+    virtual void removeInfo(const SoPickedPoint *);
 
     virtual void infoText(QString &str, bool) const;
 
@@ -125,9 +122,11 @@ private:
     const BarMod &operator=(const BarMod &);
     // Never defined
 
-    void generate(SoNode *obj, float xSpace, float zSpace);
+    void generate(ViewObj::Shape shape, float xSpace, float zSpace);
+    void setScale(int v, float yScale);
     void findBlock(SoPath *path, int &metric, int &inst, 
 		   int &value, bool idMetric = true);
+    void findMetric(int value, int &metric, int &inst);
 };
 
 #endif /* _BARMOD_H_ */
@@ -69,7 +69,6 @@ void
 BarObj::finishedAdd()
 {
     const ColorSpec	*colSpec = NULL;
-    SoNode		*object = ViewObj::object(_shape);
     SoSeparator		*labelSep = NULL;
     SoSeparator		*metricSep = NULL;
     SoSeparator		*instSep = NULL;
@@ -167,11 +166,11 @@ BarObj::finishedAdd()
 
     // Generate Bar Modulate Object
     if (_mod == BarMod::yScale)
-	_bars = new BarMod(&_metrics, object, _dir, _group,
+	_bars = new BarMod(&_metrics, _shape, _dir, _group,
 			   (float)_length, (float)_maxHeight, (float)_length,
 			   (float)_xSpace, (float)_zSpace);
     else {
-	_bars = new BarMod(&_metrics, *colScale, object, _dir, _mod, _group,
+	_bars = new BarMod(&_metrics, *colScale, _shape, _dir, _mod, _group,
 			   (float)_length, (float)_maxHeight, (float)_length,
 			   (float)_xSpace, (float)_zSpace);	
     }
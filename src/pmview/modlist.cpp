@@ -84,6 +84,7 @@ ModList::setRoot(SoSeparator *root)
     _selection->policy = SoSelection::SHIFT;
     _selection->addSelectionCallback(&ModList::selCB, this);
     _selection->addDeselectionCallback(&ModList::deselectCB, this);
+    _selection->setPickFilterCallback(&ModList::pickFilterCB, this);
 
     _motion = new SoEventCallback;
     _motion->addEventCallback(SoLocation2Event::getClassTypeId(),
@@ -233,6 +234,23 @@ ModList::selCB(void *ptrToThis, SoPath *path)
     }
 }
 
+//
+// Objects drawing several blocks with one shape map the pick to the
+// path of the block picked
+//
+SoPath *
+ModList::pickFilterCB(void *ptrToThis, const SoPickedPoint *pick)
+{
+    ModList		*me = (ModList *)ptrToThis;
+    SoPath		*path = pick->getPath();
+    int			id;
+
+    id = ModList::findToken(path);
+    if (id < 0)
+	return path;
+    return me->_list[id]->pickPath(pick);
+}
+
 void
 ModList::deselectCB(void *ptrToThis, SoPath *path)
 {
@@ -306,7 +324,7 @@ ModList::motionCB(void *ptrToThis, SoEventCallback *theEvent)
     if (id < 0) {
 	// Deselect anything selected
 	if (me->_current < me->size()) {
-	    (*me)[me->_current].removeInfo(path);
+	    (*me)[me->_current].removeInfo(pick);
 	    me->_current = me->size();
 
 	    if (pmDebugOptions.appl1)
@@ -315,15 +333,15 @@ ModList::motionCB(void *ptrToThis, SoEventCallback *theEvent)
     }
     else if (me->_current != id) {
 	if (me->_current < me->size())
-	    (*me)[me->_current].removeInfo(path);
+	    (*me)[me->_current].removeInfo(pick);
 	me->_current = id;
-	(*me)[me->_current].selectInfo(path);
+	(*me)[me->_current].selectInfo(pick);
 
     if (pmDebugOptions.appl1)
 	cerr << "ModList::motionCB: new object " << id << Qt::endl;
     }
     else {
-	(*me)[me->_current].selectInfo(path);
+	(*me)[me->_current].selectInfo(pick);
 
 	if (pmDebugOptions.appl1)
 	    cerr << "ModList::motionCB: same object " << id << Qt::endl;
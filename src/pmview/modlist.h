@@ -121,6 +121,7 @@ public:
 private:
 
     static void selCB(void *me, SoPath *path);
+    static SoPath *pickFilterCB(void *me, const SoPickedPoint *pick);
     static void motionCB(void *me, SoEventCallback *event);
     static int findToken(const SoPath *path);
 
@@ -12,6 +12,7 @@
  * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
  * for more details.
  */
+#include <Inventor/SoPickedPoint.h>
 #include <Inventor/nodes/SoSeparator.h>
 #include <Inventor/nodes/SoSelection.h>
 #include "modulate.h"
@@ -128,3 +129,9 @@ Modulate::selectAll()
     theModList->selectAllId(_root, 1);
     theModList->selectSingle(_root);
 }
+
+SoPath *
+Modulate::pickPath(const SoPickedPoint *pick)
+{
+    return pick->getPath();
+}
@@ -20,6 +20,7 @@
 
 class SoSeparator;
 class SoPath;
+class SoPickedPoint;
 class Launch;
 class Record;
 
@@ -84,11 +85,15 @@ public:
     virtual int remove(SoPath *)
 	{ return 0; }
 
-    // Should expect selectInfo calls to different paths without
+    // Path to select for a pick in this object, by default the
+    // picked path
+    virtual SoPath *pickPath(const SoPickedPoint *pick);
+
+    // Should expect selectInfo calls to different picks without
     // previous removeInfo calls
-    virtual void selectInfo(SoPath *)
+    virtual void selectInfo(const SoPickedPoint *)
 	{}
-    virtual void removeInfo(SoPath *)
+    virtual void removeInfo(const SoPickedPoint *)
 	{}
 
     virtual void infoText(QString &str, bool selected) const = 0;
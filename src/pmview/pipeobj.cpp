@@ -129,8 +129,7 @@ PipeObj::finishedAdd ()
 
 	_metrics.resolveColors(MetricList::perValue);
 	
-	StackMod * _stack = new StackMod(&_metrics, ViewObj::object (cylinder),
-						 StackMod::fixed);
+	StackMod * _stack = new StackMod(&_metrics, cylinder, StackMod::fixed);
 	_stack->setFillColor(_color);
 	_stack->setFillText((const char *)_tag.toLatin1());
 
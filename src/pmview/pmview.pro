@@ -1,7 +1,7 @@
 TEMPLATE	= app
 LANGUAGE	= C++
 HEADERS		= pmview.h main.h \
-		  colorlist.h barmod.h barobj.h baseobj.h \
+		  colorlist.h barmesh.h barmod.h barobj.h baseobj.h \
 		  defaultobj.h gridobj.h labelobj.h stackobj.h \
 		  launch.h viewobj.h pipeobj.h link.h xing.h \
 		  scenefileobj.h scenegroup.h \
@@ -10,7 +10,7 @@ HEADERS		= pmview.h main.h \
 		  scalemod.h stackmod.h togglemod.h \
 		  text.h yscalemod.h pcpcolor.h
 SOURCES		= pmview.cpp main.cpp \
-		  colorlist.cpp barmod.cpp barobj.cpp baseobj.cpp \
+		  colorlist.cpp barmesh.cpp barmod.cpp barobj.cpp baseobj.cpp \
 		  defaultobj.cpp gridobj.cpp labelobj.cpp stackobj.cpp \
 		  launch.cpp viewobj.cpp pipeobj.cpp link.cpp xing.cpp \
 		  scenefileobj.cpp scenegroup.cpp \
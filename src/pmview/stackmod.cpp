@@ -14,11 +14,8 @@
  */
 #include <Inventor/SoPath.h>
 #include <Inventor/nodes/SoBaseColor.h>
-#include <Inventor/nodes/SoTranslation.h>
-#include <Inventor/nodes/SoScale.h>
 #include <Inventor/nodes/SoSeparator.h>
 #include <Inventor/nodes/SoSelection.h>
-#include <Inventor/nodes/SoSwitch.h>
 #include "stackmod.h"
 #include "modlist.h"
 #include "launch.h"
@@ -32,12 +29,14 @@ const char StackMod::theStackId = 's';
 
 StackMod::~StackMod()
 {
+    delete _mesh;
 }
 
-StackMod::StackMod(MetricList *metrics, SoNode *obj, StackMod::Height height)
+StackMod::StackMod(MetricList *metrics, ViewObj::Shape shape,
+		   StackMod::Height height)
 : Modulate(metrics),
   _blocks(),
-  _switch(0),
+  _mesh(NULL),
   _height(height),
   _text(),
   _selectCount(0),
@@ -47,7 +46,6 @@ StackMod::StackMod(MetricList *metrics, SoNode *obj, StackMod::Height height)
 {
     int		numValues = _metrics->numValues();
     int		numMetrics = _metrics->numMetrics();
-    char	buf[32];
     float	initScale = 0.0;
     int		m, i, v;
 
@@ -61,6 +59,8 @@ StackMod::StackMod(MetricList *metrics, SoNode *obj, StackMod::Height height)
 	}
 
 	_blocks.resize(m);
+	_mesh = new BarMesh(shape, m, theStackId);
+	_root->addChild(_mesh->root());
 	_infoValue = m+1;
 
 	initScale = 1.0 / (float)numValues;
@@ -70,66 +70,36 @@ StackMod::StackMod(MetricList *metrics, SoNode *obj, StackMod::Height height)
 		 << numValues << ", num of blocks = " << m << Qt::endl 
 		 << *_metrics;
 
+	// All blocks are drawn by one face set and stacked by their
+	// positions in the mesh, picked blocks are identified by their
+	// named markers in the mesh
+	_mesh->startEditing();
 	for (m = 0, v = 0; m < numMetrics; m++) {
 	    const QmcMetric &metric = _metrics->metric(m);
 	    for (i = 0; i < metric.numValues(); i++, v++) {
 		StackBlock block;
 
-		block._sep = new SoSeparator;
-		pmsprintf(buf, sizeof(buf), "%c%d", theStackId, v);
-		block._sep->setName((SbName)buf);
-		_root->addChild(block._sep);
-
-		block._color = new SoBaseColor;
-		block._color->rgb.setValue(_errorColor.getValue());
-		block._sep->addChild(block._color);
-
-		block._scale = new SoScale;
-		block._scale->scaleFactor.setValue(1.0, initScale, 1.0);
-		block._sep->addChild(block._scale);
-
-		block._sep->addChild(obj);
+		_mesh->setColor(v, _errorColor);
+		_mesh->setGeometry(v, SbVec3f(0.0, v * initScale, 0.0),
+				   SbVec3f(1.0, initScale, 1.0));
 
 		block._state = Modulate::start;
 		block._selected = false;
-
-		if (_height == fixed || v < numValues - 1) {		    
-		    block._tran = new SoTranslation();
-		    block._tran->translation.setValue(0.0, initScale, 0.0);
-		    _root->addChild(block._tran);
-		}
-		else {
-		    block._tran = NULL;
-		}
 		_blocks[v] = block;
 	    }
 	}
 
 	if (_height == fixed) {
 	    StackBlock block;
-	    block._sep = new SoSeparator;
-	    _root->addChild(block._sep);
-	    pmsprintf(buf, sizeof(buf), "%c%d", theStackId, v);
-	    block._sep->setName((SbName)buf);
-
-	    _switch = new SoSwitch();
-	    _switch->whichChild.setValue(SO_SWITCH_ALL);
-	    block._sep->addChild(_switch);
-
-	    block._color = new SoBaseColor;
-	    block._color->rgb.setValue(theDefFillColor);
-	    _switch->addChild(block._color);
-
-	    block._tran = NULL;
-	    block._scale = new SoScale;
-	    block._scale->scaleFactor.setValue(1.0, 0.0, 1.0);
+
+	    _mesh->setColor(v, theDefFillColor);
+	    _mesh->setGeometry(v, SbVec3f(0.0, 1.0, 0.0),
+			       SbVec3f(1.0, 0.0, 1.0));
 	    block._state = Modulate::start;
 	    block._selected = false;
-	    _switch->addChild(block._scale);
-
-	    _switch->addChild(obj);
 	    _blocks[v] = block;
 	}
+	_mesh->finishEditing();
 
 	add();
     }
@@ -143,7 +113,7 @@ StackMod::StackMod(MetricList *metrics, SoNode *obj, StackMod::Height height)
 	tmpColor->rgb.setValue(_errorColor.getValue());
 	_root->addChild(tmpColor);
 
-	_root->addChild(obj);
+	_root->addChild(ViewObj::object(shape));
     }
 }
 
@@ -154,6 +124,7 @@ StackMod::refresh(bool fetchFlag)
     int		numMetrics = _metrics->numMetrics();
     int		m, i, v;
     double	sum = 0.0;
+    double	base;
 
     static QVector<double> values;
 
@@ -166,6 +137,8 @@ StackMod::refresh(bool fetchFlag)
     if (numValues > values.size())
 	values.resize(numValues);
 
+    _mesh->startEditing();
+
     for (m = 0, v = 0; m < numMetrics; m++) {
 	QmcMetric &metric = _metrics->metric(m);
 	if (fetchFlag)
@@ -175,12 +148,15 @@ StackMod::refresh(bool fetchFlag)
 	    StackBlock &block = _blocks[v];
 	    double &value = values[v];
 
+	    if (block._selected == false)
+		_mesh->prune(v);
+
 	    if (pmDebugOptions.appl3)
 		cerr << '[' << v << "] ";
 
 	    if (metric.error(i) < 0) {
 		if (block._state != Modulate::error) {
-		    block._color->rgb.setValue(_errorColor.getValue());
+		    _mesh->setColor(v, _errorColor);
 		    block._state = Modulate::error;
 		}
 		value = Modulate::theMinScale;
@@ -193,9 +169,9 @@ StackMod::refresh(bool fetchFlag)
 		     block._state == Modulate::start) {
 		block._state = Modulate::normal;
 		if (numMetrics == 1)
-		    block._color->rgb.setValue(_metrics->color(v).getValue());
+		    _mesh->setColor(v, _metrics->color(v));
 		else
-		    block._color->rgb.setValue(_metrics->color(m).getValue());
+		    _mesh->setColor(v, _metrics->color(m));
 		value = metric.value(i) * theScale;
 		if (value < theMinScale)
 		    value = theMinScale;
@@ -222,7 +198,7 @@ StackMod::refresh(bool fetchFlag)
 	    for (v = 0; v < numValues; v++) {
 		StackBlock &block = _blocks[v];
 		if (block._state != Modulate::error) {
-		    block._color->rgb.setValue(Modulate::_saturatedColor);
+		    _mesh->setColor(v, Modulate::_saturatedColor);
 		    block._state = Modulate::saturated;
 		}
 	    }
@@ -236,9 +212,9 @@ StackMod::refresh(bool fetchFlag)
 		if (block._state == Modulate::saturated) {
 		    block._state = Modulate::normal;
 		    if (numMetrics == 1)
-			block._color->rgb.setValue(_metrics->color(v).getValue());
+			_mesh->setColor(v, _metrics->color(v));
 		    else
-			block._color->rgb.setValue(_metrics->color(m).getValue());
+			_mesh->setColor(v, _metrics->color(m));
 		}
 	    }
 	}
@@ -266,31 +242,36 @@ StackMod::refresh(bool fetchFlag)
 	}
     }
 
-    for (v = 0; v < numValues; v++) {
+    for (v = 0, base = 0.0; v < numValues; v++) {
 
-	StackBlock &block = _blocks[v];
 	double &value = values[v];
  
 	if (pmDebugOptions.appl3)
 	    cerr << '[' << v << "] scale = " << value << Qt::endl;
 
-	block._scale->scaleFactor.setValue(1.0, value, 1.0);
-	
-	if (v < numValues-1 || _height == fixed)
-	    block._tran->translation.setValue(0.0, value, 0.0);
+	_mesh->setGeometry(v, SbVec3f(0.0, base, 0.0), SbVec3f(1.0, value, 1.0));
+	base += value;
     }
 
+    // The fill block is last in the mesh, so is hidden by drawing
+    // one block less
     if (_height == fixed) {
+	if (_blocks[v]._selected == false)
+	    _mesh->prune(v);
 	sum = 1.0 - sum;
 	if (sum >= theMinScale) {
-	    _switch->whichChild.setValue(SO_SWITCH_ALL);
-	    _blocks[v]._scale->scaleFactor.setValue(1.0, sum, 1.0);
+	    _mesh->setNumDrawn(v + 1);
+	    _mesh->setGeometry(v, SbVec3f(0.0, base, 0.0),
+			       SbVec3f(1.0, sum, 1.0));
 	}
 	else {
-	    _switch->whichChild.setValue(SO_SWITCH_NONE);
-	    _blocks[v]._scale->scaleFactor.setValue(1.0, theMinScale, 1.0);
+	    _mesh->setNumDrawn(v);
+	    _mesh->setGeometry(v, SbVec3f(0.0, base, 0.0),
+			       SbVec3f(1.0, theMinScale, 1.0));
 	}
     }
+
+    _mesh->finishEditing();
 }
 
 void
@@ -424,7 +405,7 @@ StackMod::selectAll()
     for (i = 0; i < _blocks.size(); i++) {
 	if (_blocks[i]._selected == false) {
 	    _selectCount++;
-	    theModList->selectSingle(_blocks[i]._sep);
+	    theModList->selectSingle(_mesh->marker(i));
 	    _blocks[i]._selected = true;
 	}
     }
@@ -468,14 +449,31 @@ StackMod::remove(SoPath *path)
     return _selectCount;
 }
 
+SoPath *
+StackMod::pickPath(const SoPickedPoint *pick)
+{
+    return _mesh->pickPath(pick);
+}
+
 void 
-StackMod::selectInfo(SoPath *path)
+StackMod::selectInfo(const SoPickedPoint *pick)
 {
-    findBlock(path, _infoMetric, _infoInst, _infoValue);
+    _infoValue = _mesh->pickBlock(pick);
+    if (_infoValue < 0) {
+	_infoValue = _blocks.size();
+	_infoMetric = _infoInst = 0;
+    }
+    else
+	findMetric(_infoValue, _infoMetric, _infoInst);
+
+    if (pmDebugOptions.appl2)
+	cerr << "StackMod::selectInfo: metric = " << _infoMetric
+	     << ", inst = " << _infoInst << ", value = " << _infoValue
+	     << Qt::endl;
 }
 
 void
-StackMod::removeInfo(SoPath *)
+StackMod::removeInfo(const SoPickedPoint *)
 {
     _infoValue = _blocks.size();
     _infoMetric = _infoInst = 0;
@@ -487,7 +485,7 @@ StackMod::findBlock(SoPath *path, int &metric, int &inst,
 {
     SoNode	*node;
     char	*str;
-    int		m, i, v;
+    int		i;
     char	c;
 
     for (i = path->getLength() - 1; i >= 0; --i) {
@@ -508,22 +506,8 @@ StackMod::findBlock(SoPath *path, int &metric, int &inst,
 	    metric = 0;
 	    inst = 0;
 	}
-	else {
-	    m = 0;
-	    v = value;
-	    while (m < _metrics->numMetrics()) {
-		i = _metrics->metric(m).numValues();
-		if (v < i) {
-		    metric = m;
-		    inst = v;
-		    break;
-		}
-		else {
-		    v -= i;
-		    m++;
-		}
-	    }
-	}
+	else
+	    findMetric(value, metric, inst);
     }
     else {
 	value = _blocks.size();
@@ -535,11 +519,33 @@ StackMod::findBlock(SoPath *path, int &metric, int &inst,
 	     << ", inst = " << inst << ", value = " << value << Qt::endl;
 }
 
+void
+StackMod::findMetric(int value, int &metric, int &inst)
+{
+    int		m = 0;
+    int		v = value;
+    int		i;
+
+    metric = inst = 0;
+    while (m < _metrics->numMetrics()) {
+	i = _metrics->metric(m).numValues();
+	if (v < i) {
+	    metric = m;
+	    inst = v;
+	    break;
+	}
+	else {
+	    v -= i;
+	    m++;
+	}
+    }
+}
+
 void
 StackMod::setFillColor(const SbColor &col)
 {
     if (_sts >= 0 && _height == fixed)
-	_blocks.last()._color->rgb.setValue(col.getValue());
+	_mesh->setColor(_mesh->numBlocks() - 1, col);
 }
  
 void
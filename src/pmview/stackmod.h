@@ -17,19 +17,11 @@
 
 #include <QVector>
 #include "modulate.h"
+#include "barmesh.h"
 
-class SoBaseColor;
-class SoTranslation;
-class SoScale;
-class SoNode;
-class SoSwitch;
 class Launch;
 
 struct StackBlock {
-    SoSeparator		*_sep;
-    SoBaseColor		*_color;
-    SoScale		*_scale;
-    SoTranslation	*_tran;
     Modulate::State	_state;
     bool		_selected;
 };
@@ -48,7 +40,7 @@ private:
     static const char	theStackId;
 
     StackBlockList	_blocks;
-    SoSwitch		*_switch;
+    BarMesh		*_mesh;
     Height		_height;
     QString		_text;
     int			_selectCount;
@@ -61,7 +53,7 @@ public:
     virtual ~StackMod();
 
     StackMod(MetricList *metrics,
-		 SoNode *obj, 
+		 ViewObj::Shape shape,
 		 Height height = unfixed);
 
     void setFillColor(const SbColor &col);
@@ -75,8 +67,10 @@ public:
     virtual int select(SoPath *);
     virtual int remove(SoPath *);
 
-    virtual void selectInfo(SoPath *);
-    virtual void removeInfo(SoPath *);
+    virtual SoPath *pickPath(const SoPickedPoint *pick);
+
+    virtual void selectInfo(const SoPickedPoint *pick);
+    virtual void removeInfo(const SoPickedPoint *);
 
     virtual void infoText(QString &str, bool) const;
 
@@ -93,6 +87,7 @@ private:
 
     void findBlock(SoPath *path, int &metric, int &inst, 
 		   int &value, bool idMetric = true);
+    void findMetric(int value, int &metric, int &inst);
 };
 
 #endif /* _STACKMOD_H_ */
@@ -89,7 +89,7 @@ StackObj::finishedAdd()
 		cerr << "StackObj::finishedAdd: metrics: " << Qt::endl 
 		     << _metrics << Qt::endl;
 
-	    _stack = new StackMod(&_metrics, ViewObj::object(_shape), _height);
+	    _stack = new StackMod(&_metrics, _shape, _height);
 	    _root->addChild(_stack->root());
 
 	    if (_text.length())
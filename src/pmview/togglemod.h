@@ -44,9 +44,9 @@ public:
     virtual int select(SoPath *);
     virtual int remove(SoPath *);
 
-    virtual void selectInfo(SoPath *)
+    virtual void selectInfo(const SoPickedPoint *)
 	{}
-    virtual void removeInfo(SoPath *)
+    virtual void removeInfo(const SoPickedPoint *)
 	{}
 
     virtual void infoText(QString &str, bool) const